@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Timed runs per measurement, after one untimed warm-up run. The BENCH_RUNS
+// environment variable overrides it.
+#define BENCH_DEFAULT_RUNS 5
+#define BENCH_MAX_RUNS 100
+
+// Monotonic wall clock in seconds
+static inline double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static inline int bench_runs(void) {
+  const char *runs = getenv("BENCH_RUNS");
+  int count = runs != NULL && *runs != '\0' ? atoi(runs) : BENCH_DEFAULT_RUNS;
+  if (count < 1) {
+    return 1;
+  }
+  return count < BENCH_MAX_RUNS ? count : BENCH_MAX_RUNS;
+}
+
+// Appends a result to the file BENCH_JSON names, as one JSON object per
+// line: the operations per run, the median run's seconds and ops/s, and the
+// seconds of every run in the order they ran
+static inline void bench_write_json(const char *name, size_t ops,
+                                    double median, const double *samples,
+                                    int count) {
+  const char *path = getenv("BENCH_JSON");
+  if (path == NULL || *path == '\0') {
+    return;
+  }
+  FILE *out = fopen(path, "a");
+  if (out == NULL) {
+    return;
+  }
+
+  fprintf(out,
+          "{\"name\": \"%s\", \"ops\": %zu, \"seconds\": %.9f, "
+          "\"ops_per_second\": %.1f, \"samples\": [",
+          name, ops, median, median > 0 ? (double)ops / median : 0.0);
+  for (int i = 0; i < count; i++) {
+    fprintf(out, "%s%.9f", i > 0 ? ", " : "", samples[i]);
+  }
+  fprintf(out, "]}\n");
+  fclose(out);
+}
+
+// Reports the median of `count` runs of `ops` operations each, and how far
+// apart the fastest and slowest runs were. Returns the median.
+static inline double bench_report_runs(const char *name, size_t ops,
+                                     const double *samples, int count) {
+  double sorted[BENCH_MAX_RUNS];
+  for (int i = 0; i < count; i++) {
+    int at = i;
+    for (; at > 0 && sorted[at - 1] > samples[i]; at--) {
+      sorted[at] = sorted[at - 1];
+    }
+    sorted[at] = samples[i];
+  }
+  double median = count % 2 == 1
+                      ? sorted[count / 2]
+                      : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+
+  printf("%-32s %12zu ops %10.3f ms %14.0f ops/s", name, ops, median * 1e3,
+         median > 0 ? (double)ops / median : 0.0);
+  if (count > 1 && median > 0) {
+    printf("  (%d runs, range %.1f%%)", count,
+           (sorted[count - 1] - sorted[0]) / median * 100);
+  }
+  printf("\n");
+  bench_write_json(name, ops, median, samples, count);
+  return median;
+}
+
+// Calls `run` once to warm up caches and the allocator, then bench_runs()
+// times, and reports and returns the median. `run` does its own setup and
+// returns the seconds spent on the part being measured.
+static inline double bench_run(const char *name, size_t ops,
+                             double (*run)(void *arg), void *arg) {
+  double samples[BENCH_MAX_RUNS];
+  int count = bench_runs();
+  run(arg);
+  for (int i = 0; i < count; i++) {
+    samples[i] = run(arg);
+  }
+  return bench_report_runs(name, ops, samples, count);
+}
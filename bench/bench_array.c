@@ -0,0 +1,61 @@
+#include <stdlib.h>
+
+#include "../src/objects/sneknew.h"
+#include "../src/vm/gc.h"
+#include "../src/vm/vm.h"
+#include "bench.h"
+
+static size_t n;
+static size_t concat_n;
+
+// Builds an N-element array by appending one element at a time.
+static double append(void *arg) {
+  (void)arg;
+  vm_t *vm = vm_new();
+  frame_t *frame = vm_new_frame(vm);
+  snek_object_t *array = new_snek_array(vm, 0);
+  frame_reference_object(frame, array);
+
+  double start = bench_now();
+  for (size_t i = 0; i < n; i++) {
+    snek_array_append(array, new_snek_integer(vm, (int)i));
+  }
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+// Builds an N-element array with `array = array + [i]`, collecting garbage
+// periodically so the intermediate arrays don't exhaust memory.
+static double concat(void *arg) {
+  (void)arg;
+  vm_t *vm = vm_new();
+  vm_new_frame(vm);
+  snek_object_t *array = new_snek_array(vm, 0);
+
+  double start = bench_now();
+  for (size_t i = 0; i < concat_n; i++) {
+    snek_object_t *single = new_snek_array(vm, 1);
+    snek_array_set(single, 0, new_snek_integer(vm, (int)i));
+    array = snek_add(vm, array, single);
+
+    if (i % 1024 == 0) {
+      vm_frame_pop(vm);
+      frame_reference_object(vm_new_frame(vm), array);
+      vm_collect_garbage(vm);
+    }
+  }
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  // Concatenation is quadratic: only run the full size when asked to
+  concat_n = argc > 2 ? strtoul(argv[2], NULL, 10) : n / 20;
+
+  bench_run("array/append", n, append, NULL);
+  bench_run("array/concat", concat_n, concat, NULL);
+  return 0;
+}
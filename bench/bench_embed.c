@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/api/sneklang.h"
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "bench.h"
+
+// A small scoring script, the kind a service runs once per request
+static const char *source = "def clamp(x: int, lo: int, hi: int) -> int:\n"
+                            "    if x < lo:\n"
+                            "        return lo\n"
+                            "    if x > hi:\n"
+                            "        return hi\n"
+                            "    return x\n"
+                            "\n"
+                            "score: int = 0\n"
+                            "for i: int = 0; i < 8; i = i + 1:\n"
+                            "    score = score + clamp(n * i - 20, 0, 50)\n"
+                            "label: string = \"low\"\n"
+                            "if score > 100:\n"
+                            "    label = \"high\"\n";
+
+static int runs;
+static long checksum;
+
+// Compile once, run many times on one VM
+static double reused_vm(void *arg) {
+  (void)arg;
+  const char *inputs[] = {"n"};
+  sneklang_vm_t *vm = sneklang_vm_new();
+  sneklang_program_t *program = sneklang_compile(source, inputs, 1);
+  if (program == NULL) {
+    exit(1);
+  }
+
+  double start = bench_now();
+  for (int i = 0; i < runs; i++) {
+    int score;
+    sneklang_bind_int(program, "n", i % 16);
+    if (!sneklang_run(vm, program) ||
+        !sneklang_get_int(program, "score", &score)) {
+      exit(1);
+    }
+    checksum += score;
+  }
+  double seconds = bench_now() - start;
+  sneklang_program_free(program);
+  sneklang_vm_free(vm);
+  return seconds;
+}
+
+// What each run cost before: lex, parse, compile and a fresh VM every time
+static double compile_each_run(void *arg) {
+  (void)arg;
+  char *fresh_source = malloc(strlen(source) + 16);
+  double start = bench_now();
+  for (int i = 0; i < runs; i++) {
+    sprintf(fresh_source, "n: int = %d\n%s", i % 16, source);
+    lexer_t *lexer = lexer_new(fresh_source);
+    parser_t *parser = parser_new(lexer);
+    program_t *fresh = compile(parse_root(parser));
+    vm_t *fresh_vm = vm_new();
+    if (fresh == NULL || vm_run(fresh_vm, fresh) != VM_OK) {
+      exit(1);
+    }
+    vm_free(fresh_vm);
+    program_free(fresh);
+    parser_free(parser);
+    lexer_free(lexer);
+  }
+  double seconds = bench_now() - start;
+  free(fresh_source);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  runs = argc > 1 ? atoi(argv[1]) : 100000;
+
+  bench_run("embed/reused_vm", runs, reused_vm, NULL);
+  bench_run("embed/compile_each_run", runs, compile_each_run, NULL);
+  return checksum < 0;
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/parser/parser.h"
+#include "bench.h"
+
+// The expression parser before binding powers: one function per precedence
+// level, so every operand went through all of them. Parenthesised operands
+// still use parse_expression, which the generated chains don't have.
+static ast_node_t *chain(parser_t *parser, int level);
+
+static bool at_level(token_type_t type, int level) {
+  switch (level) {
+  case 0:
+    return type == TOKEN_OR;
+  case 1:
+    return type == TOKEN_AND;
+  case 2:
+    return type == TOKEN_EQUAL_EQUAL || type == TOKEN_BANG_EQUAL;
+  case 3:
+    return type == TOKEN_LESS || type == TOKEN_LESS_EQUAL ||
+           type == TOKEN_GREATER || type == TOKEN_GREATER_EQUAL;
+  case 4:
+    return type == TOKEN_PLUS || type == TOKEN_MINUS;
+  default:
+    return type == TOKEN_STAR || type == TOKEN_SLASH;
+  }
+}
+
+static ast_node_t *chain(parser_t *parser, int level) {
+  if (level == 6) {
+    return parse_factor(parser);
+  }
+
+  ast_node_t *node = chain(parser, level + 1);
+  while (node != NULL && at_level(parser->current->type, level)) {
+    token_t *op = parser->current;
+    parser_advance(parser);
+    ast_node_t *right = chain(parser, level + 1);
+    if (right == NULL) {
+      ast_free_node(node);
+      return NULL;
+    }
+    node = ast_new_binary_op_node(op->type, node, right);
+    node->line = op->line;
+  }
+  return node;
+}
+
+// `lines` expressions of `operands` operands each, cycling through every
+// operator so all precedence levels appear
+static char *generate(int lines, int operands) {
+  static const char *ops[] = {" + ", " * ", " - ", " / ", " < ",
+                              " == ", " and ", " or "};
+  char *source = malloc((size_t)lines * operands * 8 + 1);
+  size_t length = 0;
+
+  for (int i = 0; i < lines; i++) {
+    for (int j = 0; j < operands; j++) {
+      if (j > 0) {
+        length += sprintf(source + length, "%s", ops[(i + j) % 8]);
+      }
+      length += sprintf(source + length, "%d", j % 10);
+    }
+    source[length++] = '\n';
+  }
+  source[length] = '\0';
+  return source;
+}
+
+static char *source;
+static int lines;
+
+static double parse_all(bool pratt) {
+  lexer_t *lexer = lexer_new(source);
+  parser_t *parser = parser_new(lexer);
+
+  double start = bench_now();
+  for (int i = 0; i < lines; i++) {
+    ast_node_t *node = pratt ? parse_expression(parser) : chain(parser, 0);
+    if (node == NULL || parser->current->type != TOKEN_EOL) {
+      exit(1);
+    }
+    ast_free_node(node);
+    parser_advance(parser); // Consume the EOL
+  }
+  double seconds = bench_now() - start;
+
+  parser_free(parser);
+  lexer_free(lexer);
+  return seconds;
+}
+
+static double per_level_functions(void *arg) {
+  (void)arg;
+  return parse_all(false);
+}
+
+static double binding_powers(void *arg) {
+  (void)arg;
+  return parse_all(true);
+}
+
+int main(int argc, char *argv[]) {
+  lines = argc > 1 ? atoi(argv[1]) : 20000;
+  const int operands = 64;
+  source = generate(lines, operands);
+
+  // Operand and operator nodes per run
+  size_t nodes = (size_t)lines * (2 * operands - 1);
+  bench_run("expr/per_level_functions", nodes, per_level_functions, NULL);
+  bench_run("expr/binding_powers", nodes, binding_powers, NULL);
+
+  free(source);
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <stdlib.h>
+
+#include "../src/objects/sneknew.h"
+#include "../src/stack/stack.h"
+#include "../src/vm/vm.h"
+#include "bench.h"
+
+static int n;
+
+// fib(n) where every call pushes a VM frame holding its argument, the way
+// an interpreted call will.
+static int fib_pooled(vm_t *vm, snek_object_t *arg, int n) {
+  frame_t *frame = vm_new_frame(vm);
+  frame_reference_object(frame, arg);
+
+  int result = n < 2 ? n : fib_pooled(vm, arg, n - 1) + fib_pooled(vm, arg, n - 2);
+
+  vm_frame_pop(vm);
+  return result;
+}
+
+// The same recursion paying for a malloc'd frame with its own reference
+// stack on every call, which is what frames cost before they were pooled.
+static int fib_malloc(snek_object_t *arg, int n) {
+  stack_t **frame = malloc(sizeof(stack_t *));
+  *frame = stack_new(8);
+  stack_push(*frame, arg);
+
+  int result = n < 2 ? n : fib_malloc(arg, n - 1) + fib_malloc(arg, n - 2);
+
+  stack_free(*frame);
+  free(frame);
+  return result;
+}
+
+static double pooled(void *arg) {
+  (void)arg;
+  vm_t *vm = vm_new();
+  snek_object_t *n_object = new_snek_integer(vm, n);
+  double start = bench_now();
+  fib_pooled(vm, n_object, n);
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+static double mallocd(void *arg) {
+  (void)arg;
+  vm_t *vm = vm_new();
+  snek_object_t *n_object = new_snek_integer(vm, n);
+  double start = bench_now();
+  fib_malloc(n_object, n);
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  n = argc > 1 ? atoi(argv[1]) : 30;
+
+  // Calls made by fib(n): one, plus those of fib(n - 1) and fib(n - 2)
+  size_t calls = 1;
+  size_t previous = 1;
+  for (int i = 2; i <= n; i++) {
+    size_t next = 1 + calls + previous;
+    previous = calls;
+    calls = next;
+  }
+
+  bench_run("frames/fib_pooled", calls, pooled, NULL);
+  bench_run("frames/fib_malloc", calls, mallocd, NULL);
+  return 0;
+}
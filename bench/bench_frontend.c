@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/parser/parser.h"
+#include "bench.h"
+
+// Functions with loops, branches and calls, between top-level declarations
+static char *generate(int functions) {
+  size_t capacity = (size_t)functions * 320 + 1;
+  char *source = malloc(capacity);
+  size_t length = 0;
+
+  for (int i = 0; i < functions; i++) {
+    length += snprintf(source + length, capacity - length,
+                       "def f%d(n: int) -> int:\n"
+                       "    total: int = 0\n"
+                       "    for j: int = 0; j < n; j = j + 1:\n"
+                       "        if j < %d and total >= 0:\n"
+                       "            total = total + j * 2 - 1\n"
+                       "        else:\n"
+                       "            total = total - (j / 3)\n"
+                       "    return total\n"
+                       "v%d: float = %d.5 * 2.0 + 1.0\n"
+                       "s%d: string = \"item %d\"\n"
+                       "print(f%d(%d), v%d)\n",
+                       i, i, i, i, i, i, i, i, i);
+  }
+  return source;
+}
+
+static size_t count_list(ast_node_list_t *list);
+
+static size_t count_nodes(ast_node_t *node) {
+  if (node == NULL) {
+    return 0;
+  }
+
+  switch (node->type) {
+  case NODE_BINARY_OP:
+    return 1 + count_nodes(node->binary_op.left) +
+           count_nodes(node->binary_op.right);
+  case NODE_UNARY_OP:
+    return 1 + count_nodes(node->unary_op.operand);
+  case NODE_ASSIGNMENT:
+    return 1 + count_nodes(node->assignment.value);
+  case NODE_DECLARATION:
+    return 1 + count_nodes(node->declaration.value);
+  case NODE_FUNCTION:
+    return 1 + count_list(&node->function.body);
+  case NODE_CALL:
+    return 1 + count_list(&node->call.args);
+  case NODE_RETURN:
+    return 1 + count_nodes(node->return_stmt.value);
+  case NODE_IF:
+    return 1 + count_nodes(node->if_stmt.condition) +
+           count_list(&node->if_stmt.then_branch) +
+           count_list(&node->if_stmt.else_branch);
+  case NODE_WHILE:
+    return 1 + count_nodes(node->while_stmt.condition) +
+           count_list(&node->while_stmt.body);
+  case NODE_FOR:
+    return 1 + count_nodes(node->for_stmt.init) +
+           count_nodes(node->for_stmt.condition) +
+           count_nodes(node->for_stmt.step) + count_list(&node->for_stmt.body);
+  case NODE_BLOCK:
+    return 1 + count_list(&node->block.statements);
+  default:
+    return 1;
+  }
+}
+
+static size_t count_list(ast_node_list_t *list) {
+  size_t count = 0;
+  for (int i = 0; i < list->count; i++) {
+    count += count_nodes(list->nodes[i]);
+  }
+  return count;
+}
+
+static double lex(void *arg) {
+  lexer_t *lexer = lexer_new(arg);
+  double start = bench_now();
+  token_t *token;
+  do {
+    token = lexer_next_token(lexer);
+    if (token == NULL) {
+      exit(1);
+    }
+    token_type_t type = token->type;
+    token_free(token);
+    if (type == TOKEN_EOF) {
+      break;
+    }
+  } while (true);
+  double seconds = bench_now() - start;
+  lexer_free(lexer);
+  return seconds;
+}
+
+// Parsing pulls its tokens from the lexer, so this includes lexing
+static double parse(void *arg) {
+  double start = bench_now();
+  lexer_t *lexer = lexer_new(arg);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = parse_root(parser);
+  double seconds = bench_now() - start;
+  if (root == NULL) {
+    exit(1);
+  }
+  parser_free(parser);
+  lexer_free(lexer);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  int functions = argc > 1 ? atoi(argv[1]) : 20000;
+  char *source = generate(functions);
+  size_t bytes = strlen(source);
+
+  lexer_t *lexer = lexer_new(source);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = parse_root(parser);
+  if (root == NULL) {
+    return 1;
+  }
+  size_t nodes = 0;
+  for (int i = 0; i < root->count; i++) {
+    nodes += count_nodes(root->nodes[i]);
+  }
+  parser_free(parser);
+  lexer_free(lexer);
+
+  // ops/s is bytes/s and nodes/s
+  bench_run("frontend/lex_bytes", bytes, lex, source);
+  bench_run("frontend/parse_nodes", nodes, parse, source);
+
+  free(source);
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/objects/sneknew.h"
+#include "../src/vm/gc.h"
+#include "bench.h"
+
+typedef struct {
+  size_t objects;
+  bool rooted;
+} heap_t;
+
+// One collection of a heap of integers. Rooted, it marks every object and
+// frees none; unrooted, it marks none and frees every one.
+static double collect(void *arg) {
+  heap_t *heap = arg;
+  vm_t *vm = vm_new();
+  frame_t *frame = vm_new_frame(vm);
+  for (size_t i = 0; i < heap->objects; i++) {
+    snek_object_t *obj = new_snek_integer(vm, (int)i);
+    if (heap->rooted) {
+      frame_reference_object(frame, obj);
+    }
+  }
+
+  double start = bench_now();
+  vm_collect_garbage(vm);
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  size_t largest = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+
+  char name[64];
+  for (size_t objects = 1000; objects <= largest; objects *= 10) {
+    heap_t heap = {.objects = objects, .rooted = true};
+    snprintf(name, sizeof(name), "gc/mark_%zu", objects);
+    bench_run(name, objects, collect, &heap);
+
+    heap.rooted = false;
+    snprintf(name, sizeof(name), "gc/sweep_%zu", objects);
+    bench_run(name, objects, collect, &heap);
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/parser/incremental.h"
+#include "bench.h"
+
+// The data script of bench_parse, one line per statement except the
+// functions, which take two
+static char *generate(int statements, int *lines) {
+  size_t capacity = (size_t)statements * 64 + 1;
+  char *source = malloc(capacity);
+  size_t length = 0;
+  *lines = 0;
+
+  for (int i = 0; i < statements; i++) {
+    char *at = source + length;
+    size_t left = capacity - length;
+    switch (i % 5) {
+    case 0:
+      length += snprintf(at, left, "v%d: int = %d * 2 + 1\n", i, i);
+      break;
+    case 1:
+      length += snprintf(at, left, "f%d: float = %d.5\n", i, i);
+      break;
+    case 2:
+      length += snprintf(at, left, "s%d: string = \"item %d\"\n", i, i);
+      break;
+    case 3:
+      length += snprintf(at, left, "b%d: int = v%d + %d\n", i, i - 3, i);
+      break;
+    default:
+      length += snprintf(at, left,
+                         "def g%d(x: int) -> int:\n"
+                         "    return x + %d\n",
+                         i, i);
+      (*lines)++;
+      break;
+    }
+    (*lines)++;
+  }
+  return source;
+}
+
+static char *source;
+static int statements;
+static int edits;
+
+static incremental_t *parse_source(void) {
+  incremental_t *parse = incremental_new(source);
+  if (parse == NULL || parse->root == NULL ||
+      parse->root->count != statements) {
+    exit(1);
+  }
+  return parse;
+}
+
+static double full_parse(void *arg) {
+  (void)arg;
+  double start = bench_now();
+  incremental_t *parse = parse_source();
+  double seconds = bench_now() - start;
+  incremental_free(parse);
+  return seconds;
+}
+
+// Typing over a digit of `v<i>: int = <i> * 2 + 1`, spread over the file
+static double edit_character(void *arg) {
+  (void)arg;
+  incremental_t *parse = parse_source();
+  double start = bench_now();
+  for (int i = 0; i < edits; i++) {
+    size_t statement = (size_t)i * 4099 % (size_t)statements / 5 * 5;
+    size_t offset = parse->starts[statement].offset + strlen("v");
+    char digit[2] = {(char)('1' + i % 9), '\0'};
+    if (!incremental_edit(parse, offset, 1, digit)) {
+      exit(1);
+    }
+  }
+  double seconds = bench_now() - start;
+  incremental_free(parse);
+  return seconds;
+}
+
+// A newline, then the tree, then the newline's removal: every statement below
+// changes line, and the first time their nodes have to follow
+static double edit_line(void *arg) {
+  (void)arg;
+  incremental_t *parse = parse_source();
+  double start = bench_now();
+  for (int i = 0; i < edits; i += 2) {
+    size_t statement = (size_t)i * 4099 % (size_t)statements;
+    size_t offset = parse->starts[statement].offset;
+    if (!incremental_edit(parse, offset, 0, "\n") ||
+        incremental_root(parse) == NULL ||
+        !incremental_edit(parse, offset, 1, "")) {
+      exit(1);
+    }
+  }
+  double seconds = bench_now() - start;
+  incremental_free(parse);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  statements = argc > 1 ? atoi(argv[1]) : 42000;
+  edits = argc > 2 ? atoi(argv[2]) : 1000;
+  int lines;
+  source = generate(statements, &lines);
+  printf("%d lines, %zu bytes\n", lines, strlen(source));
+
+  bench_run("incremental/full_parse", 1, full_parse, NULL);
+  double seconds =
+      bench_run("incremental/edit_character", edits, edit_character, NULL);
+  printf("%-32s %12.3f ms\n", "  per edit", seconds * 1e3 / edits);
+  seconds = bench_run("incremental/edit_line", edits, edit_line, NULL);
+  printf("%-32s %12.3f ms\n", "  per edit", seconds * 1e3 / edits);
+
+  free(source);
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/scheduler.h"
+#include "bench.h"
+
+// A short user script: some arithmetic, a few calls and enough allocation
+// that every isolate's collector runs
+static char *source = "def step(x: int) -> int:\n"
+                      "    if x > 1000:\n"
+                      "        return x - 997\n"
+                      "    return x * 3 + 1\n"
+                      "\n"
+                      "x: int = 7\n"
+                      "for i: int = 0; i < 1000; i = i + 1:\n"
+                      "    x = step(x)\n"
+                      "print(x)\n";
+
+static program_t *program;
+static size_t isolates;
+static isolate_t *runs;
+static FILE *out;
+
+// Every isolate, spread over `arg` workers
+static double run_all(void *arg) {
+  size_t workers = *(size_t *)arg;
+  scheduler_t *scheduler = scheduler_new(workers);
+  double start = bench_now();
+  for (size_t i = 0; i < isolates; i++) {
+    isolate_init(&runs[i], program, out);
+    scheduler_submit(scheduler, &runs[i]);
+  }
+  scheduler_wait(scheduler);
+  double seconds = bench_now() - start;
+  scheduler_free(scheduler);
+
+  for (size_t i = 0; i < isolates; i++) {
+    if (runs[i].result != VM_OK) {
+      exit(1);
+    }
+  }
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  isolates = argc > 1 ? (size_t)atol(argv[1]) : 4000;
+
+  lexer_t *lexer = lexer_new(source);
+  parser_t *parser = parser_new(lexer);
+  program = compile(parse_root(parser));
+  parser_free(parser);
+  lexer_free(lexer);
+  if (program == NULL) {
+    return 1;
+  }
+
+  out = fopen("/dev/null", "w");
+  runs = malloc(isolates * sizeof(isolate_t));
+  double single = 0;
+
+  for (size_t workers = 1; workers <= 8; workers *= 2) {
+    char name[32];
+    snprintf(name, sizeof(name), "isolates/%zu_workers", workers);
+    double seconds = bench_run(name, isolates, run_all, &workers);
+    if (workers == 1) {
+      single = seconds;
+    }
+    printf("%-32s %12.2fx\n", "  speedup", single / seconds);
+  }
+
+  free(runs);
+  fclose(out);
+  program_free(program);
+  return 0;
+}
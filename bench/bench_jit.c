@@ -0,0 +1,64 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "bench.h"
+
+// A hot loop of local loads and stores, int comparisons feeding branches and
+// arithmetic, in a function and at top level. Build with `make JIT=1` to
+// compare; otherwise both runs are interpreted.
+static const char *script = "def count(n: int) -> int:\n"
+                            "    hits: int = 0\n"
+                            "    for i: int = 0; i < n; i = i + 1:\n"
+                            "        if i == 7 or i >= n - 3:\n"
+                            "            hits = hits + 2\n"
+                            "        hits = hits + 1\n"
+                            "    return hits\n"
+                            "\n"
+                            "total: int = 0\n"
+                            "round: int = 0\n"
+                            "while round < 20:\n"
+                            "    total = total + count(100000)\n"
+                            "    round = round + 1\n"
+                            "print(total)\n";
+
+static program_t *program;
+
+static double run(void *arg) {
+  vm_t *vm = vm_new();
+  vm->out = fopen("/dev/null", "w");
+  vm->jit = *(bool *)arg;
+  double start = bench_now();
+  vm_result_t result = vm_run(vm, program);
+  double seconds = bench_now() - start;
+  fclose(vm->out);
+  vm_free(vm);
+  if (result != VM_OK) {
+    exit(1);
+  }
+  return seconds;
+}
+
+int main(void) {
+  lexer_t *lexer = lexer_new((char *)script);
+  parser_t *parser = parser_new(lexer);
+  program = compile(parse_root(parser));
+  if (program == NULL) {
+    return 1;
+  }
+
+  bool jit = false;
+  double interpreted = bench_run("jit/interpreted", 1, run, &jit);
+  jit = true;
+  double native = bench_run("jit/native", 1, run, &jit);
+  printf("%-32s %12.2fx\n", "  speedup", interpreted / native);
+#ifndef SNEK_JIT
+  printf("  (built without JIT=1, so both runs were interpreted)\n");
+#endif
+
+  program_free(program);
+  parser_free(parser);
+  lexer_free(lexer);
+  return 0;
+}
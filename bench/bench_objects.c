@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/objects/sneknew.h"
+#include "../src/objects/snekobject.h"
+#include "../src/vm/gc.h"
+#include "bench.h"
+
+static size_t n;
+
+// Makes one object of a kind. `part` is a float the VM already holds, for
+// kinds built out of other objects.
+typedef struct {
+  const char *name;
+  snek_object_t *(*make)(vm_t *vm, snek_object_t *part);
+} kind_t;
+
+static snek_object_t *make_integer(vm_t *vm, snek_object_t *part) {
+  (void)part;
+  return new_snek_integer(vm, 42);
+}
+
+static snek_object_t *make_float(vm_t *vm, snek_object_t *part) {
+  (void)part;
+  return new_snek_float(vm, 4.2f);
+}
+
+static snek_object_t *make_string(vm_t *vm, snek_object_t *part) {
+  (void)part;
+  return new_snek_string(vm, "short");
+}
+
+static snek_object_t *make_long_string(vm_t *vm, snek_object_t *part) {
+  (void)part;
+  return new_snek_string(vm, "a string too long to fit inside the object");
+}
+
+static snek_object_t *make_vector3(vm_t *vm, snek_object_t *part) {
+  return new_snek_vector3(vm, part, part, part);
+}
+
+static snek_object_t *make_array(vm_t *vm, snek_object_t *part) {
+  snek_object_t *array = new_snek_array(vm, 8);
+  for (size_t i = 0; i < 8; i++) {
+    snek_array_set(array, i, part);
+  }
+  return array;
+}
+
+static snek_object_t *make_typed_array(vm_t *vm, snek_object_t *part) {
+  (void)part;
+  return new_snek_typed_array(vm, ELEMENT_FLOAT, 8);
+}
+
+static snek_object_t *make_map(vm_t *vm, snek_object_t *part) {
+  (void)part;
+  return new_snek_map(vm);
+}
+
+static const kind_t kinds[] = {
+    {"integer", make_integer},        {"float", make_float},
+    {"string", make_string},          {"long_string", make_long_string},
+    {"vector3", make_vector3},        {"array", make_array},
+    {"typed_array", make_typed_array}, {"map", make_map},
+};
+
+// The heap is never collected, so this is allocation and tracking alone
+static double allocate(void *arg) {
+  const kind_t *kind = arg;
+  vm_t *vm = vm_new();
+  snek_object_t *part = new_snek_float(vm, 1.5f);
+  double start = bench_now();
+  for (size_t i = 0; i < n; i++) {
+    kind->make(vm, part);
+  }
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+// snek_add on two rooted operands with a safepoint after each, the way the
+// interpreter runs it, so collecting the results counts too
+static double add(void *arg) {
+  const kind_t *kind = arg;
+  vm_t *vm = vm_new();
+  frame_t *frame = vm_new_frame(vm);
+  snek_object_t *part = new_snek_float(vm, 1.5f);
+  frame_reference_object(frame, part);
+  snek_object_t *a = kind->make(vm, part);
+  snek_object_t *b = kind->make(vm, part);
+  frame_reference_object(frame, a);
+  frame_reference_object(frame, b);
+
+  double start = bench_now();
+  for (size_t i = 0; i < n; i++) {
+    if (snek_add(vm, a, b) == NULL) {
+      exit(1);
+    }
+    vm_safepoint(vm);
+  }
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+  char name[64];
+  for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+    snprintf(name, sizeof(name), "objects/new_%s", kinds[i].name);
+    bench_run(name, n, allocate, (void *)&kinds[i]);
+  }
+  // Maps don't add
+  for (size_t i = 0; i + 1 < sizeof(kinds) / sizeof(kinds[0]); i++) {
+    snprintf(name, sizeof(name), "objects/add_%s", kinds[i].name);
+    bench_run(name, n, add, (void *)&kinds[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/parser/parallel.h"
+#include "bench.h"
+
+// A generated data script: independent top-level declarations, with a few
+// functions mixed in so some statements span several lines
+static char *generate(int statements) {
+  size_t capacity = (size_t)statements * 64 + 1;
+  char *source = malloc(capacity);
+  size_t length = 0;
+
+  for (int i = 0; i < statements; i++) {
+    char *at = source + length;
+    size_t left = capacity - length;
+    switch (i % 5) {
+    case 0:
+      length += snprintf(at, left, "v%d: int = %d * 2 + 1\n", i, i);
+      break;
+    case 1:
+      length += snprintf(at, left, "f%d: float = %d.5\n", i, i);
+      break;
+    case 2:
+      length += snprintf(at, left, "s%d: string = \"item %d\"\n", i, i);
+      break;
+    case 3:
+      length += snprintf(at, left, "b%d: int = v%d + %d\n", i, i - 3, i);
+      break;
+    default:
+      length += snprintf(at, left,
+                         "def g%d(x: int) -> int:\n"
+                         "    return x + %d\n",
+                         i, i);
+      break;
+    }
+  }
+  return source;
+}
+
+static char *source;
+static int statements;
+
+static void check(ast_root_t *root) {
+  if (root == NULL || root->count != statements) {
+    exit(1);
+  }
+  ast_root_free(root);
+}
+
+// One parser over the whole source. The chunked parses release their
+// tokens as they go, so the baseline pays for that too.
+static double single_parser(void *arg) {
+  (void)arg;
+  double start = bench_now();
+  lexer_t *lexer = lexer_new(source);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = parse_root(parser);
+  parser->root = NULL;
+  parser_free(parser);
+  lexer_free(lexer);
+  double seconds = bench_now() - start;
+  check(root);
+  return seconds;
+}
+
+// Split into chunks parsed on `arg` threads
+static double parallel(void *arg) {
+  int threads = *(int *)arg;
+  double start = bench_now();
+  ast_root_t *root = parse_root_parallel(source, threads);
+  double seconds = bench_now() - start;
+  check(root);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  statements = argc > 1 ? atoi(argv[1]) : 200000;
+  source = generate(statements);
+
+  double single = bench_run("parse/parse_root", statements, single_parser,
+                            NULL);
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    char name[64];
+    snprintf(name, sizeof(name), "parse/parallel_%d_threads", threads);
+    double seconds = bench_run(name, statements, parallel, &threads);
+    printf("%-32s %12.2fx\n", "  speedup", single / seconds);
+  }
+
+  free(source);
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "../src/vm/profiler.h"
+#include "bench.h"
+
+// Deep recursion (every sample walks the call stack) and a hot loop
+static const char *script = "def fib(n: int) -> int:\n"
+                            "    if n < 2:\n"
+                            "        return n\n"
+                            "    return fib(n - 1) + fib(n - 2)\n"
+                            "\n"
+                            "total: int = 0\n"
+                            "i: int = 0\n"
+                            "while i < 2000000:\n"
+                            "    total = total + i * 2\n"
+                            "    i = i + 1\n"
+                            "print(fib(25) + total)\n";
+
+static program_t *program;
+static size_t samples;
+
+static double run(void *arg) {
+  bool profile = *(bool *)arg;
+  vm_t *vm = vm_new();
+  vm->out = fopen("/dev/null", "w");
+  double start = bench_now();
+  profiler_t *profiler = profile ? profiler_start(vm, PROFILE_INTERVAL_US) : NULL;
+  vm_run(vm, program);
+  if (profiler != NULL) {
+    profiler_stop(profiler);
+    samples += profiler_samples(profiler);
+    profiler_free(profiler);
+  }
+  double seconds = bench_now() - start;
+  fclose(vm->out);
+  vm_free(vm);
+  return seconds;
+}
+
+int main(void) {
+  lexer_t *lexer = lexer_new((char *)script);
+  parser_t *parser = parser_new(lexer);
+  program = compile(parse_root(parser));
+  if (program == NULL) {
+    return 1;
+  }
+
+  bool profile = false;
+  double plain = bench_run("profile/off", 1, run, &profile);
+  profile = true;
+  double profiled = bench_run("profile/on", 1, run, &profile);
+  printf("%-32s %12.2f%%\n", "  overhead", (profiled / plain - 1) * 100);
+  printf("%-32s %12zu\n", "  samples", samples);
+
+  program_free(program);
+  parser_free(parser);
+  lexer_free(lexer);
+  return 0;
+}
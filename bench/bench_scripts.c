@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "bench.h"
+
+// Whole scripts from bench/scripts, which `make pgo` also trains on. Run
+// from the repository root, as `make bench` does. Scripts have no vector
+// syntax, so the vector math works on components.
+typedef struct {
+  const char *name;
+  size_t ops; // Loop iterations or calls
+} script_t;
+
+static const script_t scripts[] = {
+    {"numeric_loop", 200000},
+    {"string_build", 200000},
+    {"vector_math", 200000},
+    {"calls", 242785}, // fib(25)
+};
+
+static char *read_script(const char *name) {
+  char path[256];
+  snprintf(path, sizeof(path), "bench/scripts/%s.snek", name);
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open script %s\n", path);
+    return NULL;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *source = malloc(length + 1);
+  size_t read = fread(source, 1, length, file);
+  source[read] = '\0';
+  fclose(file);
+  return source;
+}
+
+static double run(void *arg) {
+  program_t *program = arg;
+  vm_t *vm = vm_new();
+  vm->out = fopen("/dev/null", "w");
+  double start = bench_now();
+  if (vm_run(vm, program) != VM_OK) {
+    exit(1);
+  }
+  double seconds = bench_now() - start;
+  fclose(vm->out);
+  vm_free(vm);
+  return seconds;
+}
+
+int main(void) {
+  char name[64];
+  for (size_t i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++) {
+    char *source = read_script(scripts[i].name);
+    if (source == NULL) {
+      return 1;
+    }
+    lexer_t *lexer = lexer_new(source);
+    parser_t *parser = parser_new(lexer);
+    program_t *program = compile(parse_root(parser));
+    if (program == NULL) {
+      return 1;
+    }
+
+    snprintf(name, sizeof(name), "script/%s", scripts[i].name);
+    bench_run(name, scripts[i].ops, run, program);
+
+    program_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(source);
+  }
+  return 0;
+}
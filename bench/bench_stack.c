@@ -0,0 +1,47 @@
+#include <stdlib.h>
+
+#include "../src/stack/stack.h"
+#include "bench.h"
+
+static size_t n;
+
+// Growing from a small stack, then emptying it
+static double fill_and_drain(void *arg) {
+  (void)arg;
+  stack_t *stack = stack_new(8);
+  double start = bench_now();
+  for (size_t i = 0; i < n; i++) {
+    stack_push(stack, (void *)i);
+  }
+  for (size_t i = 0; i < n; i++) {
+    stack_pop(stack);
+  }
+  double seconds = bench_now() - start;
+  stack_free(stack);
+  return seconds;
+}
+
+// A push and a pop at a steady depth, like an interpreter's operands
+static double push_pop(void *arg) {
+  (void)arg;
+  stack_t *stack = stack_new(64);
+  for (size_t i = 0; i < 16; i++) {
+    stack_push(stack, (void *)i);
+  }
+  double start = bench_now();
+  for (size_t i = 0; i < n; i++) {
+    stack_push(stack, (void *)i);
+    stack_pop(stack);
+  }
+  double seconds = bench_now() - start;
+  stack_free(stack);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+
+  bench_run("stack/fill_and_drain", n, fill_and_drain, NULL);
+  bench_run("stack/push_pop", n, push_pop, NULL);
+  return 0;
+}
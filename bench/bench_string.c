@@ -0,0 +1,68 @@
+#include <stdlib.h>
+
+#include "../src/objects/sneknew.h"
+#include "../src/objects/snekstring.h"
+#include "../src/vm/gc.h"
+#include "../src/vm/vm.h"
+#include "bench.h"
+
+static const char PIECE[] = "0123456789";
+
+static size_t n;
+static size_t flat_n;
+
+// Builds a string from N ten-byte pieces with `s = s + piece`, then reads
+// the result once (which flattens the rope).
+static double rope(void *arg) {
+  (void)arg;
+  vm_t *vm = vm_new();
+  snek_object_t *piece = new_snek_string(vm, (char *)PIECE);
+  snek_object_t *str = new_snek_string(vm, "");
+
+  double start = bench_now();
+  for (size_t i = 0; i < n; i++) {
+    str = snek_add(vm, str, piece);
+  }
+  snek_string_cstr(str);
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+// Same loop, but the string is flattened after every step, which is what a
+// plain char* representation has to do.
+static double flat(void *arg) {
+  (void)arg;
+  vm_t *vm = vm_new();
+  vm_new_frame(vm);
+  snek_object_t *piece = new_snek_string(vm, (char *)PIECE);
+  snek_object_t *str = new_snek_string(vm, "");
+
+  double start = bench_now();
+  for (size_t i = 0; i < flat_n; i++) {
+    str = snek_add(vm, str, piece);
+    snek_string_cstr(str);
+
+    if (i % 256 == 0) {
+      vm_frame_pop(vm);
+      frame_t *frame = vm_new_frame(vm);
+      frame_reference_object(frame, piece);
+      frame_reference_object(frame, str);
+      vm_collect_garbage(vm);
+    }
+  }
+  double seconds = bench_now() - start;
+  vm_free(vm);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  // 1M ten-byte pieces make a 10 MB string
+  n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  // Flattening every step is quadratic: only run the full size when asked to
+  flat_n = argc > 2 ? strtoul(argv[2], NULL, 10) : n / 50;
+
+  bench_run("string/rope_concat", n, rope, NULL);
+  bench_run("string/flat_concat", flat_n, flat, NULL);
+  return 0;
+}
@@ -0,0 +1,299 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Compares two results files written by `make bench` and exits with 1 if
+// any benchmark got slower. A benchmark regresses when its median time grew
+// by more than the threshold and a one-sided Mann-Whitney U test says its
+// runs are slower than the baseline's with p below alpha. Both are needed:
+// the threshold ignores slowdowns too small to matter, and the test ignores
+// differences the runs' own noise explains.
+//
+// Every line naming the same benchmark adds its runs, so a file holding
+// several rounds of the suite gives each benchmark more runs to test. With
+// so few runs that even the most lopsided ordering isn't significant at
+// alpha (three on each side at 0.05), the benchmark is reported but never
+// fails.
+//
+// Usage: compare [--threshold PERCENT] [--alpha P] BASELINE CURRENT
+
+#define MAX_SAMPLES 1024
+// Largest run counts whose U distribution is counted exactly
+#define EXACT_LIMIT 50
+
+typedef struct {
+  char *name;
+  size_t ops;
+  double samples[MAX_SAMPLES];
+  int count;
+} result_t;
+
+typedef struct {
+  result_t *items;
+  size_t count;
+  size_t capacity;
+} results_t;
+
+static result_t *find(results_t *results, const char *name) {
+  for (size_t i = 0; i < results->count; i++) {
+    if (strcmp(results->items[i].name, name) == 0) {
+      return &results->items[i];
+    }
+  }
+  return NULL;
+}
+
+// The value after `"key": ` in a line, or NULL
+static const char *field(const char *line, const char *key) {
+  char pattern[64];
+  snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+  const char *at = strstr(line, pattern);
+  return at != NULL ? at + strlen(pattern) : NULL;
+}
+
+static bool parse_line(results_t *results, const char *line) {
+  const char *name = field(line, "name");
+  const char *ops = field(line, "ops");
+  const char *samples = field(line, "samples");
+  if (name == NULL || *name != '"' || ops == NULL || samples == NULL ||
+      *samples != '[') {
+    return false;
+  }
+  const char *end = strchr(name + 1, '"');
+  if (end == NULL) {
+    return false;
+  }
+
+  char *key = strndup(name + 1, (size_t)(end - name - 1));
+  result_t *result = find(results, key);
+  if (result == NULL) {
+    if (results->count == results->capacity) {
+      results->capacity = results->capacity == 0 ? 64 : results->capacity * 2;
+      results->items =
+          realloc(results->items, results->capacity * sizeof(result_t));
+    }
+    result = &results->items[results->count++];
+    result->name = key;
+    result->ops = strtoul(ops, NULL, 10);
+    result->count = 0;
+  } else {
+    free(key);
+  }
+
+  const char *at = samples + 1;
+  while (*at != ']' && *at != '\0') {
+    char *next;
+    double seconds = strtod(at, &next);
+    if (next == at) {
+      return false;
+    }
+    if (result->count < MAX_SAMPLES) {
+      result->samples[result->count++] = seconds;
+    }
+    at = next;
+    while (*at == ',' || *at == ' ') {
+      at++;
+    }
+  }
+  return *at == ']';
+}
+
+static bool load(const char *path, results_t *results) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open %s\n", path);
+    return false;
+  }
+
+  char *line = NULL;
+  size_t capacity = 0;
+  int number = 0;
+  bool ok = true;
+  while (getline(&line, &capacity, file) != -1) {
+    number++;
+    if (line[0] == '\n' || line[0] == '\0') {
+      continue;
+    }
+    if (!parse_line(results, line)) {
+      fprintf(stderr, "Error: %s:%d is not a benchmark result\n", path,
+              number);
+      ok = false;
+      break;
+    }
+  }
+  free(line);
+  fclose(file);
+  return ok;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double median(result_t *result) {
+  double sorted[MAX_SAMPLES];
+  memcpy(sorted, result->samples, result->count * sizeof(double));
+  qsort(sorted, result->count, sizeof(double), compare_doubles);
+  int half = result->count / 2;
+  return result->count % 2 == 1 ? sorted[half]
+                                 : (sorted[half - 1] + sorted[half]) / 2;
+}
+
+// Probability of a U of at most `u` when both sets of runs come from the
+// same distribution, counting the orderings of n and m runs exactly
+static double exact_p(int n, int m, double u) {
+  // ways[j][k]: orderings of i baseline and j current runs with U == k,
+  // built up one baseline run at a time
+  int cells = n * m + 1;
+  double *ways = calloc((size_t)(m + 1) * cells, sizeof(double));
+  for (int j = 0; j <= m; j++) {
+    ways[j * cells] = 1;
+  }
+  for (int i = 1; i <= n; i++) {
+    for (int j = 0; j <= m; j++) {
+      // The largest run is either baseline (adding j to U) or current
+      for (int k = cells - 1; k >= 0; k--) {
+        double total = k >= j ? ways[j * cells + k - j] : 0;
+        if (j > 0) {
+          total += ways[(j - 1) * cells + k];
+        }
+        ways[j * cells + k] = total;
+      }
+    }
+  }
+
+  double below = 0;
+  double all = 0;
+  for (int k = 0; k < cells; k++) {
+    all += ways[m * cells + k];
+    if (k <= u) {
+      below += ways[m * cells + k];
+    }
+  }
+  free(ways);
+  return below / all;
+}
+
+// The smallest p the test can give for n and m runs: every current run
+// slower than every baseline run, one ordering out of (n + m choose n)
+static double smallest_p(int n, int m) {
+  double orderings = 1;
+  for (int i = 1; i <= n; i++) {
+    orderings = orderings * (m + i) / i;
+  }
+  return 1 / orderings;
+}
+
+// One-sided Mann-Whitney U test: the probability of the current runs being
+// at least this much slower than the baseline's by chance
+static double slower_p(result_t *baseline, result_t *current) {
+  int n = baseline->count;
+  int m = current->count;
+  // Pairs where the baseline run was slower; few means current is slower
+  double u = 0;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < m; j++) {
+      if (baseline->samples[i] > current->samples[j]) {
+        u += 1;
+      } else if (baseline->samples[i] == current->samples[j]) {
+        u += 0.5;
+      }
+    }
+  }
+
+  if (n <= EXACT_LIMIT && m <= EXACT_LIMIT) {
+    return exact_p(n, m, u);
+  }
+  double mean = (double)n * m / 2;
+  double sd = sqrt((double)n * m * (n + m + 1) / 12);
+  return 0.5 * erfc((mean - u - 0.5) / (sd * sqrt(2)));
+}
+
+static void usage(void) {
+  fprintf(stderr, "Usage: compare [--threshold PERCENT] [--alpha P] "
+                  "<baseline.jsonl> <current.jsonl>\n");
+}
+
+int main(int argc, char *argv[]) {
+  double threshold = 5;
+  double alpha = 0.05;
+  const char *paths[2];
+  int path_count = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) {
+      alpha = atof(argv[++i]);
+    } else if (argv[i][0] == '-' || path_count == 2) {
+      usage();
+      return 2;
+    } else {
+      paths[path_count++] = argv[i];
+    }
+  }
+  if (path_count != 2) {
+    usage();
+    return 2;
+  }
+
+  results_t baseline = {0};
+  results_t current = {0};
+  if (!load(paths[0], &baseline) || !load(paths[1], &current)) {
+    return 2;
+  }
+
+  printf("%-32s %12s %12s %9s %8s  %s\n", "benchmark", "baseline ms",
+         "current ms", "change", "p", "verdict");
+  int regressions = 0;
+  for (size_t i = 0; i < current.count; i++) {
+    result_t *now = &current.items[i];
+    result_t *before = find(&baseline, now->name);
+    if (before == NULL) {
+      printf("%-32s %12s %12.3f %9s %8s  new\n", now->name, "-",
+             median(now) * 1e3, "-", "-");
+      continue;
+    }
+    if (before->ops != now->ops) {
+      printf("%-32s %12s %12s %9s %8s  ops differ (%zu, %zu)\n", now->name,
+             "-", "-", "-", "-", before->ops, now->ops);
+      continue;
+    }
+
+    double old_median = median(before);
+    double new_median = median(now);
+    double change = old_median > 0 ? (new_median / old_median - 1) * 100 : 0;
+    double p_slower = slower_p(before, now);
+    double p_faster = slower_p(now, before);
+
+    const char *verdict = "same";
+    double p = p_slower;
+    if (smallest_p(before->count, now->count) >= alpha) {
+      verdict = "too few runs";
+    } else if (change > threshold && p_slower < alpha) {
+      verdict = "REGRESSION";
+      regressions++;
+    } else if (change < -threshold && p_faster < alpha) {
+      verdict = "faster";
+      p = p_faster;
+    } else if (change > threshold) {
+      verdict = "slower, within noise";
+    }
+    printf("%-32s %12.3f %12.3f %+8.1f%% %8.4f  %s\n", now->name,
+           old_median * 1e3, new_median * 1e3, change, p, verdict);
+  }
+
+  for (size_t i = 0; i < baseline.count; i++) {
+    if (find(&current, baseline.items[i].name) == NULL) {
+      printf("%-32s %12.3f %12s %9s %8s  missing\n", baseline.items[i].name,
+             median(&baseline.items[i]) * 1e3, "-", "-", "-");
+    }
+  }
+
+  printf("\n%d regression%s (threshold %.1f%%, alpha %.3f)\n", regressions,
+         regressions == 1 ? "" : "s", threshold, alpha);
+  return regressions > 0 ? 1 : 0;
+}
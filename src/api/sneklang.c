@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../compiler/compiler.h"
+#include "../objects/sneknew.h"
+#include "../objects/snekstring.h"
+#include "../vm/gc.h"
+#include "../vm/interpreter.h"
+#include "../vm/tracer.h"
+#include "sneklang.h"
+
+struct SneklangProgram {
+  program_t *program;
+  size_t input_count;
+  // Bound values, like constants: owned here, never tracked by a VM, and
+  // permanently marked so collections leave them alone
+  snek_object_t **inputs;
+  snek_object_t **results; // Final value of every global, NULL until a run
+  bool has_results;
+};
+
+sneklang_vm_t *sneklang_vm_new(void) { return vm_new(); }
+
+void sneklang_vm_free(sneklang_vm_t *vm) {
+  if (vm != NULL) {
+    tracer_free(vm->tracer);
+    vm_free(vm);
+  }
+}
+
+void sneklang_vm_set_output(sneklang_vm_t *vm, FILE *out) { vm->out = out; }
+
+bool sneklang_vm_write_gc_stats(sneklang_vm_t *vm, FILE *out) {
+  gc_stats_t stats = vm_gc_stats(vm);
+  return gc_stats_write_json(out, &stats);
+}
+
+bool sneklang_vm_trace(sneklang_vm_t *vm, size_t events) {
+#ifdef SNEK_TRACE
+  return tracer_start(vm, events, false) != NULL;
+#else
+  (void)vm;
+  (void)events;
+  return false;
+#endif
+}
+
+bool sneklang_vm_write_trace(sneklang_vm_t *vm, FILE *out) {
+  return vm->tracer != NULL && tracer_write_chrome_json(vm->tracer, out);
+}
+
+sneklang_program_t *sneklang_compile(const char *source,
+                                     const char *const *inputs,
+                                     size_t input_count) {
+  for (size_t i = 0; i < input_count; i++) {
+    for (size_t j = 0; j < i; j++) {
+      if (strcmp(inputs[i], inputs[j]) == 0) {
+        fprintf(stderr, "Compile Error: Input '%s' is given twice\n",
+                inputs[i]);
+        return NULL;
+      }
+    }
+  }
+
+  lexer_t *lexer = lexer_new((char *)source);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = parse_root(parser);
+  program_t *program = NULL;
+  if (root != NULL) {
+    compile_options_t options = {
+        .optimize = true, .inputs = inputs, .input_count = input_count};
+    program = compile_with_options(root, &options);
+  }
+  parser_free(parser);
+  lexer_free(lexer);
+  if (program == NULL) {
+    return NULL;
+  }
+
+  sneklang_program_t *handle = malloc(sizeof(sneklang_program_t));
+  if (handle == NULL) {
+    program_free(program);
+    return NULL;
+  }
+  handle->program = program;
+  handle->input_count = input_count;
+  handle->inputs = calloc(input_count + 1, sizeof(snek_object_t *));
+  handle->results =
+      calloc(program->global_names->count + 1, sizeof(snek_object_t *));
+  handle->has_results = false;
+  if (handle->inputs == NULL || handle->results == NULL) {
+    sneklang_program_free(handle);
+    return NULL;
+  }
+  return handle;
+}
+
+void sneklang_program_free(sneklang_program_t *program) {
+  if (program == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < program->input_count && program->inputs; i++) {
+    if (program->inputs[i] != NULL) {
+      snek_object_free(program->inputs[i]);
+    }
+  }
+  free(program->inputs);
+  free(program->results);
+  program_free(program->program);
+  free(program);
+}
+
+// Replaces the bound value of `input`, taking ownership of `value`
+static bool bind(sneklang_program_t *program, const char *input,
+                 snek_object_t *value) {
+  int slot = program_find_global(program->program, input);
+  if (slot < 0 || (size_t)slot >= program->input_count) {
+    if (value != NULL) {
+      snek_object_free(value);
+    }
+    return false;
+  }
+
+  if (program->inputs[slot] != NULL) {
+    snek_object_free(program->inputs[slot]);
+  }
+  if (value != NULL) {
+    value->is_marked = true;
+  }
+  program->inputs[slot] = value;
+  program->has_results = false;
+  return true;
+}
+
+bool sneklang_bind_int(sneklang_program_t *program, const char *input,
+                       int value) {
+  return bind(program, input, new_snek_integer(NULL, value));
+}
+
+bool sneklang_bind_float(sneklang_program_t *program, const char *input,
+                         float value) {
+  return bind(program, input, new_snek_float(NULL, value));
+}
+
+bool sneklang_bind_string(sneklang_program_t *program, const char *input,
+                          const char *value) {
+  return bind(program, input, new_snek_string_len(NULL, value, strlen(value)));
+}
+
+bool sneklang_bind_null(sneklang_program_t *program, const char *input) {
+  return bind(program, input, NULL);
+}
+
+bool sneklang_run(sneklang_vm_t *vm, sneklang_program_t *program) {
+  program->has_results =
+      vm_run_with_globals(vm, program->program, program->inputs,
+                          program->input_count, program->results) == VM_OK;
+  return program->has_results;
+}
+
+static snek_object_t *result(sneklang_program_t *program, const char *global,
+                             snek_object_kind_t kind) {
+  int slot = program_find_global(program->program, global);
+  if (!program->has_results || slot < 0) {
+    return NULL;
+  }
+
+  snek_object_t *value = program->results[slot];
+  return value != NULL && value->kind == kind ? value : NULL;
+}
+
+bool sneklang_get_int(sneklang_program_t *program, const char *global,
+                      int *value) {
+  snek_object_t *object = result(program, global, INTEGER);
+  if (object == NULL) {
+    return false;
+  }
+  *value = object->data.v_int;
+  return true;
+}
+
+bool sneklang_get_float(sneklang_program_t *program, const char *global,
+                        float *value) {
+  snek_object_t *object = result(program, global, FLOAT);
+  if (object == NULL) {
+    return false;
+  }
+  *value = object->data.v_float;
+  return true;
+}
+
+const char *sneklang_get_string(sneklang_program_t *program,
+                                const char *global) {
+  snek_object_t *object = result(program, global, STRING);
+  return object != NULL ? snek_string_cstr(object) : NULL;
+}
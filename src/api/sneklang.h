@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Embedding API, built into libsneklang.a and libsneklang.so by `make lib`.
+//
+// A VM is created once and reused: its value stack, call stack and object
+// heap persist between runs, so a run only allocates what the script itself
+// creates. A program is compiled once and can be run any number of times,
+// on any VM, with different inputs each time.
+//
+//   const char *inputs[] = {"n"};
+//   sneklang_program_t *program =
+//       sneklang_compile("total: int = n * 2\n", inputs, 1);
+//   sneklang_vm_t *vm = sneklang_vm_new();
+//   sneklang_bind_int(program, "n", 21);
+//   if (sneklang_run(vm, program)) {
+//     int total;
+//     sneklang_get_int(program, "total", &total); // 42
+//   }
+//
+// Handles aren't thread safe; use one VM per thread. Compile and runtime
+// errors are reported on stderr, as they are by the sneklang command.
+
+typedef struct VirtualMachine sneklang_vm_t;
+typedef struct SneklangProgram sneklang_program_t;
+
+sneklang_vm_t *sneklang_vm_new(void);
+void sneklang_vm_free(sneklang_vm_t *vm);
+// Where `print` writes, stdout by default
+void sneklang_vm_set_output(sneklang_vm_t *vm, FILE *out);
+// Writes the VM's heap counters as JSON: objects and bytes allocated by kind,
+// collections, objects freed, mark and sweep time, the longest pause, and
+// the live and peak heap. Returns false if `out` couldn't be written.
+bool sneklang_vm_write_gc_stats(sneklang_vm_t *vm, FILE *out);
+// Starts keeping the VM's last `events` trace points: allocations, calls,
+// and collections with their phases. Returns false if the library was built
+// without trace points (make TRACE=1) or the VM is already traced.
+bool sneklang_vm_trace(sneklang_vm_t *vm, size_t events);
+// Writes the kept events as Chrome trace-event JSON, which chrome://tracing
+// and Perfetto load. Safe while another thread runs the VM; the programs it
+// ran must not be freed. Returns false if the VM isn't traced or `out`
+// couldn't be written.
+bool sneklang_vm_write_trace(sneklang_vm_t *vm, FILE *out);
+
+// Compiles `source`. `inputs` names globals the script may read without
+// declaring them; they are null until bound. Returns NULL if the source
+// doesn't compile or an input name is repeated.
+sneklang_program_t *sneklang_compile(const char *source,
+                                     const char *const *inputs,
+                                     size_t input_count);
+void sneklang_program_free(sneklang_program_t *program);
+
+// Sets the value `input` has at the start of every following run. Returns
+// false if `input` wasn't passed to sneklang_compile.
+bool sneklang_bind_int(sneklang_program_t *program, const char *input,
+                       int value);
+bool sneklang_bind_float(sneklang_program_t *program, const char *input,
+                         float value);
+bool sneklang_bind_string(sneklang_program_t *program, const char *input,
+                          const char *value);
+bool sneklang_bind_null(sneklang_program_t *program, const char *input);
+
+// Runs the program from the top. Returns false on a runtime error.
+bool sneklang_run(sneklang_vm_t *vm, sneklang_program_t *program);
+
+// Read the value a global had when the last successful run finished. They
+// return false (or NULL) if there is no such global or it holds another
+// type. Results stay valid until the VM runs again or the program's inputs
+// are rebound.
+bool sneklang_get_int(sneklang_program_t *program, const char *global,
+                      int *value);
+bool sneklang_get_float(sneklang_program_t *program, const char *global,
+                        float *value);
+const char *sneklang_get_string(sneklang_program_t *program,
+                                const char *global);
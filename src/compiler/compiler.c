@@ -0,0 +1,709 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../objects/sneknew.h"
+#include "compiler.h"
+
+static void compile_statement(compiler_t *compiler, ast_node_t *node);
+static void compile_expression(compiler_t *compiler, ast_node_t *node);
+
+static void compile_error(compiler_t *compiler, ast_node_t *node,
+                          const char *message, const char *name) {
+  fprintf(stderr, "Compile Error: %s '%s' on line %d\n", message, name,
+          node->line);
+  compiler->had_error = true;
+}
+
+static chunk_t *current_chunk(compiler_t *compiler) {
+  return &compiler->function->chunk;
+}
+
+static void emit_byte(compiler_t *compiler, uint8_t byte, int line) {
+  chunk_write(current_chunk(compiler), byte, line);
+}
+
+static void emit_short(compiler_t *compiler, uint16_t value, int line) {
+  chunk_write_short(current_chunk(compiler), value, line);
+}
+
+// Emits a forward jump with a placeholder offset and returns the offset of
+// its operand, for patch_jump
+static size_t emit_jump(compiler_t *compiler, opcode_t op, int line) {
+  emit_byte(compiler, op, line);
+  emit_short(compiler, UINT16_MAX, line);
+  return current_chunk(compiler)->count - 2;
+}
+
+// Points the jump whose operand is at `operand` to the next instruction
+static void patch_jump(compiler_t *compiler, size_t operand) {
+  chunk_t *chunk = current_chunk(compiler);
+  size_t distance = chunk->count - operand - 2;
+
+  if (distance > UINT16_MAX) {
+    fprintf(stderr, "Compile Error: Too much code to jump over in '%s'\n",
+            compiler->function->name);
+    compiler->had_error = true;
+    return;
+  }
+
+  chunk->code[operand] = (distance >> 8) & 0xff;
+  chunk->code[operand + 1] = distance & 0xff;
+  compiler->jump_target = chunk->count;
+}
+
+// Loop headers are the targets of backward jumps
+static size_t loop_header(compiler_t *compiler) {
+  compiler->jump_target = current_chunk(compiler)->count;
+  return compiler->jump_target;
+}
+
+static void emit_loop(compiler_t *compiler, size_t target, int line) {
+  emit_byte(compiler, OP_LOOP, line);
+
+  size_t distance = current_chunk(compiler)->count + 2 - target;
+  if (distance > UINT16_MAX) {
+    fprintf(stderr, "Compile Error: Loop body too large in '%s'\n",
+            compiler->function->name);
+    compiler->had_error = true;
+  }
+  emit_short(compiler, (uint16_t)distance, line);
+}
+
+static void patch_jumps(compiler_t *compiler, stack_t *operands) {
+  for (size_t i = 0; i < operands->count; i++) {
+    patch_jump(compiler, (size_t)(uintptr_t)operands->data[i]);
+  }
+}
+
+// Reuses an equal integer or float constant if the chunk already has one.
+static void emit_constant(compiler_t *compiler, snek_object_t *constant,
+                          int line) {
+  chunk_t *chunk = current_chunk(compiler);
+  int index = -1;
+
+  for (size_t i = 0; i < chunk->constants->count && index < 0; i++) {
+    snek_object_t *existing = chunk->constants->data[i];
+    if (existing->kind != constant->kind) {
+      continue;
+    }
+    if ((constant->kind == INTEGER &&
+         existing->data.v_int == constant->data.v_int) ||
+        (constant->kind == FLOAT &&
+         existing->data.v_float == constant->data.v_float)) {
+      index = (int)i;
+    }
+  }
+
+  if (index >= 0) {
+    snek_object_free(constant);
+  } else {
+    index = chunk_add_constant(chunk, constant);
+  }
+
+  if (index > UINT16_MAX) {
+    fprintf(stderr, "Compile Error: Too many constants in '%s'\n",
+            compiler->function->name);
+    compiler->had_error = true;
+    return;
+  }
+
+  emit_byte(compiler, OP_CONSTANT, line);
+  emit_short(compiler, (uint16_t)index, line);
+}
+
+static int resolve_local(compiler_t *compiler, const char *name) {
+  for (int i = compiler->local_count - 1; i >= 0; i--) {
+    if (strcmp(compiler->locals[i], name) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+// A name may be declared again once the block that declared it has ended,
+// so sibling blocks (say, two loops) can each declare their own `i`, but
+// not while it's still in scope. In the script, block locals can't shadow
+// globals either.
+static int add_local(compiler_t *compiler, ast_node_t *node, char *name) {
+  if (resolve_local(compiler, name) >= 0 ||
+      (compiler->is_top_level &&
+       program_find_global(compiler->program, name) >= 0)) {
+    compile_error(compiler, node, "Redeclaration of", name);
+    return -1;
+  }
+
+  if (compiler->local_count == MAX_LOCALS) {
+    compile_error(compiler, node, "Too many local variables at", name);
+    return -1;
+  }
+
+  compiler->locals[compiler->local_count] = name;
+  compiler->local_depths[compiler->local_count] = compiler->scope_depth;
+  int slots = compiler->first_slot + compiler->local_count + 1;
+  if (slots > compiler->function->local_count) {
+    compiler->function->local_count = slots;
+  }
+  return compiler->local_count++;
+}
+
+static void begin_scope(compiler_t *compiler) { compiler->scope_depth++; }
+
+// Drops the locals of the block being left. Their slots are reused by the
+// next block's.
+static void end_scope(compiler_t *compiler) {
+  compiler->scope_depth--;
+  while (compiler->local_count > 0 &&
+         compiler->local_depths[compiler->local_count - 1] >
+             compiler->scope_depth) {
+    compiler->local_count--;
+  }
+}
+
+static void emit_store(compiler_t *compiler, opcode_t op, int slot,
+                       int line) {
+  emit_byte(compiler, op, line);
+  if (op == OP_SET_LOCAL) {
+    emit_byte(compiler, (uint8_t)slot, line);
+  } else {
+    emit_short(compiler, (uint16_t)slot, line);
+  }
+  compiler->store_end = current_chunk(compiler)->count;
+}
+
+// Turns `SET x; GET x` into `DUP; SET x`, so a value that was just stored
+// is reused from the stack instead of being loaded again. Only done when
+// the load isn't a jump target, since another path could reach it without
+// going through the store. Returns true if the load was replaced.
+static bool reuse_stored_value(compiler_t *compiler, opcode_t set, int slot,
+                               int line) {
+  chunk_t *chunk = current_chunk(compiler);
+  size_t size = instruction_size(set);
+
+  if (!compiler->optimize || compiler->store_end != chunk->count ||
+      compiler->jump_target == chunk->count || chunk->count < size) {
+    return false;
+  }
+
+  size_t store = chunk->count - size;
+  int stored = set == OP_SET_LOCAL ? chunk->code[store + 1]
+                                   : (chunk->code[store + 1] << 8) |
+                                         chunk->code[store + 2];
+  if (chunk->code[store] != set || stored != slot) {
+    return false;
+  }
+
+  chunk_write(chunk, 0, line);
+  memmove(&chunk->code[store + 1], &chunk->code[store], size);
+  memmove(&chunk->lines[store + 1], &chunk->lines[store], size * sizeof(int));
+  chunk->code[store] = OP_DUP;
+  compiler->store_end = chunk->count;
+
+  if (compiler->report != NULL) {
+    compiler->report->loads_eliminated++;
+  }
+  return true;
+}
+
+static void emit_slot_access(compiler_t *compiler, opcode_t get,
+                             opcode_t set, int slot, bool store, int line) {
+  if (store) {
+    emit_store(compiler, set, slot, line);
+  } else if (!reuse_stored_value(compiler, set, slot, line)) {
+    emit_byte(compiler, get, line);
+    if (get == OP_GET_LOCAL) {
+      emit_byte(compiler, (uint8_t)slot, line);
+    } else {
+      emit_short(compiler, (uint16_t)slot, line);
+    }
+  }
+}
+
+// Emits a load or store of `name`, which is either a local in scope or a
+// global (a slot of the top-level frame). The script's own block locals live
+// in its frame too, so they're reached like globals.
+static void emit_variable(compiler_t *compiler, ast_node_t *node, char *name,
+                          bool store) {
+  int local = resolve_local(compiler, name);
+  if (local >= 0) {
+    int slot = compiler->first_slot + local;
+    if (compiler->is_top_level) {
+      emit_slot_access(compiler, OP_GET_GLOBAL, OP_SET_GLOBAL, slot, store,
+                       node->line);
+    } else {
+      emit_slot_access(compiler, OP_GET_LOCAL, OP_SET_LOCAL, slot, store,
+                       node->line);
+    }
+    return;
+  }
+
+  int slot = program_find_global(compiler->program, name);
+  if (slot < 0) {
+    compile_error(compiler, node, "Undefined variable", name);
+    return;
+  }
+  emit_slot_access(compiler, OP_GET_GLOBAL, OP_SET_GLOBAL, slot, store,
+                   node->line);
+}
+
+// Value a declaration without an initializer starts with
+static void emit_default_value(compiler_t *compiler, ast_node_t *node) {
+  char *type = node->declaration.type;
+  if (strcmp(type, "int") == 0 || strcmp(type, "bool") == 0) {
+    emit_constant(compiler, new_snek_integer(NULL, 0), node->line);
+  } else if (strcmp(type, "float") == 0) {
+    emit_constant(compiler, new_snek_float(NULL, 0), node->line);
+  } else if (strcmp(type, "string") == 0) {
+    emit_constant(compiler, new_snek_string(NULL, ""), node->line);
+  } else {
+    emit_byte(compiler, OP_NIL, node->line);
+  }
+}
+
+static bool is_builtin_print(compiler_t *compiler, ast_node_t *call) {
+  return strcmp(call->call.name, "print") == 0 &&
+         program_find_function(compiler->program, "print") < 0;
+}
+
+// Compiles the arguments of a call to a user-defined function and returns
+// the function's index, or -1 on error.
+static int compile_call_arguments(compiler_t *compiler, ast_node_t *node) {
+  int index = program_find_function(compiler->program, node->call.name);
+  if (index < 0) {
+    compile_error(compiler, node, "Undefined function", node->call.name);
+    return -1;
+  }
+
+  function_t *callee = compiler->program->functions->data[index];
+  if (callee->arity != node->call.args.count) {
+    fprintf(stderr,
+            "Compile Error: '%s' expects %d arguments but got %d on line %d\n",
+            callee->name, callee->arity, node->call.args.count, node->line);
+    compiler->had_error = true;
+    return -1;
+  }
+
+  for (int i = 0; i < node->call.args.count; i++) {
+    compile_expression(compiler, node->call.args.nodes[i]);
+  }
+  return index;
+}
+
+static void compile_call(compiler_t *compiler, ast_node_t *node,
+                         opcode_t op) {
+  if (node->call.args.count > UINT8_MAX) {
+    compile_error(compiler, node, "Too many arguments in call to",
+                  node->call.name);
+    return;
+  }
+
+  if (is_builtin_print(compiler, node)) {
+    for (int i = 0; i < node->call.args.count; i++) {
+      compile_expression(compiler, node->call.args.nodes[i]);
+    }
+    emit_byte(compiler, OP_PRINT, node->line);
+    emit_byte(compiler, (uint8_t)node->call.args.count, node->line);
+    return;
+  }
+
+  int index = compile_call_arguments(compiler, node);
+  if (index < 0) {
+    return;
+  }
+
+  emit_byte(compiler, op, node->line);
+  emit_short(compiler, (uint16_t)index, node->line);
+  emit_byte(compiler, (uint8_t)node->call.args.count, node->line);
+}
+
+static opcode_t binary_opcode(token_type_t op) {
+  switch (op) {
+  case TOKEN_PLUS:
+    return OP_ADD;
+  case TOKEN_MINUS:
+    return OP_SUBTRACT;
+  case TOKEN_STAR:
+    return OP_MULTIPLY;
+  case TOKEN_SLASH:
+    return OP_DIVIDE;
+  case TOKEN_EQUAL_EQUAL:
+    return OP_EQUAL;
+  case TOKEN_BANG_EQUAL:
+    return OP_NOT_EQUAL;
+  case TOKEN_LESS:
+    return OP_LESS;
+  case TOKEN_LESS_EQUAL:
+    return OP_LESS_EQUAL;
+  case TOKEN_GREATER:
+    return OP_GREATER;
+  default:
+    return OP_GREATER_EQUAL;
+  }
+}
+
+// `a and b` is `a` if it is falsy, otherwise `b`; `or` is the reverse. The
+// right operand is only evaluated when needed.
+static void compile_logical(compiler_t *compiler, ast_node_t *node) {
+  compile_expression(compiler, node->binary_op.left);
+  size_t skip = emit_jump(compiler,
+                          node->binary_op.op == TOKEN_AND
+                              ? OP_JUMP_IF_FALSE_OR_POP
+                              : OP_JUMP_IF_TRUE_OR_POP,
+                          node->line);
+  compile_expression(compiler, node->binary_op.right);
+  patch_jump(compiler, skip);
+}
+
+static void compile_expression(compiler_t *compiler, ast_node_t *node) {
+  switch (node->type) {
+  case NODE_LITERAL:
+    if (node->literal.kind == TOKEN_NULL_KEYWORD) {
+      emit_byte(compiler, OP_NIL, node->line);
+    } else if (node->literal.kind == TOKEN_FLOAT) {
+      emit_constant(compiler,
+                    new_snek_float(NULL, (float)node->literal.floating),
+                    node->line);
+    } else if (node->literal.kind == TOKEN_STRING) {
+      emit_constant(compiler, new_snek_string(NULL, node->literal.string),
+                    node->line);
+    } else {
+      emit_constant(compiler, new_snek_integer(NULL, node->literal.value),
+                    node->line);
+    }
+    break;
+  case NODE_VARIABLE:
+    emit_variable(compiler, node, node->variable.name, false);
+    break;
+  case NODE_BINARY_OP:
+    if (node->binary_op.op == TOKEN_AND || node->binary_op.op == TOKEN_OR) {
+      compile_logical(compiler, node);
+      break;
+    }
+
+    compile_expression(compiler, node->binary_op.left);
+    compile_expression(compiler, node->binary_op.right);
+    emit_byte(compiler, binary_opcode(node->binary_op.op), node->line);
+    break;
+  case NODE_UNARY_OP:
+    compile_expression(compiler, node->unary_op.operand);
+    emit_byte(compiler,
+              node->unary_op.op == TOKEN_MINUS ? OP_NEGATE : OP_NOT,
+              node->line);
+    break;
+  case NODE_CALL:
+    compile_call(compiler, node, OP_CALL);
+    break;
+  default:
+    compile_error(compiler, node, "Expected an expression", "");
+    break;
+  }
+}
+
+static void compile_return(compiler_t *compiler, ast_node_t *node) {
+  if (compiler->is_top_level) {
+    compile_error(compiler, node, "Unexpected", "return");
+    return;
+  }
+
+  ast_node_t *value = node->return_stmt.value;
+  if (value == NULL) {
+    emit_byte(compiler, OP_NIL, node->line);
+    emit_byte(compiler, OP_RETURN, node->line);
+    return;
+  }
+
+  // `return f(...)` reuses the current frame, so tail recursion runs in
+  // constant stack space
+  if (value->type == NODE_CALL && !is_builtin_print(compiler, value)) {
+    compile_call(compiler, value, OP_TAIL_CALL);
+    return;
+  }
+
+  compile_expression(compiler, value);
+  emit_byte(compiler, OP_RETURN, node->line);
+}
+
+static void compile_block(compiler_t *compiler, ast_node_list_t *block) {
+  begin_scope(compiler);
+  for (int i = 0; i < block->count; i++) {
+    compile_statement(compiler, block->nodes[i]);
+  }
+  end_scope(compiler);
+}
+
+static void compile_if(compiler_t *compiler, ast_node_t *node) {
+  compile_expression(compiler, node->if_stmt.condition);
+  size_t skip_then = emit_jump(compiler, OP_JUMP_IF_FALSE, node->line);
+  compile_block(compiler, &node->if_stmt.then_branch);
+
+  if (node->if_stmt.else_branch.count == 0) {
+    patch_jump(compiler, skip_then);
+    return;
+  }
+
+  size_t skip_else = emit_jump(compiler, OP_JUMP, node->line);
+  patch_jump(compiler, skip_then);
+  compile_block(compiler, &node->if_stmt.else_branch);
+  patch_jump(compiler, skip_else);
+}
+
+static void begin_loop(compiler_t *compiler, loop_t *loop,
+                       long continue_target) {
+  loop->enclosing = compiler->loop;
+  loop->continue_target = continue_target;
+  loop->breaks = stack_new(4);
+  loop->continues = stack_new(4);
+  compiler->loop = loop;
+}
+
+static void end_loop(compiler_t *compiler, loop_t *loop) {
+  patch_jumps(compiler, loop->breaks);
+  stack_free(loop->breaks);
+  stack_free(loop->continues);
+  compiler->loop = loop->enclosing;
+}
+
+// header: condition, JUMP_IF_FALSE exit, body, LOOP header
+static void compile_while(compiler_t *compiler, ast_node_t *node) {
+  size_t header = loop_header(compiler);
+  loop_t loop;
+  begin_loop(compiler, &loop, (long)header);
+
+  compile_expression(compiler, node->while_stmt.condition);
+  size_t exit = emit_jump(compiler, OP_JUMP_IF_FALSE, node->line);
+  compile_block(compiler, &node->while_stmt.body);
+  emit_loop(compiler, header, node->line);
+
+  patch_jump(compiler, exit);
+  end_loop(compiler, &loop);
+}
+
+// init, header: condition, JUMP_IF_FALSE exit, body, step, LOOP header.
+// The init's variable is scoped to the loop.
+static void compile_for(compiler_t *compiler, ast_node_t *node) {
+  begin_scope(compiler);
+  if (node->for_stmt.init != NULL) {
+    compile_statement(compiler, node->for_stmt.init);
+  }
+
+  size_t header = loop_header(compiler);
+  loop_t loop;
+  begin_loop(compiler, &loop, -1);
+
+  bool has_exit = node->for_stmt.condition != NULL;
+  size_t exit = 0;
+  if (has_exit) {
+    compile_expression(compiler, node->for_stmt.condition);
+    exit = emit_jump(compiler, OP_JUMP_IF_FALSE, node->line);
+  }
+
+  compile_block(compiler, &node->for_stmt.body);
+  patch_jumps(compiler, loop.continues);
+  if (node->for_stmt.step != NULL) {
+    compile_statement(compiler, node->for_stmt.step);
+  }
+  emit_loop(compiler, header, node->line);
+
+  if (has_exit) {
+    patch_jump(compiler, exit);
+  }
+  end_loop(compiler, &loop);
+  end_scope(compiler);
+}
+
+static void compile_loop_jump(compiler_t *compiler, ast_node_t *node) {
+  loop_t *loop = compiler->loop;
+  bool is_break = node->type == NODE_BREAK;
+
+  if (loop == NULL) {
+    compile_error(compiler, node, "Outside of a loop:",
+                  is_break ? "break" : "continue");
+    return;
+  }
+
+  if (is_break) {
+    size_t operand = emit_jump(compiler, OP_JUMP, node->line);
+    stack_push(loop->breaks, (void *)(uintptr_t)operand);
+  } else if (loop->continue_target >= 0) {
+    emit_loop(compiler, (size_t)loop->continue_target, node->line);
+  } else {
+    size_t operand = emit_jump(compiler, OP_JUMP, node->line);
+    stack_push(loop->continues, (void *)(uintptr_t)operand);
+  }
+}
+
+static void compile_statement(compiler_t *compiler, ast_node_t *node) {
+  switch (node->type) {
+  case NODE_IF:
+    compile_if(compiler, node);
+    break;
+  case NODE_WHILE:
+    compile_while(compiler, node);
+    break;
+  case NODE_FOR:
+    compile_for(compiler, node);
+    break;
+  case NODE_BREAK:
+  case NODE_CONTINUE:
+    compile_loop_jump(compiler, node);
+    break;
+  case NODE_BLOCK:
+    compile_block(compiler, &node->block.statements);
+    break;
+  case NODE_DECLARATION: {
+    if (node->declaration.value != NULL) {
+      compile_expression(compiler, node->declaration.value);
+    } else {
+      emit_default_value(compiler, node);
+    }
+
+    // The script's own declarations are its globals
+    if (compiler->is_top_level && compiler->scope_depth == 0) {
+      emit_variable(compiler, node, node->declaration.name, true);
+      break;
+    }
+
+    if (add_local(compiler, node, node->declaration.name) >= 0) {
+      emit_variable(compiler, node, node->declaration.name, true);
+    }
+    break;
+  }
+  case NODE_ASSIGNMENT:
+    compile_expression(compiler, node->assignment.value);
+    emit_variable(compiler, node, node->assignment.name, true);
+    break;
+  case NODE_RETURN:
+    compile_return(compiler, node);
+    break;
+  case NODE_FUNCTION:
+    compile_error(compiler, node, "Nested function definition",
+                  node->function.name);
+    break;
+  default:
+    compile_expression(compiler, node);
+    emit_byte(compiler, OP_POP, node->line);
+    break;
+  }
+}
+
+static bool compile_function(program_t *program, ast_node_t *node,
+                             compile_options_t *options) {
+  function_t *function =
+      program->functions->data[program_find_function(program,
+                                                     node->function.name)];
+  compiler_t compiler = {.program = program,
+                         .function = function,
+                         .optimize = options->optimize,
+                         .report = options->report};
+
+  for (int i = 0; i < node->function.param_count; i++) {
+    add_local(&compiler, node, node->function.param_names[i]);
+  }
+
+  for (int i = 0; i < node->function.body.count; i++) {
+    compile_statement(&compiler, node->function.body.nodes[i]);
+  }
+
+  // Falling off the end returns null
+  emit_byte(&compiler, OP_NIL, node->line);
+  emit_byte(&compiler, OP_RETURN, node->line);
+  return !compiler.had_error;
+}
+
+// Registers every top-level function and global first, so code may refer to
+// functions and globals defined further down the script.
+static bool declare_top_level(program_t *program, ast_root_t *root) {
+  for (int i = 0; i < root->count; i++) {
+    ast_node_t *node = root->nodes[i];
+
+    // Declarations nested in blocks are scoped to them
+    if (node->type == NODE_DECLARATION) {
+      if (program_find_global(program, node->declaration.name) >= 0) {
+        fprintf(stderr, "Compile Error: Redeclaration of '%s' on line %d\n",
+                node->declaration.name, node->line);
+        return false;
+      }
+      stack_push(program->global_names, strdup(node->declaration.name));
+      continue;
+    }
+    if (node->type != NODE_FUNCTION) {
+      continue;
+    }
+
+    if (program_find_function(program, node->function.name) >= 0) {
+      fprintf(stderr, "Compile Error: Redefinition of '%s' on line %d\n",
+              node->function.name, node->line);
+      return false;
+    }
+    stack_push(program->functions,
+               function_new(node->function.name, node->function.param_count));
+  }
+
+  // Block locals of the script take slots past the globals
+  if (program->global_names->count + MAX_LOCALS > UINT16_MAX + 1 ||
+      program->functions->count > UINT16_MAX) {
+    fprintf(stderr, "Compile Error: Too many globals or functions\n");
+    return false;
+  }
+
+  return true;
+}
+
+program_t *compile(ast_root_t *root) {
+  compile_options_t options = {.optimize = true};
+  return compile_with_options(root, &options);
+}
+
+program_t *compile_with_options(ast_root_t *root, compile_options_t *options) {
+  if (options->optimize) {
+    optimize(root, options->report);
+  }
+
+  program_t *program = program_new();
+  if (program == NULL) {
+    return NULL;
+  }
+
+  function_t *script = function_new("<script>", 0);
+  stack_push(program->functions, script);
+  for (size_t i = 0; i < options->input_count; i++) {
+    stack_push(program->global_names, strdup(options->inputs[i]));
+  }
+
+  if (!declare_top_level(program, root)) {
+    program_free(program);
+    return NULL;
+  }
+  script->local_count = (int)program->global_names->count;
+
+  compiler_t compiler = {.program = program,
+                         .function = script,
+                         .first_slot = script->local_count,
+                         .is_top_level = true,
+                         .optimize = options->optimize,
+                         .report = options->report};
+  bool ok = true;
+  int last_line = 0;
+
+  for (int i = 0; i < root->count; i++) {
+    ast_node_t *node = root->nodes[i];
+    last_line = node->line;
+
+    if (node->type == NODE_FUNCTION) {
+      ok = compile_function(program, node, options) && ok;
+    } else {
+      compile_statement(&compiler, node);
+    }
+  }
+
+  emit_byte(&compiler, OP_NIL, last_line);
+  emit_byte(&compiler, OP_RETURN, last_line);
+
+  if (!ok || compiler.had_error) {
+    program_free(program);
+    return NULL;
+  }
+
+  return program;
+}
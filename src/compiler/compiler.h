@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../parser/parser.h"
+#include "../vm/bytecode.h"
+#include "optimizer.h"
+
+#define MAX_LOCALS 256
+
+// The innermost loop being compiled. `break` (and `continue` in a `for`,
+// whose step comes after the body) jump forwards, so their operands are
+// patched once the target is known.
+typedef struct Loop {
+  struct Loop *enclosing;
+  long continue_target; // Offset `continue` loops back to, -1 if forward
+  stack_t *breaks;      // Operand offsets of `break` jumps
+  stack_t *continues;   // Operand offsets of forward `continue` jumps
+} loop_t;
+
+typedef struct Compiler {
+  program_t *program;
+  function_t *function;     // Function being compiled
+  char *locals[MAX_LOCALS]; // Names in scope, borrowed from the AST
+  int local_depths[MAX_LOCALS]; // Block depth each local was declared at
+  int local_count;
+  int scope_depth; // Blocks entered; 0 is the function body or the script
+  int first_slot;  // Frame slot of locals[0]. The script's block locals come
+                   // after its globals.
+  loop_t *loop;      // Innermost enclosing loop, NULL outside loops
+  bool is_top_level; // Compiling the script body rather than a `def`
+  bool had_error;
+  bool optimize;
+  opt_report_t *report; // May be NULL
+  size_t store_end;     // Offset just past the last variable store
+  size_t jump_target;   // Offset of the last jump target or loop header
+} compiler_t;
+
+typedef struct CompileOptions {
+  bool optimize;        // Run the loop optimizer and the peephole pass
+  opt_report_t *report; // Collects what the optimizer did, may be NULL
+  // Globals the host sets before each run (see vm_run_with_globals). They
+  // take the first slots, so scripts can use them without declaring them.
+  const char *const *inputs;
+  size_t input_count;
+} compile_options_t;
+
+// Compiles a parsed script into bytecode, with optimizations on. Returns NULL
+// (after reporting the errors on stderr) if the script is invalid.
+program_t *compile(ast_root_t *root);
+
+// Like compile, but optimizing rewrites `root` in place first.
+program_t *compile_with_options(ast_root_t *root, compile_options_t *options);
@@ -0,0 +1,1172 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "emit_c.h"
+
+// How a variable, parameter or result is held in the generated C
+typedef enum {
+  REP_INT,   // C int, also used for bools
+  REP_FLOAT, // C float
+  REP_BOXED, // snek_object_t * on the value stack
+} rep_t;
+
+typedef struct CVariable {
+  char *name; // Borrowed from the AST
+  rep_t rep;
+  bool is_global;
+  int slot; // Value stack slot when boxed, from the frame base for locals
+} c_variable_t;
+
+typedef struct CFunction {
+  ast_node_t *node; // NULL for the script
+  const char *name; // As reported in runtime errors
+  stack_t *locals;  // c_variable_t *, parameters first
+  int param_count;
+  int boxed_params; // Pushed by the caller, in order, before the call
+  int boxed_slots;  // Boxed parameters and locals
+  rep_t result;
+} c_function_t;
+
+typedef struct Emitter {
+  FILE *out;
+  stack_t *functions; // c_function_t *, in definition order
+  stack_t *globals;   // c_variable_t *
+  stack_t *constants; // char *, string literals, borrowed from the AST
+  c_function_t script;
+  c_function_t *function; // Function being walked
+  int visible;            // Locals of `function` declared so far
+  bool changed;           // The analysis boxed something
+  int indent;
+  int temp_count; // Names the C temporaries of nested expressions
+  int loop;       // Label number of the innermost loop
+  int loop_count;
+  bool continued; // The innermost loop has a `continue`
+} emitter_t;
+
+static rep_t annotation_rep(const char *type) {
+  if (type != NULL && (strcmp(type, "int") == 0 || strcmp(type, "bool") == 0)) {
+    return REP_INT;
+  }
+  if (type != NULL && strcmp(type, "float") == 0) {
+    return REP_FLOAT;
+  }
+  return REP_BOXED;
+}
+
+static const char *rep_type(rep_t rep) {
+  return rep == REP_INT ? "int" : rep == REP_FLOAT ? "float" : "void";
+}
+
+/// Names
+// Each name is one variable per function, and one global in the script.
+// The bytecode compiler scopes declarations to their blocks, but it has
+// already rejected any program where that differs: a name is never declared
+// while another declaration of it is in scope, so sibling blocks declaring
+// the same name can share its variable. A function's local is only visible
+// after its first declaration, and everything else is a global.
+
+static c_variable_t *find_variable(stack_t *variables, int count,
+                                   const char *name) {
+  for (int i = 0; i < count; i++) {
+    c_variable_t *variable = variables->data[i];
+    if (strcmp(variable->name, name) == 0) {
+      return variable;
+    }
+  }
+  return NULL;
+}
+
+static c_variable_t *add_variable(stack_t *variables, char *name, rep_t rep,
+                                  bool is_global) {
+  c_variable_t *existing =
+      find_variable(variables, (int)variables->count, name);
+  if (existing != NULL) {
+    return existing;
+  }
+
+  c_variable_t *variable = calloc(1, sizeof(c_variable_t));
+  if (variable == NULL) {
+    exit(1);
+  }
+  variable->name = name;
+  variable->rep = rep;
+  variable->is_global = is_global;
+  stack_push(variables, variable);
+  return variable;
+}
+
+static c_variable_t *resolve(emitter_t *em, const char *name) {
+  c_variable_t *variable = NULL;
+  if (em->function != &em->script) {
+    variable = find_variable(em->function->locals, em->visible, name);
+  }
+  if (variable == NULL) {
+    variable = find_variable(em->globals, (int)em->globals->count, name);
+  }
+  return variable;
+}
+
+// The variable a declaration of `name` stores to. Makes it visible, but only
+// after the value has been resolved.
+static c_variable_t *declared_variable(emitter_t *em, const char *name) {
+  if (em->function == &em->script) {
+    return resolve(em, name);
+  }
+
+  stack_t *locals = em->function->locals;
+  for (int i = 0; i < (int)locals->count; i++) {
+    c_variable_t *local = locals->data[i];
+    if (strcmp(local->name, name) == 0) {
+      return local;
+    }
+  }
+  return NULL;
+}
+
+static void declare(emitter_t *em, const char *name) {
+  if (em->function == &em->script) {
+    return;
+  }
+
+  stack_t *locals = em->function->locals;
+  for (int i = em->visible; i < (int)locals->count; i++) {
+    if (strcmp(((c_variable_t *)locals->data[i])->name, name) == 0) {
+      em->visible = i + 1;
+      return;
+    }
+  }
+}
+
+static c_function_t *find_function(emitter_t *em, const char *name) {
+  for (size_t i = 0; i < em->functions->count; i++) {
+    c_function_t *function = em->functions->data[i];
+    if (strcmp(function->name, name) == 0) {
+      return function;
+    }
+  }
+  return NULL;
+}
+
+static bool is_builtin_print(emitter_t *em, ast_node_t *call) {
+  return strcmp(call->call.name, "print") == 0 &&
+         find_function(em, "print") == NULL;
+}
+
+/// Collecting Declarations
+
+typedef void (*declaration_fn)(emitter_t *em, ast_node_t *declaration,
+                               void *context);
+
+// Visits declarations in the order the compiler meets them
+static void walk_declarations(emitter_t *em, ast_node_t *node,
+                              declaration_fn visit, void *context);
+
+static void walk_declaration_list(emitter_t *em, ast_node_list_t *list,
+                                  declaration_fn visit, void *context) {
+  for (int i = 0; i < list->count; i++) {
+    walk_declarations(em, list->nodes[i], visit, context);
+  }
+}
+
+static void walk_declarations(emitter_t *em, ast_node_t *node,
+                              declaration_fn visit, void *context) {
+  if (node == NULL) {
+    return;
+  }
+
+  switch (node->type) {
+  case NODE_DECLARATION:
+    visit(em, node, context);
+    break;
+  case NODE_IF:
+    walk_declaration_list(em, &node->if_stmt.then_branch, visit, context);
+    walk_declaration_list(em, &node->if_stmt.else_branch, visit, context);
+    break;
+  case NODE_WHILE:
+    walk_declaration_list(em, &node->while_stmt.body, visit, context);
+    break;
+  case NODE_FOR:
+    walk_declarations(em, node->for_stmt.init, visit, context);
+    walk_declaration_list(em, &node->for_stmt.body, visit, context);
+    break;
+  case NODE_BLOCK:
+    walk_declaration_list(em, &node->block.statements, visit, context);
+    break;
+  default:
+    break;
+  }
+}
+
+static void add_global(emitter_t *em, ast_node_t *declaration, void *context) {
+  (void)context;
+  add_variable(em->globals, declaration->declaration.name,
+               annotation_rep(declaration->declaration.type), true);
+}
+
+static void add_local(emitter_t *em, ast_node_t *declaration, void *context) {
+  (void)em;
+  c_function_t *function = context;
+  add_variable(function->locals, declaration->declaration.name,
+               annotation_rep(declaration->declaration.type), false);
+}
+
+// A native result needs every path to return a value, which is easiest to
+// be sure of when the body ends with a `return`
+static rep_t result_rep(ast_node_t *node) {
+  ast_node_list_t *body = &node->function.body;
+  if (body->count == 0) {
+    return REP_BOXED;
+  }
+
+  ast_node_t *last = body->nodes[body->count - 1];
+  if (last->type != NODE_RETURN || last->return_stmt.value == NULL) {
+    return REP_BOXED;
+  }
+  return annotation_rep(node->function.return_type);
+}
+
+static c_function_t *function_new(ast_node_t *node) {
+  c_function_t *function = calloc(1, sizeof(c_function_t));
+  if (function == NULL) {
+    exit(1);
+  }
+
+  function->node = node;
+  function->name = node->function.name;
+  function->locals = stack_new(8);
+  function->param_count = node->function.param_count;
+  function->result = result_rep(node);
+
+  for (int i = 0; i < node->function.param_count; i++) {
+    add_variable(function->locals, node->function.param_names[i],
+                 annotation_rep(node->function.param_types[i]), false);
+  }
+  return function;
+}
+
+static void free_variables(stack_t *variables) {
+  for (size_t i = 0; i < variables->count; i++) {
+    free(variables->data[i]);
+  }
+  stack_free(variables);
+}
+
+/// Analysis
+// Starts from the annotations and boxes whatever receives a value of another
+// type, until nothing changes.
+
+static void demote(emitter_t *em, rep_t *rep, rep_t value) {
+  if (*rep != REP_BOXED && *rep != value) {
+    *rep = REP_BOXED;
+    em->changed = true;
+  }
+}
+
+static bool is_comparison(token_type_t op) {
+  return op == TOKEN_EQUAL_EQUAL || op == TOKEN_BANG_EQUAL ||
+         op == TOKEN_LESS || op == TOKEN_LESS_EQUAL || op == TOKEN_GREATER ||
+         op == TOKEN_GREATER_EQUAL;
+}
+
+// Representation of the value of `node`. Also boxes parameters that are
+// passed a value of another type.
+static rep_t infer(emitter_t *em, ast_node_t *node) {
+  switch (node->type) {
+  case NODE_LITERAL:
+    return node->literal.kind == TOKEN_INT     ? REP_INT
+           : node->literal.kind == TOKEN_FLOAT ? REP_FLOAT
+                                               : REP_BOXED;
+  case NODE_VARIABLE:
+    return resolve(em, node->variable.name)->rep;
+  case NODE_BINARY_OP: {
+    rep_t left = infer(em, node->binary_op.left);
+    rep_t right = infer(em, node->binary_op.right);
+    token_type_t op = node->binary_op.op;
+
+    if (left == REP_BOXED || right == REP_BOXED) {
+      return REP_BOXED;
+    }
+    if (op == TOKEN_AND || op == TOKEN_OR) {
+      // The result is one of the operands
+      return left == right ? left : REP_BOXED;
+    }
+    if (is_comparison(op)) {
+      return REP_INT;
+    }
+    return left == REP_INT && right == REP_INT ? REP_INT : REP_FLOAT;
+  }
+  case NODE_UNARY_OP: {
+    rep_t operand = infer(em, node->unary_op.operand);
+    if (operand == REP_BOXED || node->unary_op.op == TOKEN_MINUS) {
+      return operand;
+    }
+    return REP_INT;
+  }
+  case NODE_CALL: {
+    bool print = is_builtin_print(em, node);
+    c_function_t *callee = print ? NULL : find_function(em, node->call.name);
+
+    for (int i = 0; i < node->call.args.count; i++) {
+      rep_t arg = infer(em, node->call.args.nodes[i]);
+      if (callee != NULL) {
+        demote(em, &((c_variable_t *)callee->locals->data[i])->rep, arg);
+      }
+    }
+    return callee != NULL ? callee->result : REP_BOXED;
+  }
+  default:
+    return REP_BOXED;
+  }
+}
+
+static void analyse_statement(emitter_t *em, ast_node_t *node);
+
+static void analyse_list(emitter_t *em, ast_node_list_t *list) {
+  for (int i = 0; i < list->count; i++) {
+    analyse_statement(em, list->nodes[i]);
+  }
+}
+
+static void analyse_statement(emitter_t *em, ast_node_t *node) {
+  if (node == NULL) {
+    return;
+  }
+
+  switch (node->type) {
+  case NODE_DECLARATION: {
+    ast_node_t *value = node->declaration.value;
+    rep_t rep = value != NULL ? infer(em, value)
+                              : annotation_rep(node->declaration.type);
+    declare(em, node->declaration.name);
+    demote(em, &resolve(em, node->declaration.name)->rep, rep);
+    break;
+  }
+  case NODE_ASSIGNMENT: {
+    rep_t rep = infer(em, node->assignment.value);
+    demote(em, &resolve(em, node->assignment.name)->rep, rep);
+    break;
+  }
+  case NODE_IF:
+    infer(em, node->if_stmt.condition);
+    analyse_list(em, &node->if_stmt.then_branch);
+    analyse_list(em, &node->if_stmt.else_branch);
+    break;
+  case NODE_WHILE:
+    infer(em, node->while_stmt.condition);
+    analyse_list(em, &node->while_stmt.body);
+    break;
+  case NODE_FOR:
+    analyse_statement(em, node->for_stmt.init);
+    if (node->for_stmt.condition != NULL) {
+      infer(em, node->for_stmt.condition);
+    }
+    analyse_list(em, &node->for_stmt.body);
+    analyse_statement(em, node->for_stmt.step);
+    break;
+  case NODE_BLOCK:
+    analyse_list(em, &node->block.statements);
+    break;
+  case NODE_RETURN: {
+    ast_node_t *value = node->return_stmt.value;
+    demote(em, &em->function->result,
+           value != NULL ? infer(em, value) : REP_BOXED);
+    break;
+  }
+  case NODE_BREAK:
+  case NODE_CONTINUE:
+    break;
+  default:
+    infer(em, node);
+    break;
+  }
+}
+
+static void enter_function(emitter_t *em, c_function_t *function) {
+  em->function = function;
+  em->visible = function->param_count;
+}
+
+static void analyse(emitter_t *em, ast_root_t *root) {
+  do {
+    em->changed = false;
+
+    for (int i = 0, f = 0; i < root->count; i++) {
+      if (root->nodes[i]->type == NODE_FUNCTION) {
+        enter_function(em, em->functions->data[f++]);
+        analyse_list(em, &root->nodes[i]->function.body);
+      }
+    }
+
+    enter_function(em, &em->script);
+    for (int i = 0; i < root->count; i++) {
+      if (root->nodes[i]->type != NODE_FUNCTION) {
+        analyse_statement(em, root->nodes[i]);
+      }
+    }
+  } while (em->changed);
+}
+
+// Boxed parameters come first in the frame, in order, then boxed locals
+static void assign_slots(emitter_t *em) {
+  int global_slots = 0;
+  for (size_t i = 0; i < em->globals->count; i++) {
+    c_variable_t *global = em->globals->data[i];
+    if (global->rep == REP_BOXED) {
+      global->slot = global_slots++;
+    }
+  }
+  em->script.boxed_slots = global_slots;
+
+  for (size_t i = 0; i < em->functions->count; i++) {
+    c_function_t *function = em->functions->data[i];
+    for (size_t j = 0; j < function->locals->count; j++) {
+      c_variable_t *local = function->locals->data[j];
+      if (local->rep != REP_BOXED) {
+        continue;
+      }
+
+      local->slot = function->boxed_slots++;
+      if ((int)j < function->param_count) {
+        function->boxed_params++;
+      }
+    }
+  }
+}
+
+/// Output
+
+static void emitf(emitter_t *em, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  vfprintf(em->out, format, args);
+  va_end(args);
+}
+
+static void emit_indent(emitter_t *em) {
+  for (int i = 0; i < em->indent; i++) {
+    fputs("  ", em->out);
+  }
+}
+
+static void emit_line(emitter_t *em, const char *format, ...) {
+  emit_indent(em);
+  va_list args;
+  va_start(args, format);
+  vfprintf(em->out, format, args);
+  va_end(args);
+  fputc('\n', em->out);
+}
+
+// `$` temporaries from the optimizer get their own prefix, so they can't
+// clash with a script's names
+static void emit_name(emitter_t *em, c_variable_t *variable) {
+  bool temporary = variable->name[0] == '$';
+  const char *name = temporary ? variable->name + 1 : variable->name;
+
+  if (variable->rep == REP_BOXED) {
+    emitf(em, variable->is_global ? "AOT_SLOTS(vm)[%d]"
+                                  : "AOT_SLOTS(vm)[base + %d]",
+          variable->slot);
+  } else {
+    emitf(em, "%s%s_%s", variable->is_global ? "g" : "v",
+          temporary ? "t" : "", name);
+  }
+}
+
+static int add_constant(emitter_t *em, char *string) {
+  for (size_t i = 0; i < em->constants->count; i++) {
+    if (em->constants->data[i] == string) {
+      return (int)i;
+    }
+  }
+  stack_push(em->constants, string);
+  return (int)em->constants->count - 1;
+}
+
+static void emit_string_literal(emitter_t *em, const char *string) {
+  fputc('"', em->out);
+  for (const unsigned char *c = (const unsigned char *)string; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      emitf(em, "\\%c", *c);
+    } else if (*c == '\n') {
+      emitf(em, "\\n");
+    } else if (*c < 0x20 || *c >= 0x7f) {
+      emitf(em, "\\%03o", *c);
+    } else {
+      fputc(*c, em->out);
+    }
+  }
+  fputc('"', em->out);
+}
+
+/// Expressions
+
+static bool has_call(ast_node_t *node) {
+  switch (node->type) {
+  case NODE_CALL:
+    return true;
+  case NODE_BINARY_OP:
+    return has_call(node->binary_op.left) || has_call(node->binary_op.right);
+  case NODE_UNARY_OP:
+    return has_call(node->unary_op.operand);
+  default:
+    return false;
+  }
+}
+
+static const char *binary_opcode(token_type_t op) {
+  switch (op) {
+  case TOKEN_PLUS:
+    return "OP_ADD";
+  case TOKEN_MINUS:
+    return "OP_SUBTRACT";
+  case TOKEN_STAR:
+    return "OP_MULTIPLY";
+  case TOKEN_SLASH:
+    return "OP_DIVIDE";
+  case TOKEN_EQUAL_EQUAL:
+    return "OP_EQUAL";
+  case TOKEN_BANG_EQUAL:
+    return "OP_NOT_EQUAL";
+  case TOKEN_LESS:
+    return "OP_LESS";
+  case TOKEN_LESS_EQUAL:
+    return "OP_LESS_EQUAL";
+  case TOKEN_GREATER:
+    return "OP_GREATER";
+  default:
+    return "OP_GREATER_EQUAL";
+  }
+}
+
+static const char *c_operator(token_type_t op) {
+  switch (op) {
+  case TOKEN_PLUS:
+    return "+";
+  case TOKEN_MINUS:
+    return "-";
+  case TOKEN_STAR:
+    return "*";
+  case TOKEN_SLASH:
+    return "/";
+  case TOKEN_EQUAL_EQUAL:
+    return "==";
+  case TOKEN_BANG_EQUAL:
+    return "!=";
+  case TOKEN_LESS:
+    return "<";
+  case TOKEN_LESS_EQUAL:
+    return "<=";
+  case TOKEN_GREATER:
+    return ">";
+  default:
+    return ">=";
+  }
+}
+
+static const char *int_helper(token_type_t op) {
+  switch (op) {
+  case TOKEN_PLUS:
+    return "aot_add_int";
+  case TOKEN_MINUS:
+    return "aot_subtract_int";
+  case TOKEN_STAR:
+    return "aot_multiply_int";
+  default:
+    return "aot_divide_int";
+  }
+}
+
+static void emit_native(emitter_t *em, ast_node_t *node, rep_t want);
+static void emit_push(emitter_t *em, ast_node_t *node);
+
+// A native operand, or the temporary it was already evaluated into
+static void emit_operand(emitter_t *em, ast_node_t *node, rep_t want,
+                         int temp) {
+  if (temp < 0) {
+    emit_native(em, node, want);
+  } else if (want == REP_FLOAT && infer(em, node) == REP_INT) {
+    emitf(em, "(float)_a%d", temp);
+  } else {
+    emitf(em, "_a%d", temp);
+  }
+}
+
+static void emit_truthy(emitter_t *em, rep_t rep, int temp) {
+  emitf(em, rep == REP_INT ? "_a%d != 0" : "_a%d != 0.0f", temp);
+}
+
+static void emit_native_binary(emitter_t *em, ast_node_t *node) {
+  ast_node_t *left = node->binary_op.left;
+  ast_node_t *right = node->binary_op.right;
+  token_type_t op = node->binary_op.op;
+  rep_t left_rep = infer(em, left);
+
+  if (op == TOKEN_AND || op == TOKEN_OR) {
+    int temp = em->temp_count++;
+    emitf(em, "({ %s _a%d = ", rep_type(left_rep), temp);
+    emit_native(em, left, left_rep);
+    emitf(em, "; ");
+    emit_truthy(em, left_rep, temp);
+    emitf(em, op == TOKEN_AND ? " ? " : " ? _a%d : ", temp);
+    emit_native(em, right, left_rep);
+    if (op == TOKEN_AND) {
+      emitf(em, " : _a%d", temp);
+    }
+    emitf(em, "; })");
+    return;
+  }
+
+  // C doesn't fix the order operands are evaluated in, so the left one goes
+  // into a temporary first if the right one might call something
+  int temp = -1;
+  if (has_call(left) || has_call(right)) {
+    temp = em->temp_count++;
+    emitf(em, "({ %s _a%d = ", rep_type(left_rep), temp);
+    emit_native(em, left, left_rep);
+    emitf(em, "; ");
+  }
+
+  rep_t operands = left_rep == REP_INT && infer(em, right) == REP_INT
+                       ? REP_INT
+                       : REP_FLOAT;
+  if (operands == REP_INT && !is_comparison(op)) {
+    emitf(em, "%s(", int_helper(op));
+    emit_operand(em, left, REP_INT, temp);
+    emitf(em, ", ");
+    emit_native(em, right, REP_INT);
+    if (op == TOKEN_SLASH) {
+      emitf(em, ", %d, \"%s\"", node->line, em->function->name);
+    }
+    emitf(em, ")");
+  } else {
+    emitf(em, "(");
+    emit_operand(em, left, operands, temp);
+    emitf(em, " %s ", c_operator(op));
+    emit_native(em, right, operands);
+    emitf(em, ")");
+  }
+
+  if (temp >= 0) {
+    emitf(em, "; })");
+  }
+}
+
+// Evaluates the arguments in order, natives into temporaries and boxed ones
+// onto the stack, then calls `callee`
+static void emit_call(emitter_t *em, ast_node_t *node, c_function_t *callee) {
+  int first = em->temp_count;
+  em->temp_count += node->call.args.count;
+
+  for (int i = 0; i < node->call.args.count; i++) {
+    ast_node_t *arg = node->call.args.nodes[i];
+    rep_t rep = ((c_variable_t *)callee->locals->data[i])->rep;
+
+    if (rep == REP_BOXED) {
+      emit_push(em, arg);
+      emitf(em, " ");
+    } else {
+      emitf(em, "%s _a%d = ", rep_type(rep), first + i);
+      emit_native(em, arg, rep);
+      emitf(em, "; ");
+    }
+  }
+
+  emitf(em, "f_%s(", callee->name);
+  bool separate = false;
+  for (int i = 0; i < node->call.args.count; i++) {
+    if (((c_variable_t *)callee->locals->data[i])->rep != REP_BOXED) {
+      emitf(em, separate ? ", _a%d" : "_a%d", first + i);
+      separate = true;
+    }
+  }
+  emitf(em, ");");
+}
+
+// Writes a C expression of type `want` for a node whose representation is
+// REP_INT or REP_FLOAT
+static void emit_native(emitter_t *em, ast_node_t *node, rep_t want) {
+  rep_t rep = infer(em, node);
+  if (rep == REP_INT && want == REP_FLOAT) {
+    emitf(em, "(float)");
+  }
+
+  switch (node->type) {
+  case NODE_LITERAL:
+    if (node->literal.kind == TOKEN_FLOAT) {
+      emitf(em, "(float)%.17g", node->literal.floating);
+    } else {
+      emitf(em, "%d", node->literal.value);
+    }
+    break;
+  case NODE_VARIABLE:
+    emit_name(em, resolve(em, node->variable.name));
+    break;
+  case NODE_BINARY_OP:
+    emit_native_binary(em, node);
+    break;
+  case NODE_UNARY_OP:
+    if (node->unary_op.op == TOKEN_MINUS) {
+      emitf(em, rep == REP_INT ? "aot_negate_int(" : "(-");
+    } else {
+      emitf(em, "(");
+    }
+    emit_native(em, node->unary_op.operand, infer(em, node->unary_op.operand));
+    if (node->unary_op.op != TOKEN_MINUS) {
+      emitf(em, infer(em, node->unary_op.operand) == REP_INT ? " == 0"
+                                                             : " == 0.0f");
+    }
+    emitf(em, ")");
+    break;
+  case NODE_CALL:
+    emitf(em, "({ ");
+    emit_call(em, node, find_function(em, node->call.name));
+    emitf(em, " })");
+    break;
+  default:
+    break;
+  }
+}
+
+// Writes statements that push the value of `node` onto the value stack
+static void emit_push(emitter_t *em, ast_node_t *node) {
+  rep_t rep = infer(em, node);
+  if (rep != REP_BOXED) {
+    emitf(em, rep == REP_INT ? "AOT_PUSH(vm, new_snek_integer(vm, "
+                             : "AOT_PUSH(vm, new_snek_float(vm, ");
+    emit_native(em, node, rep);
+    emitf(em, "));");
+    return;
+  }
+
+  switch (node->type) {
+  case NODE_LITERAL:
+    if (node->literal.kind == TOKEN_STRING) {
+      emitf(em, "AOT_PUSH(vm, constants[%d]);",
+            add_constant(em, node->literal.string));
+    } else {
+      emitf(em, "AOT_PUSH(vm, NULL);");
+    }
+    break;
+  case NODE_VARIABLE:
+    emitf(em, "AOT_PUSH(vm, ");
+    emit_name(em, resolve(em, node->variable.name));
+    emitf(em, ");");
+    break;
+  case NODE_BINARY_OP:
+    emit_push(em, node->binary_op.left);
+    if (node->binary_op.op == TOKEN_AND || node->binary_op.op == TOKEN_OR) {
+      // Keep the left value if it decides the result
+      emitf(em, " if (snek_is_truthy(AOT_PEEK(vm)) == %d) { (void)AOT_POP(vm); ",
+            node->binary_op.op == TOKEN_AND);
+      emit_push(em, node->binary_op.right);
+      emitf(em, " }");
+      break;
+    }
+
+    emitf(em, " ");
+    emit_push(em, node->binary_op.right);
+    emitf(em, " aot_apply(vm, %s, %d, \"%s\");",
+          binary_opcode(node->binary_op.op), node->line, em->function->name);
+    break;
+  case NODE_UNARY_OP:
+    emit_push(em, node->unary_op.operand);
+    emitf(em, " aot_apply(vm, %s, %d, \"%s\");",
+          node->unary_op.op == TOKEN_MINUS ? "OP_NEGATE" : "OP_NOT",
+          node->line, em->function->name);
+    break;
+  case NODE_CALL:
+    if (is_builtin_print(em, node)) {
+      for (int i = 0; i < node->call.args.count; i++) {
+        emit_push(em, node->call.args.nodes[i]);
+        emitf(em, " ");
+      }
+      emitf(em, "vm_print_values(vm, %d);", node->call.args.count);
+      break;
+    }
+
+    // Functions with a boxed result push it themselves
+    emitf(em, "{ ");
+    emit_call(em, node, find_function(em, node->call.name));
+    emitf(em, " }");
+    break;
+  default:
+    break;
+  }
+}
+
+static void emit_condition(emitter_t *em, ast_node_t *node) {
+  rep_t rep = infer(em, node);
+  if (rep == REP_BOXED) {
+    emitf(em, "({ ");
+    emit_push(em, node);
+    emitf(em, " snek_is_truthy(AOT_POP(vm)); })");
+    return;
+  }
+
+  emitf(em, "(");
+  emit_native(em, node, rep);
+  emitf(em, rep == REP_INT ? ") != 0" : ") != 0.0f");
+}
+
+/// Statements
+
+static void emit_statement(emitter_t *em, ast_node_t *node);
+
+static void emit_block(emitter_t *em, ast_node_list_t *list) {
+  em->indent++;
+  for (int i = 0; i < list->count; i++) {
+    emit_statement(em, list->nodes[i]);
+  }
+  em->indent--;
+}
+
+// Stores `value` (or the declaration's default if NULL) in `variable`
+static void emit_store(emitter_t *em, c_variable_t *variable,
+                       ast_node_t *value, const char *type) {
+  emit_indent(em);
+
+  if (variable->rep != REP_BOXED) {
+    emit_name(em, variable);
+    emitf(em, " = ");
+    if (value != NULL) {
+      emit_native(em, value, variable->rep);
+    } else {
+      emitf(em, variable->rep == REP_INT ? "0" : "0.0f");
+    }
+    emitf(em, ";\n");
+    return;
+  }
+
+  if (value != NULL) {
+    emit_push(em, value);
+  } else if (strcmp(type, "string") == 0) {
+    emitf(em, "AOT_PUSH(vm, constants[%d]);", add_constant(em, ""));
+  } else if (annotation_rep(type) != REP_BOXED) {
+    emitf(em, strcmp(type, "float") == 0
+                  ? "AOT_PUSH(vm, new_snek_float(vm, 0));"
+                  : "AOT_PUSH(vm, new_snek_integer(vm, 0));");
+  } else {
+    emitf(em, "AOT_PUSH(vm, NULL);");
+  }
+  emitf(em, " ");
+  emit_name(em, variable);
+  emitf(em, " = AOT_POP(vm);\n");
+}
+
+static void emit_return(emitter_t *em, ast_node_t *node) {
+  c_function_t *function = em->function;
+  ast_node_t *value = node->return_stmt.value;
+
+  if (function->result != REP_BOXED) {
+    emit_indent(em);
+    if (function->boxed_slots == 0) {
+      emitf(em, "return ");
+      emit_native(em, value, function->result);
+      emitf(em, ";\n");
+      return;
+    }
+
+    emitf(em, "{ %s _r = ", rep_type(function->result));
+    emit_native(em, value, function->result);
+    emitf(em, "; vm->stack->count = base; return _r; }\n");
+    return;
+  }
+
+  emit_indent(em);
+  if (value != NULL) {
+    emit_push(em, value);
+  } else {
+    emitf(em, "AOT_PUSH(vm, NULL);");
+  }
+  if (function->boxed_slots > 0) {
+    emitf(em, " { snek_object_t *_r = AOT_POP(vm); vm->stack->count = base; "
+              "AOT_PUSH(vm, _r); }");
+  }
+  emitf(em, " return;\n");
+}
+
+// Loops test their condition at the top and run a safepoint on the way
+// back, like the bytecode's OP_LOOP. `continue` jumps to the label.
+static void emit_loop(emitter_t *em, ast_node_t *node) {
+  bool is_for = node->type == NODE_FOR;
+  ast_node_t *condition =
+      is_for ? node->for_stmt.condition : node->while_stmt.condition;
+
+  if (is_for && node->for_stmt.init != NULL) {
+    emit_statement(em, node->for_stmt.init);
+  }
+
+  int enclosing = em->loop;
+  bool enclosing_continued = em->continued;
+  em->loop = em->loop_count++;
+  em->continued = false;
+
+  emit_line(em, "for (;;) {");
+  if (condition != NULL) {
+    em->indent++;
+    emit_indent(em);
+    emitf(em, "if (!(");
+    emit_condition(em, condition);
+    emitf(em, ")) break;\n");
+    em->indent--;
+  }
+
+  emit_block(em, is_for ? &node->for_stmt.body : &node->while_stmt.body);
+  if (em->continued) {
+    emit_line(em, "continue_%d:;", em->loop);
+  }
+  em->indent++;
+  if (is_for && node->for_stmt.step != NULL) {
+    emit_statement(em, node->for_stmt.step);
+  }
+  emit_line(em, "aot_safepoint(vm, %d, \"%s\");", node->line,
+            em->function->name);
+  em->indent--;
+  emit_line(em, "}");
+
+  em->loop = enclosing;
+  em->continued = enclosing_continued;
+}
+
+static void emit_statement(emitter_t *em, ast_node_t *node) {
+  switch (node->type) {
+  case NODE_DECLARATION: {
+    c_variable_t *variable = declared_variable(em, node->declaration.name);
+    emit_store(em, variable, node->declaration.value, node->declaration.type);
+    declare(em, node->declaration.name);
+    break;
+  }
+  case NODE_ASSIGNMENT:
+    emit_store(em, resolve(em, node->assignment.name), node->assignment.value,
+               NULL);
+    break;
+  case NODE_IF:
+    emit_indent(em);
+    emitf(em, "if (");
+    emit_condition(em, node->if_stmt.condition);
+    emitf(em, ") {\n");
+    emit_block(em, &node->if_stmt.then_branch);
+    if (node->if_stmt.else_branch.count > 0) {
+      emit_line(em, "} else {");
+      emit_block(em, &node->if_stmt.else_branch);
+    }
+    emit_line(em, "}");
+    break;
+  case NODE_WHILE:
+  case NODE_FOR:
+    emit_loop(em, node);
+    break;
+  case NODE_BREAK:
+    emit_line(em, "break;");
+    break;
+  case NODE_CONTINUE:
+    emit_line(em, "goto continue_%d;", em->loop);
+    em->continued = true;
+    break;
+  case NODE_BLOCK:
+    em->indent--;
+    emit_block(em, &node->block.statements);
+    em->indent++;
+    break;
+  case NODE_RETURN:
+    emit_return(em, node);
+    break;
+  default:
+    emit_indent(em);
+    if (infer(em, node) != REP_BOXED) {
+      emitf(em, "(void)");
+      emit_native(em, node, infer(em, node));
+      emitf(em, ";\n");
+    } else {
+      emit_push(em, node);
+      emitf(em, " (void)AOT_POP(vm);\n");
+    }
+    break;
+  }
+}
+
+/// Functions
+
+static void emit_signature(emitter_t *em, c_function_t *function) {
+  emitf(em, "static %s f_%s(", rep_type(function->result), function->name);
+
+  bool separate = false;
+  for (int i = 0; i < function->param_count; i++) {
+    c_variable_t *param = function->locals->data[i];
+    if (param->rep == REP_BOXED) {
+      continue;
+    }
+
+    emitf(em, separate ? ", %s " : "%s ", rep_type(param->rep));
+    emit_name(em, param);
+    separate = true;
+  }
+  emitf(em, separate ? ")" : "void)");
+}
+
+static void emit_function(emitter_t *em, c_function_t *function) {
+  enter_function(em, function);
+  emit_signature(em, function);
+  emitf(em, " {\n");
+  em->indent++;
+
+  if (function->boxed_slots > 0) {
+    emit_line(em, "size_t base = vm->stack->count - %d;",
+              function->boxed_params);
+    emit_line(em, "for (int i = %d; i < %d; i++) {", function->boxed_params,
+              function->boxed_slots);
+    emit_line(em, "  AOT_PUSH(vm, NULL);");
+    emit_line(em, "}");
+  }
+
+  for (size_t i = function->param_count; i < function->locals->count; i++) {
+    c_variable_t *local = function->locals->data[i];
+    if (local->rep != REP_BOXED) {
+      emit_indent(em);
+      emitf(em, "%s ", rep_type(local->rep));
+      emit_name(em, local);
+      emitf(em, local->rep == REP_INT ? " = 0;\n" : " = 0.0f;\n");
+    }
+  }
+  emit_line(em, "aot_safepoint(vm, %d, \"%s\");", function->node->line,
+            function->name);
+
+  ast_node_list_t *body = &function->node->function.body;
+  for (int i = 0; i < body->count; i++) {
+    emit_statement(em, body->nodes[i]);
+  }
+
+  // Falling off the end returns null
+  if (function->result == REP_BOXED) {
+    if (function->boxed_slots > 0) {
+      emit_line(em, "vm->stack->count = base;");
+    }
+    emit_line(em, "AOT_PUSH(vm, NULL);");
+  }
+
+  em->indent--;
+  emitf(em, "}\n\n");
+}
+
+static void emit_program(emitter_t *em, ast_root_t *root) {
+  for (size_t i = 0; i < em->globals->count; i++) {
+    c_variable_t *global = em->globals->data[i];
+    if (global->rep != REP_BOXED) {
+      emitf(em, "static %s ", rep_type(global->rep));
+      emit_name(em, global);
+      emitf(em, ";\n");
+    }
+  }
+  emitf(em, "\n");
+
+  for (size_t i = 0; i < em->functions->count; i++) {
+    emit_signature(em, em->functions->data[i]);
+    emitf(em, ";\n");
+  }
+  emitf(em, "\n");
+
+  for (size_t i = 0; i < em->functions->count; i++) {
+    emit_function(em, em->functions->data[i]);
+  }
+
+  enter_function(em, &em->script);
+  emitf(em, "static void snek_script(void) {\n");
+  em->indent++;
+  for (int i = 0; i < root->count; i++) {
+    if (root->nodes[i]->type != NODE_FUNCTION) {
+      emit_statement(em, root->nodes[i]);
+    }
+  }
+  em->indent--;
+  emitf(em, "}\n\n");
+}
+
+// The program refers to string constants by index, so the table is only
+// written out once the body has been generated
+static void emit_main(emitter_t *em) {
+  size_t count = em->constants->count;
+
+  emitf(em, "int main(void) {\n");
+  em->indent++;
+  emit_line(em, "vm = vm_new();");
+  for (size_t i = 0; i < count; i++) {
+    const char *string = em->constants->data[i];
+    emit_indent(em);
+    emitf(em, "constants[%zu] = aot_constant(new_snek_string_len(NULL, ", i);
+    emit_string_literal(em, string);
+    emitf(em, ", %zu));\n", strlen(string));
+  }
+
+  // Boxed globals are the bottom slots of the stack
+  emit_line(em, "for (int i = 0; i < %d; i++) {", em->script.boxed_slots);
+  emit_line(em, "  AOT_PUSH(vm, NULL);");
+  emit_line(em, "}");
+  emit_line(em, "snek_script();");
+  emit_line(em, "vm_free(vm);");
+  emit_line(em, "for (int i = 0; i < %zu; i++) {", count);
+  emit_line(em, "  snek_object_free(constants[i]);");
+  emit_line(em, "}");
+  emit_line(em, "return 0;");
+  em->indent--;
+  emitf(em, "}\n");
+}
+
+bool emit_c(FILE *out, ast_root_t *root) {
+  emitter_t em = {
+      .functions = stack_new(8),
+      .globals = stack_new(16),
+      .constants = stack_new(8),
+      .script = {.name = "<script>", .locals = stack_new(1)},
+      .loop = -1,
+  };
+
+  for (int i = 0; i < root->count; i++) {
+    ast_node_t *node = root->nodes[i];
+    if (node->type == NODE_FUNCTION) {
+      c_function_t *function = function_new(node);
+      walk_declaration_list(&em, &node->function.body, add_local, function);
+      stack_push(em.functions, function);
+    } else {
+      walk_declarations(&em, node, add_global, NULL);
+    }
+  }
+
+  analyse(&em, root);
+  assign_slots(&em);
+
+  char *body = NULL;
+  size_t length = 0;
+  em.out = open_memstream(&body, &length);
+  if (em.out != NULL) {
+    emit_program(&em, root);
+    fclose(em.out);
+  }
+
+  bool ok = body != NULL;
+  if (ok) {
+    em.out = out;
+    emitf(&em, "// Generated by sneklang --emit-c\n"
+               "#include \"vm/aot.h\"\n\n"
+               "static vm_t *vm;\n"
+               "static snek_object_t *constants[%zu];\n\n",
+               em.constants->count > 0 ? em.constants->count : 1);
+    fwrite(body, 1, length, out);
+    emit_main(&em);
+    ok = !ferror(out);
+  }
+  free(body);
+
+  for (size_t i = 0; i < em.functions->count; i++) {
+    c_function_t *function = em.functions->data[i];
+    free_variables(function->locals);
+    free(function);
+  }
+  stack_free(em.functions);
+  free_variables(em.globals);
+  stack_free(em.script.locals);
+  stack_free(em.constants);
+  return ok;
+}
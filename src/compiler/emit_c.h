@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../parser/parser.h"
+
+// Translates a script that compiles cleanly into a standalone C program,
+// written to `out`. The program links against the runtime (everything in
+// src/ except main.c) and behaves like `sneklang script.snek`.
+//
+// Variables declared `int`, `bool` or `float` become plain C variables
+// when every value stored in them has that type, and so do the parameters
+// and results of functions. Arithmetic on them is raw C arithmetic. All
+// other values stay boxed on the VM's value stack and go through the same
+// operations as the interpreter.
+//
+// Returns false if `out` couldn't be written.
+bool emit_c(FILE *out, ast_root_t *root);
@@ -0,0 +1,1147 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "optimizer.h"
+
+// What the optimizer knows about the values a variable can hold. NONE means
+// no assignment has been seen yet, NUMBER is either an int or a float.
+typedef enum {
+  TYPE_NONE,
+  TYPE_INT,
+  TYPE_FLOAT,
+  TYPE_NUMBER,
+  TYPE_UNKNOWN,
+} value_type_t;
+
+typedef struct Variable {
+  const char *name; // Borrowed from the AST
+  value_type_t type;
+} variable_t;
+
+// A function body or the top-level script. Only variables the scope owns are
+// tracked: a function's globals may change in any call, so they are never
+// considered invariant.
+typedef struct Scope {
+  stack_t *variables;   // variable_t *
+  stack_t *initialized; // char *, variables certainly set at this point
+  opt_report_t *report;
+  int *temp_count; // Shared by every scope so temporaries are unique
+} scope_t;
+
+typedef struct LoopInfo {
+  ast_node_t *node;
+  stack_t *assigned;         // char *, names written anywhere in the loop
+  ast_node_list_t preheader; // Declarations of temporaries, run once
+} loop_info_t;
+
+// Replaces `induction * factor` with `temp` inside a loop
+typedef struct Reduction {
+  ast_node_t *factor; // Owned copy of the int literal or invariant variable
+  char *temp;         // Borrowed from the temporary's declaration
+} reduction_t;
+
+typedef struct Pass {
+  scope_t *scope;
+  loop_info_t *loop;
+  const char *induction; // Strength reduction only
+  stack_t *steps;        // long, every step of `induction` in the loop
+  stack_t *reductions;   // reduction_t *, strength reduction only
+} pass_t;
+
+typedef void (*rewrite_fn)(pass_t *pass, ast_node_t **slot);
+
+/// Reporting
+
+opt_report_t *opt_report_new() {
+  opt_report_t *report = calloc(1, sizeof(opt_report_t));
+  if (report == NULL) {
+    return NULL;
+  }
+
+  report->messages = stack_new(8);
+  return report;
+}
+
+void opt_report_free(opt_report_t *report) {
+  if (report == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < report->messages->count; i++) {
+    free(report->messages->data[i]);
+  }
+  stack_free(report->messages);
+  free(report);
+}
+
+void opt_report_add(opt_report_t *report, const char *format, ...) {
+  if (report == NULL) {
+    return;
+  }
+
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+
+  stack_push(report->messages, strdup(buffer));
+}
+
+void opt_report_print(FILE *out, opt_report_t *report) {
+  fprintf(out, "### Optimization Report ###\n");
+  for (size_t i = 0; i < report->messages->count; i++) {
+    fprintf(out, "%s\n", (char *)report->messages->data[i]);
+  }
+  fprintf(out, "%d hoisted, %d strength-reduced, %d loads eliminated\n",
+          report->hoisted, report->strength_reduced, report->loads_eliminated);
+}
+
+typedef struct Buffer {
+  char *data;
+  size_t size;
+  size_t length;
+} buffer_t;
+
+static void buffer_printf(buffer_t *buffer, const char *format, ...) {
+  if (buffer->length + 1 >= buffer->size) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(buffer->data + buffer->length,
+                          buffer->size - buffer->length, format, args);
+  va_end(args);
+
+  if (written > 0) {
+    buffer->length += (size_t)written;
+    if (buffer->length >= buffer->size) {
+      buffer->length = buffer->size - 1;
+    }
+  }
+}
+
+// Writes `node` back out as source, for the report
+static void format_expression(buffer_t *buffer, ast_node_t *node,
+                              bool nested) {
+  switch (node->type) {
+  case NODE_LITERAL:
+    if (node->literal.kind == TOKEN_FLOAT) {
+      buffer_printf(buffer, "%g", node->literal.floating);
+    } else {
+      buffer_printf(buffer, "%d", node->literal.value);
+    }
+    break;
+  case NODE_VARIABLE:
+    buffer_printf(buffer, "%s", node->variable.name);
+    break;
+  case NODE_UNARY_OP:
+    buffer_printf(buffer, "%s", ast_operator_string(node->unary_op.op));
+    format_expression(buffer, node->unary_op.operand, true);
+    break;
+  case NODE_BINARY_OP:
+    buffer_printf(buffer, nested ? "(" : "");
+    format_expression(buffer, node->binary_op.left, true);
+    buffer_printf(buffer, " %s ", ast_operator_string(node->binary_op.op));
+    format_expression(buffer, node->binary_op.right, true);
+    buffer_printf(buffer, nested ? ")" : "");
+    break;
+  default:
+    buffer_printf(buffer, "...");
+    break;
+  }
+}
+
+/// Variables and Types
+
+static bool contains(stack_t *names, const char *name) {
+  for (size_t i = 0; i < names->count; i++) {
+    if (strcmp(names->data[i], name) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static variable_t *find_variable(scope_t *scope, const char *name) {
+  for (size_t i = 0; i < scope->variables->count; i++) {
+    variable_t *variable = scope->variables->data[i];
+    if (strcmp(variable->name, name) == 0) {
+      return variable;
+    }
+  }
+
+  return NULL;
+}
+
+static void add_variable(scope_t *scope, const char *name,
+                         value_type_t type) {
+  if (find_variable(scope, name) != NULL) {
+    return;
+  }
+
+  variable_t *variable = malloc(sizeof(variable_t));
+  if (variable == NULL) {
+    return;
+  }
+
+  variable->name = name;
+  variable->type = type;
+  stack_push(scope->variables, variable);
+}
+
+static bool is_number(value_type_t type) {
+  return type == TYPE_INT || type == TYPE_FLOAT || type == TYPE_NUMBER;
+}
+
+static value_type_t type_join(value_type_t a, value_type_t b) {
+  if (a == b || b == TYPE_NONE) {
+    return a;
+  }
+  if (a == TYPE_NONE) {
+    return b;
+  }
+  if (a == TYPE_UNKNOWN || b == TYPE_UNKNOWN) {
+    return TYPE_UNKNOWN;
+  }
+  return TYPE_NUMBER;
+}
+
+// Type an annotation gives a declaration without a value
+static value_type_t annotation_type(const char *annotation) {
+  if (strcmp(annotation, "int") == 0 || strcmp(annotation, "bool") == 0) {
+    return TYPE_INT;
+  }
+  if (strcmp(annotation, "float") == 0) {
+    return TYPE_FLOAT;
+  }
+  return TYPE_UNKNOWN;
+}
+
+static value_type_t arithmetic_type(value_type_t left, value_type_t right) {
+  if (left == TYPE_UNKNOWN || right == TYPE_UNKNOWN) {
+    return TYPE_UNKNOWN;
+  }
+  if (left == TYPE_NONE || right == TYPE_NONE) {
+    return TYPE_NONE;
+  }
+  if (left == TYPE_FLOAT || right == TYPE_FLOAT) {
+    return TYPE_FLOAT;
+  }
+  if (left == TYPE_NUMBER || right == TYPE_NUMBER) {
+    return TYPE_NUMBER;
+  }
+  return TYPE_INT;
+}
+
+static value_type_t expression_type(scope_t *scope, ast_node_t *node) {
+  switch (node->type) {
+  case NODE_LITERAL:
+    if (node->literal.kind == TOKEN_INT) {
+      return TYPE_INT;
+    }
+    return node->literal.kind == TOKEN_FLOAT ? TYPE_FLOAT : TYPE_UNKNOWN;
+  case NODE_VARIABLE: {
+    variable_t *variable = find_variable(scope, node->variable.name);
+    return variable != NULL ? variable->type : TYPE_UNKNOWN;
+  }
+  case NODE_UNARY_OP:
+    if (node->unary_op.op == TOKEN_BANG) {
+      return TYPE_INT;
+    }
+    return expression_type(scope, node->unary_op.operand);
+  case NODE_BINARY_OP: {
+    value_type_t left = expression_type(scope, node->binary_op.left);
+    value_type_t right = expression_type(scope, node->binary_op.right);
+    switch (node->binary_op.op) {
+    case TOKEN_AND:
+    case TOKEN_OR:
+      return type_join(left, right);
+    case TOKEN_PLUS:
+    case TOKEN_MINUS:
+    case TOKEN_STAR:
+    case TOKEN_SLASH:
+      return arithmetic_type(left, right);
+    default:
+      // Comparisons produce 0 or 1 whatever they compare
+      return TYPE_INT;
+    }
+  }
+  default:
+    return TYPE_UNKNOWN;
+  }
+}
+
+/// AST Helpers
+
+typedef void (*statement_fn)(ast_node_t *node, void *context);
+
+static void walk_statement(ast_node_t *node, statement_fn fn, void *context);
+
+static void walk_list(ast_node_list_t *list, statement_fn fn, void *context) {
+  for (int i = 0; i < list->count; i++) {
+    walk_statement(list->nodes[i], fn, context);
+  }
+}
+
+// Calls `fn` on `node` and every statement nested in it
+static void walk_statement(ast_node_t *node, statement_fn fn, void *context) {
+  if (node == NULL) {
+    return;
+  }
+
+  fn(node, context);
+  switch (node->type) {
+  case NODE_IF:
+    walk_list(&node->if_stmt.then_branch, fn, context);
+    walk_list(&node->if_stmt.else_branch, fn, context);
+    break;
+  case NODE_WHILE:
+    walk_list(&node->while_stmt.body, fn, context);
+    break;
+  case NODE_FOR:
+    walk_statement(node->for_stmt.init, fn, context);
+    walk_statement(node->for_stmt.step, fn, context);
+    walk_list(&node->for_stmt.body, fn, context);
+    break;
+  case NODE_BLOCK:
+    walk_list(&node->block.statements, fn, context);
+    break;
+  default:
+    break;
+  }
+}
+
+static const char *assigned_name(ast_node_t *node) {
+  if (node->type == NODE_DECLARATION) {
+    return node->declaration.name;
+  }
+  if (node->type == NODE_ASSIGNMENT) {
+    return node->assignment.name;
+  }
+  return NULL;
+}
+
+static void collect_assigned(ast_node_t *node, void *context) {
+  const char *name = assigned_name(node);
+  if (name != NULL && !contains(context, name)) {
+    stack_push(context, (void *)name);
+  }
+}
+
+static void declare_variable(ast_node_t *node, void *context) {
+  if (node->type == NODE_DECLARATION) {
+    add_variable(context, node->declaration.name, TYPE_NONE);
+  }
+}
+
+static bool ast_equal(ast_node_t *a, ast_node_t *b) {
+  if (a->type != b->type) {
+    return false;
+  }
+
+  switch (a->type) {
+  case NODE_LITERAL:
+    return a->literal.kind == b->literal.kind &&
+           (a->literal.kind == TOKEN_FLOAT
+                ? a->literal.floating == b->literal.floating
+                : a->literal.value == b->literal.value);
+  case NODE_VARIABLE:
+    return strcmp(a->variable.name, b->variable.name) == 0;
+  case NODE_UNARY_OP:
+    return a->unary_op.op == b->unary_op.op &&
+           ast_equal(a->unary_op.operand, b->unary_op.operand);
+  case NODE_BINARY_OP:
+    return a->binary_op.op == b->binary_op.op &&
+           ast_equal(a->binary_op.left, b->binary_op.left) &&
+           ast_equal(a->binary_op.right, b->binary_op.right);
+  default:
+    return false;
+  }
+}
+
+static ast_node_t *new_variable(const char *name, int line) {
+  ast_node_t *node = ast_new_variable_node((char *)name);
+  node->line = line;
+  return node;
+}
+
+// Copies a literal or variable
+static ast_node_t *copy_leaf(ast_node_t *node) {
+  if (node->type == NODE_VARIABLE) {
+    return new_variable(node->variable.name, node->line);
+  }
+
+  ast_node_t *copy = node->literal.kind == TOKEN_FLOAT
+                         ? ast_new_float_literal_node(node->literal.floating)
+                         : ast_new_literal_node(node->literal.value);
+  copy->line = node->line;
+  return copy;
+}
+
+static bool mentions_variable(ast_node_t *node) {
+  switch (node->type) {
+  case NODE_VARIABLE:
+    return true;
+  case NODE_UNARY_OP:
+    return mentions_variable(node->unary_op.operand);
+  case NODE_BINARY_OP:
+    return mentions_variable(node->binary_op.left) ||
+           mentions_variable(node->binary_op.right);
+  default:
+    return false;
+  }
+}
+
+// Declares a temporary holding `value` before the loop
+static ast_node_t *new_temporary(pass_t *pass, ast_node_t *value) {
+  char name[32];
+  snprintf(name, sizeof(name), "$t%d", (*pass->scope->temp_count)++);
+
+  value_type_t type = expression_type(pass->scope, value);
+  ast_node_t *declaration =
+      ast_new_declaration_node(name, type == TYPE_INT ? "int" : "float", value);
+  declaration->line = value->line;
+  ast_node_list_append(&pass->loop->preheader, declaration);
+
+  add_variable(pass->scope, declaration->declaration.name, type);
+  stack_push(pass->scope->initialized, declaration->declaration.name);
+  return declaration;
+}
+
+/// Rewriting
+
+static void rewrite_list(pass_t *pass, ast_node_list_t *list,
+                         rewrite_fn rewrite);
+
+// Calls `rewrite` on every expression directly held by the statement in
+// `slot`, including expression statements themselves
+static void rewrite_statement(pass_t *pass, ast_node_t **slot,
+                              rewrite_fn rewrite) {
+  ast_node_t *node = *slot;
+  if (node == NULL) {
+    return;
+  }
+
+  switch (node->type) {
+  case NODE_DECLARATION:
+    rewrite(pass, &node->declaration.value);
+    break;
+  case NODE_ASSIGNMENT:
+    rewrite(pass, &node->assignment.value);
+    break;
+  case NODE_RETURN:
+    rewrite(pass, &node->return_stmt.value);
+    break;
+  case NODE_IF:
+    rewrite(pass, &node->if_stmt.condition);
+    rewrite_list(pass, &node->if_stmt.then_branch, rewrite);
+    rewrite_list(pass, &node->if_stmt.else_branch, rewrite);
+    break;
+  case NODE_WHILE:
+    rewrite(pass, &node->while_stmt.condition);
+    rewrite_list(pass, &node->while_stmt.body, rewrite);
+    break;
+  case NODE_FOR:
+    rewrite_statement(pass, &node->for_stmt.init, rewrite);
+    rewrite(pass, &node->for_stmt.condition);
+    rewrite_statement(pass, &node->for_stmt.step, rewrite);
+    rewrite_list(pass, &node->for_stmt.body, rewrite);
+    break;
+  case NODE_BLOCK:
+    rewrite_list(pass, &node->block.statements, rewrite);
+    break;
+  case NODE_BREAK:
+  case NODE_CONTINUE:
+  case NODE_FUNCTION:
+    break;
+  default:
+    rewrite(pass, slot);
+    break;
+  }
+}
+
+static void rewrite_list(pass_t *pass, ast_node_list_t *list,
+                         rewrite_fn rewrite) {
+  for (int i = 0; i < list->count; i++) {
+    rewrite_statement(pass, &list->nodes[i], rewrite);
+  }
+}
+
+// Rewrites the part of the loop that runs on every iteration
+static void rewrite_loop(pass_t *pass, rewrite_fn rewrite) {
+  ast_node_t *loop = pass->loop->node;
+  if (loop->type == NODE_WHILE) {
+    rewrite(pass, &loop->while_stmt.condition);
+    rewrite_list(pass, &loop->while_stmt.body, rewrite);
+  } else {
+    rewrite(pass, &loop->for_stmt.condition);
+    rewrite_statement(pass, &loop->for_stmt.step, rewrite);
+    rewrite_list(pass, &loop->for_stmt.body, rewrite);
+  }
+}
+
+static void rewrite_children(pass_t *pass, ast_node_t *node,
+                             rewrite_fn rewrite) {
+  switch (node->type) {
+  case NODE_BINARY_OP:
+    rewrite(pass, &node->binary_op.left);
+    rewrite(pass, &node->binary_op.right);
+    break;
+  case NODE_UNARY_OP:
+    rewrite(pass, &node->unary_op.operand);
+    break;
+  case NODE_CALL:
+    for (int i = 0; i < node->call.args.count; i++) {
+      rewrite(pass, &node->call.args.nodes[i]);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/// Loop-Invariant Code Motion
+
+static bool is_invariant_variable(pass_t *pass, const char *name) {
+  variable_t *variable = find_variable(pass->scope, name);
+  return variable != NULL && is_number(variable->type) &&
+         contains(pass->scope->initialized, name) &&
+         !contains(pass->loop->assigned, name);
+}
+
+// True if `node` gives the same number on every iteration and evaluating it
+// can't fail
+static bool is_invariant(pass_t *pass, ast_node_t *node) {
+  switch (node->type) {
+  case NODE_LITERAL:
+    return node->literal.kind == TOKEN_INT || node->literal.kind == TOKEN_FLOAT;
+  case NODE_VARIABLE:
+    return is_invariant_variable(pass, node->variable.name);
+  case NODE_UNARY_OP:
+    return is_invariant(pass, node->unary_op.operand);
+  case NODE_BINARY_OP: {
+    ast_node_t *left = node->binary_op.left;
+    ast_node_t *right = node->binary_op.right;
+    if (!is_invariant(pass, left) || !is_invariant(pass, right)) {
+      return false;
+    }
+    if (node->binary_op.op != TOKEN_SLASH) {
+      return true;
+    }
+
+    // Integer division by zero is the only way arithmetic on numbers fails
+    return (right->type == NODE_LITERAL &&
+            (right->literal.kind == TOKEN_FLOAT || right->literal.value != 0)) ||
+           expression_type(pass->scope, left) == TYPE_FLOAT ||
+           expression_type(pass->scope, right) == TYPE_FLOAT;
+  }
+  default:
+    return false;
+  }
+}
+
+static void hoist_expression(pass_t *pass, ast_node_t **slot) {
+  ast_node_t *node = *slot;
+  if (node == NULL) {
+    return;
+  }
+
+  bool is_operation =
+      node->type == NODE_BINARY_OP || node->type == NODE_UNARY_OP;
+  if (!is_operation || !mentions_variable(node) || !is_invariant(pass, node)) {
+    rewrite_children(pass, node, hoist_expression);
+    return;
+  }
+
+  char text[128];
+  buffer_t buffer = {text, sizeof(text), 0};
+  text[0] = '\0';
+  format_expression(&buffer, node, false);
+
+  // Identical expressions in the same loop share a temporary
+  ast_node_t *temporary = NULL;
+  for (int i = 0; i < pass->loop->preheader.count && temporary == NULL; i++) {
+    ast_node_t *declaration = pass->loop->preheader.nodes[i];
+    if (ast_equal(declaration->declaration.value, node)) {
+      temporary = declaration;
+    }
+  }
+
+  *slot = NULL;
+  if (temporary != NULL) {
+    ast_free_node(node);
+  } else {
+    temporary = new_temporary(pass, node);
+  }
+  *slot = new_variable(temporary->declaration.name, node->line);
+
+  if (pass->scope->report != NULL) {
+    pass->scope->report->hoisted++;
+  }
+  opt_report_add(pass->scope->report,
+                 "line %d: hoisted `%s` out of the loop on line %d",
+                 (*slot)->line, text, pass->loop->node->line);
+}
+
+/// Strength Reduction
+
+// Matches `name = name + c`, `name = name - c` and `name = c + name` for an
+// int literal c, the only updates an induction variable may have
+static bool induction_step(ast_node_t *node, const char *name, long *step) {
+  if (node->type != NODE_ASSIGNMENT ||
+      strcmp(node->assignment.name, name) != 0) {
+    return false;
+  }
+
+  ast_node_t *value = node->assignment.value;
+  if (value->type != NODE_BINARY_OP || (value->binary_op.op != TOKEN_PLUS &&
+                                        value->binary_op.op != TOKEN_MINUS)) {
+    return false;
+  }
+
+  ast_node_t *left = value->binary_op.left;
+  ast_node_t *right = value->binary_op.right;
+  bool is_minus = value->binary_op.op == TOKEN_MINUS;
+
+  if (left->type == NODE_VARIABLE && strcmp(left->variable.name, name) == 0 &&
+      right->type == NODE_LITERAL && right->literal.kind == TOKEN_INT) {
+    *step = is_minus ? -(long)right->literal.value : right->literal.value;
+    return true;
+  }
+
+  if (!is_minus && right->type == NODE_VARIABLE &&
+      strcmp(right->variable.name, name) == 0 && left->type == NODE_LITERAL &&
+      left->literal.kind == TOKEN_INT) {
+    *step = left->literal.value;
+    return true;
+  }
+
+  return false;
+}
+
+typedef struct InductionSteps {
+  const char *name;
+  stack_t *steps; // long, stored in the pointers
+  bool valid;
+} induction_steps_t;
+
+static void collect_steps(ast_node_t *node, void *context) {
+  induction_steps_t *induction = context;
+  const char *name = assigned_name(node);
+  if (name == NULL || strcmp(name, induction->name) != 0) {
+    return;
+  }
+
+  long step;
+  if (induction_step(node, induction->name, &step)) {
+    stack_push(induction->steps, (void *)(intptr_t)step);
+  } else {
+    induction->valid = false;
+  }
+}
+
+// The factor `k` of `induction * k` or `k * induction`, if k is an int
+// literal or an invariant int variable
+static ast_node_t *product_factor(pass_t *pass, ast_node_t *node) {
+  if (node->type != NODE_BINARY_OP || node->binary_op.op != TOKEN_STAR) {
+    return NULL;
+  }
+
+  ast_node_t *left = node->binary_op.left;
+  ast_node_t *right = node->binary_op.right;
+  ast_node_t *factor = NULL;
+  if (left->type == NODE_VARIABLE &&
+      strcmp(left->variable.name, pass->induction) == 0) {
+    factor = right;
+  } else if (right->type == NODE_VARIABLE &&
+             strcmp(right->variable.name, pass->induction) == 0) {
+    factor = left;
+  } else {
+    return NULL;
+  }
+
+  if (factor->type == NODE_LITERAL && factor->literal.kind == TOKEN_INT) {
+    return factor;
+  }
+  if (factor->type == NODE_VARIABLE &&
+      is_invariant_variable(pass, factor->variable.name) &&
+      find_variable(pass->scope, factor->variable.name)->type == TYPE_INT) {
+    return factor;
+  }
+  return NULL;
+}
+
+static bool steps_fit(stack_t *steps, ast_node_t *factor) {
+  for (size_t i = 0; i < steps->count; i++) {
+    long step = (long)(intptr_t)steps->data[i];
+    if (factor->type == NODE_VARIABLE && step != 1 && step != -1) {
+      return false;
+    }
+    if (factor->type == NODE_LITERAL) {
+      long delta = step * factor->literal.value;
+      if (delta > INT32_MAX || delta < INT32_MIN) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+static void reduce_expression(pass_t *pass, ast_node_t **slot) {
+  ast_node_t *node = *slot;
+  if (node == NULL) {
+    return;
+  }
+
+  // A factor whose steps can't fold into a constant or a plain add would
+  // need a multiply per update, which gains nothing
+  ast_node_t *factor = product_factor(pass, node);
+  if (factor == NULL || !steps_fit(pass->steps, factor)) {
+    rewrite_children(pass, node, reduce_expression);
+    return;
+  }
+
+  reduction_t *reduction = NULL;
+  for (size_t i = 0; i < pass->reductions->count && reduction == NULL; i++) {
+    reduction_t *existing = pass->reductions->data[i];
+    if (ast_equal(existing->factor, factor)) {
+      reduction = existing;
+    }
+  }
+
+  if (reduction == NULL) {
+    reduction = malloc(sizeof(reduction_t));
+    reduction->factor = copy_leaf(factor);
+    ast_node_t *initial = ast_new_binary_op_node(
+        TOKEN_STAR, new_variable(pass->induction, node->line),
+        copy_leaf(factor));
+    initial->line = node->line;
+    reduction->temp = new_temporary(pass, initial)->declaration.name;
+    stack_push(pass->reductions, reduction);
+  }
+
+  char text[128];
+  buffer_t buffer = {text, sizeof(text), 0};
+  text[0] = '\0';
+  format_expression(&buffer, node, false);
+
+  *slot = new_variable(reduction->temp, node->line);
+  ast_free_node(node);
+
+  if (pass->scope->report != NULL) {
+    pass->scope->report->strength_reduced++;
+  }
+  opt_report_add(pass->scope->report,
+                 "line %d: replaced `%s` with a running sum stepped with `%s`",
+                 (*slot)->line, text, pass->induction);
+}
+
+// `temp = temp + step * factor`, keeping temp equal to induction * factor
+static ast_node_t *new_update(reduction_t *reduction, long step, int line) {
+  token_type_t op = TOKEN_PLUS;
+  ast_node_t *delta;
+
+  if (reduction->factor->type == NODE_LITERAL) {
+    delta = ast_new_literal_node((int)(step * reduction->factor->literal.value));
+  } else {
+    // Only unit steps are reduced with a variable factor
+    op = step > 0 ? TOKEN_PLUS : TOKEN_MINUS;
+    delta = copy_leaf(reduction->factor);
+  }
+  delta->line = line;
+
+  ast_node_t *sum = ast_new_binary_op_node(
+      op, new_variable(reduction->temp, line), delta);
+  sum->line = line;
+  ast_node_t *update = ast_new_assignment_node(reduction->temp, sum);
+  update->line = line;
+  return update;
+}
+
+static void insert_updates(pass_t *pass, ast_node_list_t *list);
+
+static void insert_updates_after(pass_t *pass, ast_node_list_t *list,
+                                 int index, long step) {
+  ast_node_t *assignment = list->nodes[index];
+  for (size_t i = 0; i < pass->reductions->count; i++) {
+    ast_node_list_insert(list, index + 1 + (int)i,
+                         new_update(pass->reductions->data[i], step,
+                                    assignment->line));
+  }
+}
+
+// Same as insert_updates for the single statement step of a `for`
+static void insert_step_updates(pass_t *pass, ast_node_t **slot) {
+  ast_node_t *step_node = *slot;
+  long step;
+
+  if (step_node == NULL) {
+    return;
+  }
+  if (step_node->type == NODE_BLOCK) {
+    insert_updates(pass, &step_node->block.statements);
+    return;
+  }
+  if (!induction_step(step_node, pass->induction, &step)) {
+    return;
+  }
+
+  ast_node_t *block = ast_new_block_node();
+  block->line = step_node->line;
+  ast_node_list_append(&block->block.statements, step_node);
+  insert_updates_after(pass, &block->block.statements, 0, step);
+  *slot = block;
+}
+
+// Follows every update of the induction variable with updates of the
+// temporaries derived from it
+static void insert_updates(pass_t *pass, ast_node_list_t *list) {
+  for (int i = 0; i < list->count; i++) {
+    ast_node_t *node = list->nodes[i];
+    long step;
+
+    switch (node->type) {
+    case NODE_ASSIGNMENT:
+      if (induction_step(node, pass->induction, &step)) {
+        insert_updates_after(pass, list, i, step);
+        i += (int)pass->reductions->count;
+      }
+      break;
+    case NODE_IF:
+      insert_updates(pass, &node->if_stmt.then_branch);
+      insert_updates(pass, &node->if_stmt.else_branch);
+      break;
+    case NODE_WHILE:
+      insert_updates(pass, &node->while_stmt.body);
+      break;
+    case NODE_FOR:
+      insert_step_updates(pass, &node->for_stmt.step);
+      insert_updates(pass, &node->for_stmt.body);
+      break;
+    case NODE_BLOCK:
+      insert_updates(pass, &node->block.statements);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static void reduce_induction(pass_t *pass, const char *name) {
+  variable_t *variable = find_variable(pass->scope, name);
+  if (variable == NULL || variable->type != TYPE_INT ||
+      !contains(pass->scope->initialized, name)) {
+    return;
+  }
+
+  ast_node_t *loop = pass->loop->node;
+  induction_steps_t induction = {name, stack_new(4), true};
+  if (loop->type == NODE_WHILE) {
+    walk_list(&loop->while_stmt.body, collect_steps, &induction);
+  } else {
+    walk_statement(loop->for_stmt.step, collect_steps, &induction);
+    walk_list(&loop->for_stmt.body, collect_steps, &induction);
+  }
+
+  if (induction.valid && induction.steps->count > 0) {
+    pass->induction = name;
+    pass->steps = induction.steps;
+    pass->reductions = stack_new(4);
+    rewrite_loop(pass, reduce_expression);
+
+    if (loop->type == NODE_WHILE) {
+      insert_updates(pass, &loop->while_stmt.body);
+    } else {
+      insert_step_updates(pass, &loop->for_stmt.step);
+      insert_updates(pass, &loop->for_stmt.body);
+    }
+
+    for (size_t i = 0; i < pass->reductions->count; i++) {
+      reduction_t *reduction = pass->reductions->data[i];
+      ast_free_node(reduction->factor);
+      free(reduction);
+    }
+    stack_free(pass->reductions);
+    pass->reductions = NULL;
+  }
+
+  stack_free(induction.steps);
+}
+
+/// Driver
+
+static bool infer_statement(scope_t *scope, ast_node_t *node);
+
+static bool infer_list(scope_t *scope, ast_node_list_t *list) {
+  bool changed = false;
+  for (int i = 0; i < list->count; i++) {
+    changed |= infer_statement(scope, list->nodes[i]);
+  }
+  return changed;
+}
+
+static bool infer_assignment(scope_t *scope, const char *name,
+                             value_type_t type) {
+  variable_t *variable = find_variable(scope, name);
+  if (variable == NULL) {
+    return false;
+  }
+
+  value_type_t joined = type_join(variable->type, type);
+  if (joined == variable->type) {
+    return false;
+  }
+  variable->type = joined;
+  return true;
+}
+
+// Joins the type of each value stored by `node` into its variable. Returns
+// true if any variable's type changed.
+static bool infer_statement(scope_t *scope, ast_node_t *node) {
+  if (node == NULL) {
+    return false;
+  }
+
+  switch (node->type) {
+  case NODE_DECLARATION: {
+    ast_node_t *value = node->declaration.value;
+    return infer_assignment(scope, node->declaration.name,
+                            value != NULL
+                                ? expression_type(scope, value)
+                                : annotation_type(node->declaration.type));
+  }
+  case NODE_ASSIGNMENT:
+    return infer_assignment(scope, node->assignment.name,
+                            expression_type(scope, node->assignment.value));
+  case NODE_IF:
+    return infer_list(scope, &node->if_stmt.then_branch) |
+           infer_list(scope, &node->if_stmt.else_branch);
+  case NODE_WHILE:
+    return infer_list(scope, &node->while_stmt.body);
+  case NODE_FOR:
+    return infer_statement(scope, node->for_stmt.init) |
+           infer_statement(scope, node->for_stmt.step) |
+           infer_list(scope, &node->for_stmt.body);
+  case NODE_BLOCK:
+    return infer_list(scope, &node->block.statements);
+  default:
+    return false;
+  }
+}
+
+// Types only grow, so this settles after a few rounds
+static void infer_types(scope_t *scope, ast_node_list_t *body) {
+  while (infer_list(scope, body)) {
+  }
+
+  for (size_t i = 0; i < scope->variables->count; i++) {
+    variable_t *variable = scope->variables->data[i];
+    if (variable->type == TYPE_NONE) {
+      variable->type = TYPE_UNKNOWN;
+    }
+  }
+}
+
+static void optimize_list(scope_t *scope, ast_node_list_t *list);
+
+// Optimizes the loops nested in `loop` and then `loop` itself. Returns the
+// node to put in the loop's place: the loop, or a block running the new
+// temporaries' declarations first.
+static ast_node_t *optimize_loop(scope_t *scope, ast_node_t *loop) {
+  size_t mark = scope->initialized->count;
+  bool is_for = loop->type == NODE_FOR;
+  ast_node_t *init = is_for ? loop->for_stmt.init : NULL;
+
+  if (init != NULL && assigned_name(init) != NULL) {
+    stack_push(scope->initialized, (void *)assigned_name(init));
+  }
+
+  size_t body_mark = scope->initialized->count;
+  optimize_list(scope, is_for ? &loop->for_stmt.body : &loop->while_stmt.body);
+  scope->initialized->count = body_mark;
+
+  loop_info_t info = {.node = loop, .assigned = stack_new(8)};
+  if (is_for) {
+    walk_statement(loop->for_stmt.step, collect_assigned, info.assigned);
+    walk_list(&loop->for_stmt.body, collect_assigned, info.assigned);
+  } else {
+    walk_list(&loop->while_stmt.body, collect_assigned, info.assigned);
+  }
+
+  pass_t pass = {.scope = scope, .loop = &info};
+  rewrite_loop(&pass, hoist_expression);
+  for (size_t i = 0; i < info.assigned->count; i++) {
+    reduce_induction(&pass, info.assigned->data[i]);
+  }
+
+  stack_free(info.assigned);
+  scope->initialized->count = mark;
+
+  if (info.preheader.count == 0) {
+    return loop;
+  }
+
+  ast_node_t *block = ast_new_block_node();
+  block->line = loop->line;
+  if (init != NULL) {
+    // The initializer must run before the temporaries read it
+    ast_node_list_append(&block->block.statements, init);
+    loop->for_stmt.init = NULL;
+  }
+  for (int i = 0; i < info.preheader.count; i++) {
+    ast_node_list_append(&block->block.statements, info.preheader.nodes[i]);
+  }
+  free(info.preheader.nodes);
+  ast_node_list_append(&block->block.statements, loop);
+  return block;
+}
+
+static void optimize_list(scope_t *scope, ast_node_list_t *list) {
+  for (int i = 0; i < list->count; i++) {
+    ast_node_t *node = list->nodes[i];
+    size_t mark = scope->initialized->count;
+
+    switch (node->type) {
+    case NODE_DECLARATION:
+    case NODE_ASSIGNMENT:
+      stack_push(scope->initialized, (void *)assigned_name(node));
+      break;
+    case NODE_IF:
+      optimize_list(scope, &node->if_stmt.then_branch);
+      scope->initialized->count = mark;
+      optimize_list(scope, &node->if_stmt.else_branch);
+      scope->initialized->count = mark;
+      break;
+    case NODE_WHILE:
+    case NODE_FOR:
+      list->nodes[i] = optimize_loop(scope, node);
+      break;
+    case NODE_BLOCK:
+      optimize_list(scope, &node->block.statements);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static void scope_init(scope_t *scope, opt_report_t *report,
+                       int *temp_count) {
+  scope->variables = stack_new(16);
+  scope->initialized = stack_new(16);
+  scope->report = report;
+  scope->temp_count = temp_count;
+}
+
+static void scope_free(scope_t *scope) {
+  for (size_t i = 0; i < scope->variables->count; i++) {
+    free(scope->variables->data[i]);
+  }
+  stack_free(scope->variables);
+  stack_free(scope->initialized);
+}
+
+// Annotations aren't checked at runtime, so a parameter may hold anything a
+// caller passes. Hoisting arithmetic on one could make a loop that never
+// runs fail.
+static void optimize_function(ast_node_t *function, opt_report_t *report,
+                              int *temp_count) {
+  scope_t scope;
+  scope_init(&scope, report, temp_count);
+
+  for (int i = 0; i < function->function.param_count; i++) {
+    char *name = function->function.param_names[i];
+    add_variable(&scope, name, TYPE_UNKNOWN);
+    stack_push(scope.initialized, name);
+  }
+  walk_list(&function->function.body, declare_variable, &scope);
+
+  infer_types(&scope, &function->function.body);
+  optimize_list(&scope, &function->function.body);
+  scope_free(&scope);
+}
+
+typedef struct FunctionLocals {
+  stack_t *locals;    // char *, parameters and declarations of the function
+  scope_t *top_level; // Globals the function assigns become unknown
+} function_locals_t;
+
+static void collect_local(ast_node_t *node, void *context) {
+  if (node->type == NODE_DECLARATION) {
+    stack_push(context, node->declaration.name);
+  }
+}
+
+static void forget_global(ast_node_t *node, void *context) {
+  function_locals_t *function = context;
+  if (node->type != NODE_ASSIGNMENT ||
+      contains(function->locals, node->assignment.name)) {
+    return;
+  }
+
+  variable_t *global = find_variable(function->top_level, node->assignment.name);
+  if (global != NULL) {
+    global->type = TYPE_UNKNOWN;
+  }
+}
+
+static void optimize_script(ast_root_t *root, opt_report_t *report,
+                            int *temp_count) {
+  scope_t scope;
+  scope_init(&scope, report, temp_count);
+
+  // The script's statements, without the function definitions
+  ast_node_list_t body = {0};
+  for (int i = 0; i < root->count; i++) {
+    if (root->nodes[i]->type != NODE_FUNCTION) {
+      ast_node_list_append(&body, root->nodes[i]);
+    }
+  }
+  walk_list(&body, declare_variable, &scope);
+  infer_types(&scope, &body);
+
+  // A global a function writes may hold anything after any call
+  for (int i = 0; i < root->count; i++) {
+    ast_node_t *node = root->nodes[i];
+    if (node->type != NODE_FUNCTION) {
+      continue;
+    }
+
+    function_locals_t function = {stack_new(8), &scope};
+    for (int j = 0; j < node->function.param_count; j++) {
+      stack_push(function.locals, node->function.param_names[j]);
+    }
+    walk_list(&node->function.body, collect_local, function.locals);
+    walk_list(&node->function.body, forget_global, &function);
+    stack_free(function.locals);
+  }
+
+  optimize_list(&scope, &body);
+
+  // Loops at the top level may have been replaced by blocks
+  for (int i = 0, j = 0; i < root->count; i++) {
+    if (root->nodes[i]->type != NODE_FUNCTION) {
+      root->nodes[i] = body.nodes[j++];
+    }
+  }
+
+  free(body.nodes);
+  scope_free(&scope);
+}
+
+void optimize(ast_root_t *root, opt_report_t *report) {
+  int temp_count = 0;
+
+  for (int i = 0; i < root->count; i++) {
+    if (root->nodes[i]->type == NODE_FUNCTION) {
+      optimize_function(root->nodes[i], report, &temp_count);
+    }
+  }
+  optimize_script(root, report, &temp_count);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "../parser/parser.h"
+
+// What the optimizer changed, printed by `sneklang --opt-report`
+typedef struct OptReport {
+  stack_t *messages;    // char *, one line per transformation
+  int hoisted;          // Loop-invariant expressions moved before their loop
+  int strength_reduced; // Induction variable products turned into sums
+  int loads_eliminated; // Reloads of a variable that was just stored
+} opt_report_t;
+
+opt_report_t *opt_report_new();
+void opt_report_free(opt_report_t *report);
+void opt_report_add(opt_report_t *report, const char *format, ...);
+void opt_report_print(FILE *out, opt_report_t *report);
+
+// Rewrites the loops of `root` in place. Invariant arithmetic is computed once
+// into a temporary before the loop, and `i * k` for an induction variable `i`
+// becomes a temporary advanced alongside `i`. Only expressions that can't
+// fail are moved, so a loop that never runs can't raise a new error. Records
+// each change in `report`, which may be NULL.
+void optimize(ast_root_t *root, opt_report_t *report);
@@ -0,0 +1,64 @@
+#include <errno.h>
+#include <stddef.h>
+#include <sys/time.h>
+
+#include "interrupt.h"
+
+static volatile sig_atomic_t *interrupt_flag = NULL;
+static void (*volatile interrupt_tick)(void) = NULL;
+
+static void handle_sigint(int signal) {
+  (void)signal;
+  *interrupt_flag = 1;
+}
+
+static void handle_sigprof(int signal) {
+  (void)signal;
+  int saved = errno;
+  void (*tick)(void) = interrupt_tick;
+  if (tick != NULL) {
+    tick();
+  }
+  errno = saved;
+}
+
+void interrupt_on_sigint(volatile sig_atomic_t *flag) {
+  struct sigaction action = {0};
+  action.sa_handler = flag != NULL ? handle_sigint : SIG_DFL;
+  sigemptyset(&action.sa_mask);
+  // The handler never sees a NULL flag
+  if (flag != NULL) {
+    interrupt_flag = flag;
+  }
+  sigaction(SIGINT, &action, NULL);
+  interrupt_flag = flag;
+}
+
+int interrupt_every(long microseconds, void (*tick)(void)) {
+  struct itimerval timer = {0};
+  if (tick == NULL) {
+    setitimer(ITIMER_PROF, &timer, NULL);
+    interrupt_tick = NULL;
+    signal(SIGPROF, SIG_DFL);
+    return 1;
+  }
+
+  struct sigaction action = {0};
+  action.sa_handler = handle_sigprof;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  interrupt_tick = tick;
+  if (sigaction(SIGPROF, &action, NULL) != 0) {
+    interrupt_tick = NULL;
+    return 0;
+  }
+
+  timer.it_interval.tv_sec = microseconds / 1000000;
+  timer.it_interval.tv_usec = microseconds % 1000000;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+    interrupt_every(0, NULL);
+    return 0;
+  }
+  return 1;
+}
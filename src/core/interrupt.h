@@ -0,0 +1,17 @@
+#pragma once
+
+// <signal.h> declares a stack_t of its own, which would clash with the VM's,
+// so its one is renamed here. Include <signal.h> through this header only.
+#define stack_t signal_stack_t
+#include <signal.h>
+#undef stack_t
+
+// Makes SIGINT set `*flag` (see vm_interrupt) instead of killing the
+// process. Passing NULL restores the default handler.
+void interrupt_on_sigint(volatile sig_atomic_t *flag);
+
+// Calls `tick` from a SIGPROF handler each time the process has used
+// `microseconds` of CPU time, on whichever thread is running. Passing NULL
+// stops the timer and restores the default handler. Returns 0 if the timer
+// couldn't be set.
+int interrupt_every(long microseconds, void (*tick)(void));
@@ -1,15 +1,179 @@
+#include "../compiler/compiler.h"
+#include "../compiler/emit_c.h"
 #include "../lexer/lexer.h"
+#include "../parser/parallel.h"
 #include "../parser/parser.h"
+#include "../vm/cache.h"
+#include "../vm/gc.h"
+#include "../vm/heap_profiler.h"
+#include "../vm/interpreter.h"
+#include "../vm/profiler.h"
+#include "../vm/tracer.h"
+#include "../vm/vm.h"
+#include "interrupt.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+static void print_usage() {
+  printf("Usage: sneklang [--ast] [--bytecode] [--opt-report] [--no-opt] "
+         "[--emit-c] [--no-cache] [--parse-threads N] [--profile FILE] "
+         "[--gc-stats] [--heap-profile FILE] [--trace FILE] "
+         "[--trace-dispatch] <script.snek>\n");
+}
+
+// Runs and frees `program`, returning the process exit status. With a
+// `profile_path`, the run is sampled and the folded stacks written there.
+// With `gc_stats`, the heap counters are written to stderr as JSON at exit.
+// With a `heap_profile_path`, allocations are sampled by site, a report
+// written to stderr and the same numbers to the file as JSON. With a
+// `trace_path`, the last TRACER_DEFAULT_EVENTS trace points (and every
+// instruction, with `trace_dispatch`) are written there as a Chrome trace.
+static int run_program(program_t *program, int show_bytecode,
+                       const char *profile_path, int gc_stats,
+                       const char *heap_profile_path, const char *trace_path,
+                       int trace_dispatch) {
+  if (show_bytecode) {
+    disassemble_program(stdout, program);
+  }
+
+  int status = 0;
+  vm_t *vm = vm_new();
+  profiler_t *profiler = NULL;
+  if (profile_path != NULL) {
+    profiler = profiler_start(vm, PROFILE_INTERVAL_US);
+    if (profiler == NULL) {
+      fprintf(stderr, "Error: Could not start the profiler\n");
+      status = 1;
+    }
+  }
+  heap_profiler_t *heap_profiler = NULL;
+  if (heap_profile_path != NULL) {
+    heap_profiler = heap_profiler_start(vm, HEAP_PROFILE_INTERVAL);
+  }
+  tracer_t *tracer = NULL;
+  if (trace_path != NULL) {
+    tracer = tracer_start(vm, TRACER_DEFAULT_EVENTS, trace_dispatch);
+  }
+
+  // Ctrl-C stops the script at its next safepoint
+  interrupt_on_sigint(&vm->interrupted);
+  if (status == 0 && vm_run(vm, program) != VM_OK) {
+    status = 1;
+  }
+  interrupt_on_sigint(NULL);
+
+  if (profiler != NULL) {
+    profiler_stop(profiler);
+    FILE *out = fopen(profile_path, "w");
+    if (out == NULL || !profiler_write_folded(profiler, out)) {
+      fprintf(stderr, "Error: Could not write profile %s\n", profile_path);
+      status = 1;
+    }
+    if (out != NULL) {
+      fclose(out);
+    }
+    profiler_free(profiler);
+  }
+
+  if (heap_profiler != NULL) {
+    heap_profiler_stop(heap_profiler);
+    heap_profiler_write_report(heap_profiler, stderr);
+    FILE *out = fopen(heap_profile_path, "w");
+    if (out == NULL || !heap_profiler_write_json(heap_profiler, out)) {
+      fprintf(stderr, "Error: Could not write heap profile %s\n",
+              heap_profile_path);
+      status = 1;
+    }
+    if (out != NULL) {
+      fclose(out);
+    }
+    heap_profiler_free(heap_profiler);
+  }
+
+  if (tracer != NULL) {
+    tracer_stop(tracer);
+    FILE *out = fopen(trace_path, "w");
+    if (out == NULL || !tracer_write_chrome_json(tracer, out)) {
+      fprintf(stderr, "Error: Could not write trace %s\n", trace_path);
+      status = 1;
+    }
+    if (out != NULL) {
+      fclose(out);
+    }
+    tracer_free(tracer);
+  }
+
+  if (gc_stats) {
+    gc_stats_t stats = vm_gc_stats(vm);
+    gc_stats_write_json(stderr, &stats);
+  }
+
+  vm_free(vm);
+  program_free(program);
+  return status;
+}
 
 int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    printf("Usage: sneklang <script.snek>\n");
+  const char *script_path = NULL;
+  int show_ast = 0;
+  int show_bytecode = 0;
+  int show_opt_report = 0;
+  int emit_c_source = 0;
+  int use_cache = 1;
+  int parse_threads = 1;
+  const char *profile_path = NULL;
+  int gc_stats = 0;
+  const char *heap_profile_path = NULL;
+  const char *trace_path = NULL;
+  int trace_dispatch = 0;
+  compile_options_t options = {.optimize = true};
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--ast") == 0) {
+      show_ast = 1;
+    } else if (strcmp(argv[i], "--bytecode") == 0) {
+      show_bytecode = 1;
+    } else if (strcmp(argv[i], "--opt-report") == 0) {
+      show_opt_report = 1;
+    } else if (strcmp(argv[i], "--no-opt") == 0) {
+      options.optimize = false;
+    } else if (strcmp(argv[i], "--emit-c") == 0) {
+      emit_c_source = 1;
+    } else if (strcmp(argv[i], "--no-cache") == 0) {
+      use_cache = 0;
+    } else if (strcmp(argv[i], "--parse-threads") == 0 && i + 1 < argc) {
+      parse_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+      profile_path = argv[++i];
+    } else if (strcmp(argv[i], "--gc-stats") == 0) {
+      gc_stats = 1;
+    } else if (strcmp(argv[i], "--heap-profile") == 0 && i + 1 < argc) {
+      heap_profile_path = argv[++i];
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_path = argv[++i];
+    } else if (strcmp(argv[i], "--trace-dispatch") == 0) {
+      trace_dispatch = 1;
+    } else if (argv[i][0] == '-' || script_path != NULL) {
+      print_usage();
+      return 1;
+    } else {
+      script_path = argv[i];
+    }
+  }
+
+  if (script_path == NULL) {
+    print_usage();
     return 1;
   }
+#ifndef SNEK_TRACE
+  if (trace_path != NULL) {
+    fprintf(stderr, "Error: --trace needs a build with trace points "
+                    "(make TRACE=1)\n");
+    return 1;
+  }
+#endif
 
-  const char *script_path = argv[1];
   FILE *file = fopen(script_path, "r");
   if (!file) {
     printf("Error: Could not open script %s\n", script_path);
@@ -27,37 +191,97 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  fread(source, 1, length, file);
-  source[length] = '\0';
+  size_t read = fread(source, 1, length, file);
+  source[read] = '\0';
   fclose(file);
 
-  // Store pointer to source for later freeing
-  char *original_source = source;
+  if (show_ast) {
+    // Print script contents
+    printf("\n### Script Contents ###\n");
+    printf("%s\n", source);
+  }
+
+  // The cache holds optimized bytecode only. Anything that needs the AST or
+  // the optimizer's report compiles from source and leaves the cache alone.
+  uint64_t source_hash = cache_hash_source(source, read);
+  char *cached_path = NULL;
+  if (use_cache && !show_ast && !show_opt_report && !emit_c_source &&
+      options.optimize) {
+    cached_path = cache_path(script_path);
+  }
+
+  if (cached_path != NULL) {
+    program_t *program = cache_load(cached_path, source_hash);
+    if (program != NULL) {
+      free(cached_path);
+      free(source);
+      return run_program(program, show_bytecode, profile_path, gc_stats,
+                         heap_profile_path, trace_path, trace_dispatch);
+    }
+  }
 
-  // Print script contents
-  printf("\n### Script Contents ###\n");
-  printf("%s\n", source);
+  // Parse the script. Without a parser, the parallel parse owns the AST.
+  lexer_t *lexer = NULL;
+  parser_t *parser = NULL;
+  ast_root_t *root;
+  if (parse_threads > 1) {
+    root = parse_root_parallel(source, parse_threads);
+  } else {
+    lexer = lexer_new(source);
+    parser = parser_new(lexer);
+    root = parse_root(parser);
+  }
+  if (root == NULL) {
+    lexer_free(lexer);
+    parser_free(parser);
+    free(cached_path);
+    free(source);
+    return 1;
+  }
 
-  source = original_source;
+  if (show_ast) {
+    // Print the AST
+    printf("\n### AST ###\n");
+    for (int i = 0; i < root->count; i++) {
+      print_ast_tree(root->nodes[i]);
+    }
+  }
 
-  lexer_t *lexer = lexer_new(source);
-  parser_t *parser = parser_new(lexer);
+  int status = 0;
+  if (show_opt_report) {
+    options.report = opt_report_new();
+  }
 
-  // Parse the script
-  parser->root = parse_root(parser);
-  
+  program_t *program = compile_with_options(root, &options);
+  if (options.report != NULL) {
+    opt_report_print(stderr, options.report);
+    opt_report_free(options.report);
+  }
 
-  // Print the AST
-  printf("\n### AST ###\n");
-  for (int i = 0; i < parser->root->count; i++) {
-    print_ast_tree(parser->root->nodes[i]);
+  if (program == NULL) {
+    status = 1;
+  } else if (emit_c_source) {
+    // Compiling first reports any errors and runs the optimizer on the AST
+    program_free(program);
+    if (!emit_c(stdout, root)) {
+      status = 1;
+    }
+  } else {
+    if (cached_path != NULL) {
+      // A read-only directory just means every run compiles
+      cache_write(cached_path, program, source_hash);
+    }
+    status = run_program(program, show_bytecode, profile_path, gc_stats,
+                         heap_profile_path, trace_path, trace_dispatch);
   }
 
-  // TODO: Call the execution engine (not implemented yet)
-  
   // Clean up
+  if (parser == NULL) {
+    ast_root_free(root);
+  }
   lexer_free(lexer);
   parser_free(parser);
+  free(cached_path);
   free(source);
-  return 0;
+  return status;
 }
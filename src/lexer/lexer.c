@@ -63,15 +63,23 @@ token_t *lexer_next_token(lexer_t *lexer) {
     int new_indent = lexer->current - lexer->start;
     int current_indent = lexer->indent_stack[lexer->indent_top];
 
-    if (new_indent > current_indent) {
+    if (*lexer->current == '\n' || *lexer->current == '\0') {
+      // Blank lines don't affect indentation
+      lexer->is_new_line = 0;
+    } else if (new_indent > current_indent) {
       // Indentation increased
       lexer->indent_stack[++lexer->indent_top] = new_indent;
       lexer->is_new_line = 0;
       return token_new(TOKEN_INDENT, "", 0, lexer->line);
     } else if (new_indent < current_indent) {
-      // Indentation decreased
+      // Indentation decreased. Rewind to the start of the line so the next
+      // call emits another DEDENT if more than one block is closed.
       lexer->indent_top--;
-      lexer->is_new_line = 0;
+      if (new_indent >= lexer->indent_stack[lexer->indent_top]) {
+        lexer->is_new_line = 0;
+      } else {
+        lexer->current = lexer->start;
+      }
       return token_new(TOKEN_DEDENT, "", 0, lexer->line);
     } else {
       // Indentation remains the same
@@ -0,0 +1,226 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "snekmap.h"
+#include "snekstring.h"
+
+static bool snek_map_key_valid(snek_object_t *key) {
+  return key != NULL && (key->kind == INTEGER || key->kind == STRING);
+}
+
+static uint32_t snek_map_hash_key(snek_object_t *key) {
+  if (key->kind == STRING) {
+    return snek_string_hash(key);
+  }
+
+  // Integer finalizer from MurmurHash3, so sequential keys spread out
+  uint32_t x = (uint32_t)key->data.v_int;
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+  return x;
+}
+
+static bool snek_map_keys_equal(snek_object_t *a, snek_object_t *b) {
+  if (a->kind != b->kind) {
+    return false;
+  }
+
+  if (a->kind == INTEGER) {
+    return a->data.v_int == b->data.v_int;
+  }
+
+  return snek_string_equal(a, b);
+}
+
+static snek_map_entry_t *table_find(snek_map_table_t *table,
+                                    snek_object_t *key, uint32_t hash) {
+  if (table->entries == NULL) {
+    return NULL;
+  }
+
+  size_t mask = table->capacity - 1;
+  size_t i = hash & mask;
+  for (uint32_t distance = 1;; distance++, i = (i + 1) & mask) {
+    snek_map_entry_t *entry = &table->entries[i];
+
+    // Robin Hood invariant: once a slot is closer to its home than we are to
+    // ours, the key would have displaced it, so it is not in the table.
+    if (entry->distance < distance) {
+      return NULL;
+    }
+
+    if (entry->key != NULL && entry->hash == hash &&
+        snek_map_keys_equal(entry->key, key)) {
+      return entry;
+    }
+  }
+}
+
+// Inserts a key known to be absent. Only used on the current table, which
+// never holds tombstones, so a zero distance always means a free slot.
+static void table_insert(snek_map_table_t *table, snek_map_entry_t entry) {
+  size_t mask = table->capacity - 1;
+  size_t i = entry.hash & mask;
+
+  for (entry.distance = 1;; entry.distance++, i = (i + 1) & mask) {
+    snek_map_entry_t *slot = &table->entries[i];
+    if (slot->distance == 0) {
+      *slot = entry;
+      table->count++;
+      return;
+    }
+
+    // Displace entries that are closer to their home slot than we are
+    if (slot->distance < entry.distance) {
+      snek_map_entry_t displaced = *slot;
+      *slot = entry;
+      entry = displaced;
+    }
+  }
+}
+
+// Backward-shift deletion keeps probe sequences short without tombstones.
+static void table_remove(snek_map_table_t *table, snek_map_entry_t *entry) {
+  size_t mask = table->capacity - 1;
+  size_t i = entry - table->entries;
+
+  for (;;) {
+    size_t next = (i + 1) & mask;
+    snek_map_entry_t *following = &table->entries[next];
+    if (following->distance <= 1) {
+      table->entries[i] = (snek_map_entry_t){0};
+      break;
+    }
+
+    table->entries[i] = *following;
+    table->entries[i].distance--;
+    i = next;
+  }
+
+  table->count--;
+}
+
+// Moves up to `steps` slots of the old table into the current one. Moved and
+// deleted slots of the old table become tombstones (NULL key, distance kept)
+// so lookups for the entries after them still probe far enough.
+static void snek_map_migrate(snek_map_t *map, size_t steps) {
+  snek_map_table_t *old = &map->old;
+
+  while (old->entries != NULL && steps-- > 0) {
+    if (old->count == 0 || map->migrate_index == old->capacity) {
+      free(old->entries);
+      *old = (snek_map_table_t){0};
+      map->migrate_index = 0;
+      return;
+    }
+
+    snek_map_entry_t *entry = &old->entries[map->migrate_index++];
+    if (entry->key != NULL) {
+      table_insert(&map->table, *entry);
+      entry->key = NULL;
+      entry->value = NULL;
+      old->count--;
+    }
+  }
+}
+
+static bool snek_map_grow(snek_map_t *map) {
+  // Never have two resizes in flight
+  snek_map_migrate(map, SIZE_MAX);
+
+  size_t capacity = map->table.capacity * 2;
+  snek_map_entry_t *entries = calloc(capacity, sizeof(snek_map_entry_t));
+  if (entries == NULL) {
+    return false;
+  }
+
+  map->old = map->table;
+  map->table = (snek_map_table_t){.entries = entries, .capacity = capacity};
+  map->migrate_index = 0;
+  return true;
+}
+
+bool snek_map_set(snek_object_t *obj, snek_object_t *key,
+                  snek_object_t *value) {
+  if (obj == NULL || obj->kind != MAP || !snek_map_key_valid(key) ||
+      value == NULL) {
+    return false;
+  }
+
+  snek_map_t *map = obj->data.v_map;
+  uint32_t hash = snek_map_hash_key(key);
+  snek_map_migrate(map, SNEK_MAP_MIGRATE_STEP);
+
+  snek_map_entry_t *entry = table_find(&map->table, key, hash);
+  if (entry == NULL) {
+    // Entries not yet migrated are updated where they are
+    entry = table_find(&map->old, key, hash);
+  }
+  if (entry != NULL) {
+    entry->value = value;
+    return true;
+  }
+
+  // Keep the load factor at or below 3/4, counting entries still in `old`
+  size_t count = map->table.count + map->old.count + 1;
+  if (count * 4 > map->table.capacity * 3 && !snek_map_grow(map)) {
+    return false;
+  }
+
+  table_insert(&map->table,
+               (snek_map_entry_t){.key = key, .value = value, .hash = hash});
+  return true;
+}
+
+snek_object_t *snek_map_get(snek_object_t *obj, snek_object_t *key) {
+  if (obj == NULL || obj->kind != MAP || !snek_map_key_valid(key)) {
+    return NULL;
+  }
+
+  snek_map_t *map = obj->data.v_map;
+  uint32_t hash = snek_map_hash_key(key);
+
+  snek_map_entry_t *entry = table_find(&map->table, key, hash);
+  if (entry == NULL) {
+    entry = table_find(&map->old, key, hash);
+  }
+
+  return entry != NULL ? entry->value : NULL;
+}
+
+bool snek_map_delete(snek_object_t *obj, snek_object_t *key) {
+  if (obj == NULL || obj->kind != MAP || !snek_map_key_valid(key)) {
+    return false;
+  }
+
+  snek_map_t *map = obj->data.v_map;
+  uint32_t hash = snek_map_hash_key(key);
+  snek_map_migrate(map, SNEK_MAP_MIGRATE_STEP);
+
+  snek_map_entry_t *entry = table_find(&map->table, key, hash);
+  if (entry != NULL) {
+    table_remove(&map->table, entry);
+    return true;
+  }
+
+  entry = table_find(&map->old, key, hash);
+  if (entry != NULL) {
+    entry->key = NULL;
+    entry->value = NULL;
+    map->old.count--;
+    return true;
+  }
+
+  return false;
+}
+
+size_t snek_map_count(snek_object_t *obj) {
+  if (obj == NULL || obj->kind != MAP) {
+    return 0;
+  }
+
+  return obj->data.v_map->table.count + obj->data.v_map->old.count;
+}
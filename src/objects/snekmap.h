@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "snekobject.h"
+
+#define SNEK_MAP_MIN_CAPACITY 8
+// Slots of the old table moved per write while a resize is in progress. At
+// a 3/4 load factor this always finishes before the new table fills up.
+#define SNEK_MAP_MIGRATE_STEP 8
+
+bool snek_map_set(snek_object_t *map, snek_object_t *key, snek_object_t *value);
+snek_object_t *snek_map_get(snek_object_t *map, snek_object_t *key);
+bool snek_map_delete(snek_object_t *map, snek_object_t *key);
+size_t snek_map_count(snek_object_t *map);
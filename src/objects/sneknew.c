@@ -2,37 +2,125 @@
 #include <string.h>
 
 #include "../vm/vm.h"
+#include "sneknew.h"
+#include "snekmap.h"
 #include "snekobject.h"
+#include "snektypedarray.h"
 
-snek_object_t *_new_snek_object(vm_t *vm) {
+static snek_object_t *_new_snek_object(void) {
   snek_object_t *obj = calloc(1, sizeof(snek_object_t));
   if (obj == NULL) {
     return NULL;
   }
 
   obj->is_marked = false;
+  return obj;
+}
 
-  vm_track_object(vm, obj);
-
+// Hands a finished object to the VM's heap. Constructors call this last, so
+// the VM never tracks an object they give up on, and it counts the object
+// with its kind and buffers.
+static snek_object_t *track(vm_t *vm, snek_object_t *obj) {
+  if (vm != NULL) {
+    vm_track_object(vm, obj);
+  }
   return obj;
 }
 
 snek_object_t *new_snek_array(vm_t *vm, size_t size) {
-  snek_object_t *obj = _new_snek_object(vm);
+  snek_object_t *obj = _new_snek_object();
   if (obj == NULL) {
     return NULL;
   }
 
   snek_object_t **elements = calloc(size, sizeof(snek_object_t *));
-  if (elements == NULL) {
+  if (elements == NULL && size > 0) {
     free(obj);
     return NULL;
   }
 
   obj->kind = ARRAY;
-  obj->data.v_array = (snek_array_t){.size = size, .elements = elements};
+  obj->data.v_array =
+      (snek_array_t){.size = size, .capacity = size, .elements = elements};
 
-  return obj;
+  return track(vm, obj);
+}
+
+snek_object_t *new_snek_array_slice(vm_t *vm, snek_object_t *array,
+                                    size_t start, size_t end) {
+  if (array == NULL || array->kind != ARRAY) {
+    return NULL;
+  }
+
+  snek_array_t *source = &array->data.v_array;
+  if (start > end || end > source->size) {
+    return NULL;
+  }
+
+  // Slicing a view shares the root's storage, never a chain of views
+  snek_object_t *base = array;
+  size_t offset = start;
+  if (source->base != NULL) {
+    base = source->base;
+    offset += source->offset;
+  }
+
+  snek_object_t *obj = _new_snek_object();
+  if (obj == NULL) {
+    return NULL;
+  }
+
+  obj->kind = ARRAY;
+  obj->data.v_array =
+      (snek_array_t){.size = end - start, .base = base, .offset = offset};
+
+  return track(vm, obj);
+}
+
+snek_object_t *new_snek_map(vm_t *vm) {
+  snek_object_t *obj = _new_snek_object();
+  if (obj == NULL) {
+    return NULL;
+  }
+
+  snek_map_t *map = calloc(1, sizeof(snek_map_t));
+  if (map == NULL) {
+    free(obj);
+    return NULL;
+  }
+
+  map->table.capacity = SNEK_MAP_MIN_CAPACITY;
+  map->table.entries = calloc(map->table.capacity, sizeof(snek_map_entry_t));
+  if (map->table.entries == NULL) {
+    free(map);
+    free(obj);
+    return NULL;
+  }
+
+  obj->kind = MAP;
+  obj->data.v_map = map;
+
+  return track(vm, obj);
+}
+
+snek_object_t *new_snek_typed_array(vm_t *vm, snek_element_kind_t kind,
+                                    size_t size) {
+  snek_object_t *obj = _new_snek_object();
+  if (obj == NULL) {
+    return NULL;
+  }
+
+  void *data = calloc(size, snek_element_size(kind));
+  if (data == NULL && size > 0) {
+    free(obj);
+    return NULL;
+  }
+
+  obj->kind = TYPED_ARRAY;
+  obj->data.v_typed_array =
+      (snek_typed_array_t){.element_kind = kind, .size = size, .data = data};
+
+  return track(vm, obj);
 }
 
 snek_object_t *new_snek_vector3(vm_t *vm, snek_object_t *x, snek_object_t *y,
@@ -41,7 +129,7 @@ snek_object_t *new_snek_vector3(vm_t *vm, snek_object_t *x, snek_object_t *y,
     return NULL;
   }
 
-  snek_object_t *obj = _new_snek_object(vm);
+  snek_object_t *obj = _new_snek_object();
   if (obj == NULL) {
     return NULL;
   }
@@ -49,11 +137,11 @@ snek_object_t *new_snek_vector3(vm_t *vm, snek_object_t *x, snek_object_t *y,
   obj->kind = VECTOR3;
   obj->data.v_vector3 = (snek_vector_t){.x = x, .y = y, .z = z};
 
-  return obj;
+  return track(vm, obj);
 }
 
 snek_object_t *new_snek_integer(vm_t *vm, int value) {
-  snek_object_t *obj = _new_snek_object(vm);
+  snek_object_t *obj = _new_snek_object();
   if (obj == NULL) {
     return NULL;
   }
@@ -61,36 +149,71 @@ snek_object_t *new_snek_integer(vm_t *vm, int value) {
   obj->kind = INTEGER;
   obj->data.v_int = value;
 
-  return obj;
+  return track(vm, obj);
 }
 
 snek_object_t *new_snek_float(vm_t *vm, float value) {
-  snek_object_t *obj = _new_snek_object(vm);
+  snek_object_t *obj = _new_snek_object();
   if (obj == NULL) {
     return NULL;
   }
 
   obj->kind = FLOAT;
   obj->data.v_float = value;
-  return obj;
+  return track(vm, obj);
 }
 
 snek_object_t *new_snek_string(vm_t *vm, char *value) {
-  snek_object_t *obj = _new_snek_object(vm);
+  return new_snek_string_len(vm, value, strlen(value));
+}
+
+snek_object_t *new_snek_string_len(vm_t *vm, const char *value,
+                                   size_t length) {
+  snek_object_t *obj = _new_snek_object();
   if (obj == NULL) {
     return NULL;
   }
 
-  int len = strlen(value);
-  char *dst = malloc(len + 1);
+  obj->kind = STRING;
+  obj->data.v_string = (snek_string_t){.length = length};
+
+  // Short strings are stored in the object, saving a second allocation
+  if (snek_string_is_inline(&obj->data.v_string)) {
+    memcpy(obj->data.v_string.inline_chars, value, length);
+    obj->data.v_string.inline_chars[length] = '\0';
+    return track(vm, obj);
+  }
+
+  char *dst = malloc(length + 1);
   if (dst == NULL) {
     free(obj);
     return NULL;
   }
 
-  strcpy(dst, value);
+  memcpy(dst, value, length);
+  dst[length] = '\0';
+
+  obj->data.v_string.chars = dst;
+  return track(vm, obj);
+}
+
+snek_object_t *new_snek_rope(vm_t *vm, snek_object_t *left,
+                             snek_object_t *right) {
+  if (left == NULL || right == NULL || left->kind != STRING ||
+      right->kind != STRING) {
+    return NULL;
+  }
+
+  snek_object_t *obj = _new_snek_object();
+  if (obj == NULL) {
+    return NULL;
+  }
 
   obj->kind = STRING;
-  obj->data.v_string = dst;
-  return obj;
+  obj->data.v_string = (snek_string_t){
+      .length = left->data.v_string.length + right->data.v_string.length,
+      .left = left,
+      .right = right,
+  };
+  return track(vm, obj);
 }
@@ -3,9 +3,22 @@
 #include "../vm/vm.h"
 #include "snekobject.h"
 
+// Every constructor registers the new object with `vm` for garbage
+// collection. With a NULL `vm` the object is untracked and owned by the
+// caller, which must release it with snek_object_free.
 snek_object_t *new_snek_integer(vm_t *vm, int value);
 snek_object_t *new_snek_float(vm_t *vm, float value);
 snek_object_t *new_snek_string(vm_t *vm, char *value);
+snek_object_t *new_snek_string_len(vm_t *vm, const char *value, size_t length);
+// Lazy concatenation of two strings, see snekstring.h
+snek_object_t *new_snek_rope(vm_t *vm, snek_object_t *left,
+                             snek_object_t *right);
 snek_object_t *new_snek_vector3(vm_t *vm, snek_object_t *x, snek_object_t *y,
                                 snek_object_t *z);
 snek_object_t *new_snek_array(vm_t *vm, size_t size);
+// Zero-copy view of elements [start, end) of `array`
+snek_object_t *new_snek_array_slice(vm_t *vm, snek_object_t *array,
+                                    size_t start, size_t end);
+snek_object_t *new_snek_map(vm_t *vm);
+snek_object_t *new_snek_typed_array(vm_t *vm, snek_element_kind_t kind,
+                                    size_t size);
@@ -1,7 +1,10 @@
 #include <string.h>
 
 #include "sneknew.h"
+#include "snekmap.h"
 #include "snekobject.h"
+#include "snekstring.h"
+#include "snektypedarray.h"
 
 void snek_object_free(snek_object_t *obj) {
   switch (obj->kind) {
@@ -9,7 +12,9 @@ void snek_object_free(snek_object_t *obj) {
   case FLOAT:
     break;
   case STRING:
-    free(obj->data.v_string);
+    if (!snek_string_is_inline(&obj->data.v_string)) {
+      free(obj->data.v_string.chars);
+    }
     break;
   case VECTOR3: {
     break;
@@ -20,11 +25,94 @@ void snek_object_free(snek_object_t *obj) {
 
     break;
   }
+  case TYPED_ARRAY:
+    free(obj->data.v_typed_array.data);
+    break;
+  case MAP:
+    free(obj->data.v_map->table.entries);
+    free(obj->data.v_map->old.entries);
+    free(obj->data.v_map);
+    break;
   }
 
   free(obj);
 }
 
+size_t snek_buffer_size(snek_object_t *obj) {
+  size_t size = 0;
+
+  switch (obj->kind) {
+  case STRING:
+    if (!snek_string_is_inline(&obj->data.v_string) &&
+        obj->data.v_string.chars != NULL) {
+      size += obj->data.v_string.length + 1;
+    }
+    break;
+  case ARRAY:
+    if (obj->data.v_array.base == NULL) {
+      size += obj->data.v_array.capacity * sizeof(snek_object_t *);
+    }
+    break;
+  case TYPED_ARRAY:
+    size += obj->data.v_typed_array.size *
+            snek_element_size(obj->data.v_typed_array.element_kind);
+    break;
+  case MAP:
+    size += sizeof(snek_map_t) + (obj->data.v_map->table.capacity +
+                                  obj->data.v_map->old.capacity) *
+                                     sizeof(snek_map_entry_t);
+    break;
+  default:
+    break;
+  }
+  return size;
+}
+
+// Returns the first slot of `array`, and via `available` how many slots from
+// there are actually backed by storage. A view may outlive elements popped
+// from its base, so `available` can be smaller than `size`.
+static snek_object_t **snek_array_slots(snek_array_t *array,
+                                        size_t *available) {
+  if (array->base == NULL) {
+    *available = array->size;
+    return array->elements;
+  }
+
+  snek_array_t *base = &array->base->data.v_array;
+  if (array->offset >= base->size) {
+    *available = 0;
+    return NULL;
+  }
+
+  size_t remaining = base->size - array->offset;
+  *available = array->size < remaining ? array->size : remaining;
+  return base->elements + array->offset;
+}
+
+// Gives a view its own copy of the elements it can still see, so it can grow
+// without writing into its base.
+static bool snek_array_materialize(snek_array_t *array) {
+  size_t available;
+  snek_object_t **slots = snek_array_slots(array, &available);
+
+  size_t capacity = available < 8 ? 8 : available;
+  snek_object_t **elements = malloc(capacity * sizeof(snek_object_t *));
+  if (elements == NULL) {
+    return false;
+  }
+
+  if (available > 0) {
+    memcpy(elements, slots, available * sizeof(snek_object_t *));
+  }
+
+  array->size = available;
+  array->capacity = capacity;
+  array->elements = elements;
+  array->base = NULL;
+  array->offset = 0;
+  return true;
+}
+
 bool snek_array_set(snek_object_t *array, size_t index, snek_object_t *value) {
   if (array == NULL || value == NULL) {
     return false;
@@ -34,11 +122,13 @@ bool snek_array_set(snek_object_t *array, size_t index, snek_object_t *value) {
     return false;
   }
 
-  if (index >= array->data.v_array.size) {
+  size_t available;
+  snek_object_t **slots = snek_array_slots(&array->data.v_array, &available);
+  if (index >= available) {
     return false;
   }
 
-  array->data.v_array.elements[index] = value;
+  slots[index] = value;
   return true;
 }
 
@@ -51,12 +141,76 @@ snek_object_t *snek_array_get(snek_object_t *array, size_t index) {
     return NULL;
   }
 
-  if (index >= array->data.v_array.size) {
+  size_t available;
+  snek_object_t **slots = snek_array_slots(&array->data.v_array, &available);
+  if (index >= available) {
     return NULL;
   }
 
   // Set the value directly now (already checked size constraint)
-  return array->data.v_array.elements[index];
+  return slots[index];
+}
+
+bool snek_array_reserve(snek_object_t *array, size_t capacity) {
+  if (array == NULL || array->kind != ARRAY) {
+    return false;
+  }
+
+  snek_array_t *arr = &array->data.v_array;
+  if (arr->base != NULL && !snek_array_materialize(arr)) {
+    return false;
+  }
+
+  if (capacity <= arr->capacity) {
+    return true;
+  }
+
+  snek_object_t **elements =
+      realloc(arr->elements, capacity * sizeof(snek_object_t *));
+  if (elements == NULL) {
+    return false;
+  }
+
+  arr->elements = elements;
+  arr->capacity = capacity;
+  return true;
+}
+
+bool snek_array_append(snek_object_t *array, snek_object_t *value) {
+  if (array == NULL || value == NULL || array->kind != ARRAY) {
+    return false;
+  }
+
+  snek_array_t *arr = &array->data.v_array;
+  if (arr->base != NULL && !snek_array_materialize(arr)) {
+    return false;
+  }
+
+  // Doubling keeps appends amortized O(1)
+  if (arr->size == arr->capacity) {
+    size_t capacity = arr->capacity < 8 ? 8 : arr->capacity * 2;
+    if (!snek_array_reserve(array, capacity)) {
+      return false;
+    }
+  }
+
+  arr->elements[arr->size++] = value;
+  return true;
+}
+
+snek_object_t *snek_array_pop(snek_object_t *array) {
+  if (array == NULL || array->kind != ARRAY) {
+    return NULL;
+  }
+
+  snek_array_t *arr = &array->data.v_array;
+  if (arr->size == 0) {
+    return NULL;
+  }
+
+  snek_object_t *value = snek_array_get(array, arr->size - 1);
+  arr->size--;
+  return value;
 }
 
 snek_object_t *snek_add(vm_t *vm, snek_object_t *a, snek_object_t *b) {
@@ -68,7 +222,7 @@ snek_object_t *snek_add(vm_t *vm, snek_object_t *a, snek_object_t *b) {
   case INTEGER:
     switch (b->kind) {
     case INTEGER:
-      return new_snek_integer(vm, a->data.v_int + b->data.v_int);
+      return new_snek_integer(vm, snek_int_add(a->data.v_int, b->data.v_int));
     case FLOAT:
       return new_snek_float(vm, (float)a->data.v_int + b->data.v_float);
     default:
@@ -83,21 +237,8 @@ snek_object_t *snek_add(vm_t *vm, snek_object_t *a, snek_object_t *b) {
     }
   case STRING:
     switch (b->kind) {
-    case STRING: {
-      int a_len = strlen(a->data.v_string);
-      int b_len = strlen(b->data.v_string);
-      int len = a_len + b_len + 1;
-      char *dst = malloc(len * sizeof(char));
-      dst[0] = '\0';
-
-      strcat(dst, a->data.v_string);
-      strcat(dst, b->data.v_string);
-
-      snek_object_t *obj = new_snek_string(vm, dst);
-      free(dst);
-
-      return obj;
-    }
+    case STRING:
+      return snek_string_concat(vm, a, b);
     default:
       return NULL;
     }
@@ -114,18 +255,21 @@ snek_object_t *snek_add(vm_t *vm, snek_object_t *a, snek_object_t *b) {
   case ARRAY:
     switch (b->kind) {
     case ARRAY: {
-      size_t a_len = a->data.v_array.size;
-      size_t b_len = b->data.v_array.size;
-      size_t length = a_len + b_len;
-
-      snek_object_t *array = new_snek_array(vm, length);
+      size_t a_len, b_len;
+      snek_object_t **a_slots = snek_array_slots(&a->data.v_array, &a_len);
+      snek_object_t **b_slots = snek_array_slots(&b->data.v_array, &b_len);
 
-      for (size_t i = 0; i < a_len; i++) {
-        snek_array_set(array, i, snek_array_get(a, i));
+      snek_object_t *array = new_snek_array(vm, a_len + b_len);
+      if (array == NULL) {
+        return NULL;
       }
 
-      for (size_t i = 0; i < b_len; i++) {
-        snek_array_set(array, i + a_len, snek_array_get(b, i));
+      snek_object_t **elements = array->data.v_array.elements;
+      if (a_len > 0) {
+        memcpy(elements, a_slots, a_len * sizeof(snek_object_t *));
+      }
+      if (b_len > 0) {
+        memcpy(elements + a_len, b_slots, b_len * sizeof(snek_object_t *));
       }
 
       return array;
@@ -133,7 +277,213 @@ snek_object_t *snek_add(vm_t *vm, snek_object_t *a, snek_object_t *b) {
     default:
       return NULL;
     }
+  case TYPED_ARRAY:
+    return snek_typed_array_add(vm, a, b);
   default:
     return NULL;
   }
 }
+
+// Applies `op` to two numbers, promoting to float when either one is a float.
+// Returns NULL if either operand is not a number.
+static snek_object_t *snek_arithmetic(vm_t *vm, char op, snek_object_t *a,
+                                      snek_object_t *b) {
+  if (a == NULL || b == NULL) {
+    return NULL;
+  }
+
+  if (a->kind == INTEGER && b->kind == INTEGER) {
+    int x = a->data.v_int;
+    int y = b->data.v_int;
+    switch (op) {
+    case '-':
+      return new_snek_integer(vm, snek_int_subtract(x, y));
+    case '*':
+      return new_snek_integer(vm, snek_int_multiply(x, y));
+    case '/':
+      return y == 0 ? NULL : new_snek_integer(vm, snek_int_divide(x, y));
+    default:
+      return NULL;
+    }
+  }
+
+  if ((a->kind != INTEGER && a->kind != FLOAT) ||
+      (b->kind != INTEGER && b->kind != FLOAT)) {
+    return NULL;
+  }
+
+  float x = a->kind == FLOAT ? a->data.v_float : (float)a->data.v_int;
+  float y = b->kind == FLOAT ? b->data.v_float : (float)b->data.v_int;
+  switch (op) {
+  case '-':
+    return new_snek_float(vm, x - y);
+  case '*':
+    return new_snek_float(vm, x * y);
+  case '/':
+    return new_snek_float(vm, x / y);
+  default:
+    return NULL;
+  }
+}
+
+snek_object_t *snek_subtract(vm_t *vm, snek_object_t *a, snek_object_t *b) {
+  if (a != NULL && b != NULL && a->kind == VECTOR3 && b->kind == VECTOR3) {
+    return new_snek_vector3(
+        vm, snek_subtract(vm, a->data.v_vector3.x, b->data.v_vector3.x),
+        snek_subtract(vm, a->data.v_vector3.y, b->data.v_vector3.y),
+        snek_subtract(vm, a->data.v_vector3.z, b->data.v_vector3.z));
+  }
+
+  return snek_arithmetic(vm, '-', a, b);
+}
+
+snek_object_t *snek_multiply(vm_t *vm, snek_object_t *a, snek_object_t *b) {
+  return snek_arithmetic(vm, '*', a, b);
+}
+
+snek_object_t *snek_divide(vm_t *vm, snek_object_t *a, snek_object_t *b) {
+  return snek_arithmetic(vm, '/', a, b);
+}
+
+snek_object_t *snek_negate(vm_t *vm, snek_object_t *a) {
+  if (a == NULL) {
+    return NULL;
+  }
+
+  switch (a->kind) {
+  case INTEGER:
+    return new_snek_integer(vm, snek_int_negate(a->data.v_int));
+  case FLOAT:
+    return new_snek_float(vm, -a->data.v_float);
+  default:
+    return NULL;
+  }
+}
+
+static bool snek_is_number(snek_object_t *obj) {
+  return obj != NULL && (obj->kind == INTEGER || obj->kind == FLOAT);
+}
+
+static float snek_number_value(snek_object_t *obj) {
+  return obj->kind == FLOAT ? obj->data.v_float : (float)obj->data.v_int;
+}
+
+bool snek_equal(snek_object_t *a, snek_object_t *b) {
+  if (a == b) {
+    return true;
+  }
+  if (a == NULL || b == NULL) {
+    return false;
+  }
+
+  if (a->kind == INTEGER && b->kind == INTEGER) {
+    return a->data.v_int == b->data.v_int;
+  }
+  if (snek_is_number(a) && snek_is_number(b)) {
+    return snek_number_value(a) == snek_number_value(b);
+  }
+  if (a->kind == STRING && b->kind == STRING) {
+    return snek_string_equal(a, b);
+  }
+
+  // Containers compare by identity
+  return false;
+}
+
+bool snek_compare(snek_object_t *a, snek_object_t *b, int *out) {
+  if (a == NULL || b == NULL) {
+    return false;
+  }
+
+  if (a->kind == INTEGER && b->kind == INTEGER) {
+    *out = (a->data.v_int > b->data.v_int) - (a->data.v_int < b->data.v_int);
+    return true;
+  }
+  if (snek_is_number(a) && snek_is_number(b)) {
+    float x = snek_number_value(a);
+    float y = snek_number_value(b);
+    *out = (x > y) - (x < y);
+    return true;
+  }
+  if (a->kind == STRING && b->kind == STRING) {
+    *out = strcmp(snek_string_cstr(a), snek_string_cstr(b));
+    return true;
+  }
+
+  return false;
+}
+
+bool snek_is_truthy(snek_object_t *obj) {
+  if (obj == NULL) {
+    return false;
+  }
+
+  switch (obj->kind) {
+  case INTEGER:
+    return obj->data.v_int != 0;
+  case FLOAT:
+    return obj->data.v_float != 0.0f;
+  case STRING:
+    return obj->data.v_string.length > 0;
+  case ARRAY:
+    return obj->data.v_array.size > 0;
+  case TYPED_ARRAY:
+    return obj->data.v_typed_array.size > 0;
+  case MAP:
+    return snek_map_count(obj) > 0;
+  case VECTOR3:
+    return true;
+  }
+
+  return false;
+}
+
+void snek_object_print(FILE *out, snek_object_t *obj) {
+  if (obj == NULL) {
+    fprintf(out, "null");
+    return;
+  }
+
+  switch (obj->kind) {
+  case INTEGER:
+    fprintf(out, "%d", obj->data.v_int);
+    break;
+  case FLOAT:
+    fprintf(out, "%g", obj->data.v_float);
+    break;
+  case STRING:
+    fwrite(snek_string_cstr(obj), 1, obj->data.v_string.length, out);
+    break;
+  case VECTOR3:
+    fprintf(out, "<");
+    snek_object_print(out, obj->data.v_vector3.x);
+    fprintf(out, ", ");
+    snek_object_print(out, obj->data.v_vector3.y);
+    fprintf(out, ", ");
+    snek_object_print(out, obj->data.v_vector3.z);
+    fprintf(out, ">");
+    break;
+  case ARRAY:
+    fprintf(out, "[");
+    for (size_t i = 0; i < obj->data.v_array.size; i++) {
+      if (i > 0) {
+        fprintf(out, ", ");
+      }
+      snek_object_print(out, snek_array_get(obj, i));
+    }
+    fprintf(out, "]");
+    break;
+  case TYPED_ARRAY:
+    fprintf(out, "[");
+    for (size_t i = 0; i < obj->data.v_typed_array.size; i++) {
+      double value = 0;
+      snek_typed_array_get(obj, i, &value);
+      fprintf(out, "%s%g", i > 0 ? ", " : "", value);
+    }
+    fprintf(out, "]");
+    break;
+  case MAP:
+    fprintf(out, "<map of %zu>", snek_map_count(obj));
+    break;
+  }
+}
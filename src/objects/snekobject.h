@@ -2,17 +2,80 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 #include "../stack/stack.h"
 
 typedef struct VirtualMachine vm_t;
 typedef struct SnekObject snek_object_t;
 
+// An array either owns `elements` (growable up to `capacity`) or is a view of
+// `size` elements of `base`, starting at `offset`. Views share the backing
+// store and keep `base` alive; appending to a view copies it out first.
 typedef struct {
   size_t size;
+  size_t capacity;
   snek_object_t **elements;
+  snek_object_t *base;
+  size_t offset;
 } snek_array_t;
 
+// Strings know their length and cache their hash. Strings shorter than
+// SNEK_STRING_INLINE_CAPACITY live in `inline_chars`, inside the object
+// itself. Longer ones own a heap buffer in `chars`, or, for a concatenation
+// of two long strings, are a rope (`left` + `right`, `chars == NULL`) that is
+// only flattened when its characters are needed.
+#define SNEK_STRING_INLINE_CAPACITY 24
+
+typedef struct {
+  size_t length;
+  uint32_t hash; // 0 until computed
+  union {
+    char inline_chars[SNEK_STRING_INLINE_CAPACITY];
+    struct {
+      char *chars;
+      snek_object_t *left;
+      snek_object_t *right;
+    };
+  };
+} snek_string_t;
+
+typedef enum SnekElementKind {
+  ELEMENT_INT32,
+  ELEMENT_FLOAT,
+  ELEMENT_DOUBLE,
+} snek_element_kind_t;
+
+// Homogeneous array of unboxed primitives. The GC never scans `data`.
+typedef struct {
+  snek_element_kind_t element_kind;
+  size_t size;
+  void *data;
+} snek_typed_array_t;
+
+typedef struct {
+  snek_object_t *key; // NULL for empty slots and tombstones
+  snek_object_t *value;
+  uint32_t hash;
+  uint32_t distance; // probe distance + 1, 0 for an empty slot
+} snek_map_entry_t;
+
+typedef struct {
+  snek_map_entry_t *entries;
+  size_t capacity; // always a power of two
+  size_t count;
+} snek_map_table_t;
+
+// Open-addressing hash table with Robin Hood probing, keyed by INTEGER and
+// STRING objects. Growing moves entries from `old` into `table` a few slots
+// per write, so no single insert pays for rehashing the whole map.
+typedef struct {
+  snek_map_table_t table;
+  snek_map_table_t old;
+  size_t migrate_index; // next slot of `old` to move into `table`
+} snek_map_t;
+
 typedef struct {
   snek_object_t *x;
   snek_object_t *y;
@@ -25,14 +88,18 @@ typedef enum SnekObjectKind {
   STRING,
   VECTOR3,
   ARRAY,
+  TYPED_ARRAY,
+  MAP,
 } snek_object_kind_t;
 
 typedef union SnekObjectData {
   int v_int;
   float v_float;
-  char *v_string;
+  snek_string_t v_string;
   snek_vector_t v_vector3;
   snek_array_t v_array;
+  snek_typed_array_t v_typed_array;
+  snek_map_t *v_map;
 } snek_object_data_t;
 
 typedef struct SnekObject {
@@ -42,8 +109,60 @@ typedef struct SnekObject {
   snek_object_data_t data;
 } snek_object_t;
 
+#define snek_string_is_inline(str)                                             \
+  ((str)->length < SNEK_STRING_INLINE_CAPACITY)
+
 void snek_object_free(snek_object_t *obj);
+// Bytes `obj` holds: the object and the buffers it owns as they are now,
+// without the allocator's own overhead. Array views count only themselves.
+size_t snek_buffer_size(snek_object_t *obj);
+static inline size_t snek_object_size(snek_object_t *obj) {
+  // Numbers are most of the heap, and own nothing
+  if (obj->kind == INTEGER || obj->kind == FLOAT) {
+    return sizeof(snek_object_t);
+  }
+  return sizeof(snek_object_t) + snek_buffer_size(obj);
+}
 
 bool snek_array_set(snek_object_t *array, size_t index, snek_object_t *value);
 snek_object_t *snek_array_get(snek_object_t *array, size_t index);
+bool snek_array_append(snek_object_t *array, snek_object_t *value);
+snek_object_t *snek_array_pop(snek_object_t *array);
+bool snek_array_reserve(snek_object_t *array, size_t capacity);
+// Int arithmetic wraps around in two's complement, here and in the C that
+// --emit-c generates, rather than overflowing (which C leaves undefined)
+static inline int snek_int_add(int a, int b) {
+  return (int)((uint32_t)a + (uint32_t)b);
+}
+
+static inline int snek_int_subtract(int a, int b) {
+  return (int)((uint32_t)a - (uint32_t)b);
+}
+
+static inline int snek_int_multiply(int a, int b) {
+  return (int)((uint32_t)a * (uint32_t)b);
+}
+
+static inline int snek_int_negate(int a) { return (int)(0u - (uint32_t)a); }
+
+// `b` must not be 0. The one quotient that overflows, INT_MIN / -1, wraps
+// around to INT_MIN instead of trapping.
+static inline int snek_int_divide(int a, int b) {
+  return b == -1 ? snek_int_negate(a) : a / b;
+}
+
 snek_object_t *snek_add(vm_t *vm, snek_object_t *a, snek_object_t *b);
+snek_object_t *snek_subtract(vm_t *vm, snek_object_t *a, snek_object_t *b);
+snek_object_t *snek_multiply(vm_t *vm, snek_object_t *a, snek_object_t *b);
+// Returns NULL for integer division by zero
+snek_object_t *snek_divide(vm_t *vm, snek_object_t *a, snek_object_t *b);
+snek_object_t *snek_negate(vm_t *vm, snek_object_t *a);
+
+// Numbers compare by value across kinds, strings by contents and everything
+// else by identity. null only equals null.
+bool snek_equal(snek_object_t *a, snek_object_t *b);
+// Orders two numbers or two strings, setting `out` to <0, 0 or >0. Returns
+// false if the operands can't be ordered.
+bool snek_compare(snek_object_t *a, snek_object_t *b, int *out);
+bool snek_is_truthy(snek_object_t *obj);
+void snek_object_print(FILE *out, snek_object_t *obj);
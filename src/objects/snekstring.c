@@ -0,0 +1,143 @@
+#include <string.h>
+
+#include "../stack/stack.h"
+#include "sneknew.h"
+#include "snekstring.h"
+
+// Inline storage is keyed on length alone, so a rope must always be too long
+// to be mistaken for an inline string.
+_Static_assert(SNEK_ROPE_THRESHOLD >= SNEK_STRING_INLINE_CAPACITY,
+               "ropes must not fit inline");
+
+size_t snek_string_length(snek_object_t *str) {
+  if (str == NULL || str->kind != STRING) {
+    return 0;
+  }
+
+  return str->data.v_string.length;
+}
+
+// Copies every leaf of the rope rooted at `str` into one buffer. Ropes built
+// in a loop are as deep as the number of pieces, so this walks the tree with
+// an explicit stack instead of recursing.
+static bool snek_string_flatten(snek_object_t *str) {
+  snek_string_t *string = &str->data.v_string;
+
+  char *dst = malloc(string->length + 1);
+  if (dst == NULL) {
+    return false;
+  }
+
+  stack_t *pending = stack_new(8);
+  if (pending == NULL) {
+    free(dst);
+    return false;
+  }
+
+  size_t offset = 0;
+  stack_push(pending, str);
+  while (pending->count > 0) {
+    snek_string_t *node = &((snek_object_t *)stack_pop(pending))->data.v_string;
+    if (snek_string_is_inline(node)) {
+      memcpy(dst + offset, node->inline_chars, node->length);
+      offset += node->length;
+      continue;
+    }
+    if (node->chars != NULL) {
+      memcpy(dst + offset, node->chars, node->length);
+      offset += node->length;
+      continue;
+    }
+
+    stack_push(pending, node->right);
+    stack_push(pending, node->left);
+  }
+  stack_free(pending);
+
+  dst[string->length] = '\0';
+  string->chars = dst;
+  string->left = NULL;
+  string->right = NULL;
+  return true;
+}
+
+const char *snek_string_cstr(snek_object_t *str) {
+  if (str == NULL || str->kind != STRING) {
+    return NULL;
+  }
+
+  if (snek_string_is_inline(&str->data.v_string)) {
+    return str->data.v_string.inline_chars;
+  }
+
+  if (str->data.v_string.chars == NULL && !snek_string_flatten(str)) {
+    return NULL;
+  }
+
+  return str->data.v_string.chars;
+}
+
+// FNV-1a
+uint32_t snek_string_hash(snek_object_t *str) {
+  if (str == NULL || str->kind != STRING) {
+    return 0;
+  }
+
+  snek_string_t *string = &str->data.v_string;
+  if (string->hash != 0) {
+    return string->hash;
+  }
+
+  const char *chars = snek_string_cstr(str);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < string->length; i++) {
+    hash ^= (uint8_t)chars[i];
+    hash *= 16777619u;
+  }
+
+  // Reserve 0 for "not computed yet"
+  string->hash = hash == 0 ? 1 : hash;
+  return string->hash;
+}
+
+bool snek_string_equal(snek_object_t *a, snek_object_t *b) {
+  if (a == b) {
+    return true;
+  }
+
+  if (a == NULL || b == NULL || a->kind != STRING || b->kind != STRING) {
+    return false;
+  }
+
+  if (a->data.v_string.length != b->data.v_string.length) {
+    return false;
+  }
+
+  if (a->data.v_string.hash != 0 && b->data.v_string.hash != 0 &&
+      a->data.v_string.hash != b->data.v_string.hash) {
+    return false;
+  }
+
+  return memcmp(snek_string_cstr(a), snek_string_cstr(b),
+                snek_string_length(a)) == 0;
+}
+
+snek_object_t *snek_string_concat(vm_t *vm, snek_object_t *a,
+                                  snek_object_t *b) {
+  if (a == NULL || b == NULL || a->kind != STRING || b->kind != STRING) {
+    return NULL;
+  }
+
+  size_t a_len = a->data.v_string.length;
+  size_t b_len = b->data.v_string.length;
+
+  if (a_len + b_len >= SNEK_ROPE_THRESHOLD) {
+    return new_snek_rope(vm, a, b);
+  }
+
+  char dst[SNEK_ROPE_THRESHOLD];
+  memcpy(dst, snek_string_cstr(a), a_len);
+  memcpy(dst + a_len, snek_string_cstr(b), b_len);
+
+  return new_snek_string_len(vm, dst, a_len + b_len);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../vm/vm.h"
+#include "snekobject.h"
+
+// Concatenations shorter than this are copied eagerly; longer ones become
+// rope nodes so building a string piece by piece stays linear.
+#define SNEK_ROPE_THRESHOLD 64
+
+size_t snek_string_length(snek_object_t *str);
+uint32_t snek_string_hash(snek_object_t *str);
+// Returns the NUL-terminated characters, flattening a rope on first use.
+const char *snek_string_cstr(snek_object_t *str);
+bool snek_string_equal(snek_object_t *a, snek_object_t *b);
+snek_object_t *snek_string_concat(vm_t *vm, snek_object_t *a,
+                                  snek_object_t *b);
@@ -0,0 +1,319 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "sneknew.h"
+#include "snektypedarray.h"
+
+// Number of independent accumulators used by the reductions. Keeping them
+// separate lets the compiler map them onto vector lanes without needing
+// -ffast-math to reassociate a single running total.
+#define LANES 8
+
+#define ADD_FLOATS(a, b) ((a) + (b))
+
+// `add` adds two elements. Ints use snek_int_add, so they wrap around on
+// overflow like the interpreter's.
+#define DEFINE_TYPED_KERNELS(suffix, type, acc_type, add)                      \
+  static void add_##suffix(type *restrict dst, const type *restrict a,         \
+                           const type *restrict b, size_t n) {                 \
+    for (size_t i = 0; i < n; i++) {                                           \
+      dst[i] = add(a[i], b[i]);                                                \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static void fill_##suffix(type *restrict dst, type value, size_t n) {        \
+    for (size_t i = 0; i < n; i++) {                                           \
+      dst[i] = value;                                                          \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static double sum_##suffix(const type *restrict src, size_t n) {             \
+    acc_type lanes[LANES] = {0};                                               \
+    size_t i = 0;                                                              \
+    for (; i + LANES <= n; i += LANES) {                                       \
+      for (size_t j = 0; j < LANES; j++) {                                     \
+        lanes[j] += src[i + j];                                                \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    acc_type total = 0;                                                        \
+    for (size_t j = 0; j < LANES; j++) {                                       \
+      total += lanes[j];                                                       \
+    }                                                                          \
+    for (; i < n; i++) {                                                       \
+      total += src[i];                                                         \
+    }                                                                          \
+    return (double)total;                                                      \
+  }                                                                            \
+                                                                               \
+  /* Callers guarantee n > 0. */                                               \
+  static type min_##suffix(const type *restrict src, size_t n) {               \
+    type lanes[LANES];                                                         \
+    for (size_t j = 0; j < LANES; j++) {                                       \
+      lanes[j] = src[0];                                                       \
+    }                                                                          \
+    size_t i = 0;                                                              \
+    for (; i + LANES <= n; i += LANES) {                                       \
+      for (size_t j = 0; j < LANES; j++) {                                     \
+        lanes[j] = src[i + j] < lanes[j] ? src[i + j] : lanes[j];              \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    type result = lanes[0];                                                    \
+    for (size_t j = 1; j < LANES; j++) {                                       \
+      result = lanes[j] < result ? lanes[j] : result;                          \
+    }                                                                          \
+    for (; i < n; i++) {                                                       \
+      result = src[i] < result ? src[i] : result;                              \
+    }                                                                          \
+    return result;                                                             \
+  }                                                                            \
+                                                                               \
+  static type max_##suffix(const type *restrict src, size_t n) {               \
+    type lanes[LANES];                                                         \
+    for (size_t j = 0; j < LANES; j++) {                                       \
+      lanes[j] = src[0];                                                       \
+    }                                                                          \
+    size_t i = 0;                                                              \
+    for (; i + LANES <= n; i += LANES) {                                       \
+      for (size_t j = 0; j < LANES; j++) {                                     \
+        lanes[j] = src[i + j] > lanes[j] ? src[i + j] : lanes[j];              \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    type result = lanes[0];                                                    \
+    for (size_t j = 1; j < LANES; j++) {                                       \
+      result = lanes[j] > result ? lanes[j] : result;                          \
+    }                                                                          \
+    for (; i < n; i++) {                                                       \
+      result = src[i] > result ? src[i] : result;                              \
+    }                                                                          \
+    return result;                                                             \
+  }
+
+DEFINE_TYPED_KERNELS(int32, int32_t, int64_t, snek_int_add)
+DEFINE_TYPED_KERNELS(float, float, float, ADD_FLOATS)
+DEFINE_TYPED_KERNELS(double, double, double, ADD_FLOATS)
+
+// Casting NaN or a double out of range to an int is undefined, so those
+// saturate instead, with NaN becoming 0
+static int32_t to_int32(double value) {
+  if (value != value) {
+    return 0;
+  }
+  if (value <= INT32_MIN) {
+    return INT32_MIN;
+  }
+  if (value >= INT32_MAX) {
+    return INT32_MAX;
+  }
+  return (int32_t)value;
+}
+
+size_t snek_element_size(snek_element_kind_t kind) {
+  switch (kind) {
+  case ELEMENT_INT32:
+    return sizeof(int32_t);
+  case ELEMENT_FLOAT:
+    return sizeof(float);
+  case ELEMENT_DOUBLE:
+    return sizeof(double);
+  }
+
+  return 0;
+}
+
+static bool is_typed_array(snek_object_t *obj) {
+  return obj != NULL && obj->kind == TYPED_ARRAY;
+}
+
+bool snek_typed_array_set(snek_object_t *array, size_t index, double value) {
+  if (!is_typed_array(array)) {
+    return false;
+  }
+
+  snek_typed_array_t *typed = &array->data.v_typed_array;
+  if (index >= typed->size) {
+    return false;
+  }
+
+  switch (typed->element_kind) {
+  case ELEMENT_INT32:
+    ((int32_t *)typed->data)[index] = to_int32(value);
+    break;
+  case ELEMENT_FLOAT:
+    ((float *)typed->data)[index] = (float)value;
+    break;
+  case ELEMENT_DOUBLE:
+    ((double *)typed->data)[index] = value;
+    break;
+  }
+
+  return true;
+}
+
+bool snek_typed_array_get(snek_object_t *array, size_t index, double *out) {
+  if (!is_typed_array(array) || out == NULL) {
+    return false;
+  }
+
+  snek_typed_array_t *typed = &array->data.v_typed_array;
+  if (index >= typed->size) {
+    return false;
+  }
+
+  switch (typed->element_kind) {
+  case ELEMENT_INT32:
+    *out = ((int32_t *)typed->data)[index];
+    break;
+  case ELEMENT_FLOAT:
+    *out = ((float *)typed->data)[index];
+    break;
+  case ELEMENT_DOUBLE:
+    *out = ((double *)typed->data)[index];
+    break;
+  }
+
+  return true;
+}
+
+snek_object_t *snek_typed_array_add(vm_t *vm, snek_object_t *a,
+                                    snek_object_t *b) {
+  if (!is_typed_array(a) || !is_typed_array(b)) {
+    return NULL;
+  }
+
+  snek_typed_array_t *ta = &a->data.v_typed_array;
+  snek_typed_array_t *tb = &b->data.v_typed_array;
+  if (ta->element_kind != tb->element_kind || ta->size != tb->size) {
+    return NULL;
+  }
+
+  snek_object_t *result = new_snek_typed_array(vm, ta->element_kind, ta->size);
+  if (result == NULL) {
+    return NULL;
+  }
+
+  void *dst = result->data.v_typed_array.data;
+  switch (ta->element_kind) {
+  case ELEMENT_INT32:
+    add_int32(dst, ta->data, tb->data, ta->size);
+    break;
+  case ELEMENT_FLOAT:
+    add_float(dst, ta->data, tb->data, ta->size);
+    break;
+  case ELEMENT_DOUBLE:
+    add_double(dst, ta->data, tb->data, ta->size);
+    break;
+  }
+
+  return result;
+}
+
+bool snek_typed_array_fill(snek_object_t *array, double value) {
+  if (!is_typed_array(array)) {
+    return false;
+  }
+
+  snek_typed_array_t *typed = &array->data.v_typed_array;
+  switch (typed->element_kind) {
+  case ELEMENT_INT32:
+    fill_int32(typed->data, to_int32(value), typed->size);
+    break;
+  case ELEMENT_FLOAT:
+    fill_float(typed->data, (float)value, typed->size);
+    break;
+  case ELEMENT_DOUBLE:
+    fill_double(typed->data, value, typed->size);
+    break;
+  }
+
+  return true;
+}
+
+bool snek_typed_array_copy(snek_object_t *dst, snek_object_t *src) {
+  if (!is_typed_array(dst) || !is_typed_array(src)) {
+    return false;
+  }
+
+  snek_typed_array_t *td = &dst->data.v_typed_array;
+  snek_typed_array_t *ts = &src->data.v_typed_array;
+  size_t count = td->size < ts->size ? td->size : ts->size;
+
+  if (td->element_kind == ts->element_kind) {
+    memmove(td->data, ts->data, count * snek_element_size(td->element_kind));
+    return true;
+  }
+
+  // Mixed kinds go through double, which represents every int32 and float
+  // exactly.
+  for (size_t i = 0; i < count; i++) {
+    double value = 0;
+    snek_typed_array_get(src, i, &value);
+    snek_typed_array_set(dst, i, value);
+  }
+
+  return true;
+}
+
+double snek_typed_array_sum(snek_object_t *array) {
+  if (!is_typed_array(array)) {
+    return 0;
+  }
+
+  snek_typed_array_t *typed = &array->data.v_typed_array;
+  switch (typed->element_kind) {
+  case ELEMENT_INT32:
+    return sum_int32(typed->data, typed->size);
+  case ELEMENT_FLOAT:
+    return sum_float(typed->data, typed->size);
+  case ELEMENT_DOUBLE:
+    return sum_double(typed->data, typed->size);
+  }
+
+  return 0;
+}
+
+bool snek_typed_array_min(snek_object_t *array, double *out) {
+  if (!is_typed_array(array) || out == NULL ||
+      array->data.v_typed_array.size == 0) {
+    return false;
+  }
+
+  snek_typed_array_t *typed = &array->data.v_typed_array;
+  switch (typed->element_kind) {
+  case ELEMENT_INT32:
+    *out = min_int32(typed->data, typed->size);
+    break;
+  case ELEMENT_FLOAT:
+    *out = min_float(typed->data, typed->size);
+    break;
+  case ELEMENT_DOUBLE:
+    *out = min_double(typed->data, typed->size);
+    break;
+  }
+
+  return true;
+}
+
+bool snek_typed_array_max(snek_object_t *array, double *out) {
+  if (!is_typed_array(array) || out == NULL ||
+      array->data.v_typed_array.size == 0) {
+    return false;
+  }
+
+  snek_typed_array_t *typed = &array->data.v_typed_array;
+  switch (typed->element_kind) {
+  case ELEMENT_INT32:
+    *out = max_int32(typed->data, typed->size);
+    break;
+  case ELEMENT_FLOAT:
+    *out = max_float(typed->data, typed->size);
+    break;
+  case ELEMENT_DOUBLE:
+    *out = max_double(typed->data, typed->size);
+    break;
+  }
+
+  return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../vm/vm.h"
+#include "snekobject.h"
+
+size_t snek_element_size(snek_element_kind_t kind);
+
+/// Element Access
+bool snek_typed_array_set(snek_object_t *array, size_t index, double value);
+bool snek_typed_array_get(snek_object_t *array, size_t index, double *out);
+
+/// Bulk Operations
+// Element-wise sum of two arrays of the same element kind and size.
+snek_object_t *snek_typed_array_add(vm_t *vm, snek_object_t *a,
+                                    snek_object_t *b);
+bool snek_typed_array_fill(snek_object_t *array, double value);
+// Copies min(dst.size, src.size) elements, converting between kinds.
+bool snek_typed_array_copy(snek_object_t *dst, snek_object_t *src);
+double snek_typed_array_sum(snek_object_t *array);
+bool snek_typed_array_min(snek_object_t *array, double *out);
+bool snek_typed_array_max(snek_object_t *array, double *out);
@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "incremental.h"
+
+static bool append_start(statement_start_t **starts, size_t *count,
+                         size_t *capacity, size_t offset, int line) {
+  if (*count == *capacity) {
+    size_t grown_capacity = *capacity < 64 ? 64 : *capacity * 2;
+    statement_start_t *grown =
+        realloc(*starts, grown_capacity * sizeof(statement_start_t));
+    if (grown == NULL) {
+      return false;
+    }
+    *starts = grown;
+    *capacity = grown_capacity;
+  }
+  (*starts)[(*count)++] =
+      (statement_start_t){.offset = offset, .line = line, .parsed_line = line};
+  return true;
+}
+
+// Number of statements that start before `offset`
+static size_t starts_before(const incremental_t *parse, size_t offset) {
+  size_t low = 0;
+  size_t high = parse->count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (parse->starts[middle].offset < offset) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// Returns the next statement start after `offset`, the start of a line
+// outside any string, or the end of the text. `*line` follows the lexer,
+// which doesn't count newlines inside string literals.
+static size_t next_statement(const char *source, size_t offset, int *line) {
+  bool in_string = false;
+  size_t i = offset;
+  for (; source[i] != '\0'; i++) {
+    if (source[i] == '"') {
+      in_string = !in_string;
+    }
+    if (source[i] == '\n' && !in_string) {
+      (*line)++;
+      if (line_starts_statement(&source[i + 1])) {
+        return i + 1;
+      }
+    }
+  }
+  return i;
+}
+
+static ast_root_t *parse_text(char *text, int line) {
+  lexer_t *lexer = lexer_new(text);
+  if (lexer == NULL) {
+    return NULL;
+  }
+  lexer->line = line;
+
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = NULL;
+  if (parser != NULL) {
+    root = parse_root(parser);
+    if (root != NULL) {
+      parser->root = NULL;
+    }
+    parser_free(parser);
+  }
+  lexer_free(lexer);
+  return root;
+}
+
+static ast_root_t *parse_all(incremental_t *parse) {
+  ast_root_free(parse->root);
+  parse->root = parse_text(parse->source, 1);
+  parse->reparsed = parse->root == NULL ? 0 : parse->root->count;
+
+  parse->count = 0;
+  parse->tracked = false;
+  parse->moved = false;
+  if (parse->root == NULL) {
+    return NULL;
+  }
+
+  parse->tracked = true;
+  int line = 1;
+  size_t offset = 0;
+  if (line_starts_statement(parse->source)) {
+    parse->tracked = append_start(&parse->starts, &parse->count,
+                                  &parse->capacity, offset, line);
+  }
+  while (parse->tracked &&
+         (offset = next_statement(parse->source, offset, &line)) <
+             parse->length) {
+    parse->tracked = append_start(&parse->starts, &parse->count,
+                                  &parse->capacity, offset, line);
+  }
+
+  // Anything the lexer reads differently from the statement scan, such as
+  // a "\r" on an otherwise blank line, leaves edits to parse everything
+  parse->tracked = parse->tracked && parse->count == (size_t)parse->root->count;
+  return parse->root;
+}
+
+static void shift_list(ast_node_list_t *list, int delta);
+
+// Moves a statement that was kept to where edits above it have put it
+static void shift_lines(ast_node_t *node, int delta) {
+  if (node == NULL) {
+    return;
+  }
+
+  node->line += delta;
+  switch (node->type) {
+  case NODE_BINARY_OP:
+    shift_lines(node->binary_op.left, delta);
+    shift_lines(node->binary_op.right, delta);
+    break;
+  case NODE_UNARY_OP:
+    shift_lines(node->unary_op.operand, delta);
+    break;
+  case NODE_ASSIGNMENT:
+    shift_lines(node->assignment.value, delta);
+    break;
+  case NODE_DECLARATION:
+    shift_lines(node->declaration.value, delta);
+    break;
+  case NODE_FUNCTION:
+    shift_list(&node->function.body, delta);
+    break;
+  case NODE_CALL:
+    shift_list(&node->call.args, delta);
+    break;
+  case NODE_RETURN:
+    shift_lines(node->return_stmt.value, delta);
+    break;
+  case NODE_IF:
+    shift_lines(node->if_stmt.condition, delta);
+    shift_list(&node->if_stmt.then_branch, delta);
+    shift_list(&node->if_stmt.else_branch, delta);
+    break;
+  case NODE_WHILE:
+    shift_lines(node->while_stmt.condition, delta);
+    shift_list(&node->while_stmt.body, delta);
+    break;
+  case NODE_FOR:
+    shift_lines(node->for_stmt.init, delta);
+    shift_lines(node->for_stmt.condition, delta);
+    shift_lines(node->for_stmt.step, delta);
+    shift_list(&node->for_stmt.body, delta);
+    break;
+  case NODE_BLOCK:
+    shift_list(&node->block.statements, delta);
+    break;
+  default:
+    break;
+  }
+}
+
+static void shift_list(ast_node_list_t *list, int delta) {
+  for (int i = 0; i < list->count; i++) {
+    shift_lines(list->nodes[i], delta);
+  }
+}
+
+incremental_t *incremental_new(const char *source) {
+  incremental_t *parse = calloc(1, sizeof(incremental_t));
+  if (parse == NULL) {
+    return NULL;
+  }
+
+  parse->source = strdup(source);
+  if (parse->source == NULL) {
+    free(parse);
+    return NULL;
+  }
+  parse->length = strlen(source);
+  parse_all(parse);
+  return parse;
+}
+
+void incremental_free(incremental_t *parse) {
+  if (parse == NULL) {
+    return;
+  }
+
+  ast_root_free(parse->root);
+  free(parse->starts);
+  free(parse->source);
+  free(parse);
+}
+
+// Replaces statements [first, rest) of the root with the parsed range
+static bool splice(incremental_t *parse, size_t first, size_t rest,
+                   ast_root_t *range, statement_start_t *starts) {
+  ast_root_t *root = parse->root;
+  size_t count = (size_t)root->count - (rest - first) + (size_t)range->count;
+
+  if (count > (size_t)root->capacity) {
+    ast_node_t **nodes = realloc(root->nodes, count * sizeof(ast_node_t *));
+    if (nodes == NULL) {
+      return false;
+    }
+    root->nodes = nodes;
+    root->capacity = (int)count;
+  }
+  if (count > parse->capacity) {
+    statement_start_t *grown =
+        realloc(parse->starts, count * sizeof(statement_start_t));
+    if (grown == NULL) {
+      return false;
+    }
+    parse->starts = grown;
+    parse->capacity = count;
+  }
+
+  for (size_t i = first; i < rest; i++) {
+    ast_free_node(root->nodes[i]);
+  }
+  size_t moved = (size_t)root->count - rest;
+  memmove(&root->nodes[first + range->count], &root->nodes[rest],
+          moved * sizeof(ast_node_t *));
+  memcpy(&root->nodes[first], range->nodes,
+         range->count * sizeof(ast_node_t *));
+  memmove(&parse->starts[first + range->count], &parse->starts[rest],
+          moved * sizeof(statement_start_t));
+  memcpy(&parse->starts[first], starts,
+         range->count * sizeof(statement_start_t));
+
+  root->count = (int)count;
+  parse->count = count;
+  return true;
+}
+
+bool incremental_edit(incremental_t *parse, size_t offset, size_t removed,
+                      const char *inserted) {
+  if (offset > parse->length || removed > parse->length - offset) {
+    fprintf(stderr, "Parser Error: Edit at %zu is past the end of the text\n",
+            offset);
+    return false;
+  }
+
+  size_t inserted_length = strlen(inserted);
+  size_t length = parse->length - removed + inserted_length;
+  if (inserted_length > removed) {
+    char *grown = realloc(parse->source, length + 1);
+    if (grown == NULL) {
+      return false;
+    }
+    parse->source = grown;
+  }
+  memmove(parse->source + offset + inserted_length,
+          parse->source + offset + removed,
+          parse->length - offset - removed + 1);
+  memcpy(parse->source + offset, inserted, inserted_length);
+  parse->length = length;
+
+  if (parse->root == NULL || !parse->tracked) {
+    return parse_all(parse) != NULL;
+  }
+
+  // Start at the statement holding the edit, or an earlier one if the edit
+  // could have made its first line continue the statement before it
+  size_t first = starts_before(parse, offset + 1);
+  first = first > 0 ? first - 1 : 0;
+  while (first > 0 &&
+         (parse->starts[first].offset == offset ||
+          !line_starts_statement(parse->source + parse->starts[first].offset))) {
+    first--;
+  }
+  size_t start = first == 0 ? 0 : parse->starts[first].offset;
+  int start_line = first == 0 ? 1 : parse->starts[first].line;
+
+  // Find the statements of the edited range, up to the first one that starts
+  // where a statement started before the edit. The text from there on is
+  // unchanged, and so is the way it is lexed and parsed.
+  statement_start_t *starts = NULL;
+  size_t count = 0;
+  size_t capacity = 0;
+  bool ok = true;
+  if (line_starts_statement(parse->source + start)) {
+    ok = append_start(&starts, &count, &capacity, start, start_line);
+  }
+
+  size_t rest = parse->count;
+  size_t end = start;
+  int line = start_line;
+  while (ok && (end = next_statement(parse->source, end, &line)) < length) {
+    if (end >= offset + inserted_length) {
+      size_t old_offset = end - inserted_length + removed;
+      size_t same = starts_before(parse, old_offset);
+      if (same < parse->count && parse->starts[same].offset == old_offset) {
+        rest = same;
+        break;
+      }
+    }
+    ok = append_start(&starts, &count, &capacity, end, line);
+  }
+  int line_delta = rest < parse->count ? line - parse->starts[rest].line : 0;
+
+  ast_root_t *range = NULL;
+  char *text = ok ? malloc(end - start + 1) : NULL;
+  if (text != NULL) {
+    memcpy(text, parse->source + start, end - start);
+    text[end - start] = '\0';
+    range = parse_text(text, start_line);
+    free(text);
+  }
+
+  if (range == NULL) {
+    free(starts);
+    ast_root_free(parse->root);
+    parse->root = NULL;
+    return false;
+  }
+  if ((size_t)range->count != count ||
+      !splice(parse, first, rest, range, starts)) {
+    free(starts);
+    ast_root_free(range);
+    return parse_all(parse) != NULL;
+  }
+
+  for (size_t i = first + count; i < parse->count; i++) {
+    parse->starts[i].offset = parse->starts[i].offset + inserted_length - removed;
+    parse->starts[i].line += line_delta;
+  }
+  parse->moved = parse->moved || line_delta != 0;
+
+  parse->reparsed = range->count;
+  free(range->nodes);
+  free(range);
+  free(starts);
+  return true;
+}
+
+ast_root_t *incremental_root(incremental_t *parse) {
+  if (parse->root == NULL || !parse->moved) {
+    return parse->root;
+  }
+
+  for (size_t i = 0; i < parse->count; i++) {
+    statement_start_t *start = &parse->starts[i];
+    if (start->line != start->parsed_line) {
+      shift_lines(parse->root->nodes[i], start->line - start->parsed_line);
+      start->parsed_line = start->line;
+    }
+  }
+  parse->moved = false;
+  return parse->root;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parser.h"
+
+// Where a top-level statement starts: the line (outside any string) that
+// line_starts_statement accepts. Statement i of the root starts at starts[i].
+typedef struct StatementStart {
+  size_t offset;   // Byte offset in the source
+  int line;        // Line number, as the lexer counts them
+  int parsed_line; // Line the statement's nodes are numbered from. Edits
+                   // above it only move `line`; incremental_root catches the
+                   // nodes up.
+} statement_start_t;
+
+// A script kept parsed across edits, for editors that re-check the buffer on
+// every keystroke. Each edit re-lexes and re-parses only the top-level
+// statements it touches; the other statements keep their nodes. An edit that
+// adds or removes lines only moves the line of each statement below it, and
+// the line numbers of their nodes are moved once the root is asked for, so
+// a run of edits between two looks at the tree costs one pass over them.
+//
+// Top-level statements begin in column 0, where the lexer's indent stack is
+// empty, so a fresh lexer started at a statement reads it exactly as the
+// lexer of the whole script would.
+typedef struct IncrementalParse {
+  char *source; // Current text, NUL-terminated
+  size_t length;
+  ast_root_t *root; // NULL while the current text doesn't parse
+  statement_start_t *starts; // One per node of `root`
+  size_t count;
+  size_t capacity;
+  bool tracked;  // False if the statements couldn't be matched to lines
+  bool moved;    // Some statement's `line` differs from its `parsed_line`
+  int reparsed;  // Statements parsed by the last edit
+} incremental_t;
+
+// Parses `source` in full. Check incremental_root for errors, which are
+// reported like parse_root's. Returns NULL if out of memory.
+incremental_t *incremental_new(const char *source);
+void incremental_free(incremental_t *parse);
+
+// Replaces `removed` bytes at `offset` with `inserted` and updates the parse.
+// Returns false after reporting the errors if the new text doesn't parse (or
+// the edit is out of range, which leaves the text as it was). The next edit
+// after a failure parses the whole text again. Nodes of statements the edit
+// didn't touch stay at the same addresses.
+bool incremental_edit(incremental_t *parse, size_t offset, size_t removed,
+                      const char *inserted);
+
+// The parse of the current text, with every node on its current line, or
+// NULL if the text doesn't parse
+ast_root_t *incremental_root(incremental_t *parse);
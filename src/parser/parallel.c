@@ -0,0 +1,171 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel.h"
+
+typedef struct {
+  size_t start; // Byte range of the source
+  size_t end;
+  int line;         // Line number of the first byte
+  ast_root_t *root; // NULL if the chunk failed to parse
+  char *text;       // NUL-terminated copy of the range
+  lexer_t *lexer;
+  parser_t *parser;
+} parse_chunk_t;
+
+typedef struct {
+  const char *source;
+  parse_chunk_t *chunks;
+  size_t count;
+  size_t next; // Next chunk to parse, taken atomically by each thread
+} parse_work_t;
+
+// Splits `source` into chunks of at least `target` bytes. Line numbers follow
+// the lexer, which doesn't count newlines inside string literals.
+static parse_chunk_t *split_source(const char *source, size_t target,
+                                   size_t *count) {
+  size_t capacity = 16;
+  parse_chunk_t *chunks = malloc(capacity * sizeof(parse_chunk_t));
+  if (chunks == NULL) {
+    return NULL;
+  }
+  chunks[0] = (parse_chunk_t){.start = 0, .line = 1};
+  *count = 1;
+
+  bool in_string = false;
+  int line = 1;
+  size_t i = 0;
+  for (; source[i] != '\0'; i++) {
+    if (source[i] == '"') {
+      in_string = !in_string;
+    }
+    if (source[i] != '\n' || in_string) {
+      continue;
+    }
+
+    line++;
+    parse_chunk_t *last = &chunks[*count - 1];
+    if (i + 1 - last->start < target || !line_starts_statement(&source[i + 1])) {
+      continue;
+    }
+
+    if (*count == capacity) {
+      capacity *= 2;
+      parse_chunk_t *grown = realloc(chunks, capacity * sizeof(parse_chunk_t));
+      if (grown == NULL) {
+        free(chunks);
+        return NULL;
+      }
+      chunks = grown;
+    }
+    chunks[*count - 1].end = i + 1;
+    chunks[(*count)++] = (parse_chunk_t){.start = i + 1, .line = line};
+  }
+
+  chunks[*count - 1].end = i;
+  return chunks;
+}
+
+static void parse_chunk(const char *source, parse_chunk_t *chunk) {
+  // The lexer reads up to a NUL, so each chunk gets its own copy
+  size_t length = chunk->end - chunk->start;
+  chunk->text = malloc(length + 1);
+  if (chunk->text == NULL) {
+    return;
+  }
+  memcpy(chunk->text, source + chunk->start, length);
+  chunk->text[length] = '\0';
+
+  chunk->lexer = lexer_new(chunk->text);
+  chunk->lexer->line = chunk->line;
+  chunk->parser = parser_new(chunk->lexer);
+  chunk->root = parse_root(chunk->parser);
+}
+
+// Frees the chunk's tokens, keeping the statements if it parsed. Done once
+// every chunk is parsed: freeing while other chunks still allocate leaves
+// them a fragmented heap, which makes parsing them much slower.
+static void release_chunk(parse_chunk_t *chunk) {
+  if (chunk->root != NULL) {
+    chunk->parser->root = NULL;
+  }
+  parser_free(chunk->parser);
+  lexer_free(chunk->lexer);
+  free(chunk->text);
+}
+
+static void *parse_worker(void *arg) {
+  parse_work_t *work = arg;
+
+  for (;;) {
+    size_t index = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED);
+    if (index >= work->count) {
+      return NULL;
+    }
+    parse_chunk(work->source, &work->chunks[index]);
+  }
+}
+
+ast_root_t *parse_root_parallel(const char *source, int thread_count) {
+  if (thread_count < 1) {
+    thread_count = 1;
+  }
+
+  // A few chunks per thread evens out statements of different sizes
+  size_t target = strlen(source) / ((size_t)thread_count * 4);
+  if (target < PARSE_CHUNK_MIN_BYTES) {
+    target = PARSE_CHUNK_MIN_BYTES;
+  }
+
+  parse_work_t work = {.source = source};
+  work.chunks = split_source(source, target, &work.count);
+  if (work.chunks == NULL) {
+    return NULL;
+  }
+
+  // The calling thread parses chunks too
+  size_t helpers = (size_t)thread_count - 1;
+  if (helpers > work.count - 1) {
+    helpers = work.count - 1;
+  }
+  pthread_t *threads = malloc((helpers + 1) * sizeof(pthread_t));
+  size_t started = 0;
+  while (threads != NULL && started < helpers &&
+         pthread_create(&threads[started], NULL, parse_worker, &work) == 0) {
+    started++;
+  }
+  parse_worker(&work);
+  for (size_t i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+
+  ast_root_t *root = ast_root_new();
+  bool ok = root != NULL;
+  for (size_t i = 0; i < work.count; i++) {
+    ok = ok && work.chunks[i].root != NULL;
+  }
+
+  for (size_t i = 0; i < work.count; i++) {
+    release_chunk(&work.chunks[i]);
+    ast_root_t *chunk_root = work.chunks[i].root;
+    if (!ok) {
+      ast_root_free(chunk_root);
+      continue;
+    }
+
+    for (int j = 0; j < chunk_root->count; j++) {
+      ast_root_append(root, chunk_root->nodes[j]);
+    }
+    free(chunk_root->nodes);
+    free(chunk_root);
+  }
+  free(work.chunks);
+
+  if (!ok) {
+    ast_root_free(root);
+    return NULL;
+  }
+  return root;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "parser.h"
+
+// Chunks are at least this long, so short scripts stay on one thread
+#define PARSE_CHUNK_MIN_BYTES 4096
+
+// Parses `source` like parse_root, using up to `thread_count` threads. The
+// source is split before top-level statements (lines that start in column
+// 0, outside a string, and aren't an `elif` or `else`), and each chunk is
+// lexed and parsed by its own lexer and parser. The chunks' statements are
+// joined in source order, with the same line numbers a single parser gives.
+//
+// Returns NULL after reporting the errors if any chunk fails to parse. An
+// error in each of several chunks may be reported. Free the result with
+// ast_root_free.
+ast_root_t *parse_root_parallel(const char *source, int thread_count);
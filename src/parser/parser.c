@@ -1,5 +1,7 @@
 #include "parser.h"
 #include "../lexer/lexer.h"
+#include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,19 +13,14 @@ parser_t *parser_new(lexer_t *lexer) {
   }
 
   parser->lexer = lexer;
-  parser->root = malloc(sizeof(ast_root_t));
+  parser->root = ast_root_new();
   if (parser->root == NULL) {
     free(parser);
     return NULL;
   }
 
-  parser->root->nodes = malloc(sizeof(ast_node_t *) * MAX_NODES);
-  if (parser->root->nodes == NULL) {
-    free(parser->root);
-    free(parser);
-    return NULL;
-  }
-  parser->root->count = 0;
+  parser->current = NULL;
+  parser->tokens = stack_new(64);
   parser_advance(parser);
 
   return parser;
@@ -34,12 +31,12 @@ void parser_free(parser_t *parser) {
     return;
   }
 
-  for (int i = 0; i < parser->root->count; i++) {
-    ast_free_node(parser->root->nodes[i]);
-  }
+  ast_root_free(parser->root);
 
-  free(parser->root->nodes);
-  free(parser->root);
+  for (size_t i = 0; i < parser->tokens->count; i++) {
+    token_free(parser->tokens->data[i]);
+  }
+  stack_free(parser->tokens);
   free(parser);
 }
 
@@ -53,9 +50,45 @@ void parser_advance(parser_t *parser) {
     fprintf(stderr, "Parser Error: Unexpected end of file\n");
     return;
   }
+  stack_push(parser->tokens, next);
   parser->current = next;
 }
 
+ast_root_t *ast_root_new() {
+  ast_root_t *root = malloc(sizeof(ast_root_t));
+  if (root == NULL) {
+    return NULL;
+  }
+
+  root->nodes = NULL;
+  root->count = 0;
+  root->capacity = 0;
+  return root;
+}
+
+void ast_root_append(ast_root_t *root, ast_node_t *node) {
+  if (root->count == root->capacity) {
+    root->capacity = root->capacity < 64 ? 64 : root->capacity * 2;
+    root->nodes = realloc(root->nodes, root->capacity * sizeof(ast_node_t *));
+    if (root->nodes == NULL) {
+      exit(1);
+    }
+  }
+  root->nodes[root->count++] = node;
+}
+
+void ast_root_free(ast_root_t *root) {
+  if (root == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < root->count; i++) {
+    ast_free_node(root->nodes[i]);
+  }
+  free(root->nodes);
+  free(root);
+}
+
 ast_node_t *ast_new_node(ast_node_type_t type) {
   ast_node_t *node = calloc(1, sizeof(ast_node_t));
   if (node == NULL) {
@@ -72,11 +105,44 @@ ast_node_t *ast_new_literal_node(int value) {
     return NULL;
   }
 
+  node->literal.kind = TOKEN_INT;
   node->literal.value = value;
   return node;
 }
 
-ast_node_t *ast_new_binary_op_node(char op, ast_node_t *left,
+ast_node_t *ast_new_null_literal_node() {
+  ast_node_t *node = ast_new_node(NODE_LITERAL);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->literal.kind = TOKEN_NULL_KEYWORD;
+  return node;
+}
+
+ast_node_t *ast_new_float_literal_node(double value) {
+  ast_node_t *node = ast_new_node(NODE_LITERAL);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->literal.kind = TOKEN_FLOAT;
+  node->literal.floating = value;
+  return node;
+}
+
+ast_node_t *ast_new_string_literal_node(char *value) {
+  ast_node_t *node = ast_new_node(NODE_LITERAL);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->literal.kind = TOKEN_STRING;
+  node->literal.string = strdup(value);
+  return node;
+}
+
+ast_node_t *ast_new_binary_op_node(token_type_t op, ast_node_t *left,
                                    ast_node_t *right) {
   ast_node_t *node = ast_new_node(NODE_BINARY_OP);
   if (node == NULL) {
@@ -89,7 +155,7 @@ ast_node_t *ast_new_binary_op_node(char op, ast_node_t *left,
   return node;
 }
 
-ast_node_t *ast_new_unary_op_node(char op, ast_node_t *operand) {
+ast_node_t *ast_new_unary_op_node(token_type_t op, ast_node_t *operand) {
   ast_node_t *node = ast_new_node(NODE_UNARY_OP);
   if (node == NULL) {
     return NULL;
@@ -134,6 +200,86 @@ ast_node_t *ast_new_declaration_node(char *name, char *type,
   return node;
 }
 
+ast_node_t *ast_new_function_node(char *name) {
+  ast_node_t *node = ast_new_node(NODE_FUNCTION);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->function.name = strdup(name);
+  return node;
+}
+
+ast_node_t *ast_new_call_node(char *name) {
+  ast_node_t *node = ast_new_node(NODE_CALL);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->call.name = strdup(name);
+  return node;
+}
+
+ast_node_t *ast_new_return_node(ast_node_t *value) {
+  ast_node_t *node = ast_new_node(NODE_RETURN);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->return_stmt.value = value;
+  return node;
+}
+
+ast_node_t *ast_new_if_node(ast_node_t *condition) {
+  ast_node_t *node = ast_new_node(NODE_IF);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->if_stmt.condition = condition;
+  return node;
+}
+
+ast_node_t *ast_new_while_node(ast_node_t *condition) {
+  ast_node_t *node = ast_new_node(NODE_WHILE);
+  if (node == NULL) {
+    return NULL;
+  }
+
+  node->while_stmt.condition = condition;
+  return node;
+}
+
+ast_node_t *ast_new_for_node() { return ast_new_node(NODE_FOR); }
+
+ast_node_t *ast_new_block_node() { return ast_new_node(NODE_BLOCK); }
+
+void ast_node_list_append(ast_node_list_t *list, ast_node_t *node) {
+  if (list->count == list->capacity) {
+    list->capacity = list->capacity < 4 ? 4 : list->capacity * 2;
+    list->nodes = realloc(list->nodes, list->capacity * sizeof(ast_node_t *));
+    if (list->nodes == NULL) {
+      exit(1);
+    }
+  }
+
+  list->nodes[list->count++] = node;
+}
+
+void ast_node_list_insert(ast_node_list_t *list, int index, ast_node_t *node) {
+  ast_node_list_append(list, node);
+  memmove(&list->nodes[index + 1], &list->nodes[index],
+          (list->count - 1 - index) * sizeof(ast_node_t *));
+  list->nodes[index] = node;
+}
+
+void ast_node_list_free(ast_node_list_t *list) {
+  for (int i = 0; i < list->count; i++) {
+    ast_free_node(list->nodes[i]);
+  }
+  free(list->nodes);
+}
+
 void ast_free_node(ast_node_t *node) {
   if (node == NULL) {
     return;
@@ -141,6 +287,7 @@ void ast_free_node(ast_node_t *node) {
 
   switch (node->type) {
   case NODE_LITERAL:
+    free(node->literal.string);
     break;
   case NODE_BINARY_OP:
     ast_free_node(node->binary_op.left);
@@ -161,11 +308,64 @@ void ast_free_node(ast_node_t *node) {
     free(node->declaration.type);
     ast_free_node(node->declaration.value);
     break;
+  case NODE_FUNCTION:
+    free(node->function.name);
+    for (int i = 0; i < node->function.param_count; i++) {
+      free(node->function.param_names[i]);
+      free(node->function.param_types[i]);
+    }
+    free(node->function.param_names);
+    free(node->function.param_types);
+    free(node->function.return_type);
+    ast_node_list_free(&node->function.body);
+    break;
+  case NODE_CALL:
+    free(node->call.name);
+    ast_node_list_free(&node->call.args);
+    break;
+  case NODE_RETURN:
+    ast_free_node(node->return_stmt.value);
+    break;
+  case NODE_IF:
+    ast_free_node(node->if_stmt.condition);
+    ast_node_list_free(&node->if_stmt.then_branch);
+    ast_node_list_free(&node->if_stmt.else_branch);
+    break;
+  case NODE_WHILE:
+    ast_free_node(node->while_stmt.condition);
+    ast_node_list_free(&node->while_stmt.body);
+    break;
+  case NODE_FOR:
+    ast_free_node(node->for_stmt.init);
+    ast_free_node(node->for_stmt.condition);
+    ast_free_node(node->for_stmt.step);
+    ast_node_list_free(&node->for_stmt.body);
+    break;
+  case NODE_BLOCK:
+    ast_node_list_free(&node->block.statements);
+    break;
+  case NODE_BREAK:
+  case NODE_CONTINUE:
+    break;
   }
 
   free(node);
 }
 
+bool line_starts_statement(const char *line) {
+  if (*line == ' ' || *line == '\t' || *line == '\n' || *line == '\0') {
+    return false;
+  }
+
+  bool continues =
+      strncmp(line, "elif", 4) == 0 || strncmp(line, "else", 4) == 0;
+  if (continues) {
+    char next = line[4];
+    continues = !(next == '_' || isalnum((unsigned char)next));
+  }
+  return !continues;
+}
+
 ast_root_t *parse_root(parser_t *parser) {
   ast_root_t *root = parser->root;
 
@@ -185,7 +385,7 @@ ast_root_t *parse_root(parser_t *parser) {
       printf("Parser Error: Statement return NULL\n");
       return NULL;
     }
-    root->nodes[root->count++] = node;
+    ast_root_append(root, node);
   }
   return root;
 }
@@ -194,8 +394,27 @@ ast_node_t *parse_statement(parser_t *parser) {
   token_t *token = parser->current;
   ast_node_t *node = NULL;
   switch (token->type) {
-    //  case TOKEN_DEF:
-    //    return parse_function(parser);
+  case TOKEN_DEF:
+    // Compound statements end with their block's DEDENT, not an EOL
+    return parse_function(parser);
+  case TOKEN_IF:
+    return parse_if(parser);
+  case TOKEN_WHILE:
+    return parse_while(parser);
+  case TOKEN_FOR:
+    return parse_for(parser);
+  case TOKEN_RETURN:
+    node = parse_return(parser);
+    break;
+  case TOKEN_BREAK:
+  case TOKEN_CONTINUE:
+    parser_advance(parser); // Consume the keyword
+    node = ast_new_node(token->type == TOKEN_BREAK ? NODE_BREAK
+                                                   : NODE_CONTINUE);
+    if (node != NULL) {
+      node->line = token->line;
+    }
+    break;
   case TOKEN_IDENTIFIER:
     node = parse_assignment(parser);
     break;
@@ -207,8 +426,20 @@ ast_node_t *parse_statement(parser_t *parser) {
     node = parse_expression(parser);
   }
 
-  if (parser->current && parser->current->type == TOKEN_EOL) {
+  if (node == NULL) {
+    return NULL;
+  }
+
+  // A simple statement ends its line, or the block or file it's last in
+  token_t *end = parser->current;
+  if (end != NULL && end->type == TOKEN_EOL) {
     parser_advance(parser); // Consume the EOL token
+  } else if (end != NULL && end->type != TOKEN_DEDENT &&
+             end->type != TOKEN_EOF) {
+    fprintf(stderr, "Parser Error: Unexpected token '%s' on line %d\n",
+            end->lexeme, end->line);
+    ast_free_node(node);
+    return NULL;
   }
 
   return node;
@@ -258,8 +489,12 @@ ast_node_t *parse_assignment(parser_t *parser) {
       }
     }
 
-    return ast_new_declaration_node(strdup(identifier->lexeme),
-                                    strdup(type_token->lexeme), value);
+    ast_node_t *node =
+        ast_new_declaration_node(identifier->lexeme, type_token->lexeme, value);
+    if (node != NULL) {
+      node->line = identifier->line;
+    }
+    return node;
   }
 
   // **Check for Variable Assignment (x = value)**
@@ -272,7 +507,16 @@ ast_node_t *parse_assignment(parser_t *parser) {
       return NULL;
     }
 
-    return ast_new_assignment_node(strdup(identifier->lexeme), value);
+    ast_node_t *node = ast_new_assignment_node(identifier->lexeme, value);
+    if (node != NULL) {
+      node->line = identifier->line;
+    }
+    return node;
+  }
+
+  // **Check for a Call Statement (f(args))**
+  if (next->type == TOKEN_LPAREN) {
+    return parse_call(parser, identifier);
   }
 
   // **If neither `:` nor `=` follows, it's an error**
@@ -283,66 +527,87 @@ ast_node_t *parse_assignment(parser_t *parser) {
   return NULL;
 }
 
-ast_node_t *parse_expression(parser_t *parser) {
-  ast_node_t *node = parse_term(parser);
-
-  while (parser->current->type == TOKEN_PLUS ||
-         parser->current->type == TOKEN_MINUS) {
-    token_t *op = parser->current;
-    parser_advance(parser); // Consume the operator
-    ast_node_t *right = parse_term(parser);
-    if (right == NULL) {
-      return NULL;
-    }
-
-    if (!op->lexeme) {
-      fprintf(stderr, "Parser Error: Expected operator on line %d\n", op->line);
-      return NULL;
-    }
-
-    ast_node_t *new_node = ast_new_binary_op_node(op->lexeme[0], node, right);
-    if (new_node == NULL) {
-      return NULL;
-    }
-
-    node = new_node;
-  }
-
-  return node;
+// How tightly each binary operator binds its operands, 0 for tokens that
+// don't continue an expression. Every operator is left associative.
+static const uint8_t binding_powers[TOTAL_TOKEN_COUNT] = {
+    [TOKEN_OR] = 1,           [TOKEN_AND] = 2,
+    [TOKEN_EQUAL_EQUAL] = 3,  [TOKEN_BANG_EQUAL] = 3,
+    [TOKEN_LESS] = 4,         [TOKEN_LESS_EQUAL] = 4,
+    [TOKEN_GREATER] = 4,      [TOKEN_GREATER_EQUAL] = 4,
+    [TOKEN_PLUS] = 5,         [TOKEN_MINUS] = 5,
+    [TOKEN_STAR] = 6,         [TOKEN_SLASH] = 6,
+};
+
+static int binding_power(token_type_t type) {
+  return type >= 0 && type < TOTAL_TOKEN_COUNT ? binding_powers[type] : 0;
 }
 
-ast_node_t *parse_term(parser_t *parser) {
+// Parses an operand followed by every operator that binds tighter than
+// `min_power`. Operands are parsed by parse_factor directly, however many
+// precedence levels there are, and only an operator that binds tighter
+// than the one before it recurses.
+static ast_node_t *parse_precedence(parser_t *parser, int min_power) {
   ast_node_t *node = parse_factor(parser);
 
-  while (parser->current->type == TOKEN_STAR ||
-         parser->current->type == TOKEN_SLASH) {
+  while (node != NULL) {
     token_t *op = parser->current;
+    int power = binding_power(op->type);
+    if (power <= min_power) {
+      break;
+    }
+
     parser_advance(parser); // Consume the operator
-    ast_node_t *right = parse_factor(parser);
+    ast_node_t *right = parse_precedence(parser, power);
     if (right == NULL) {
+      ast_free_node(node);
       return NULL;
     }
 
-    ast_node_t *new_node = ast_new_binary_op_node(op->lexeme[0], node, right);
+    ast_node_t *new_node = ast_new_binary_op_node(op->type, node, right);
     if (new_node == NULL) {
       return NULL;
     }
 
+    new_node->line = op->line;
     node = new_node;
   }
 
   return node;
 }
 
+// Precedence, lowest first: or, and, == !=, < <= > >=, + -, * /
+ast_node_t *parse_expression(parser_t *parser) {
+  return parse_precedence(parser, 0);
+}
+
 ast_node_t *parse_factor(parser_t *parser) {
   token_t *token = parser->current;
+  ast_node_t *node = NULL;
   switch (token->type) {
   case TOKEN_INT:
     parser_advance(parser); // Consume the integer
-    return ast_new_literal_node(token->integer);
+    node = ast_new_literal_node(token->integer);
+    break;
+  case TOKEN_FLOAT:
+    parser_advance(parser); // Consume the float
+    node = ast_new_float_literal_node(token->floating);
+    break;
+  case TOKEN_STRING:
+    parser_advance(parser); // Consume the string
+    node = ast_new_string_literal_node(token->lexeme);
+    break;
+  case TOKEN_TRUE:
+  case TOKEN_FALSE:
+    parser_advance(parser); // Consume the boolean
+    node = ast_new_literal_node(token->type == TOKEN_TRUE);
+    break;
+  case TOKEN_NULL_KEYWORD:
+    parser_advance(parser); // Consume `null`
+    node = ast_new_null_literal_node();
+    break;
   case TOKEN_LPAREN: {
     parser_advance(parser); // Consume the '('
-    ast_node_t *node = parse_expression(parser);
+    node = parse_expression(parser);
     if (node == NULL) {
       return NULL;
     }
@@ -350,6 +615,7 @@ ast_node_t *parse_factor(parser_t *parser) {
     if (!parser->current || parser->current->type != TOKEN_RPAREN) {
       fprintf(stderr, "Parser Error: Expected ')' on line %d\n",
               parser->current->line);
+      ast_free_node(node);
       return NULL;
     }
     parser_advance(parser); // Consume the ')'
@@ -364,16 +630,349 @@ ast_node_t *parse_factor(parser_t *parser) {
       return NULL;
     }
 
-    return ast_new_unary_op_node(op->lexeme[0], operand);
+    node = ast_new_unary_op_node(op->type, operand);
+    break;
   }
   case TOKEN_IDENTIFIER:
-    return ast_new_variable_node(token->lexeme);
+    parser_advance(parser); // Consume the identifier
+    if (parser->current->type == TOKEN_LPAREN) {
+      return parse_call(parser, token);
+    }
+    node = ast_new_variable_node(token->lexeme);
+    break;
   default:
-    fprintf(stderr, "Parser Error: Unexpected token on line %d\n", token->line);
+    fprintf(stderr, "Parser Error: Unexpected token '%s' on line %d\n",
+            token->lexeme, token->line);
     return NULL;
   }
+
+  if (node != NULL) {
+    node->line = token->line;
+  }
+  return node;
 }
 
+// Parses `(arg, ...)` after a function name that was already consumed
+ast_node_t *parse_call(parser_t *parser, token_t *identifier) {
+  ast_node_t *node = ast_new_call_node(identifier->lexeme);
+  if (node == NULL) {
+    return NULL;
+  }
+  node->line = identifier->line;
+
+  parser_advance(parser); // Consume the '('
+  while (parser->current->type != TOKEN_RPAREN) {
+    ast_node_t *arg = parse_expression(parser);
+    if (arg == NULL) {
+      ast_free_node(node);
+      return NULL;
+    }
+    ast_node_list_append(&node->call.args, arg);
+
+    if (parser->current->type == TOKEN_COMMA) {
+      parser_advance(parser); // Consume the ','
+    } else if (parser->current->type != TOKEN_RPAREN) {
+      fprintf(stderr, "Parser Error: Expected ',' or ')' in call to '%s' on "
+                      "line %d\n",
+              identifier->lexeme, parser->current->line);
+      ast_free_node(node);
+      return NULL;
+    }
+  }
+  parser_advance(parser); // Consume the ')'
+
+  return node;
+}
+
+// def name(param: type, ...) -> type:
+//     body
+ast_node_t *parse_function(parser_t *parser) {
+  token_t *def = parser->current;
+  parser_advance(parser); // Consume `def`
+
+  token_t *name = parser->current;
+  if (name->type != TOKEN_IDENTIFIER) {
+    fprintf(stderr, "Parser Error: Expected function name on line %d\n",
+            name->line);
+    return NULL;
+  }
+  parser_advance(parser); // Consume the name
+
+  if (parser->current->type != TOKEN_LPAREN) {
+    fprintf(stderr, "Parser Error: Expected '(' after '%s' on line %d\n",
+            name->lexeme, parser->current->line);
+    return NULL;
+  }
+  parser_advance(parser); // Consume the '('
+
+  ast_node_t *node = ast_new_function_node(name->lexeme);
+  if (node == NULL) {
+    return NULL;
+  }
+  node->line = def->line;
+
+  while (parser->current->type != TOKEN_RPAREN) {
+    token_t *param = parser->current;
+    if (param->type != TOKEN_IDENTIFIER) {
+      fprintf(stderr, "Parser Error: Expected parameter name on line %d\n",
+              param->line);
+      ast_free_node(node);
+      return NULL;
+    }
+    parser_advance(parser); // Consume the parameter name
+
+    if (parser->current->type != TOKEN_COLON) {
+      fprintf(stderr,
+              "Parser Error: Expected ':' after parameter '%s' on line %d\n",
+              param->lexeme, param->line);
+      ast_free_node(node);
+      return NULL;
+    }
+    parser_advance(parser); // Consume `:`
+    token_t *type = parser->current;
+    parser_advance(parser); // Consume the type
+
+    int count = node->function.param_count + 1;
+    node->function.param_names =
+        realloc(node->function.param_names, count * sizeof(char *));
+    node->function.param_types =
+        realloc(node->function.param_types, count * sizeof(char *));
+    node->function.param_names[count - 1] = strdup(param->lexeme);
+    node->function.param_types[count - 1] = strdup(type->lexeme);
+    node->function.param_count = count;
+
+    if (parser->current->type == TOKEN_COMMA) {
+      parser_advance(parser); // Consume the ','
+    } else if (parser->current->type != TOKEN_RPAREN) {
+      fprintf(stderr, "Parser Error: Expected ',' or ')' on line %d\n",
+              parser->current->line);
+      ast_free_node(node);
+      return NULL;
+    }
+  }
+  parser_advance(parser); // Consume the ')'
+
+  // The lexer has no arrow token, `->` arrives as `-` followed by `>`
+  if (parser->current->type == TOKEN_MINUS) {
+    parser_advance(parser); // Consume `-`
+    if (parser->current->type != TOKEN_GREATER) {
+      fprintf(stderr, "Parser Error: Expected '->' on line %d\n",
+              parser->current->line);
+      ast_free_node(node);
+      return NULL;
+    }
+    parser_advance(parser); // Consume `>`
+    node->function.return_type = strdup(parser->current->lexeme);
+    parser_advance(parser); // Consume the return type
+  } else {
+    node->function.return_type = strdup("void");
+  }
+
+  if (!parse_block(parser, &node->function.body)) {
+    ast_free_node(node);
+    return NULL;
+  }
+
+  return node;
+}
+
+ast_node_t *parse_return(parser_t *parser) {
+  token_t *token = parser->current;
+  parser_advance(parser); // Consume `return`
+
+  ast_node_t *value = NULL;
+  if (parser->current->type != TOKEN_EOL &&
+      parser->current->type != TOKEN_DEDENT &&
+      parser->current->type != TOKEN_EOF) {
+    value = parse_expression(parser);
+    if (value == NULL) {
+      return NULL;
+    }
+  }
+
+  ast_node_t *node = ast_new_return_node(value);
+  if (node != NULL) {
+    node->line = token->line;
+  }
+  return node;
+}
+
+// if condition:
+//     body
+// elif condition:
+//     body
+// else:
+//     body
+ast_node_t *parse_if(parser_t *parser) {
+  token_t *token = parser->current;
+  parser_advance(parser); // Consume `if` or `elif`
+
+  ast_node_t *condition = parse_expression(parser);
+  if (condition == NULL) {
+    return NULL;
+  }
+
+  ast_node_t *node = ast_new_if_node(condition);
+  if (node == NULL) {
+    ast_free_node(condition);
+    return NULL;
+  }
+  node->line = token->line;
+
+  if (!parse_block(parser, &node->if_stmt.then_branch)) {
+    ast_free_node(node);
+    return NULL;
+  }
+
+  if (parser->current->type == TOKEN_ELIF) {
+    ast_node_t *elif = parse_if(parser);
+    if (elif == NULL) {
+      ast_free_node(node);
+      return NULL;
+    }
+    ast_node_list_append(&node->if_stmt.else_branch, elif);
+  } else if (parser->current->type == TOKEN_ELSE) {
+    parser_advance(parser); // Consume `else`
+    if (!parse_block(parser, &node->if_stmt.else_branch)) {
+      ast_free_node(node);
+      return NULL;
+    }
+  }
+
+  return node;
+}
+
+// while condition:
+//     body
+ast_node_t *parse_while(parser_t *parser) {
+  token_t *token = parser->current;
+  parser_advance(parser); // Consume `while`
+
+  ast_node_t *condition = parse_expression(parser);
+  if (condition == NULL) {
+    return NULL;
+  }
+
+  ast_node_t *node = ast_new_while_node(condition);
+  if (node == NULL) {
+    ast_free_node(condition);
+    return NULL;
+  }
+  node->line = token->line;
+
+  if (!parse_block(parser, &node->while_stmt.body)) {
+    ast_free_node(node);
+    return NULL;
+  }
+
+  return node;
+}
+
+// for init; condition; step:
+//     body
+// Each of the three clauses may be left empty.
+ast_node_t *parse_for(parser_t *parser) {
+  token_t *token = parser->current;
+  parser_advance(parser); // Consume `for`
+
+  ast_node_t *node = ast_new_for_node();
+  if (node == NULL) {
+    return NULL;
+  }
+  node->line = token->line;
+
+  if (parser->current->type != TOKEN_SEMICOLON) {
+    node->for_stmt.init = parse_assignment(parser);
+    if (node->for_stmt.init == NULL) {
+      ast_free_node(node);
+      return NULL;
+    }
+  }
+  if (parser->current->type != TOKEN_SEMICOLON) {
+    fprintf(stderr, "Parser Error: Expected ';' after for initializer on "
+                    "line %d\n",
+            parser->current->line);
+    ast_free_node(node);
+    return NULL;
+  }
+  parser_advance(parser); // Consume `;`
+
+  if (parser->current->type != TOKEN_SEMICOLON) {
+    node->for_stmt.condition = parse_expression(parser);
+    if (node->for_stmt.condition == NULL) {
+      ast_free_node(node);
+      return NULL;
+    }
+  }
+  if (parser->current->type != TOKEN_SEMICOLON) {
+    fprintf(stderr, "Parser Error: Expected ';' after for condition on "
+                    "line %d\n",
+            parser->current->line);
+    ast_free_node(node);
+    return NULL;
+  }
+  parser_advance(parser); // Consume `;`
+
+  if (parser->current->type != TOKEN_COLON) {
+    node->for_stmt.step = parse_assignment(parser);
+    if (node->for_stmt.step == NULL) {
+      ast_free_node(node);
+      return NULL;
+    }
+  }
+
+  if (!parse_block(parser, &node->for_stmt.body)) {
+    ast_free_node(node);
+    return NULL;
+  }
+
+  return node;
+}
+
+// Parses `: EOL INDENT statement... DEDENT` into `block`
+bool parse_block(parser_t *parser, ast_node_list_t *block) {
+  if (parser->current->type != TOKEN_COLON) {
+    fprintf(stderr, "Parser Error: Expected ':' before block on line %d\n",
+            parser->current->line);
+    return false;
+  }
+  parser_advance(parser); // Consume `:`
+
+  while (parser->current->type == TOKEN_EOL) {
+    parser_advance(parser);
+  }
+
+  if (parser->current->type != TOKEN_INDENT) {
+    fprintf(stderr, "Parser Error: Expected an indented block on line %d\n",
+            parser->current->line);
+    return false;
+  }
+  parser_advance(parser); // Consume INDENT
+
+  while (parser->current->type != TOKEN_DEDENT &&
+         parser->current->type != TOKEN_EOF) {
+    if (parser->current->type == TOKEN_EOL) {
+      parser_advance(parser);
+      continue;
+    }
+
+    ast_node_t *node = parse_statement(parser);
+    if (node == NULL) {
+      return false;
+    }
+    ast_node_list_append(block, node);
+  }
+
+  if (parser->current->type == TOKEN_DEDENT) {
+    parser_advance(parser); // Consume DEDENT
+  }
+
+  return true;
+}
+
+static void print_ast_list(const char *label, ast_node_list_t *list, int depth,
+                           int is_last, int branch_stack[]);
+
 void print_ast(ast_node_t *node, int depth, int is_last, int branch_stack[]) {
     if (!node)
         return;
@@ -395,16 +994,24 @@ void print_ast(ast_node_t *node, int depth, int is_last, int branch_stack[]) {
     // Print node type
     switch (node->type) {
     case NODE_LITERAL:
-        printf("Literal: %d\n", node->literal.value);
+        if (node->literal.kind == TOKEN_FLOAT) {
+            printf("Literal: %g\n", node->literal.floating);
+        } else if (node->literal.kind == TOKEN_STRING) {
+            printf("Literal: \"%s\"\n", node->literal.string);
+        } else if (node->literal.kind == TOKEN_NULL_KEYWORD) {
+            printf("Literal: null\n");
+        } else {
+            printf("Literal: %d\n", node->literal.value);
+        }
         break;
     case NODE_BINARY_OP:
-        printf("Binary Op: %c\n", node->binary_op.op);
+        printf("Binary Op: %s\n", ast_operator_string(node->binary_op.op));
         branch_stack[depth] = !is_last;  // Mark if we need a vertical line
         print_ast(node->binary_op.left, depth + 1, 0, branch_stack);
         print_ast(node->binary_op.right, depth + 1, 1, branch_stack);
         break;
     case NODE_UNARY_OP:
-        printf("Unary Op: %c\n", node->unary_op.op);
+        printf("Unary Op: %s\n", ast_operator_string(node->unary_op.op));
         print_ast(node->unary_op.operand, depth + 1, 1, branch_stack);
         break;
     case NODE_VARIABLE:
@@ -420,6 +1027,121 @@ void print_ast(ast_node_t *node, int depth, int is_last, int branch_stack[]) {
             print_ast(node->declaration.value, depth + 1, 1, branch_stack);
         }
         break;
+    case NODE_FUNCTION:
+        printf("Function: %s(", node->function.name);
+        for (int i = 0; i < node->function.param_count; i++) {
+            printf("%s%s: %s", i > 0 ? ", " : "", node->function.param_names[i],
+                   node->function.param_types[i]);
+        }
+        printf(") -> %s\n", node->function.return_type);
+        branch_stack[depth] = !is_last;
+        for (int i = 0; i < node->function.body.count; i++) {
+            print_ast(node->function.body.nodes[i], depth + 1,
+                      i == node->function.body.count - 1, branch_stack);
+        }
+        break;
+    case NODE_CALL:
+        printf("Call: %s\n", node->call.name);
+        branch_stack[depth] = !is_last;
+        for (int i = 0; i < node->call.args.count; i++) {
+            print_ast(node->call.args.nodes[i], depth + 1,
+                      i == node->call.args.count - 1, branch_stack);
+        }
+        break;
+    case NODE_RETURN:
+        printf("Return\n");
+        print_ast(node->return_stmt.value, depth + 1, 1, branch_stack);
+        break;
+    case NODE_IF:
+        printf("If\n");
+        branch_stack[depth] = !is_last;
+        print_ast(node->if_stmt.condition, depth + 1, 0, branch_stack);
+        print_ast_list("Then", &node->if_stmt.then_branch, depth + 1,
+                       node->if_stmt.else_branch.count == 0, branch_stack);
+        if (node->if_stmt.else_branch.count > 0) {
+            print_ast_list("Else", &node->if_stmt.else_branch, depth + 1, 1,
+                           branch_stack);
+        }
+        break;
+    case NODE_WHILE:
+        printf("While\n");
+        branch_stack[depth] = !is_last;
+        print_ast(node->while_stmt.condition, depth + 1, 0, branch_stack);
+        print_ast_list("Body", &node->while_stmt.body, depth + 1, 1,
+                       branch_stack);
+        break;
+    case NODE_FOR:
+        printf("For\n");
+        branch_stack[depth] = !is_last;
+        print_ast(node->for_stmt.init, depth + 1, 0, branch_stack);
+        print_ast(node->for_stmt.condition, depth + 1, 0, branch_stack);
+        print_ast(node->for_stmt.step, depth + 1, 0, branch_stack);
+        print_ast_list("Body", &node->for_stmt.body, depth + 1, 1,
+                       branch_stack);
+        break;
+    case NODE_BREAK:
+        printf("Break\n");
+        break;
+    case NODE_CONTINUE:
+        printf("Continue\n");
+        break;
+    case NODE_BLOCK:
+        printf("Block\n");
+        branch_stack[depth] = !is_last;
+        for (int i = 0; i < node->block.statements.count; i++) {
+            print_ast(node->block.statements.nodes[i], depth + 1,
+                      i == node->block.statements.count - 1, branch_stack);
+        }
+        break;
+    }
+}
+
+// Prints `label` as a node whose children are the statements of `list`
+static void print_ast_list(const char *label, ast_node_list_t *list, int depth,
+                           int is_last, int branch_stack[]) {
+    for (int i = 0; i < depth - 1; i++) {
+        printf(branch_stack[i] ? "│   " : "    ");
+    }
+    printf(is_last ? "└── " : "├── ");
+    printf("%s\n", label);
+
+    branch_stack[depth] = !is_last;
+    for (int i = 0; i < list->count; i++) {
+        print_ast(list->nodes[i], depth + 1, i == list->count - 1,
+                  branch_stack);
+    }
+}
+
+const char *ast_operator_string(token_type_t op) {
+    switch (op) {
+    case TOKEN_PLUS:
+        return "+";
+    case TOKEN_MINUS:
+        return "-";
+    case TOKEN_STAR:
+        return "*";
+    case TOKEN_SLASH:
+        return "/";
+    case TOKEN_BANG:
+        return "!";
+    case TOKEN_EQUAL_EQUAL:
+        return "==";
+    case TOKEN_BANG_EQUAL:
+        return "!=";
+    case TOKEN_LESS:
+        return "<";
+    case TOKEN_LESS_EQUAL:
+        return "<=";
+    case TOKEN_GREATER:
+        return ">";
+    case TOKEN_GREATER_EQUAL:
+        return ">=";
+    case TOKEN_AND:
+        return "and";
+    case TOKEN_OR:
+        return "or";
+    default:
+        return "?";
     }
 }
 
@@ -1,7 +1,6 @@
 #pragma once
 #include "../lexer/lexer.h"
-
-#define MAX_NODES 1024
+#include "../stack/stack.h"
 
 typedef enum {
   NODE_LITERAL,
@@ -10,22 +9,43 @@ typedef enum {
   NODE_VARIABLE,
   NODE_ASSIGNMENT,
   NODE_DECLARATION,
-  // NODE_FUNCTION
+  NODE_FUNCTION,
+  NODE_CALL,
+  NODE_RETURN,
+  NODE_IF,
+  NODE_WHILE,
+  NODE_FOR,
+  NODE_BREAK,
+  NODE_CONTINUE,
+  NODE_BLOCK,
 } ast_node_type_t;
 
+typedef struct ASTNode ast_node_t;
+
+// Growable list of nodes, used for blocks and argument lists
+typedef struct ASTNodeList {
+  ast_node_t **nodes;
+  int count;
+  int capacity;
+} ast_node_list_t;
+
 typedef struct ASTNode {
   ast_node_type_t type;
+  int line; // Source line the node starts on
   union {
     struct {
+      token_type_t kind; // TOKEN_INT, TOKEN_FLOAT, TOKEN_STRING or null
       int value;
+      double floating;
+      char *string;
     } literal;
     struct {
-      char op;
+      token_type_t op; // Operator token, `and`/`or` short-circuit
       struct ASTNode *left;
       struct ASTNode *right;
     } binary_op;
     struct {
-      char op;
+      token_type_t op;
       struct ASTNode *operand;
     } unary_op;
     struct {
@@ -40,45 +60,108 @@ typedef struct ASTNode {
       char *type;
       struct ASTNode *value;
     } declaration;
+    struct {
+      char *name;
+      char **param_names;
+      char **param_types;
+      int param_count;
+      char *return_type;
+      ast_node_list_t body;
+    } function;
+    struct {
+      char *name;
+      ast_node_list_t args;
+    } call;
+    struct {
+      struct ASTNode *value; // NULL for a bare `return`
+    } return_stmt;
+    struct {
+      struct ASTNode *condition;
+      ast_node_list_t then_branch;
+      ast_node_list_t else_branch; // An `elif` is a lone nested NODE_IF
+    } if_stmt;
+    struct {
+      struct ASTNode *condition;
+      ast_node_list_t body;
+    } while_stmt;
+    struct {
+      struct ASTNode *init;      // Declaration or assignment, may be NULL
+      struct ASTNode *condition; // NULL loops until `break`
+      struct ASTNode *step;      // Assignment, may be NULL
+      ast_node_list_t body;
+    } for_stmt;
+    struct {
+      ast_node_list_t statements; // Run in order, without a new scope
+    } block;
   };
 } ast_node_t;
 
+// Top-level statements of a script, in source order
 typedef struct ASTRoot {
   ast_node_t **nodes;
   int count;
+  int capacity;
 } ast_root_t;
 
 typedef struct Parser {
   lexer_t *lexer;
   ast_root_t *root;
   token_t *current;
+  stack_t *tokens; // Every token read, freed with the parser
 } parser_t;
 
 // Memory management
+ast_root_t *ast_root_new();
+void ast_root_append(ast_root_t *root, ast_node_t *node);
+void ast_root_free(ast_root_t *root); // Frees the nodes too
 ast_node_t *ast_new_node(ast_node_type_t type);
 ast_node_t *ast_new_literal_node(int value);
-ast_node_t *ast_new_binary_op_node(char op, ast_node_t *left,
+ast_node_t *ast_new_null_literal_node();
+ast_node_t *ast_new_float_literal_node(double value);
+ast_node_t *ast_new_string_literal_node(char *value);
+ast_node_t *ast_new_binary_op_node(token_type_t op, ast_node_t *left,
                                    ast_node_t *right);
-ast_node_t *ast_new_unary_op_node(char op, ast_node_t *operand);
+ast_node_t *ast_new_unary_op_node(token_type_t op, ast_node_t *operand);
 ast_node_t *ast_new_variable_node(char *name);
 ast_node_t *ast_new_assignment_node(char *name, ast_node_t *value);
 ast_node_t *ast_new_declaration_node(char *name, char *type, ast_node_t *value);
+ast_node_t *ast_new_function_node(char *name);
+ast_node_t *ast_new_call_node(char *name);
+ast_node_t *ast_new_return_node(ast_node_t *value);
+ast_node_t *ast_new_if_node(ast_node_t *condition);
+ast_node_t *ast_new_while_node(ast_node_t *condition);
+ast_node_t *ast_new_for_node();
+ast_node_t *ast_new_block_node();
 void ast_free_node(ast_node_t *node);
+void ast_node_list_append(ast_node_list_t *list, ast_node_t *node);
+void ast_node_list_insert(ast_node_list_t *list, int index, ast_node_t *node);
+void ast_node_list_free(ast_node_list_t *list);
 
 // Parser function prototypes
 parser_t *parser_new(lexer_t *lexer);
 void parser_free(parser_t *parser);
 void parser_advance(parser_t *parser);
 ast_root_t *parse_root(parser_t *parser);
+// True if a top-level statement starts at `line`, the start of a line
+// outside any string literal: it begins in column 0, isn't blank, and
+// doesn't continue an `if` with `elif` or `else`.
+bool line_starts_statement(const char *line);
 ast_node_t *parse_statement(parser_t *parser);
 ast_node_t *parse_expression(parser_t *parser);
 ast_node_t *parse_assignment(parser_t *parser);
 ast_node_t *parse_declaration(parser_t *parser);
 ast_node_t *parse_primary(parser_t *parser);
 ast_node_t *parse_unary(parser_t *parser);
-ast_node_t *parse_term(parser_t *parser);
 ast_node_t *parse_factor(parser_t *parser);
+ast_node_t *parse_call(parser_t *parser, token_t *identifier);
+ast_node_t *parse_function(parser_t *parser);
+ast_node_t *parse_return(parser_t *parser);
+ast_node_t *parse_if(parser_t *parser);
+ast_node_t *parse_while(parser_t *parser);
+ast_node_t *parse_for(parser_t *parser);
+bool parse_block(parser_t *parser, ast_node_list_t *block);
 
 // Debugging
+const char *ast_operator_string(token_type_t op);
 void print_ast(ast_node_t *node, int depth, int is_right, int *branch_stack);
 void print_ast_tree(ast_node_t *root);
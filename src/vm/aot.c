@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aot.h"
+#include "gc.h"
+
+_Noreturn void aot_error(const char *message, int line, const char *function) {
+  fprintf(stderr, "Runtime Error: %s on line %d in %s\n", message, line,
+          function);
+  exit(1);
+}
+
+void aot_safepoint(vm_t *vm, int line, const char *function) {
+  if (vm->interrupted) {
+    aot_error("Interrupted", line, function);
+  }
+
+  vm_safepoint(vm);
+}
+
+void aot_apply(vm_t *vm, opcode_t op, int line, const char *function) {
+  const char *error = vm_apply(vm, op);
+  if (error != NULL) {
+    aot_error(error, line, function);
+  }
+}
+
+snek_object_t *aot_constant(snek_object_t *constant) {
+  constant->is_marked = true;
+  return constant;
+}
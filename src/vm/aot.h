@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "../objects/sneknew.h"
+#include "bytecode.h"
+#include "interpreter.h"
+#include "vm.h"
+
+// Runtime support for the C that `sneklang --emit-c` generates. Typed ints
+// and floats live in C variables; every other value is kept on the VM's
+// value stack, exactly as the interpreter keeps it, so the GC still finds
+// all of them.
+
+#define AOT_SLOTS(vm) ((snek_object_t **)(vm)->stack->data)
+#define AOT_PUSH(vm, value) stack_push((vm)->stack, (value))
+#define AOT_POP(vm) ((snek_object_t *)stack_pop((vm)->stack))
+#define AOT_PEEK(vm) (AOT_SLOTS(vm)[(vm)->stack->count - 1])
+
+// Reports a runtime error the way the interpreter does and exits
+_Noreturn void aot_error(const char *message, int line, const char *function);
+
+// Collects garbage if due and stops the program if it was interrupted. Only
+// called where every live object is on the value stack.
+void aot_safepoint(vm_t *vm, int line, const char *function);
+
+// vm_apply, exiting with the interpreter's message if it fails
+void aot_apply(vm_t *vm, opcode_t op, int line, const char *function);
+
+// Marks an untracked object as permanently reachable, like a chunk constant
+snek_object_t *aot_constant(snek_object_t *constant);
+
+// Integer arithmetic wraps around with the interpreter's own helpers
+#define aot_add_int snek_int_add
+#define aot_subtract_int snek_int_subtract
+#define aot_multiply_int snek_int_multiply
+#define aot_negate_int snek_int_negate
+
+static inline int aot_divide_int(int a, int b, int line,
+                                 const char *function) {
+  if (b == 0) {
+    aot_error("Division by zero", line, function);
+  }
+  return snek_int_divide(a, b);
+}
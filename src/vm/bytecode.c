@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../objects/snekobject.h"
+#include "../objects/snekstring.h"
+#include "bytecode.h"
+#include "jit.h"
+
+void chunk_init(chunk_t *chunk) {
+  chunk->code = NULL;
+  chunk->lines = NULL;
+  chunk->count = 0;
+  chunk->capacity = 0;
+  chunk->constants = stack_new(8);
+}
+
+void chunk_free(chunk_t *chunk) {
+  free(chunk->code);
+  free(chunk->lines);
+
+  for (size_t i = 0; i < chunk->constants->count; i++) {
+    snek_object_free(chunk->constants->data[i]);
+  }
+  stack_free(chunk->constants);
+}
+
+void chunk_write(chunk_t *chunk, uint8_t byte, int line) {
+  if (chunk->count == chunk->capacity) {
+    chunk->capacity = chunk->capacity < 64 ? 64 : chunk->capacity * 2;
+    chunk->code = realloc(chunk->code, chunk->capacity);
+    chunk->lines = realloc(chunk->lines, chunk->capacity * sizeof(int));
+    if (chunk->code == NULL || chunk->lines == NULL) {
+      exit(1);
+    }
+  }
+
+  chunk->code[chunk->count] = byte;
+  chunk->lines[chunk->count] = line;
+  chunk->count++;
+}
+
+void chunk_write_short(chunk_t *chunk, uint16_t value, int line) {
+  chunk_write(chunk, (value >> 8) & 0xff, line);
+  chunk_write(chunk, value & 0xff, line);
+}
+
+// Constants are created without a VM and owned by the chunk. They are marked
+// once here and never swept, so the GC treats them as permanently reachable
+// and stops tracing when it reaches one. String hashes are cached up front so
+// isolates sharing the program on other threads never write to a constant.
+int chunk_add_constant(chunk_t *chunk, snek_object_t *constant) {
+  constant->is_marked = true;
+  if (constant->kind == STRING) {
+    snek_string_hash(constant);
+  }
+  stack_push(chunk->constants, constant);
+  return (int)chunk->constants->count - 1;
+}
+
+function_t *function_new(const char *name, int arity) {
+  function_t *function = malloc(sizeof(function_t));
+  if (function == NULL) {
+    return NULL;
+  }
+
+  function->name = strdup(name);
+  function->arity = arity;
+  function->local_count = arity;
+  chunk_init(&function->chunk);
+  function->back_edges = 0;
+  function->jit = NULL;
+  return function;
+}
+
+void function_free(function_t *function) {
+  if (function == NULL) {
+    return;
+  }
+
+  free(function->name);
+  chunk_free(&function->chunk);
+  jit_free(function->jit);
+  free(function);
+}
+
+program_t *program_new() {
+  program_t *program = malloc(sizeof(program_t));
+  if (program == NULL) {
+    return NULL;
+  }
+
+  program->functions = stack_new(8);
+  program->global_names = stack_new(8);
+  return program;
+}
+
+void program_free(program_t *program) {
+  if (program == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < program->functions->count; i++) {
+    function_free(program->functions->data[i]);
+  }
+  stack_free(program->functions);
+
+  for (size_t i = 0; i < program->global_names->count; i++) {
+    free(program->global_names->data[i]);
+  }
+  stack_free(program->global_names);
+  free(program);
+}
+
+int program_find_function(program_t *program, const char *name) {
+  for (size_t i = 0; i < program->functions->count; i++) {
+    function_t *function = program->functions->data[i];
+    if (strcmp(function->name, name) == 0) {
+      return (int)i;
+    }
+  }
+
+  return -1;
+}
+
+int program_find_global(program_t *program, const char *name) {
+  for (size_t i = 0; i < program->global_names->count; i++) {
+    if (strcmp(program->global_names->data[i], name) == 0) {
+      return (int)i;
+    }
+  }
+
+  return -1;
+}
+
+const char *opcode_name(opcode_t op) {
+  switch (op) {
+  case OP_CONSTANT:
+    return "CONSTANT";
+  case OP_NIL:
+    return "NIL";
+  case OP_POP:
+    return "POP";
+  case OP_DUP:
+    return "DUP";
+  case OP_GET_LOCAL:
+    return "GET_LOCAL";
+  case OP_SET_LOCAL:
+    return "SET_LOCAL";
+  case OP_GET_GLOBAL:
+    return "GET_GLOBAL";
+  case OP_SET_GLOBAL:
+    return "SET_GLOBAL";
+  case OP_ADD:
+    return "ADD";
+  case OP_SUBTRACT:
+    return "SUBTRACT";
+  case OP_MULTIPLY:
+    return "MULTIPLY";
+  case OP_DIVIDE:
+    return "DIVIDE";
+  case OP_NEGATE:
+    return "NEGATE";
+  case OP_NOT:
+    return "NOT";
+  case OP_EQUAL:
+    return "EQUAL";
+  case OP_NOT_EQUAL:
+    return "NOT_EQUAL";
+  case OP_LESS:
+    return "LESS";
+  case OP_LESS_EQUAL:
+    return "LESS_EQUAL";
+  case OP_GREATER:
+    return "GREATER";
+  case OP_GREATER_EQUAL:
+    return "GREATER_EQUAL";
+  case OP_JUMP:
+    return "JUMP";
+  case OP_JUMP_IF_FALSE:
+    return "JUMP_IF_FALSE";
+  case OP_JUMP_IF_FALSE_OR_POP:
+    return "JUMP_IF_FALSE_OR_POP";
+  case OP_JUMP_IF_TRUE_OR_POP:
+    return "JUMP_IF_TRUE_OR_POP";
+  case OP_LOOP:
+    return "LOOP";
+  case OP_CALL:
+    return "CALL";
+  case OP_TAIL_CALL:
+    return "TAIL_CALL";
+  case OP_RETURN:
+    return "RETURN";
+  case OP_PRINT:
+    return "PRINT";
+  }
+
+  return "UNKNOWN";
+}
+
+size_t instruction_size(opcode_t op) {
+  switch (op) {
+  case OP_GET_LOCAL:
+  case OP_SET_LOCAL:
+  case OP_PRINT:
+    return 2;
+  case OP_CONSTANT:
+  case OP_GET_GLOBAL:
+  case OP_SET_GLOBAL:
+  case OP_JUMP:
+  case OP_JUMP_IF_FALSE:
+  case OP_JUMP_IF_FALSE_OR_POP:
+  case OP_JUMP_IF_TRUE_OR_POP:
+  case OP_LOOP:
+    return 3;
+  case OP_CALL:
+  case OP_TAIL_CALL:
+    return 4;
+  default:
+    return 1;
+  }
+}
+
+static uint16_t read_short(chunk_t *chunk, size_t offset) {
+  return (uint16_t)((chunk->code[offset] << 8) | chunk->code[offset + 1]);
+}
+
+size_t disassemble_instruction(FILE *out, program_t *program, chunk_t *chunk,
+                               size_t offset) {
+  opcode_t op = chunk->code[offset];
+  fprintf(out, "%04zu %4d  %-14s", offset, chunk->lines[offset],
+          opcode_name(op));
+
+  switch (op) {
+  case OP_CONSTANT: {
+    uint16_t index = read_short(chunk, offset + 1);
+    fprintf(out, " %u (", index);
+    snek_object_print(out, chunk->constants->data[index]);
+    fprintf(out, ")\n");
+    return offset + 3;
+  }
+  case OP_GET_LOCAL:
+  case OP_SET_LOCAL:
+  case OP_PRINT:
+    fprintf(out, " %u\n", chunk->code[offset + 1]);
+    return offset + 2;
+  case OP_GET_GLOBAL:
+  case OP_SET_GLOBAL: {
+    uint16_t slot = read_short(chunk, offset + 1);
+    // Slots past the globals are the script's block locals
+    fprintf(out, " %u (%s)\n", slot,
+            slot < program->global_names->count
+                ? (char *)program->global_names->data[slot]
+                : "local");
+    return offset + 3;
+  }
+  case OP_JUMP:
+  case OP_JUMP_IF_FALSE:
+  case OP_JUMP_IF_FALSE_OR_POP:
+  case OP_JUMP_IF_TRUE_OR_POP:
+    fprintf(out, " -> %04zu\n", offset + 3 + read_short(chunk, offset + 1));
+    return offset + 3;
+  case OP_LOOP:
+    fprintf(out, " -> %04zu\n", offset + 3 - read_short(chunk, offset + 1));
+    return offset + 3;
+  case OP_CALL:
+  case OP_TAIL_CALL: {
+    function_t *callee = program->functions->data[read_short(chunk, offset + 1)];
+    fprintf(out, " %s/%u\n", callee->name, chunk->code[offset + 3]);
+    return offset + 4;
+  }
+  default:
+    fprintf(out, "\n");
+    return offset + 1;
+  }
+}
+
+void disassemble_program(FILE *out, program_t *program) {
+  for (size_t i = 0; i < program->functions->count; i++) {
+    function_t *function = program->functions->data[i];
+    fprintf(out, "== %s (arity %d, locals %d) ==\n", function->name,
+            function->arity, function->local_count);
+
+    chunk_t *chunk = &function->chunk;
+    for (size_t offset = 0; offset < chunk->count;) {
+      offset = disassemble_instruction(out, program, chunk, offset);
+    }
+  }
+}
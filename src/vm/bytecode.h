@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../stack/stack.h"
+
+typedef struct SnekObject snek_object_t;
+typedef struct JitCode jit_code_t;
+
+// Operands follow the opcode byte. u8 operands are one byte, u16 operands
+// are two bytes, big endian. OP_LOOP is the only backward jump, so every
+// loop header is the target of one, and the interpreter runs its safepoint
+// (GC, interrupts) there.
+typedef enum {
+  OP_CONSTANT,             // u16 constant index
+  OP_NIL,                  // push NULL
+  OP_POP,                  //
+  OP_DUP,                  // push the top value again
+  OP_GET_LOCAL,            // u8 slot in the current frame
+  OP_SET_LOCAL,            // u8 slot in the current frame, pops the value
+  OP_GET_GLOBAL,           // u16 slot in the top-level frame
+  OP_SET_GLOBAL,           // u16 slot in the top-level frame, pops the value
+  OP_ADD,                  //
+  OP_SUBTRACT,             //
+  OP_MULTIPLY,             //
+  OP_DIVIDE,               //
+  OP_NEGATE,               //
+  OP_NOT,                  //
+  OP_EQUAL,                //
+  OP_NOT_EQUAL,            //
+  OP_LESS,                 //
+  OP_LESS_EQUAL,           //
+  OP_GREATER,              //
+  OP_GREATER_EQUAL,        //
+  OP_JUMP,                 // u16 forward offset from the next instruction
+  OP_JUMP_IF_FALSE,        // u16 forward offset, pops the condition
+  OP_JUMP_IF_FALSE_OR_POP, // u16 forward offset, keeps the value if jumping
+  OP_JUMP_IF_TRUE_OR_POP,  // u16 forward offset, keeps the value if jumping
+  OP_LOOP,                 // u16 backward offset from the next instruction
+  OP_CALL,                 // u16 function index, u8 argument count
+  OP_TAIL_CALL,            // u16 function index, u8 argument count
+  OP_RETURN,               //
+  OP_PRINT,                // u8 argument count
+} opcode_t;
+
+typedef struct Chunk {
+  uint8_t *code;
+  int *lines; // Source line of each byte in `code`
+  size_t count;
+  size_t capacity;
+  stack_t *constants; // snek_object_t *, owned by the chunk
+} chunk_t;
+
+typedef struct Function {
+  char *name;
+  int arity;
+  int local_count; // Slots used by the frame, parameters first
+  chunk_t chunk;
+  uint32_t back_edges; // Backward jumps taken, to find hot functions
+  jit_code_t *jit;     // Native code, NULL until the function gets hot
+} function_t;
+
+// A compiled script. functions[0] is the top-level code; its locals are the
+// script's globals, so they live in the bottom frame of the value stack.
+typedef struct Program {
+  stack_t *functions;    // function_t *
+  stack_t *global_names; // char *, one per slot of the top-level frame
+} program_t;
+
+/// Chunks
+void chunk_init(chunk_t *chunk);
+void chunk_free(chunk_t *chunk);
+void chunk_write(chunk_t *chunk, uint8_t byte, int line);
+void chunk_write_short(chunk_t *chunk, uint16_t value, int line);
+int chunk_add_constant(chunk_t *chunk, snek_object_t *constant);
+
+/// Functions and Programs
+function_t *function_new(const char *name, int arity);
+void function_free(function_t *function);
+program_t *program_new();
+void program_free(program_t *program);
+int program_find_function(program_t *program, const char *name);
+int program_find_global(program_t *program, const char *name);
+
+// Size in bytes of an instruction, opcode included
+size_t instruction_size(opcode_t op);
+// Name of an opcode without the OP_ prefix, as the disassembler prints it
+const char *opcode_name(opcode_t op);
+
+/// Debugging
+size_t disassemble_instruction(FILE *out, program_t *program, chunk_t *chunk,
+                               size_t offset);
+void disassemble_program(FILE *out, program_t *program);
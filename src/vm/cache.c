@@ -0,0 +1,446 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../objects/snekobject.h"
+#include "../objects/sneknew.h"
+#include "../objects/snekstring.h"
+#include "cache.h"
+
+// File layout. Every integer is little endian.
+//
+//   header    "SNKC", u32 version, u64 source hash,
+//             u32 function count, u32 global count
+//   globals   one string per global slot
+//   functions name (string), u32 arity, u32 local count,
+//             u32 code length, code bytes,
+//             u32 line runs, (u32 line, u32 length) per run,
+//             u32 constant count, one constant each
+//   constant  u8 kind, then i32 (INTEGER), f32 bits (FLOAT) or
+//             string (STRING)
+//   string    u32 length, bytes (no terminator)
+//
+// Line numbers are stored as runs because every byte of an instruction
+// shares its line, and most consecutive instructions do too.
+
+typedef struct {
+  const uint8_t *data;
+  size_t length;
+  size_t offset;
+  bool failed; // Set by any read past the end; later reads return zeros
+} reader_t;
+
+static const uint8_t *read_bytes(reader_t *reader, size_t length) {
+  if (reader->failed || length > reader->length - reader->offset) {
+    reader->failed = true;
+    return NULL;
+  }
+
+  const uint8_t *bytes = reader->data + reader->offset;
+  reader->offset += length;
+  return bytes;
+}
+
+static uint32_t read_u32(reader_t *reader) {
+  const uint8_t *bytes = read_bytes(reader, 4);
+  if (bytes == NULL) {
+    return 0;
+  }
+
+  return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+         (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static uint64_t read_u64(reader_t *reader) {
+  uint64_t low = read_u32(reader);
+  return low | (uint64_t)read_u32(reader) << 32;
+}
+
+// Returns a NUL-terminated copy (free it), or NULL if the file is too short
+static char *read_string(reader_t *reader) {
+  uint32_t length = read_u32(reader);
+  const uint8_t *bytes = read_bytes(reader, length);
+  if (bytes == NULL) {
+    return NULL;
+  }
+
+  char *string = malloc(length + 1);
+  if (string == NULL) {
+    reader->failed = true;
+    return NULL;
+  }
+  memcpy(string, bytes, length);
+  string[length] = '\0';
+  return string;
+}
+
+static snek_object_t *read_constant(reader_t *reader) {
+  const uint8_t *kind = read_bytes(reader, 1);
+  if (kind == NULL) {
+    return NULL;
+  }
+
+  switch (*kind) {
+  case INTEGER:
+    return new_snek_integer(NULL, (int32_t)read_u32(reader));
+  case FLOAT: {
+    uint32_t bits = read_u32(reader);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return new_snek_float(NULL, value);
+  }
+  case STRING: {
+    uint32_t length = read_u32(reader);
+    const uint8_t *bytes = read_bytes(reader, length);
+    if (bytes == NULL) {
+      return NULL;
+    }
+    return new_snek_string_len(NULL, (const char *)bytes, length);
+  }
+  default:
+    reader->failed = true;
+    return NULL;
+  }
+}
+
+static bool read_function(reader_t *reader, program_t *program) {
+  char *name = read_string(reader);
+  if (name == NULL) {
+    return false;
+  }
+
+  uint32_t arity = read_u32(reader);
+  function_t *function = function_new(name, (int)arity);
+  free(name);
+  if (function == NULL) {
+    return false;
+  }
+  stack_push(program->functions, function);
+  function->local_count = (int)read_u32(reader);
+
+  // Copy the code into the chunk's own buffers so the mapping can go away
+  chunk_t *chunk = &function->chunk;
+  uint32_t count = read_u32(reader);
+  const uint8_t *code = read_bytes(reader, count);
+  // The script's slots, its globals and then its block locals, are reached
+  // with 16-bit operands, a function's with 8-bit ones
+  bool script = program->functions->count == 1;
+  int min_slots = script ? (int)program->global_names->count : function->arity;
+  int max_slots = script ? UINT16_MAX + 1 : UINT8_MAX + 1;
+  if (code == NULL || function->local_count < min_slots ||
+      function->local_count > max_slots) {
+    return false;
+  }
+  chunk->code = malloc(count > 0 ? count : 1);
+  chunk->lines = malloc((count > 0 ? count : 1) * sizeof(int));
+  if (chunk->code == NULL || chunk->lines == NULL) {
+    return false;
+  }
+  memcpy(chunk->code, code, count);
+  chunk->count = chunk->capacity = count;
+
+  uint32_t runs = read_u32(reader);
+  size_t filled = 0;
+  for (uint32_t i = 0; i < runs && !reader->failed; i++) {
+    int line = (int)read_u32(reader);
+    uint32_t length = read_u32(reader);
+    if (length > count - filled) {
+      return false;
+    }
+    for (uint32_t j = 0; j < length; j++) {
+      chunk->lines[filled++] = line;
+    }
+  }
+  if (filled != count) {
+    return false;
+  }
+
+  uint32_t constants = read_u32(reader);
+  for (uint32_t i = 0; i < constants; i++) {
+    snek_object_t *constant = read_constant(reader);
+    if (constant == NULL) {
+      return false;
+    }
+    chunk_add_constant(chunk, constant);
+  }
+
+  return !reader->failed;
+}
+
+// Checks every operand against the program, so a damaged cache file can't
+// make the interpreter index out of bounds or run operands as opcodes.
+static bool verify_function(program_t *program, function_t *function) {
+  chunk_t *chunk = &function->chunk;
+  // Where each instruction starts, the only places a jump may land, and the
+  // end of the chunk
+  bool *starts = calloc(chunk->count + 1, sizeof(bool));
+  if (starts == NULL) {
+    return false;
+  }
+
+  size_t offset = 0;
+  while (offset < chunk->count) {
+    opcode_t op = chunk->code[offset];
+    if (op > OP_PRINT || instruction_size(op) > chunk->count - offset) {
+      free(starts);
+      return false;
+    }
+    starts[offset] = true;
+    offset += instruction_size(op);
+  }
+  starts[chunk->count] = true;
+
+  bool ok = true;
+  for (offset = 0; offset < chunk->count && ok;) {
+    opcode_t op = chunk->code[offset];
+    const uint8_t *operands = chunk->code + offset + 1;
+    uint16_t value = instruction_size(op) >= 3
+                         ? (uint16_t)(operands[0] << 8 | operands[1])
+                         : 0;
+    size_t next = offset + instruction_size(op);
+    switch (op) {
+    case OP_CONSTANT:
+      ok = value < chunk->constants->count;
+      break;
+    case OP_GET_LOCAL:
+    case OP_SET_LOCAL:
+      ok = operands[0] < function->local_count;
+      break;
+    case OP_GET_GLOBAL:
+    case OP_SET_GLOBAL:
+      // Globals, then the script's block locals
+      ok = value < ((function_t *)program->functions->data[0])->local_count;
+      break;
+    case OP_JUMP:
+    case OP_JUMP_IF_FALSE:
+    case OP_JUMP_IF_FALSE_OR_POP:
+    case OP_JUMP_IF_TRUE_OR_POP:
+      ok = value <= chunk->count - next && starts[next + value];
+      break;
+    case OP_LOOP:
+      ok = value <= next && starts[next - value];
+      break;
+    case OP_CALL:
+    case OP_TAIL_CALL: {
+      function_t *callee = value < program->functions->count
+                               ? program->functions->data[value]
+                               : NULL;
+      ok = callee != NULL && operands[2] == callee->arity;
+      break;
+    }
+    default:
+      break;
+    }
+    offset = next;
+  }
+
+  free(starts);
+  return ok;
+}
+
+static program_t *read_program(reader_t *reader, uint64_t source_hash) {
+  const uint8_t *magic = read_bytes(reader, 4);
+  if (magic == NULL || memcmp(magic, SNEKC_MAGIC, 4) != 0 ||
+      read_u32(reader) != SNEKC_VERSION || read_u64(reader) != source_hash) {
+    return NULL;
+  }
+
+  uint32_t function_count = read_u32(reader);
+  uint32_t global_count = read_u32(reader);
+  if (reader->failed || function_count == 0 || global_count > UINT16_MAX + 1) {
+    return NULL;
+  }
+
+  program_t *program = program_new();
+  if (program == NULL) {
+    return NULL;
+  }
+
+  bool ok = true;
+  for (uint32_t i = 0; i < global_count && ok; i++) {
+    char *name = read_string(reader);
+    if (name == NULL) {
+      ok = false;
+    } else {
+      stack_push(program->global_names, name);
+    }
+  }
+  for (uint32_t i = 0; i < function_count && ok; i++) {
+    ok = read_function(reader, program);
+  }
+  for (size_t i = 0; i < program->functions->count && ok; i++) {
+    ok = verify_function(program, program->functions->data[i]);
+  }
+
+  if (!ok || reader->offset != reader->length) {
+    program_free(program);
+    return NULL;
+  }
+  return program;
+}
+
+program_t *cache_load(const char *path, uint64_t source_hash) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+
+  void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+
+  reader_t reader = {.data = data, .length = info.st_size};
+  program_t *program = read_program(&reader, source_hash);
+  munmap(data, info.st_size);
+  return program;
+}
+
+static void write_u32(FILE *out, uint32_t value) {
+  uint8_t bytes[4] = {value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff,
+                      (value >> 24) & 0xff};
+  fwrite(bytes, 1, sizeof(bytes), out);
+}
+
+static void write_string(FILE *out, const char *string, size_t length) {
+  write_u32(out, (uint32_t)length);
+  fwrite(string, 1, length, out);
+}
+
+static void write_constant(FILE *out, snek_object_t *constant) {
+  fputc(constant->kind, out);
+  switch (constant->kind) {
+  case INTEGER:
+    write_u32(out, (uint32_t)constant->data.v_int);
+    break;
+  case FLOAT: {
+    uint32_t bits;
+    memcpy(&bits, &constant->data.v_float, sizeof(bits));
+    write_u32(out, bits);
+    break;
+  }
+  default:
+    write_string(out, snek_string_cstr(constant), snek_string_length(constant));
+    break;
+  }
+}
+
+static void write_function(FILE *out, function_t *function) {
+  write_string(out, function->name, strlen(function->name));
+  write_u32(out, (uint32_t)function->arity);
+  write_u32(out, (uint32_t)function->local_count);
+
+  chunk_t *chunk = &function->chunk;
+  write_u32(out, (uint32_t)chunk->count);
+  fwrite(chunk->code, 1, chunk->count, out);
+
+  uint32_t runs = 0;
+  for (size_t i = 0; i < chunk->count; i++) {
+    if (i == 0 || chunk->lines[i] != chunk->lines[i - 1]) {
+      runs++;
+    }
+  }
+  write_u32(out, runs);
+  for (size_t i = 0; i < chunk->count;) {
+    size_t end = i;
+    while (end < chunk->count && chunk->lines[end] == chunk->lines[i]) {
+      end++;
+    }
+    write_u32(out, (uint32_t)chunk->lines[i]);
+    write_u32(out, (uint32_t)(end - i));
+    i = end;
+  }
+
+  write_u32(out, (uint32_t)chunk->constants->count);
+  for (size_t i = 0; i < chunk->constants->count; i++) {
+    write_constant(out, chunk->constants->data[i]);
+  }
+}
+
+bool cache_write(const char *path, program_t *program, uint64_t source_hash) {
+  size_t length = strlen(path) + 32;
+  char *temp_path = malloc(length);
+  if (temp_path == NULL) {
+    return false;
+  }
+  snprintf(temp_path, length, "%s.%ld.tmp", path, (long)getpid());
+
+  FILE *out = fopen(temp_path, "wb");
+  if (out == NULL) {
+    free(temp_path);
+    return false;
+  }
+
+  fwrite(SNEKC_MAGIC, 1, 4, out);
+  write_u32(out, SNEKC_VERSION);
+  write_u32(out, (uint32_t)source_hash);
+  write_u32(out, (uint32_t)(source_hash >> 32));
+  write_u32(out, (uint32_t)program->functions->count);
+  write_u32(out, (uint32_t)program->global_names->count);
+  for (size_t i = 0; i < program->global_names->count; i++) {
+    char *name = program->global_names->data[i];
+    write_string(out, name, strlen(name));
+  }
+  for (size_t i = 0; i < program->functions->count; i++) {
+    write_function(out, program->functions->data[i]);
+  }
+
+  bool ok = !ferror(out);
+  ok = fclose(out) == 0 && ok;
+  ok = ok && rename(temp_path, path) == 0;
+  if (!ok) {
+    remove(temp_path);
+  }
+  free(temp_path);
+  return ok;
+}
+
+uint64_t cache_hash_source(const char *source, size_t length) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)source[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+char *cache_path(const char *script_path) {
+  const char *dir = getenv(SNEKC_DIR_ENV);
+  if (dir == NULL || dir[0] == '\0') {
+    // script.snek -> script.snekc, anything else just gets a "c"
+    size_t length = strlen(script_path);
+    char *path = malloc(length + 2);
+    if (path == NULL) {
+      return NULL;
+    }
+    memcpy(path, script_path, length);
+    path[length] = 'c';
+    path[length + 1] = '\0';
+    return path;
+  }
+
+  // Scripts from different directories can share a name, so the cache file
+  // is named after the script's full path
+  char *resolved = realpath(script_path, NULL);
+  const char *key = resolved != NULL ? resolved : script_path;
+  uint64_t hash = cache_hash_source(key, strlen(key));
+  free(resolved);
+
+  size_t length = strlen(dir) + 32;
+  char *path = malloc(length);
+  if (path == NULL) {
+    return NULL;
+  }
+  snprintf(path, length, "%s/%016llx.snekc", dir, (unsigned long long)hash);
+  return path;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bytecode.h"
+
+// Compiled scripts are cached as .snekc files so later runs can skip
+// lexing, parsing and compiling. A cache file starts with a header holding
+// SNEKC_MAGIC, SNEKC_VERSION and the hash of the source it was compiled
+// from; a file whose header doesn't match the current source is ignored.
+//
+// Bump SNEKC_VERSION whenever the opcodes, their operands or the file
+// layout change, so stale caches are recompiled instead of misread.
+#define SNEKC_MAGIC "SNKC"
+#define SNEKC_VERSION 2
+
+// Scripts are cached next to themselves (script.snek -> script.snekc)
+// unless this environment variable names a directory to keep them in.
+#define SNEKC_DIR_ENV "SNEK_CACHE_DIR"
+
+// 64-bit FNV-1a hash of the script source
+uint64_t cache_hash_source(const char *source, size_t length);
+
+// Returns the cache path for `script_path` (free it), or NULL if it
+// couldn't be built.
+char *cache_path(const char *script_path);
+
+// Loads the program cached at `path` if it was compiled from source with
+// `source_hash` by this version of sneklang. Returns NULL otherwise.
+program_t *cache_load(const char *path, uint64_t source_hash);
+
+// Writes `program` to `path`. The file is written under a temporary name
+// and renamed into place, so concurrent runs never see half a cache.
+bool cache_write(const char *path, program_t *program, uint64_t source_hash);
@@ -1,83 +1,145 @@
+#include <time.h>
+
 #include "gc.h"
+#include "heap_profiler.h"
+#include "profiler.h"
+#include "tracer.h"
 #include "vm.h"
 
-#include <stdint.h>
-#include <stdio.h>
+_Static_assert(MAP + 1 == VM_OBJECT_KINDS, "gc_stats_t counts every kind");
+
+// Names of snek_object_kind_t in the JSON stats
+static const char *kind_names[VM_OBJECT_KINDS] = {
+    [INTEGER] = "integer", [FLOAT] = "float",
+    [STRING] = "string",   [VECTOR3] = "vector3",
+    [ARRAY] = "array",     [TYPED_ARRAY] = "typed_array",
+    [MAP] = "map",
+};
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void note_heap(gc_stats_t *stats, size_t objects, size_t bytes) {
+  stats->live = objects;
+  stats->live_bytes = bytes;
+  if (objects > stats->peak) {
+    stats->peak = objects;
+  }
+  if (bytes > stats->peak_bytes) {
+    stats->peak_bytes = bytes;
+  }
+}
 
 void vm_collect_garbage(vm_t *vm) {
+  gc_stats_t *stats = &vm->gc_stats;
+  TRACE_POINT(vm, TRACE_GC_BEGIN, TRACE_COLLECT, 0, NULL);
+  uint64_t start = now_ns();
   mark(vm);
   trace(vm);
+  if (vm->heap_profiler != NULL) {
+    heap_profiler_collect(vm->heap_profiler);
+  }
+  uint64_t marked = now_ns();
   sweep(vm);
+  uint64_t end = now_ns();
+
+  TRACE_POINT(vm, TRACE_GC_END, TRACE_COLLECT, stats->live, NULL);
+  stats->collections++;
+  stats->mark_ns += marked - start;
+  stats->sweep_ns += end - marked;
+  if (end - start > stats->max_pause_ns) {
+    stats->max_pause_ns = end - start;
+  }
 }
 
-void mark(vm_t *vm) {
-  if (!vm || !vm->frames || !vm->objects) {
-    fprintf(stderr, "[ERROR] VM, frames, or objects are NULL!\n");
-    return;
+gc_stats_t vm_gc_stats(vm_t *vm) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < vm->objects->count; i++) {
+    bytes += snek_object_size(vm->objects->data[i]);
   }
+  note_heap(&vm->gc_stats, vm->objects->count, bytes);
+  return vm->gc_stats;
+}
 
-  for (size_t i = 0; i < vm->frames->count; i++) {
-    frame_t *frame = vm->frames->data[i];
-
-    if (!frame) {
-      fprintf(stderr, "[ERROR] Frame %zu is NULL!\n", i);
-      continue;
-    }
-    if (!frame->references || !frame->references->data) {
-      fprintf(stderr, "[ERROR] Frame %zu has NULL references or data!\n", i);
-      continue;
-    }
-
-    for (size_t j = 0; j < frame->references->count; j++) {
-      snek_object_t *obj = frame->references->data[j];
-
-      // 🚨 Additional Safety Check
-      if (!obj) {
-        fprintf(stderr,
-                "[WARNING] Null object reference at frame %zu, index %zu\n", i,
-                j);
-        continue;
-      }
-
-      if ((uintptr_t)obj < 0x1000 ||
-          (uintptr_t)obj > 0x7fffffffffff) { // Check for valid address range
-        fprintf(stderr,
-                "[ERROR] Detected invalid object pointer at frame %zu, index "
-                "%zu: %p\n",
-                i, j, obj);
-        continue;
-      }
-
-      if (obj->is_marked) {
-        fprintf(stderr,
-                "[WARNING] Object already marked at frame %zu, index %zu\n", i,
-                j);
-        continue;
-      }
-
-      obj->is_marked = true;
-    }
+bool gc_stats_write_json(FILE *out, const gc_stats_t *stats) {
+  size_t objects = 0;
+  size_t bytes = 0;
+  fprintf(out, "{\n  \"allocated\": {\n");
+  for (int kind = 0; kind < VM_OBJECT_KINDS; kind++) {
+    objects += stats->allocated[kind];
+    bytes += stats->allocated_bytes[kind];
+    fprintf(out, "    \"%s\": {\"objects\": %zu, \"bytes\": %zu}%s\n",
+            kind_names[kind], stats->allocated[kind],
+            stats->allocated_bytes[kind],
+            kind + 1 < VM_OBJECT_KINDS ? "," : "");
   }
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"allocated_objects\": %zu,\n", objects);
+  fprintf(out, "  \"allocated_bytes\": %zu,\n", bytes);
+  fprintf(out, "  \"collections\": %zu,\n", stats->collections);
+  fprintf(out, "  \"freed_objects\": %zu,\n", stats->freed);
+  fprintf(out, "  \"freed_bytes\": %zu,\n", stats->freed_bytes);
+  fprintf(out, "  \"live_objects\": %zu,\n", stats->live);
+  fprintf(out, "  \"live_bytes\": %zu,\n", stats->live_bytes);
+  fprintf(out, "  \"peak_objects\": %zu,\n", stats->peak);
+  fprintf(out, "  \"peak_bytes\": %zu,\n", stats->peak_bytes);
+  fprintf(out, "  \"mark_ns\": %llu,\n", (unsigned long long)stats->mark_ns);
+  fprintf(out, "  \"sweep_ns\": %llu,\n",
+          (unsigned long long)stats->sweep_ns);
+  fprintf(out, "  \"max_pause_ns\": %llu\n}\n",
+          (unsigned long long)stats->max_pause_ns);
+  return !ferror(out);
 }
 
-void trace(vm_t *vm) {
-  stack_t *gray_objects = stack_new(8);
-  if (gray_objects == NULL) {
+const char *gc_kind_name(snek_object_kind_t kind) { return kind_names[kind]; }
+
+void vm_safepoint(vm_t *vm) {
+  if (vm->samples_pending) {
+    vm->samples_pending = 0;
+    profiler_drain(vm->profiler);
+  }
+  if (vm->objects->count < vm->next_gc) {
     return;
   }
 
-  for (size_t i = 0; i < vm->objects->count; i++) {
-    snek_object_t *obj = vm->objects->data[i];
-    if (obj->is_marked) {
-      stack_push(gray_objects, obj);
-    }
+  vm_collect_garbage(vm);
+  // Let the heap double before collecting again, so collection cost stays
+  // proportional to allocation
+  vm->next_gc = vm->objects->count * 2;
+  if (vm->next_gc < VM_INITIAL_GC_THRESHOLD) {
+    vm->next_gc = VM_INITIAL_GC_THRESHOLD;
   }
+}
 
-  while (gray_objects->count > 0) {
-    trace_blacken_object(gray_objects, stack_pop(gray_objects));
+// Roots are exactly the live slots of the value stack. trace_mark_object
+// skips NULL (unset) slots and objects already reached through another slot,
+// so each object enters the worklist once.
+void mark(vm_t *vm) {
+  TRACE_POINT(vm, TRACE_GC_BEGIN, TRACE_MARK, 0, NULL);
+  stack_t *roots = vm->stack;
+  for (size_t i = 0; i < roots->count; i++) {
+    trace_mark_object(vm->gray_objects, roots->data[i]);
   }
+  TRACE_POINT(vm, TRACE_GC_END, TRACE_MARK, vm->gray_objects->count, NULL);
+}
 
-  stack_free(gray_objects);
+// Also measures the live heap, while each reachable object is at hand
+void trace(vm_t *vm) {
+  TRACE_POINT(vm, TRACE_GC_BEGIN, TRACE_TRACE, 0, NULL);
+  stack_t *gray_objects = vm->gray_objects;
+  size_t live_bytes = 0;
+  size_t traced = 0;
+  while (gray_objects->count > 0) {
+    snek_object_t *obj = stack_pop(gray_objects);
+    live_bytes += snek_object_size(obj);
+    trace_blacken_object(gray_objects, obj);
+    traced++;
+  }
+  vm->gc_stats.live_bytes = live_bytes;
+  TRACE_POINT(vm, TRACE_GC_END, TRACE_TRACE, traced, NULL);
 }
 
 void trace_blacken_object(stack_t *gray_objects, snek_object_t *ref) {
@@ -86,8 +148,19 @@ void trace_blacken_object(stack_t *gray_objects, snek_object_t *ref) {
   switch (obj->kind) {
   case INTEGER:
   case FLOAT:
-  case STRING:
+  case TYPED_ARRAY:
+    break;
+  case STRING: {
+    // Rope nodes keep both halves alive until they are flattened
+    snek_string_t str = obj->data.v_string;
+    if (snek_string_is_inline(&str))
+      break;
+    if (str.left)
+      trace_mark_object(gray_objects, str.left);
+    if (str.right)
+      trace_mark_object(gray_objects, str.right);
     break;
+  }
   case VECTOR3: {
     snek_vector_t vec = obj->data.v_vector3;
     if (vec.x)
@@ -99,12 +172,32 @@ void trace_blacken_object(stack_t *gray_objects, snek_object_t *ref) {
     break;
   }
   case ARRAY: {
+    // A view keeps its whole base alive, which in turn traces the elements
+    if (obj->data.v_array.base) {
+      trace_mark_object(gray_objects, obj->data.v_array.base);
+      break;
+    }
     for (size_t i = 0; i < obj->data.v_array.size; i++) {
       if (obj->data.v_array.elements[i])
         trace_mark_object(gray_objects, obj->data.v_array.elements[i]);
     }
     break;
   }
+  case MAP: {
+    // Both tables hold live entries while a resize is in progress
+    snek_map_table_t *tables[] = {&obj->data.v_map->table,
+                                  &obj->data.v_map->old};
+    for (size_t t = 0; t < 2; t++) {
+      for (size_t i = 0; i < tables[t]->capacity; i++) {
+        snek_map_entry_t *entry = &tables[t]->entries[i];
+        if (entry->key) {
+          trace_mark_object(gray_objects, entry->key);
+          trace_mark_object(gray_objects, entry->value);
+        }
+      }
+    }
+    break;
+  }
   }
 }
 
@@ -116,7 +209,10 @@ void trace_mark_object(stack_t *gray_objects, snek_object_t *obj) {
   obj->is_marked = true;
 }
 
+// Expects trace to have measured the live heap in `gc_stats`
 void sweep(vm_t *vm) {
+  TRACE_POINT(vm, TRACE_GC_BEGIN, TRACE_SWEEP, 0, NULL);
+  size_t freed_bytes = 0;
   int writeIndex = 0;
   for (size_t i = 0; i < vm->objects->count; i++) {
     snek_object_t *obj = vm->objects->data[i];
@@ -124,8 +220,20 @@ void sweep(vm_t *vm) {
       obj->is_marked = false;
       vm->objects->data[writeIndex++] = obj;
     } else {
+      freed_bytes += snek_object_size(obj);
       snek_object_free(obj);
     }
   }
+
+  // The heap is at its largest just before a collection
+  gc_stats_t *stats = &vm->gc_stats;
+  size_t live_bytes = stats->live_bytes;
+  note_heap(stats, vm->objects->count, live_bytes + freed_bytes);
+  stats->freed += vm->objects->count - writeIndex;
+  stats->freed_bytes += freed_bytes;
+  stats->live = writeIndex;
+  stats->live_bytes = live_bytes;
+  TRACE_POINT(vm, TRACE_GC_END, TRACE_SWEEP, vm->objects->count - writeIndex,
+              NULL);
   vm->objects->count = writeIndex;
 }
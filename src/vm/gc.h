@@ -1,8 +1,23 @@
 #pragma once
+#include <stdbool.h>
+#include <stdio.h>
+
 #include "../objects/snekobject.h"
 #include "../stack/stack.h"
+#include "vm.h"
 
 void vm_collect_garbage(vm_t *vm);
+// Collects if enough objects were allocated since the last collection. The
+// interpreter only calls this where every live object is on the value stack.
+void vm_safepoint(vm_t *vm);
+// The VM's heap counters, with the live and peak sizes brought up to date by
+// walking the heap
+gc_stats_t vm_gc_stats(vm_t *vm);
+// Writes `stats` as a JSON object. Returns false if `out` couldn't be
+// written.
+bool gc_stats_write_json(FILE *out, const gc_stats_t *stats);
+// Name of an object kind, as in the JSON stats
+const char *gc_kind_name(snek_object_kind_t kind);
 void mark(vm_t *vm);
 void trace(vm_t *vm);
 void sweep(vm_t *vm);
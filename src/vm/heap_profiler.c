@@ -0,0 +1,417 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../objects/snekobject.h"
+#include "bytecode.h"
+#include "heap_profiler.h"
+
+// Objects made at one line by one instruction. Numbers are estimates: each
+// sample adds the objects it stands for.
+typedef struct HeapSite {
+  function_t *function; // NULL for objects made outside a running script
+  char *name;           // Copy of the function's name
+  int line;
+  int op; // opcode_t, or -1 outside a script
+  double allocated;
+  double allocated_bytes;
+  double survived; // Objects that outlived at least one collection
+  double live;     // As of the last collection
+  double live_bytes;
+  double peak_bytes; // Largest `live_bytes` of any collection
+} heap_site_t;
+
+typedef struct {
+  snek_object_t *obj;
+  size_t site;
+  double scale; // Objects this sample stands for
+  bool survived;
+} heap_sample_t;
+
+// Maps an instruction to its site, so only the first allocation at each
+// instruction looks up its line and opcode
+typedef struct {
+  uint8_t *ip;
+  size_t site;
+} site_slot_t;
+
+struct HeapProfiler {
+  vm_t *vm;
+  bool running;
+  size_t interval;
+  size_t countdown; // Bytes left until the next sample, at least 1
+  size_t sample_count;
+  size_t collections;
+
+  heap_site_t *sites;
+  size_t site_count;
+  size_t site_capacity;
+  site_slot_t *slots; // Open addressing, SIZE_MAX marks a free slot
+  size_t slot_count;
+  size_t slot_capacity;
+
+  // Sampled objects not yet collected
+  heap_sample_t *samples;
+  size_t live_count;
+  size_t live_capacity;
+};
+
+#define INITIAL_SLOTS 64
+
+static size_t hash_ip(uint8_t *ip, size_t capacity) {
+  uintptr_t key = (uintptr_t)ip;
+  key ^= key >> 17;
+  key *= 0x9e3779b97f4a7c15u;
+  return (size_t)(key >> 7) & (capacity - 1);
+}
+
+static bool grow(void **items, size_t *capacity, size_t count, size_t size) {
+  if (count < *capacity) {
+    return true;
+  }
+
+  size_t new_capacity = *capacity == 0 ? 16 : *capacity * 2;
+  void *grown = realloc(*items, new_capacity * size);
+  if (grown == NULL) {
+    return false;
+  }
+  *items = grown;
+  *capacity = new_capacity;
+  return true;
+}
+
+static bool grow_slots(heap_profiler_t *profiler) {
+  size_t capacity = profiler->slot_capacity * 2;
+  site_slot_t *slots = malloc(capacity * sizeof(site_slot_t));
+  if (slots == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < capacity; i++) {
+    slots[i].site = SIZE_MAX;
+  }
+
+  for (size_t i = 0; i < profiler->slot_capacity; i++) {
+    site_slot_t *slot = &profiler->slots[i];
+    if (slot->site == SIZE_MAX) {
+      continue;
+    }
+    size_t at = hash_ip(slot->ip, capacity);
+    while (slots[at].site != SIZE_MAX) {
+      at = (at + 1) & (capacity - 1);
+    }
+    slots[at] = *slot;
+  }
+
+  free(profiler->slots);
+  profiler->slots = slots;
+  profiler->slot_capacity = capacity;
+  return true;
+}
+
+// The site of `ip` in `function`: the instruction running, or the call being
+// made, since ip is past both
+static size_t find_site(heap_profiler_t *profiler, function_t *function,
+                        uint8_t *ip) {
+  int line = 0;
+  int op = -1;
+  if (function != NULL) {
+    chunk_t *chunk = &function->chunk;
+    size_t offset = ip > chunk->code ? (size_t)(ip - chunk->code) - 1 : 0;
+    size_t start = 0;
+    while (start < chunk->count &&
+           start + instruction_size(chunk->code[start]) <= offset) {
+      start += instruction_size(chunk->code[start]);
+    }
+    if (start < chunk->count) {
+      line = chunk->lines[start];
+      op = chunk->code[start];
+    }
+  }
+
+  for (size_t i = 0; i < profiler->site_count; i++) {
+    heap_site_t *site = &profiler->sites[i];
+    if (site->function == function && site->line == line && site->op == op) {
+      return i;
+    }
+  }
+
+  if (!grow((void **)&profiler->sites, &profiler->site_capacity,
+            profiler->site_count, sizeof(heap_site_t))) {
+    return SIZE_MAX;
+  }
+  char *name = NULL;
+  if (function != NULL && (name = strdup(function->name)) == NULL) {
+    return SIZE_MAX;
+  }
+  profiler->sites[profiler->site_count] = (heap_site_t){
+      .function = function, .name = name, .line = line, .op = op};
+  return profiler->site_count++;
+}
+
+// The site allocating right now, from the innermost frame
+static size_t current_site(heap_profiler_t *profiler) {
+  vm_t *vm = profiler->vm;
+  function_t *function = NULL;
+  uint8_t *ip = NULL;
+  if (vm->frame_count > 0) {
+    frame_t *frame = &vm->frames[vm->frame_count - 1];
+    function = frame->function;
+    ip = frame->ip;
+    chunk_t *chunk = function != NULL ? &function->chunk : NULL;
+    if (chunk != NULL &&
+        (ip < chunk->code || ip > chunk->code + chunk->count)) {
+      ip = chunk->code;
+    }
+  }
+
+  size_t at = hash_ip(ip, profiler->slot_capacity);
+  while (profiler->slots[at].site != SIZE_MAX) {
+    if (profiler->slots[at].ip == ip) {
+      return profiler->slots[at].site;
+    }
+    at = (at + 1) & (profiler->slot_capacity - 1);
+  }
+
+  size_t site = find_site(profiler, function, ip);
+  if (site == SIZE_MAX) {
+    return SIZE_MAX;
+  }
+  profiler->slots[at] = (site_slot_t){.ip = ip, .site = site};
+  // Keep at most half the slots full
+  if (++profiler->slot_count * 2 > profiler->slot_capacity) {
+    grow_slots(profiler);
+  }
+  return site;
+}
+
+heap_profiler_t *heap_profiler_start(vm_t *vm, size_t interval) {
+  if (vm->heap_profiler != NULL || interval == 0) {
+    return NULL;
+  }
+
+  heap_profiler_t *profiler = calloc(1, sizeof(heap_profiler_t));
+  if (profiler == NULL) {
+    return NULL;
+  }
+  profiler->slots = malloc(INITIAL_SLOTS * sizeof(site_slot_t));
+  if (profiler->slots == NULL) {
+    free(profiler);
+    return NULL;
+  }
+  for (size_t i = 0; i < INITIAL_SLOTS; i++) {
+    profiler->slots[i].site = SIZE_MAX;
+  }
+  profiler->slot_capacity = INITIAL_SLOTS;
+
+  profiler->vm = vm;
+  profiler->interval = interval;
+  profiler->countdown = interval;
+  profiler->running = true;
+  vm->heap_profiler = profiler;
+  return profiler;
+}
+
+void heap_profiler_record(heap_profiler_t *profiler, snek_object_t *obj,
+                          size_t size) {
+  if (size < profiler->countdown) {
+    profiler->countdown -= size;
+    return;
+  }
+
+  // The object may cross several marks, and stands for all of them
+  size_t past = size - profiler->countdown;
+  size_t crossed = 1 + past / profiler->interval;
+  profiler->countdown = profiler->interval - past % profiler->interval;
+
+  size_t site = current_site(profiler);
+  if (site == SIZE_MAX ||
+      !grow((void **)&profiler->samples, &profiler->live_capacity,
+            profiler->live_count, sizeof(heap_sample_t))) {
+    return;
+  }
+
+  double scale = (double)crossed * profiler->interval / size;
+  profiler->samples[profiler->live_count++] =
+      (heap_sample_t){.obj = obj, .site = site, .scale = scale};
+  profiler->sites[site].allocated += scale;
+  profiler->sites[site].allocated_bytes += scale * size;
+  profiler->sample_count++;
+}
+
+void heap_profiler_collect(heap_profiler_t *profiler) {
+  for (size_t i = 0; i < profiler->site_count; i++) {
+    profiler->sites[i].live = 0;
+    profiler->sites[i].live_bytes = 0;
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < profiler->live_count; i++) {
+    heap_sample_t sample = profiler->samples[i];
+    if (!sample.obj->is_marked) {
+      continue;
+    }
+
+    heap_site_t *site = &profiler->sites[sample.site];
+    if (!sample.survived) {
+      sample.survived = true;
+      site->survived += sample.scale;
+    }
+    // Arrays and maps may have grown since they were sampled
+    site->live += sample.scale;
+    site->live_bytes += sample.scale * snek_object_size(sample.obj);
+    profiler->samples[kept++] = sample;
+  }
+  profiler->live_count = kept;
+
+  for (size_t i = 0; i < profiler->site_count; i++) {
+    heap_site_t *site = &profiler->sites[i];
+    if (site->live_bytes > site->peak_bytes) {
+      site->peak_bytes = site->live_bytes;
+    }
+  }
+  profiler->collections++;
+}
+
+void heap_profiler_stop(heap_profiler_t *profiler) {
+  if (!profiler->running) {
+    return;
+  }
+
+  free(profiler->samples);
+  profiler->samples = NULL;
+  profiler->live_count = 0;
+  profiler->live_capacity = 0;
+  profiler->vm->heap_profiler = NULL;
+  profiler->running = false;
+}
+
+static void write_site_name(FILE *out, heap_site_t *site) {
+  if (site->function == NULL) {
+    fputs("[outside a script]", out);
+  } else {
+    fprintf(out, "%s:%d %s", site->name, site->line,
+            opcode_name(site->op));
+  }
+}
+
+// Largest peak first, then largest allocated
+static int compare_peak(const void *a, const void *b) {
+  const heap_site_t *x = *(heap_site_t *const *)a;
+  const heap_site_t *y = *(heap_site_t *const *)b;
+  if (x->peak_bytes != y->peak_bytes) {
+    return x->peak_bytes < y->peak_bytes ? 1 : -1;
+  }
+  if (x->allocated_bytes != y->allocated_bytes) {
+    return x->allocated_bytes < y->allocated_bytes ? 1 : -1;
+  }
+  return 0;
+}
+
+// By function name, line and opcode, with objects outside a script first
+static int compare_site(const void *a, const void *b) {
+  const heap_site_t *x = *(heap_site_t *const *)a;
+  const heap_site_t *y = *(heap_site_t *const *)b;
+  if (x->name == NULL || y->name == NULL) {
+    return (x->name != NULL) - (y->name != NULL);
+  }
+  int order = strcmp(x->name, y->name);
+  if (order != 0) {
+    return order;
+  }
+  if (x->line != y->line) {
+    return x->line < y->line ? -1 : 1;
+  }
+  return x->op - y->op;
+}
+
+static heap_site_t **sorted_sites(heap_profiler_t *profiler,
+                                  int (*compare)(const void *,
+                                                 const void *)) {
+  heap_site_t **order = malloc((profiler->site_count + 1) * sizeof(*order));
+  if (order == NULL) {
+    return NULL;
+  }
+  for (size_t i = 0; i < profiler->site_count; i++) {
+    order[i] = &profiler->sites[i];
+  }
+  qsort(order, profiler->site_count, sizeof(*order), compare);
+  return order;
+}
+
+bool heap_profiler_write_report(heap_profiler_t *profiler, FILE *out) {
+  heap_site_t **order = sorted_sites(profiler, compare_peak);
+  if (order == NULL) {
+    return false;
+  }
+
+  fprintf(out,
+          "Heap profile: %zu samples, one per %zu bytes, %zu collections\n",
+          profiler->sample_count, profiler->interval, profiler->collections);
+  fprintf(out, "%12s %12s %10s %12s %10s %10s  %s\n", "peak bytes",
+          "live bytes", "live", "alloc bytes", "allocs", "survived", "site");
+  for (size_t i = 0; i < profiler->site_count; i++) {
+    heap_site_t *site = order[i];
+    fprintf(out, "%12.0f %12.0f %10.0f %12.0f %10.0f %10.0f  ",
+            site->peak_bytes, site->live_bytes, site->live,
+            site->allocated_bytes, site->allocated, site->survived);
+    write_site_name(out, site);
+    fputc('\n', out);
+  }
+
+  free(order);
+  return !ferror(out);
+}
+
+bool heap_profiler_write_json(heap_profiler_t *profiler, FILE *out) {
+  heap_site_t **order = sorted_sites(profiler, compare_site);
+  if (order == NULL) {
+    return false;
+  }
+
+  fprintf(out, "{\n  \"interval\": %zu,\n  \"samples\": %zu,\n",
+          profiler->interval, profiler->sample_count);
+  fprintf(out, "  \"collections\": %zu,\n  \"sites\": [\n",
+          profiler->collections);
+  for (size_t i = 0; i < profiler->site_count; i++) {
+    heap_site_t *site = order[i];
+    if (site->name == NULL) {
+      fprintf(out, "    {\"function\": null, \"line\": 0, \"op\": null, ");
+    } else {
+      fprintf(out, "    {\"function\": \"%s\", \"line\": %d, \"op\": \"%s\", ",
+              site->name, site->line, opcode_name(site->op));
+    }
+    fprintf(out,
+            "\"allocated_objects\": %.0f, \"allocated_bytes\": %.0f, "
+            "\"survived_objects\": %.0f, \"live_objects\": %.0f, "
+            "\"live_bytes\": %.0f, \"peak_live_bytes\": %.0f}%s\n",
+            site->allocated, site->allocated_bytes, site->survived, site->live,
+            site->live_bytes, site->peak_bytes,
+            i + 1 < profiler->site_count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+
+  free(order);
+  return !ferror(out);
+}
+
+size_t heap_profiler_samples(heap_profiler_t *profiler) {
+  return profiler->sample_count;
+}
+
+size_t heap_profiler_collections(heap_profiler_t *profiler) {
+  return profiler->collections;
+}
+
+void heap_profiler_free(heap_profiler_t *profiler) {
+  if (profiler == NULL) {
+    return;
+  }
+
+  heap_profiler_stop(profiler);
+  for (size_t i = 0; i < profiler->site_count; i++) {
+    free(profiler->sites[i].name);
+  }
+  free(profiler->sites);
+  free(profiler->slots);
+  free(profiler);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "vm.h"
+
+// Bytes allocated between samples
+#define HEAP_PROFILE_INTERVAL 4096
+
+// An allocation-site heap profiler for one VM. Each time another `interval`
+// bytes have been allocated, the object that crossed the mark is sampled,
+// along with the function, line and instruction that made it. A sample
+// stands for the bytes since the previous one, so per-site totals are
+// estimates that sharpen as more samples land. Sampling by byte count is
+// deterministic, so the same script gives the same profile on every run.
+//
+// Every collection checks the sampled objects against the mark bits before
+// sweeping, to find the ones that survived and the live bytes of each site.
+// Live numbers are as of the last collection.
+//
+// As with the sampling profiler, objects made by JIT code count against the
+// line where the interpreter entered it.
+typedef struct HeapProfiler heap_profiler_t;
+
+// Starts recording allocations of `vm`, sampling once per `interval` bytes
+// (1 records every object). Returns NULL if `vm` already has a heap profiler.
+heap_profiler_t *heap_profiler_start(vm_t *vm, size_t interval);
+
+// Stops recording. The profile can be written afterwards, even once the VM
+// and program are freed.
+void heap_profiler_stop(heap_profiler_t *profiler);
+
+// Called by vm_track_object for each new object of `size` bytes
+void heap_profiler_record(heap_profiler_t *profiler, snek_object_t *obj,
+                          size_t size);
+
+// Called by vm_collect_garbage between marking and sweeping, while the mark
+// bits tell which sampled objects survive
+void heap_profiler_collect(heap_profiler_t *profiler);
+
+// Writes one line per allocation site, largest peak first: the most bytes
+// the site had live at any collection, then the estimated bytes and objects
+// live, allocated, and surviving at least one collection. Returns false if
+// `out` couldn't be written.
+bool heap_profiler_write_report(heap_profiler_t *profiler, FILE *out);
+
+// Writes the same numbers as JSON, one site per line in site order, so two
+// runs can be compared with diff
+bool heap_profiler_write_json(heap_profiler_t *profiler, FILE *out);
+
+// Objects sampled, and collections seen
+size_t heap_profiler_samples(heap_profiler_t *profiler);
+size_t heap_profiler_collections(heap_profiler_t *profiler);
+
+// Stops the profiler if it's running
+void heap_profiler_free(heap_profiler_t *profiler);
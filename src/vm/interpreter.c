@@ -0,0 +1,348 @@
+#include <string.h>
+
+#include "../objects/sneknew.h"
+#include "gc.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "tracer.h"
+
+#define READ_BYTE() (*frame->ip++)
+#define READ_SHORT()                                                           \
+  (frame->ip += 2, (uint16_t)((frame->ip[-2] << 8) | frame->ip[-1]))
+#define SLOTS() ((snek_object_t **)vm->stack->data)
+#define PUSH(value) stack_push(vm->stack, (value))
+#define POP() ((snek_object_t *)stack_pop(vm->stack))
+#define PEEK(distance) (SLOTS()[vm->stack->count - 1 - (distance)])
+
+static vm_result_t runtime_error(vm_t *vm, size_t first_frame,
+                                 const char *message) {
+  frame_t *frame = &vm->frames[vm->frame_count - 1];
+  chunk_t *chunk = &frame->function->chunk;
+  // ip is past the failing instruction, or at the start of a function or
+  // loop header if a safepoint stopped the script
+  size_t offset = frame->ip > chunk->code ? frame->ip - chunk->code - 1 : 0;
+
+  fprintf(stderr, "Runtime Error: %s on line %d in %s\n", message,
+          chunk->lines[offset], frame->function->name);
+
+  // Drop every frame this run pushed
+#ifdef SNEK_TRACE
+  for (size_t i = vm->frame_count; i > first_frame; i--) {
+    TRACE_POINT(vm, TRACE_FRAME_POP, 0, i - 1, vm->frames[i - 1].function);
+  }
+#endif
+  vm->stack->count = vm->frames[first_frame].base;
+  vm->frame_count = first_frame;
+  return VM_RUNTIME_ERROR;
+}
+
+// Runs at loop back-edges and calls, where every live object is reachable
+// from the value stack. Returns false if the script should stop.
+static bool safepoint(vm_t *vm) {
+  if (vm->interrupted) {
+    vm->interrupted = 0;
+    return false;
+  }
+
+  vm_safepoint(vm);
+  return true;
+}
+
+// Starts executing `callee` with its `argc` arguments on top of the stack,
+// which become the first slots of the new frame. Returns NULL if the call
+// stack can't grow.
+static frame_t *push_call(vm_t *vm, function_t *callee, uint8_t argc) {
+  frame_t *frame = vm_new_frame(vm);
+  if (frame == NULL) {
+    return NULL;
+  }
+  frame->base -= argc;
+  frame->function = callee;
+  frame->ip = callee->chunk.code;
+
+  for (int i = argc; i < callee->local_count; i++) {
+    PUSH(NULL);
+  }
+  return frame;
+}
+
+// Continues `frame` in its function's native code, if it has any, until the
+// code reaches an instruction it leaves to the interpreter. Functions are
+// compiled once their loops have taken JIT_HOT_BACK_EDGES backward jumps.
+static void run_native(vm_t *vm, frame_t *frame, size_t globals,
+                       bool back_edge) {
+#ifdef SNEK_JIT
+  function_t *function = frame->function;
+  if (!vm->jit) {
+    return;
+  }
+
+  // A program may be running on several isolates at once. Exactly one of
+  // them sees the counter reach the threshold and compiles the function.
+  if (__atomic_load_n(&function->jit, __ATOMIC_ACQUIRE) == NULL) {
+    if (!back_edge ||
+        __atomic_add_fetch(&function->back_edges, 1, __ATOMIC_RELAXED) !=
+            JIT_HOT_BACK_EDGES ||
+        !jit_compile(function)) {
+      return;
+    }
+  }
+  frame->ip = jit_run(vm, frame, globals);
+#else
+  (void)vm;
+  (void)frame;
+  (void)globals;
+  (void)back_edge;
+#endif
+}
+
+void vm_print_values(vm_t *vm, uint8_t argc) {
+  for (uint8_t i = 0; i < argc; i++) {
+    if (i > 0) {
+      fputc(' ', vm->out);
+    }
+    snek_object_print(vm->out, PEEK(argc - 1 - i));
+  }
+  fputc('\n', vm->out);
+  vm->stack->count -= argc;
+  PUSH(NULL);
+}
+
+// Objects allocated here are unreachable until pushed, which is fine because
+// collections only happen at safepoints
+static snek_object_t *apply_binary(vm_t *vm, opcode_t op, snek_object_t *a,
+                                   snek_object_t *b, const char **error) {
+  int order;
+
+  switch (op) {
+  case OP_ADD:
+    return snek_add(vm, a, b);
+  case OP_SUBTRACT:
+    return snek_subtract(vm, a, b);
+  case OP_MULTIPLY:
+    return snek_multiply(vm, a, b);
+  case OP_DIVIDE:
+    if (b != NULL && b->kind == INTEGER && b->data.v_int == 0 && a != NULL &&
+        a->kind == INTEGER) {
+      *error = "Division by zero";
+      return NULL;
+    }
+    return snek_divide(vm, a, b);
+  case OP_EQUAL:
+    return new_snek_integer(vm, snek_equal(a, b));
+  case OP_NOT_EQUAL:
+    return new_snek_integer(vm, !snek_equal(a, b));
+  default:
+    break;
+  }
+
+  if (!snek_compare(a, b, &order)) {
+    *error = "Operands can't be compared";
+    return NULL;
+  }
+
+  bool result = op == OP_LESS         ? order < 0
+                : op == OP_LESS_EQUAL ? order <= 0
+                : op == OP_GREATER    ? order > 0
+                                      : order >= 0;
+  return new_snek_integer(vm, result);
+}
+
+const char *vm_apply(vm_t *vm, opcode_t op) {
+  const char *error = NULL;
+
+  if (op == OP_NEGATE || op == OP_NOT) {
+    snek_object_t *result = op == OP_NEGATE
+                                ? snek_negate(vm, PEEK(0))
+                                : new_snek_integer(vm, !snek_is_truthy(PEEK(0)));
+    if (result == NULL) {
+      return "Invalid operand";
+    }
+    PEEK(0) = result;
+    return NULL;
+  }
+
+  snek_object_t *result = apply_binary(vm, op, PEEK(1), PEEK(0), &error);
+  if (result == NULL) {
+    return error != NULL ? error : "Invalid operands";
+  }
+  POP();
+  PEEK(0) = result;
+  return NULL;
+}
+
+static vm_result_t execute(vm_t *vm, program_t *program, size_t first_frame,
+                           snek_object_t **results) {
+  function_t **functions = (function_t **)program->functions->data;
+  // Globals are the slots of the top-level frame
+  size_t globals = vm->frames[first_frame].base;
+  frame_t *frame = &vm->frames[vm->frame_count - 1];
+
+  for (;;) {
+    uint8_t op = READ_BYTE();
+    TRACE_DISPATCH_POINT(vm, op, frame->ip - 1 - frame->function->chunk.code,
+                         frame->function);
+
+    switch (op) {
+    case OP_CONSTANT:
+      PUSH(frame->function->chunk.constants->data[READ_SHORT()]);
+      break;
+    case OP_NIL:
+      PUSH(NULL);
+      break;
+    case OP_POP:
+      POP();
+      break;
+    case OP_DUP:
+      PUSH(PEEK(0));
+      break;
+    case OP_GET_LOCAL:
+      PUSH(SLOTS()[frame->base + READ_BYTE()]);
+      break;
+    case OP_SET_LOCAL: {
+      uint8_t slot = READ_BYTE();
+      SLOTS()[frame->base + slot] = POP();
+      break;
+    }
+    case OP_GET_GLOBAL:
+      PUSH(SLOTS()[globals + READ_SHORT()]);
+      break;
+    case OP_SET_GLOBAL: {
+      uint16_t slot = READ_SHORT();
+      SLOTS()[globals + slot] = POP();
+      break;
+    }
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_NEGATE:
+    case OP_NOT:
+    case OP_EQUAL:
+    case OP_NOT_EQUAL:
+    case OP_LESS:
+    case OP_LESS_EQUAL:
+    case OP_GREATER:
+    case OP_GREATER_EQUAL: {
+      const char *error = vm_apply(vm, op);
+      if (error != NULL) {
+        return runtime_error(vm, first_frame, error);
+      }
+      break;
+    }
+    case OP_JUMP: {
+      uint16_t offset = READ_SHORT();
+      frame->ip += offset;
+      break;
+    }
+    case OP_JUMP_IF_FALSE: {
+      uint16_t offset = READ_SHORT();
+      if (!snek_is_truthy(POP())) {
+        frame->ip += offset;
+      }
+      break;
+    }
+    case OP_JUMP_IF_FALSE_OR_POP:
+    case OP_JUMP_IF_TRUE_OR_POP: {
+      uint16_t offset = READ_SHORT();
+      if (snek_is_truthy(PEEK(0)) == (op == OP_JUMP_IF_TRUE_OR_POP)) {
+        frame->ip += offset;
+      } else {
+        POP();
+      }
+      break;
+    }
+    case OP_LOOP: {
+      uint16_t offset = READ_SHORT();
+      frame->ip -= offset;
+      if (!safepoint(vm)) {
+        return runtime_error(vm, first_frame, "Interrupted");
+      }
+      run_native(vm, frame, globals, true);
+      break;
+    }
+    case OP_CALL: {
+      function_t *callee = functions[READ_SHORT()];
+      uint8_t argc = READ_BYTE();
+
+      if (vm->frame_count - first_frame >= VM_MAX_FRAMES) {
+        return runtime_error(vm, first_frame, "Stack overflow");
+      }
+      if (!safepoint(vm)) {
+        return runtime_error(vm, first_frame, "Interrupted");
+      }
+
+      frame_t *called = push_call(vm, callee, argc);
+      if (called == NULL) {
+        return runtime_error(vm, first_frame, "Stack overflow");
+      }
+      frame = called;
+      run_native(vm, frame, globals, false);
+      break;
+    }
+    case OP_TAIL_CALL: {
+      function_t *callee = functions[READ_SHORT()];
+      uint8_t argc = READ_BYTE();
+
+      // Replace the caller's slots with the arguments and reuse its frame
+      size_t args = vm->stack->count - argc;
+      memmove(&SLOTS()[frame->base], &SLOTS()[args],
+              argc * sizeof(snek_object_t *));
+      vm->stack->count = frame->base + argc;
+      for (int i = argc; i < callee->local_count; i++) {
+        PUSH(NULL);
+      }
+      // Traced as a return and a call, though the frame stays
+      TRACE_POINT(vm, TRACE_FRAME_POP, 0, vm->frame_count - 1, frame->function);
+      TRACE_POINT(vm, TRACE_FRAME_PUSH, 0, vm->frame_count, NULL);
+      frame->function = callee;
+      frame->ip = callee->chunk.code;
+
+      if (!safepoint(vm)) {
+        return runtime_error(vm, first_frame, "Interrupted");
+      }
+      run_native(vm, frame, globals, false);
+      break;
+    }
+    case OP_RETURN: {
+      snek_object_t *result = POP();
+      if (results != NULL && vm->frame_count - 1 == first_frame) {
+        memcpy(results, &SLOTS()[globals],
+               program->global_names->count * sizeof(snek_object_t *));
+      }
+      vm_frame_pop(vm);
+      if (vm->frame_count == first_frame) {
+        return VM_OK;
+      }
+
+      frame = &vm->frames[vm->frame_count - 1];
+      PUSH(result);
+      break;
+    }
+    case OP_PRINT:
+      vm_print_values(vm, READ_BYTE());
+      break;
+    default:
+      return runtime_error(vm, first_frame, "Unknown opcode");
+    }
+  }
+}
+
+vm_result_t vm_run(vm_t *vm, program_t *program) {
+  return vm_run_with_globals(vm, program, NULL, 0, NULL);
+}
+
+vm_result_t vm_run_with_globals(vm_t *vm, program_t *program,
+                                snek_object_t **inputs, size_t input_count,
+                                snek_object_t **results) {
+  size_t first_frame = vm->frame_count;
+  frame_t *frame = push_call(vm, program->functions->data[0], 0);
+  if (frame == NULL) {
+    fprintf(stderr, "Runtime Error: Stack overflow\n");
+    return VM_RUNTIME_ERROR;
+  }
+  for (size_t i = 0; i < input_count; i++) {
+    SLOTS()[frame->base + i] = inputs[i];
+  }
+  return execute(vm, program, first_frame, results);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "bytecode.h"
+#include "vm.h"
+
+// Maximum call depth before a script is stopped with a stack overflow. Tail
+// calls reuse their frame and don't count towards it.
+#define VM_MAX_FRAMES (1 << 20)
+
+typedef enum {
+  VM_OK,
+  VM_RUNTIME_ERROR,
+} vm_result_t;
+
+// Runs `program` on top of any frames already on the VM. Runtime errors are
+// reported on stderr and unwind back to the frames the caller had.
+vm_result_t vm_run(vm_t *vm, program_t *program);
+
+// Like vm_run, but the first `input_count` globals start as `inputs` instead
+// of null. If the script finishes and `results` isn't NULL, it receives the
+// final value of every global. Those objects belong to the VM and are only
+// guaranteed to live until it runs again.
+vm_result_t vm_run_with_globals(vm_t *vm, program_t *program,
+                                snek_object_t **inputs, size_t input_count,
+                                snek_object_t **results);
+
+// Applies the arithmetic, comparison or logic `op` to the values on top of the
+// stack. Returns an error message, leaving the stack as it was, if the
+// operands don't support it.
+const char *vm_apply(vm_t *vm, opcode_t op);
+
+// Prints the top `argc` values on one line and replaces them with null
+void vm_print_values(vm_t *vm, uint8_t argc);
@@ -0,0 +1,612 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "jit.h"
+
+#ifndef SNEK_JIT
+
+bool jit_compile(function_t *function) {
+  (void)function;
+  return false;
+}
+
+void jit_free(jit_code_t *jit) { (void)jit; }
+
+uint8_t *jit_run(vm_t *vm, frame_t *frame, size_t globals) {
+  (void)vm;
+  (void)globals;
+  return frame->ip;
+}
+
+#else
+
+#include <stddef.h>
+#include <sys/mman.h>
+
+#include "../objects/snekobject.h"
+#include "gc.h"
+#include "interpreter.h"
+
+// Passed to every helper. The native code keeps it in rbx and the VM's stack
+// in r12, which the helpers (being ordinary C functions) preserve.
+typedef struct JitState {
+  vm_t *vm;
+  stack_t *stack; // vm->stack
+  size_t base;    // Stack index of the frame's first slot
+  size_t globals; // Stack index of the first global
+  snek_object_t **constants;
+} jit_state_t;
+
+// Native entry point: jumps to `target` and returns the bytecode offset the
+// interpreter resumes at
+typedef int32_t (*jit_entry_t)(jit_state_t *state, void *target);
+
+#define SLOTS(state) ((snek_object_t **)(state)->vm->stack->data)
+#define TOP(state) (SLOTS(state)[(state)->vm->stack->count - 1])
+
+/// Helpers
+// Every helper takes the state and one operand, so they are all called the
+// same way. They return 0 on success, except the truthiness tests.
+
+static int helper_constant(jit_state_t *state, uint32_t index) {
+  stack_push(state->vm->stack, state->constants[index]);
+  return 0;
+}
+
+static int helper_nil(jit_state_t *state, uint32_t unused) {
+  (void)unused;
+  stack_push(state->vm->stack, NULL);
+  return 0;
+}
+
+static int helper_pop(jit_state_t *state, uint32_t unused) {
+  (void)unused;
+  stack_pop(state->vm->stack);
+  return 0;
+}
+
+static int helper_dup(jit_state_t *state, uint32_t unused) {
+  (void)unused;
+  stack_push(state->vm->stack, TOP(state));
+  return 0;
+}
+
+// Loads and stores are inline; these push when the stack has to grow
+static int helper_get_local(jit_state_t *state, uint32_t slot) {
+  stack_push(state->vm->stack, SLOTS(state)[state->base + slot]);
+  return 0;
+}
+
+static int helper_get_global(jit_state_t *state, uint32_t slot) {
+  stack_push(state->vm->stack, SLOTS(state)[state->globals + slot]);
+  return 0;
+}
+
+// Failing leaves the stack alone, so the interpreter can run the instruction
+// again and report the error itself
+static int helper_apply(jit_state_t *state, uint32_t op) {
+  return vm_apply(state->vm, op) != NULL;
+}
+
+static int helper_print(jit_state_t *state, uint32_t argc) {
+  vm_print_values(state->vm, argc);
+  return 0;
+}
+
+static int helper_pop_truthy(jit_state_t *state, uint32_t unused) {
+  (void)unused;
+  return snek_is_truthy(stack_pop(state->vm->stack));
+}
+
+static int helper_peek_truthy(jit_state_t *state, uint32_t unused) {
+  (void)unused;
+  return snek_is_truthy(TOP(state));
+}
+
+// An interrupt is left for the interpreter's own safepoint to report
+static int helper_safepoint(jit_state_t *state, uint32_t unused) {
+  (void)unused;
+  if (state->vm->interrupted) {
+    return 1;
+  }
+
+  vm_safepoint(state->vm);
+  return 0;
+}
+
+/// Assembler
+
+typedef int (*helper_t)(jit_state_t *state, uint32_t operand);
+
+// A rel32 jump operand waiting for the native offset of its target
+typedef struct Fixup {
+  size_t at;     // Offset of the rel32 in the native code
+  size_t target; // Bytecode offset jumped to
+} fixup_t;
+
+typedef struct Assembler {
+  uint8_t *code;
+  size_t count;
+  size_t capacity;
+  fixup_t *fixups;
+  size_t fixup_count;
+  size_t fixup_capacity;
+  bool failed; // Out of memory
+} assembler_t;
+
+// The prologue saves rbx and r12 (keeping the stack 16-byte aligned for
+// calls), loads the state and the VM's stack into them and jumps to the entry
+// point. The epilogue follows it, so exits can jump back to a known offset.
+static const uint8_t PROLOGUE[] = {
+    0x53,                   // push rbx
+    0x41, 0x54,             // push r12
+    0x48, 0x83, 0xec, 0x08, // sub rsp, 8
+    0x48, 0x89, 0xfb,       // mov rbx, rdi
+    0x4c, 0x8b, 0x67,       // mov r12, [rdi + stack]
+    (uint8_t)offsetof(jit_state_t, stack),
+    0xff, 0xe6, // jmp rsi
+};
+#define EPILOGUE sizeof(PROLOGUE)
+static const uint8_t EPILOGUE_CODE[] = {
+    0x48, 0x83, 0xc4, 0x08, // add rsp, 8
+    0x41, 0x5c,             // pop r12
+    0x5b,                   // pop rbx
+    0xc3,                   // ret
+};
+
+static void emit_bytes(assembler_t *as, const uint8_t *bytes, size_t count) {
+  if (as->count + count > as->capacity) {
+    size_t capacity = as->capacity < 256 ? 256 : as->capacity * 2;
+    while (capacity < as->count + count) {
+      capacity *= 2;
+    }
+
+    uint8_t *code = realloc(as->code, capacity);
+    if (code == NULL) {
+      as->failed = true;
+      return;
+    }
+    as->code = code;
+    as->capacity = capacity;
+  }
+
+  memcpy(as->code + as->count, bytes, count);
+  as->count += count;
+}
+
+static void emit_byte(assembler_t *as, uint8_t byte) {
+  emit_bytes(as, &byte, 1);
+}
+
+// x86-64 is little endian, and so are the immediates
+static void emit_u32(assembler_t *as, uint32_t value) {
+  uint8_t bytes[4] = {value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff,
+                      (value >> 24) & 0xff};
+  emit_bytes(as, bytes, sizeof(bytes));
+}
+
+static void emit_u64(assembler_t *as, uint64_t value) {
+  emit_u32(as, (uint32_t)value);
+  emit_u32(as, (uint32_t)(value >> 32));
+}
+
+static void patch_u32(assembler_t *as, size_t at, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    as->code[at + i] = (value >> (8 * i)) & 0xff;
+  }
+}
+
+// Registers, numbered as in their encoding
+enum { RAX, RCX, RDX, RBX, RSP, RSI = 6, RDI = 7, R12 = 12 };
+#define NO_INDEX -1
+
+// `opcode reg, [base + index * 8 + disp]`, with a 64-bit operand if `wide`
+static void emit_memory(assembler_t *as, bool wide, uint8_t opcode, int reg,
+                        int base, int index, int32_t disp) {
+  uint8_t rex = 0x40 | (wide ? 0x08 : 0) | ((reg >> 3) << 2) |
+                (index >= 8 ? 0x02 : 0) | (base >> 3);
+  if (rex != 0x40) {
+    emit_byte(as, rex);
+  }
+  emit_byte(as, opcode);
+
+  // Always a 32-bit displacement; rsp and r12 as a base need a SIB byte
+  bool sib = index != NO_INDEX || (base & 7) == RSP;
+  emit_byte(as, 0x80 | ((reg & 7) << 3) | (sib ? RSP : (base & 7)));
+  if (sib) {
+    emit_byte(as, index != NO_INDEX ? 0xc0 | ((index & 7) << 3) | (base & 7)
+                                    : (RSP << 3) | (base & 7));
+  }
+  emit_u32(as, (uint32_t)disp);
+}
+
+#define MOV_LOAD 0x8b  // mov reg, [memory]
+#define MOV_STORE 0x89 // mov [memory], reg
+#define CMP_LOAD 0x3b  // cmp reg, [memory]
+
+// A jmp or jcc with a rel8 operand to a later offset, patched by
+// patch_short_jump once the code it skips has been emitted
+static size_t emit_short_jump(assembler_t *as, uint8_t opcode) {
+  emit_byte(as, opcode);
+  emit_byte(as, 0);
+  return as->count;
+}
+
+static void patch_short_jump(assembler_t *as, size_t end) {
+  size_t distance = as->count - end;
+  if (distance > INT8_MAX) {
+    as->failed = true;
+  } else if (!as->failed) {
+    as->code[end - 1] = (uint8_t)distance;
+  }
+}
+
+#define JMP8 0xeb
+#define JZ8 0x74
+#define JNZ8 0x75
+
+// helper(state, operand), leaving its result in eax
+static void emit_call(assembler_t *as, helper_t helper, uint32_t operand) {
+  static const uint8_t MOV_RDI_RBX[] = {0x48, 0x89, 0xdf};
+  static const uint8_t CALL_RAX[] = {0xff, 0xd0};
+
+  emit_bytes(as, MOV_RDI_RBX, sizeof(MOV_RDI_RBX));
+  emit_byte(as, 0xbe); // mov esi, imm32
+  emit_u32(as, operand);
+  emit_byte(as, 0x48); // movabs rax, imm64
+  emit_byte(as, 0xb8);
+  emit_u64(as, (uint64_t)(uintptr_t)helper);
+  emit_bytes(as, CALL_RAX, sizeof(CALL_RAX));
+}
+
+// Returns to the interpreter, which resumes at bytecode `offset`
+static void emit_exit(assembler_t *as, size_t offset) {
+  emit_byte(as, 0xb8); // mov eax, imm32
+  emit_u32(as, (uint32_t)offset);
+  emit_byte(as, 0xe9); // jmp rel32
+  emit_u32(as, (uint32_t)(EPILOGUE - (as->count + 4)));
+}
+
+static void emit_test_eax(assembler_t *as) {
+  static const uint8_t TEST_EAX_EAX[] = {0x85, 0xc0};
+  emit_bytes(as, TEST_EAX_EAX, sizeof(TEST_EAX_EAX));
+}
+
+// Exits at `offset` if the helper just called returned nonzero
+static void emit_exit_on_failure(assembler_t *as, size_t offset) {
+  emit_test_eax(as);
+  emit_byte(as, 0x74); // jz over the exit
+  emit_byte(as, 10);
+  emit_exit(as, offset);
+}
+
+// `opcode` is a jmp or jcc with a rel32 operand, patched once every
+// instruction has been placed
+static void emit_jump(assembler_t *as, const uint8_t *opcode, size_t length,
+                      size_t target) {
+  emit_bytes(as, opcode, length);
+  if (as->fixup_count == as->fixup_capacity) {
+    size_t capacity = as->fixup_capacity < 16 ? 16 : as->fixup_capacity * 2;
+    fixup_t *fixups = realloc(as->fixups, capacity * sizeof(fixup_t));
+    if (fixups == NULL) {
+      as->failed = true;
+      return;
+    }
+    as->fixups = fixups;
+    as->fixup_capacity = capacity;
+  }
+
+  as->fixups[as->fixup_count++] = (fixup_t){as->count, target};
+  emit_u32(as, 0);
+}
+
+static const uint8_t JMP[] = {0xe9};
+static const uint8_t JZ[] = {0x0f, 0x84};
+static const uint8_t JNZ[] = {0x0f, 0x85};
+
+static uint16_t read_short(chunk_t *chunk, size_t offset) {
+  return (uint16_t)((chunk->code[offset] << 8) | chunk->code[offset + 1]);
+}
+
+static const uint8_t ADD_RCX_1[] = {0x48, 0x83, 0xc1, 0x01};
+static const uint8_t SUB_RCX_1[] = {0x48, 0x83, 0xe9, 0x01};
+static const uint8_t SUB_RCX_2[] = {0x48, 0x83, 0xe9, 0x02};
+
+// Pushes slot `slot` past the state's `field` (base or globals) straight onto
+// the VM's stack. Only a full stack calls `helper`, which grows it.
+static void emit_get_slot(assembler_t *as, size_t field, uint32_t slot,
+                          helper_t helper) {
+  emit_memory(as, true, MOV_LOAD, RCX, R12, NO_INDEX,
+              offsetof(stack_t, count));
+  emit_memory(as, true, CMP_LOAD, RCX, R12, NO_INDEX,
+              offsetof(stack_t, capacity));
+  size_t fits = emit_short_jump(as, JNZ8);
+  emit_call(as, helper, slot);
+  size_t done = emit_short_jump(as, JMP8);
+
+  patch_short_jump(as, fits);
+  emit_memory(as, true, MOV_LOAD, RAX, R12, NO_INDEX, offsetof(stack_t, data));
+  emit_memory(as, true, MOV_LOAD, RDX, RBX, NO_INDEX, (int32_t)field);
+  emit_memory(as, true, MOV_LOAD, RDX, RAX, RDX, (int32_t)slot * 8);
+  emit_memory(as, true, MOV_STORE, RDX, RAX, RCX, 0);
+  emit_bytes(as, ADD_RCX_1, sizeof(ADD_RCX_1));
+  emit_memory(as, true, MOV_STORE, RCX, R12, NO_INDEX,
+              offsetof(stack_t, count));
+  patch_short_jump(as, done);
+}
+
+// Pops the top of the VM's stack into slot `slot` past the state's `field`
+static void emit_set_slot(assembler_t *as, size_t field, uint32_t slot) {
+  emit_memory(as, true, MOV_LOAD, RAX, R12, NO_INDEX, offsetof(stack_t, data));
+  emit_memory(as, true, MOV_LOAD, RCX, R12, NO_INDEX,
+              offsetof(stack_t, count));
+  emit_bytes(as, SUB_RCX_1, sizeof(SUB_RCX_1));
+  emit_memory(as, true, MOV_STORE, RCX, R12, NO_INDEX,
+              offsetof(stack_t, count));
+  emit_memory(as, true, MOV_LOAD, RDX, RAX, RCX, 0);
+  emit_memory(as, true, MOV_LOAD, RCX, RBX, NO_INDEX, (int32_t)field);
+  emit_memory(as, true, MOV_STORE, RDX, RAX, RCX, (int32_t)slot * 8);
+}
+
+// The jcc (rel32) taken when comparison `op` of two ints is false
+static const uint8_t *jump_unless(opcode_t op) {
+  static const uint8_t JGE[] = {0x0f, 0x8d};
+  static const uint8_t JG[] = {0x0f, 0x8f};
+  static const uint8_t JLE[] = {0x0f, 0x8e};
+  static const uint8_t JL[] = {0x0f, 0x8c};
+  static const uint8_t JNE[] = {0x0f, 0x85};
+  static const uint8_t JE[] = {0x0f, 0x84};
+
+  switch (op) {
+  case OP_LESS:
+    return JGE;
+  case OP_LESS_EQUAL:
+    return JG;
+  case OP_GREATER:
+    return JLE;
+  case OP_GREATER_EQUAL:
+    return JL;
+  case OP_EQUAL:
+    return JNE;
+  default:
+    return JE;
+  }
+}
+
+// A comparison followed by JUMP_IF_FALSE at `branch`. When both operands are
+// ints they are compared and popped inline, and the code branches straight to
+// where the jump would go, without making a bool. Anything else takes the
+// helper and falls through to the jump's own code, which follows.
+static void emit_compare_and_branch(assembler_t *as, chunk_t *chunk,
+                                    size_t offset, size_t branch) {
+  static const uint8_t TEST_RSI_RSI[] = {0x48, 0x85, 0xf6};
+  static const uint8_t TEST_RDI_RDI[] = {0x48, 0x85, 0xff};
+  opcode_t op = chunk->code[offset];
+  size_t after = branch + instruction_size(OP_JUMP_IF_FALSE);
+  size_t slow[4];
+
+  emit_memory(as, true, MOV_LOAD, RAX, R12, NO_INDEX, offsetof(stack_t, data));
+  emit_memory(as, true, MOV_LOAD, RCX, R12, NO_INDEX,
+              offsetof(stack_t, count));
+  emit_memory(as, true, MOV_LOAD, RSI, RAX, RCX, -16);
+  emit_memory(as, true, MOV_LOAD, RDI, RAX, RCX, -8);
+  emit_bytes(as, TEST_RSI_RSI, sizeof(TEST_RSI_RSI));
+  slow[0] = emit_short_jump(as, JZ8);
+  emit_bytes(as, TEST_RDI_RDI, sizeof(TEST_RDI_RDI));
+  slow[1] = emit_short_jump(as, JZ8);
+  for (int i = 0; i < 2; i++) {
+    emit_memory(as, false, 0x81, 7, i == 0 ? RSI : RDI, NO_INDEX,
+                offsetof(snek_object_t, kind)); // cmp dword [...], imm32
+    emit_u32(as, INTEGER);
+    slow[2 + i] = emit_short_jump(as, JNZ8);
+  }
+
+  emit_bytes(as, SUB_RCX_2, sizeof(SUB_RCX_2));
+  emit_memory(as, true, MOV_STORE, RCX, R12, NO_INDEX,
+              offsetof(stack_t, count));
+  emit_memory(as, false, MOV_LOAD, RDX, RSI, NO_INDEX,
+              offsetof(snek_object_t, data.v_int));
+  emit_memory(as, false, CMP_LOAD, RDX, RDI, NO_INDEX,
+              offsetof(snek_object_t, data.v_int));
+  emit_jump(as, jump_unless(op), 2, after + read_short(chunk, branch + 1));
+  emit_jump(as, JMP, sizeof(JMP), after);
+
+  for (int i = 0; i < 4; i++) {
+    patch_short_jump(as, slow[i]);
+  }
+  emit_call(as, helper_apply, op);
+  emit_exit_on_failure(as, offset);
+}
+
+static void emit_instruction(assembler_t *as, chunk_t *chunk, size_t offset) {
+  opcode_t op = chunk->code[offset];
+  // Jump offsets are relative to the next instruction
+  size_t next = offset + instruction_size(op);
+
+  switch (op) {
+  case OP_CONSTANT:
+    emit_call(as, helper_constant, read_short(chunk, offset + 1));
+    break;
+  case OP_NIL:
+    emit_call(as, helper_nil, 0);
+    break;
+  case OP_POP:
+    emit_call(as, helper_pop, 0);
+    break;
+  case OP_DUP:
+    emit_call(as, helper_dup, 0);
+    break;
+  case OP_GET_LOCAL:
+    emit_get_slot(as, offsetof(jit_state_t, base), chunk->code[offset + 1],
+                  helper_get_local);
+    break;
+  case OP_SET_LOCAL:
+    emit_set_slot(as, offsetof(jit_state_t, base), chunk->code[offset + 1]);
+    break;
+  case OP_GET_GLOBAL:
+    emit_get_slot(as, offsetof(jit_state_t, globals),
+                  read_short(chunk, offset + 1), helper_get_global);
+    break;
+  case OP_SET_GLOBAL:
+    emit_set_slot(as, offsetof(jit_state_t, globals),
+                  read_short(chunk, offset + 1));
+    break;
+  case OP_EQUAL:
+  case OP_NOT_EQUAL:
+  case OP_LESS:
+  case OP_LESS_EQUAL:
+  case OP_GREATER:
+  case OP_GREATER_EQUAL:
+    if (next < chunk->count && chunk->code[next] == OP_JUMP_IF_FALSE) {
+      emit_compare_and_branch(as, chunk, offset, next);
+      break;
+    }
+    emit_call(as, helper_apply, op);
+    emit_exit_on_failure(as, offset);
+    break;
+  case OP_ADD:
+  case OP_SUBTRACT:
+  case OP_MULTIPLY:
+  case OP_DIVIDE:
+  case OP_NEGATE:
+  case OP_NOT:
+    emit_call(as, helper_apply, op);
+    emit_exit_on_failure(as, offset);
+    break;
+  case OP_JUMP:
+    emit_jump(as, JMP, sizeof(JMP), next + read_short(chunk, offset + 1));
+    break;
+  case OP_JUMP_IF_FALSE:
+    emit_call(as, helper_pop_truthy, 0);
+    emit_test_eax(as);
+    emit_jump(as, JZ, sizeof(JZ), next + read_short(chunk, offset + 1));
+    break;
+  case OP_JUMP_IF_FALSE_OR_POP:
+  case OP_JUMP_IF_TRUE_OR_POP:
+    emit_call(as, helper_peek_truthy, 0);
+    emit_test_eax(as);
+    if (op == OP_JUMP_IF_TRUE_OR_POP) {
+      emit_jump(as, JNZ, sizeof(JNZ), next + read_short(chunk, offset + 1));
+    } else {
+      emit_jump(as, JZ, sizeof(JZ), next + read_short(chunk, offset + 1));
+    }
+    emit_call(as, helper_pop, 0);
+    break;
+  case OP_LOOP:
+    emit_call(as, helper_safepoint, 0);
+    emit_exit_on_failure(as, offset);
+    emit_jump(as, JMP, sizeof(JMP), next - read_short(chunk, offset + 1));
+    break;
+  case OP_PRINT:
+    emit_call(as, helper_print, chunk->code[offset + 1]);
+    break;
+  default:
+    // Calls and returns change frames, which only the interpreter does
+    emit_exit(as, offset);
+    break;
+  }
+}
+
+static bool patch_fixups(assembler_t *as, uint32_t *entries, size_t count) {
+  for (size_t i = 0; i < as->fixup_count; i++) {
+    fixup_t *fixup = &as->fixups[i];
+    if (fixup->target >= count || entries[fixup->target] == UINT32_MAX) {
+      return false;
+    }
+    patch_u32(as, fixup->at,
+              (uint32_t)(entries[fixup->target] - (fixup->at + 4)));
+  }
+  return true;
+}
+
+// Copies the code into its own mapping, which is never writable and
+// executable at the same time
+static uint8_t *map_code(assembler_t *as) {
+  uint8_t *code = mmap(NULL, as->count, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED) {
+    return NULL;
+  }
+
+  memcpy(code, as->code, as->count);
+  if (mprotect(code, as->count, PROT_READ | PROT_EXEC) != 0) {
+    munmap(code, as->count);
+    return NULL;
+  }
+  return code;
+}
+
+bool jit_compile(function_t *function) {
+  chunk_t *chunk = &function->chunk;
+  jit_code_t *jit = malloc(sizeof(jit_code_t));
+  uint32_t *entries = malloc(chunk->count * sizeof(uint32_t));
+  if (jit == NULL || entries == NULL) {
+    free(jit);
+    free(entries);
+    return false;
+  }
+
+  for (size_t i = 0; i < chunk->count; i++) {
+    entries[i] = UINT32_MAX;
+  }
+
+  assembler_t as = {0};
+  emit_bytes(&as, PROLOGUE, sizeof(PROLOGUE));
+  emit_bytes(&as, EPILOGUE_CODE, sizeof(EPILOGUE_CODE));
+
+  for (size_t offset = 0; offset < chunk->count;
+       offset += instruction_size(chunk->code[offset])) {
+    entries[offset] = (uint32_t)as.count;
+    emit_instruction(&as, chunk, offset);
+  }
+
+  uint8_t *code = NULL;
+  if (!as.failed && patch_fixups(&as, entries, chunk->count)) {
+    code = map_code(&as);
+  }
+  free(as.code);
+  free(as.fixups);
+
+  if (code == NULL) {
+    free(jit);
+    free(entries);
+    return false;
+  }
+
+  jit->code = code;
+  jit->size = as.count;
+  jit->entries = entries;
+  // Isolates running the same program on other threads may pick the code up
+  // as soon as it is stored
+  __atomic_store_n(&function->jit, jit, __ATOMIC_RELEASE);
+  return true;
+}
+
+void jit_free(jit_code_t *jit) {
+  if (jit == NULL) {
+    return;
+  }
+
+  munmap(jit->code, jit->size);
+  free(jit->entries);
+  free(jit);
+}
+
+uint8_t *jit_run(vm_t *vm, frame_t *frame, size_t globals) {
+  function_t *function = frame->function;
+  jit_code_t *jit = __atomic_load_n(&function->jit, __ATOMIC_ACQUIRE);
+  size_t offset = frame->ip - function->chunk.code;
+
+  jit_state_t state = {
+      .vm = vm,
+      .stack = vm->stack,
+      .base = frame->base,
+      .globals = globals,
+      .constants = (snek_object_t **)function->chunk.constants->data,
+  };
+  jit_entry_t entry = (jit_entry_t)(void *)jit->code;
+  int32_t resume = entry(&state, jit->code + jit->entries[offset]);
+  return function->chunk.code + resume;
+}
+
+#endif
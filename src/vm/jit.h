@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bytecode.h"
+#include "vm.h"
+
+// The baseline JIT is only built with `make JIT=1`, which defines SNEK_JIT.
+// Without it jit_compile always fails and scripts stay interpreted.
+#if defined(SNEK_JIT) && !defined(__x86_64__)
+#error "The JIT only generates x86-64 code"
+#endif
+
+// Backward jumps a function takes before it is compiled to native code
+#define JIT_HOT_BACK_EDGES 1000
+
+// Native code for one function. Loads and stores of locals and globals, jumps,
+// and int comparisons that feed a branch are inline; other instructions call
+// the same helper the interpreter uses, so the native code behaves exactly
+// like the bytecode without the dispatch loop. Calls, returns and failed
+// operations exit back to the interpreter at the instruction that needs it.
+typedef struct JitCode {
+  uint8_t *code;     // Executable mapping
+  size_t size;       // Bytes mapped at `code`
+  uint32_t *entries; // Native offset of each bytecode offset, or UINT32_MAX
+} jit_code_t;
+
+// Compiles `function` and stores the result in `function->jit`. Returns false
+// if this build has no JIT or the code couldn't be mapped.
+bool jit_compile(function_t *function);
+void jit_free(jit_code_t *jit);
+
+// Runs the native code of the function in `frame` from `frame->ip`, which
+// must be the start of an instruction. Returns the instruction the
+// interpreter should continue with.
+uint8_t *jit_run(vm_t *vm, frame_t *frame, size_t globals);
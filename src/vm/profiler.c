@@ -0,0 +1,223 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../core/interrupt.h"
+#include "bytecode.h"
+#include "profiler.h"
+
+// One function at one line, called from the path of nodes above it. The
+// root has no function, and a node without a function below the root stands
+// for the outer frames a deep sample left out.
+typedef struct ProfileNode {
+  function_t *function;
+  int line;
+  size_t samples; // Samples taken with this as the innermost frame
+  struct ProfileNode *children;
+  struct ProfileNode *next; // Next child of the same parent
+} profile_node_t;
+
+struct Profiler {
+  vm_t *vm;
+  pthread_t thread; // The thread running `vm`
+  bool running;
+  // Written by the signal handler, one record per sample: a header holding
+  // the depth and whether frames were left out, then the function and
+  // instruction pointer of each frame, outermost first. `head` and `tail`
+  // only grow; words are indexed modulo the buffer size.
+  uintptr_t buffer[PROFILE_BUFFER_WORDS];
+  volatile size_t head;
+  volatile size_t tail;
+  volatile size_t dropped;
+  size_t samples;
+  profile_node_t root;
+};
+
+// The profiler SIGPROF samples for. The timer is per process, so there is
+// at most one.
+static profiler_t *volatile active = NULL;
+
+// Runs in the signal handler, which may have interrupted the VM anywhere.
+// vm_new_frame fills a frame in before counting it, and frees an old call
+// stack only after switching to the new one, so the frames read here exist.
+static void take_sample(void) {
+  profiler_t *profiler = active;
+  if (profiler == NULL || !pthread_equal(pthread_self(), profiler->thread)) {
+    return;
+  }
+
+  vm_t *vm = profiler->vm;
+  size_t count = vm->frame_count;
+  frame_t *frames = vm->frames;
+  size_t first = count > PROFILE_MAX_DEPTH ? count - PROFILE_MAX_DEPTH : 0;
+  size_t head = profiler->head;
+  if (head - profiler->tail + 1 + 2 * (count - first) > PROFILE_BUFFER_WORDS) {
+    profiler->dropped++;
+    return;
+  }
+
+  uintptr_t *buffer = profiler->buffer;
+  buffer[head++ % PROFILE_BUFFER_WORDS] = (count - first) << 1 | (first > 0);
+  for (size_t i = first; i < count; i++) {
+    buffer[head++ % PROFILE_BUFFER_WORDS] = (uintptr_t)frames[i].function;
+    buffer[head++ % PROFILE_BUFFER_WORDS] = (uintptr_t)frames[i].ip;
+  }
+  __atomic_signal_fence(__ATOMIC_RELEASE);
+  profiler->head = head;
+  vm->samples_pending = 1;
+}
+
+static profile_node_t *find_child(profile_node_t *parent,
+                                  function_t *function, int line) {
+  for (profile_node_t *child = parent->children; child != NULL;
+       child = child->next) {
+    if (child->function == function && child->line == line) {
+      return child;
+    }
+  }
+
+  profile_node_t *child = calloc(1, sizeof(profile_node_t));
+  if (child == NULL) {
+    return parent;
+  }
+  child->function = function;
+  child->line = line;
+  child->next = parent->children;
+  parent->children = child;
+  return child;
+}
+
+static void free_children(profile_node_t *node) {
+  profile_node_t *child = node->children;
+  while (child != NULL) {
+    profile_node_t *next = child->next;
+    free_children(child);
+    free(child);
+    child = next;
+  }
+}
+
+profiler_t *profiler_start(vm_t *vm, long interval_us) {
+  profiler_t *profiler = calloc(1, sizeof(profiler_t));
+  if (profiler == NULL) {
+    return NULL;
+  }
+  profiler->vm = vm;
+  profiler->thread = pthread_self();
+
+  profiler_t *expected = NULL;
+  if (!__atomic_compare_exchange_n(&active, &expected, profiler, false,
+                                   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+    free(profiler);
+    return NULL;
+  }
+
+  vm->profiler = profiler;
+  if (!interrupt_every(interval_us, take_sample)) {
+    vm->profiler = NULL;
+    active = NULL;
+    free(profiler);
+    return NULL;
+  }
+  profiler->running = true;
+  return profiler;
+}
+
+void profiler_stop(profiler_t *profiler) {
+  if (!profiler->running) {
+    return;
+  }
+
+  interrupt_every(0, NULL);
+  active = NULL;
+  profiler->vm->profiler = NULL;
+  profiler->vm->samples_pending = 0;
+  profiler->running = false;
+  profiler_drain(profiler);
+}
+
+void profiler_drain(profiler_t *profiler) {
+  size_t head = profiler->head;
+  __atomic_signal_fence(__ATOMIC_ACQUIRE);
+  size_t tail = profiler->tail;
+  uintptr_t *buffer = profiler->buffer;
+
+  while (tail != head) {
+    uintptr_t header = buffer[tail++ % PROFILE_BUFFER_WORDS];
+    profile_node_t *node = &profiler->root;
+    if (header & 1) {
+      node = find_child(node, NULL, 0);
+    }
+
+    for (size_t depth = header >> 1; depth > 0; depth--) {
+      function_t *function =
+          (function_t *)buffer[tail++ % PROFILE_BUFFER_WORDS];
+      uint8_t *ip = (uint8_t *)buffer[tail++ % PROFILE_BUFFER_WORDS];
+      // A frame caught while a call sets it up has no function yet, or
+      // still has the instruction of the function a tail call replaced
+      if (function == NULL || ip < function->chunk.code ||
+          ip > function->chunk.code + function->chunk.count) {
+        continue;
+      }
+
+      // ip is past the instruction running (or the call being made)
+      chunk_t *chunk = &function->chunk;
+      size_t offset = ip > chunk->code ? (size_t)(ip - chunk->code) - 1 : 0;
+      node = find_child(node, function, chunk->lines[offset]);
+    }
+
+    if (node != &profiler->root) {
+      node->samples++;
+      profiler->samples++;
+    }
+  }
+
+  __atomic_signal_fence(__ATOMIC_RELEASE);
+  profiler->tail = tail;
+}
+
+static void write_node(FILE *out, profile_node_t *node, profile_node_t **path,
+                       size_t depth) {
+  path[depth++] = node;
+  if (node->samples > 0) {
+    for (size_t i = 0; i < depth; i++) {
+      if (i > 0) {
+        fputc(';', out);
+      }
+      if (path[i]->function == NULL) {
+        fputs("[truncated]", out);
+      } else {
+        fprintf(out, "%s:%d", path[i]->function->name, path[i]->line);
+      }
+    }
+    fprintf(out, " %zu\n", node->samples);
+  }
+
+  for (profile_node_t *child = node->children; child != NULL;
+       child = child->next) {
+    write_node(out, child, path, depth);
+  }
+}
+
+bool profiler_write_folded(profiler_t *profiler, FILE *out) {
+  profile_node_t *path[PROFILE_MAX_DEPTH + 1];
+  for (profile_node_t *child = profiler->root.children; child != NULL;
+       child = child->next) {
+    write_node(out, child, path, 0);
+  }
+  return !ferror(out);
+}
+
+size_t profiler_samples(profiler_t *profiler) { return profiler->samples; }
+
+size_t profiler_dropped(profiler_t *profiler) { return profiler->dropped; }
+
+void profiler_free(profiler_t *profiler) {
+  if (profiler == NULL) {
+    return;
+  }
+
+  profiler_stop(profiler);
+  free_children(&profiler->root);
+  free(profiler);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "vm.h"
+
+// CPU time between samples
+#define PROFILE_INTERVAL_US 1000
+// Frames kept per sample, counted from the innermost
+#define PROFILE_MAX_DEPTH 128
+// Words of the buffer the signal handler writes samples into
+#define PROFILE_BUFFER_WORDS (1 << 16)
+
+// A sampling profiler for one VM. A SIGPROF timer interrupts the thread that
+// started it and records the function and instruction of every frame on the
+// call stack, without allocating or reading anything the frames point to.
+// The VM folds the samples into a call tree at its safepoints, keyed by
+// function and source line.
+//
+// Native code from the JIT doesn't update its frame's instruction, so its
+// samples land on the line where the interpreter entered it.
+typedef struct Profiler profiler_t;
+
+// Starts sampling `vm` on the calling thread. Returns NULL if a profiler is
+// already running (the timer is per process) or the timer can't be set.
+profiler_t *profiler_start(vm_t *vm, long interval_us);
+
+// Stops the timer and folds the remaining samples. The functions the VM ran
+// must still be alive.
+void profiler_stop(profiler_t *profiler);
+
+// Folds the samples taken since the last call into the call tree. Called
+// from vm_safepoint when the signal handler has set `samples_pending`.
+void profiler_drain(profiler_t *profiler);
+
+// Writes one line per distinct stack, outermost frame first, in the folded
+// format flame graph tools read: `<script>:12;fib:3;fib:4 17`. Returns false
+// if `out` couldn't be written.
+bool profiler_write_folded(profiler_t *profiler, FILE *out);
+
+// Samples recorded, and samples lost because the buffer was full
+size_t profiler_samples(profiler_t *profiler);
+size_t profiler_dropped(profiler_t *profiler);
+
+// Stops the profiler if it's running
+void profiler_free(profiler_t *profiler);
@@ -0,0 +1,137 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "scheduler.h"
+#include "vm.h"
+
+struct Scheduler {
+  pthread_t *workers;
+  size_t worker_count;
+  pthread_mutex_t lock;
+  pthread_cond_t work_ready; // Signalled when isolates are queued or stopping
+  pthread_cond_t all_done;   // Signalled when `pending` drops to zero
+  isolate_t *head;           // Next isolate to run
+  isolate_t *tail;
+  size_t pending; // Queued or running isolates
+  bool stopping;
+};
+
+void isolate_init(isolate_t *isolate, program_t *program, FILE *out) {
+  isolate->program = program;
+  isolate->out = out;
+  isolate->result = VM_OK;
+  isolate->next = NULL;
+}
+
+static void run_isolate(isolate_t *isolate) {
+  vm_t *vm = vm_new();
+  vm->out = isolate->out;
+  isolate->result = vm_run(vm, isolate->program);
+  vm_free(vm);
+}
+
+static void *worker_main(void *arg) {
+  scheduler_t *scheduler = arg;
+
+  pthread_mutex_lock(&scheduler->lock);
+  for (;;) {
+    while (scheduler->head == NULL && !scheduler->stopping) {
+      pthread_cond_wait(&scheduler->work_ready, &scheduler->lock);
+    }
+    if (scheduler->head == NULL) {
+      break;
+    }
+
+    isolate_t *isolate = scheduler->head;
+    scheduler->head = isolate->next;
+    if (scheduler->head == NULL) {
+      scheduler->tail = NULL;
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+
+    run_isolate(isolate);
+
+    pthread_mutex_lock(&scheduler->lock);
+    if (--scheduler->pending == 0) {
+      pthread_cond_broadcast(&scheduler->all_done);
+    }
+  }
+  pthread_mutex_unlock(&scheduler->lock);
+  return NULL;
+}
+
+scheduler_t *scheduler_new(size_t worker_count) {
+  scheduler_t *scheduler = calloc(1, sizeof(scheduler_t));
+  if (scheduler == NULL) {
+    return NULL;
+  }
+
+  scheduler->workers = malloc(worker_count * sizeof(pthread_t));
+  if (scheduler->workers == NULL) {
+    free(scheduler);
+    return NULL;
+  }
+  pthread_mutex_init(&scheduler->lock, NULL);
+  pthread_cond_init(&scheduler->work_ready, NULL);
+  pthread_cond_init(&scheduler->all_done, NULL);
+
+  for (size_t i = 0; i < worker_count; i++) {
+    if (pthread_create(&scheduler->workers[i], NULL, worker_main, scheduler) !=
+        0) {
+      break;
+    }
+    scheduler->worker_count++;
+  }
+
+  if (scheduler->worker_count == 0) {
+    scheduler_free(scheduler);
+    return NULL;
+  }
+  return scheduler;
+}
+
+void scheduler_free(scheduler_t *scheduler) {
+  if (scheduler == NULL) {
+    return;
+  }
+
+  scheduler_wait(scheduler);
+  pthread_mutex_lock(&scheduler->lock);
+  scheduler->stopping = true;
+  pthread_cond_broadcast(&scheduler->work_ready);
+  pthread_mutex_unlock(&scheduler->lock);
+
+  for (size_t i = 0; i < scheduler->worker_count; i++) {
+    pthread_join(scheduler->workers[i], NULL);
+  }
+
+  pthread_mutex_destroy(&scheduler->lock);
+  pthread_cond_destroy(&scheduler->work_ready);
+  pthread_cond_destroy(&scheduler->all_done);
+  free(scheduler->workers);
+  free(scheduler);
+}
+
+void scheduler_submit(scheduler_t *scheduler, isolate_t *isolate) {
+  isolate->next = NULL;
+
+  pthread_mutex_lock(&scheduler->lock);
+  if (scheduler->tail != NULL) {
+    scheduler->tail->next = isolate;
+  } else {
+    scheduler->head = isolate;
+  }
+  scheduler->tail = isolate;
+  scheduler->pending++;
+  pthread_cond_signal(&scheduler->work_ready);
+  pthread_mutex_unlock(&scheduler->lock);
+}
+
+void scheduler_wait(scheduler_t *scheduler) {
+  pthread_mutex_lock(&scheduler->lock);
+  while (scheduler->pending > 0) {
+    pthread_cond_wait(&scheduler->all_done, &scheduler->lock);
+  }
+  pthread_mutex_unlock(&scheduler->lock);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "bytecode.h"
+#include "interpreter.h"
+
+// An isolate is one run of a program on a VM of its own, with its own heap
+// and collector. Isolates share nothing mutable, so any number of them can
+// run at once, including several running the same program: programs are
+// only read while they run (apart from the JIT's counters and code, which
+// are updated atomically).
+typedef struct Isolate {
+  program_t *program;   // Must outlive the run
+  FILE *out;            // Where `print` writes
+  vm_result_t result;   // Set once the isolate has finished
+  struct Isolate *next; // Run queue link, owned by the scheduler
+} isolate_t;
+
+void isolate_init(isolate_t *isolate, program_t *program, FILE *out);
+
+// Runs isolates on a fixed pool of worker threads. Each worker takes the
+// next queued isolate and runs it to completion on a fresh VM.
+typedef struct Scheduler scheduler_t;
+
+scheduler_t *scheduler_new(size_t worker_count);
+// Waits for every queued isolate, then stops the workers
+void scheduler_free(scheduler_t *scheduler);
+
+// Queues `isolate`, which must stay valid until scheduler_wait returns
+void scheduler_submit(scheduler_t *scheduler, isolate_t *isolate);
+// Blocks until every submitted isolate has finished
+void scheduler_wait(scheduler_t *scheduler);
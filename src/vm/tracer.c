@@ -0,0 +1,207 @@
+#include <stdlib.h>
+
+#include "../objects/snekobject.h"
+#include "bytecode.h"
+#include "gc.h"
+#include "tracer.h"
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static const char *phase_names[] = {
+    [TRACE_COLLECT] = "gc",
+    [TRACE_MARK] = "mark",
+    [TRACE_TRACE] = "trace",
+    [TRACE_SWEEP] = "sweep",
+};
+
+tracer_t *tracer_start(vm_t *vm, size_t events, bool dispatch) {
+  if (vm->tracer != NULL) {
+    return NULL;
+  }
+
+  size_t capacity = 1;
+  while (capacity < events) {
+    capacity *= 2;
+  }
+  tracer_t *tracer = malloc(sizeof(tracer_t));
+  if (tracer == NULL) {
+    return NULL;
+  }
+  tracer->events = malloc(capacity * sizeof(trace_event_t));
+  if (tracer->events == NULL) {
+    free(tracer);
+    return NULL;
+  }
+  tracer->vm = vm;
+  tracer->capacity = capacity;
+  tracer->head = 0;
+  tracer->dispatch = dispatch;
+  tracer->start_ns = now_ns();
+  tracer->start_ticks = tracer_ticks();
+  vm->tracer = tracer;
+  return tracer;
+}
+
+void tracer_stop(tracer_t *tracer) {
+  if (tracer->vm != NULL) {
+    tracer->vm->tracer = NULL;
+    tracer->vm = NULL;
+  }
+}
+
+// Copies the events the VM can't overwrite during the copy into `events`,
+// oldest first. Returns how many.
+static size_t snapshot(tracer_t *tracer, trace_event_t *events) {
+  size_t capacity = tracer->capacity;
+  size_t before = __atomic_load_n(&tracer->head, __ATOMIC_ACQUIRE);
+  size_t first = before > capacity ? before - capacity : 0;
+  for (size_t i = first; i < before; i++) {
+    events[i - first] = tracer->events[i & (capacity - 1)];
+  }
+
+  // Meanwhile the VM wrote up to `after`, and unless it's stopped may be
+  // writing over the slot of `after - capacity`
+  size_t after = __atomic_load_n(&tracer->head, __ATOMIC_ACQUIRE);
+  size_t writing = tracer->vm != NULL ? 1 : 0;
+  size_t kept = after + writing > capacity ? after + writing - capacity : 0;
+  if (kept <= first) {
+    return before - first;
+  }
+  if (kept >= before) {
+    return 0;
+  }
+  size_t count = before - kept;
+  for (size_t i = 0; i < count; i++) {
+    events[i] = events[kept - first + i];
+  }
+  return count;
+}
+
+static const char *function_name(const void *function) {
+  return function != NULL ? ((const function_t *)function)->name : "?";
+}
+
+static bool is_begin(const trace_event_t *event) {
+  return event->kind == TRACE_GC_BEGIN || event->kind == TRACE_FRAME_PUSH;
+}
+
+// The event ending the span `begin` opened
+static bool ends(const trace_event_t *end, const trace_event_t *begin) {
+  return (end->kind == TRACE_GC_END && begin->kind == TRACE_GC_BEGIN &&
+          end->arg == begin->arg) ||
+         (end->kind == TRACE_FRAME_POP && begin->kind == TRACE_FRAME_PUSH);
+}
+
+bool tracer_write_chrome_json(tracer_t *tracer, FILE *out) {
+  trace_event_t *events = malloc(tracer->capacity * sizeof(trace_event_t));
+  // For each event, the span it ends or begins, or SIZE_MAX if it has none
+  // among the events kept
+  size_t *match = malloc(tracer->capacity * sizeof(size_t));
+  size_t *open = malloc(tracer->capacity * sizeof(size_t));
+  if (events == NULL || match == NULL || open == NULL) {
+    free(events);
+    free(match);
+    free(open);
+    return false;
+  }
+  size_t count = snapshot(tracer, events);
+
+  // Spans nest, so a stack pairs them up. A frame's pop names the function,
+  // which isn't known yet when it's pushed.
+  size_t depth = 0;
+  for (size_t i = 0; i < count; i++) {
+    match[i] = SIZE_MAX;
+    if (is_begin(&events[i])) {
+      open[depth++] = i;
+    } else if (depth > 0 && ends(&events[i], &events[open[depth - 1]])) {
+      depth--;
+      match[i] = open[depth];
+      match[open[depth]] = i;
+    }
+  }
+
+  // Ticks run at a steady rate, measured against the clock since the start
+  uint64_t ticks = tracer_ticks() - tracer->start_ticks;
+  uint64_t ns = now_ns() - tracer->start_ns;
+  double ns_per_tick = ticks > 0 ? (double)ns / ticks : 1;
+  uint64_t start = count > 0 ? events[0].ticks : 0;
+  fprintf(out, "{\"traceEvents\": [");
+  const char *separator = "\n";
+  for (size_t i = 0; i < count; i++) {
+    trace_event_t *event = &events[i];
+    double ts = (double)(event->ticks - start) * ns_per_tick / 1000;
+    // An end whose beginning was overwritten would close the wrong span
+    if ((event->kind == TRACE_GC_END || event->kind == TRACE_FRAME_POP) &&
+        match[i] == SIZE_MAX) {
+      continue;
+    }
+
+    fputs(separator, out);
+    separator = ",\n";
+    switch ((trace_kind_t)event->kind) {
+    case TRACE_ALLOC:
+      fprintf(out,
+              "{\"name\": \"%s\", \"cat\": \"alloc\", \"ph\": \"i\", "
+              "\"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+              "\"args\": {\"bytes\": %u}}",
+              gc_kind_name(event->arg), ts, event->value);
+      break;
+    case TRACE_GC_BEGIN:
+      fprintf(out,
+              "{\"name\": \"%s\", \"cat\": \"gc\", \"ph\": \"B\", "
+              "\"ts\": %.3f, \"pid\": 1, \"tid\": 1}",
+              phase_names[event->arg], ts);
+      break;
+    case TRACE_GC_END:
+      fprintf(out,
+              "{\"name\": \"%s\", \"cat\": \"gc\", \"ph\": \"E\", "
+              "\"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+              "\"args\": {\"objects\": %u}}",
+              phase_names[event->arg], ts, event->value);
+      break;
+    case TRACE_FRAME_PUSH:
+      fprintf(out,
+              "{\"name\": \"%s\", \"cat\": \"call\", \"ph\": \"B\", "
+              "\"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+              "\"args\": {\"depth\": %u}}",
+              match[i] != SIZE_MAX ? function_name(events[match[i]].subject)
+                                   : "?",
+              ts, event->value);
+      break;
+    case TRACE_FRAME_POP:
+      fprintf(out,
+              "{\"name\": \"%s\", \"cat\": \"call\", \"ph\": \"E\", "
+              "\"ts\": %.3f, \"pid\": 1, \"tid\": 1}",
+              function_name(event->subject), ts);
+      break;
+    case TRACE_DISPATCH:
+      fprintf(out,
+              "{\"name\": \"%s\", \"cat\": \"dispatch\", \"ph\": \"i\", "
+              "\"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": 1, "
+              "\"args\": {\"function\": \"%s\", \"offset\": %u}}",
+              opcode_name(event->arg), ts, function_name(event->subject),
+              event->value);
+      break;
+    }
+  }
+  fprintf(out, "\n], \"displayTimeUnit\": \"ns\"}\n");
+
+  free(events);
+  free(match);
+  free(open);
+  return !ferror(out);
+}
+
+void tracer_free(tracer_t *tracer) {
+  if (tracer == NULL) {
+    return;
+  }
+
+  tracer_stop(tracer);
+  free(tracer->events);
+  free(tracer);
+}
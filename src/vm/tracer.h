@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "vm.h"
+
+// Events kept by default, the most recent ones
+#define TRACER_DEFAULT_EVENTS (1 << 16)
+
+typedef enum {
+  TRACE_ALLOC,      // arg: object kind, value: bytes
+  TRACE_GC_BEGIN,   // arg: trace_phase_t
+  TRACE_GC_END,     // arg: trace_phase_t, value: objects the phase reached
+                    // or freed, or that a collection left live
+  TRACE_FRAME_PUSH, // value: call depth
+  TRACE_FRAME_POP,  // subject: the frame's function, value: call depth
+  TRACE_DISPATCH,   // arg: opcode, value: offset, subject: the function
+} trace_kind_t;
+
+typedef enum {
+  TRACE_COLLECT, // A whole collection, around the other three
+  TRACE_MARK,
+  TRACE_TRACE,
+  TRACE_SWEEP,
+} trace_phase_t;
+
+// One fixed-size record
+typedef struct TraceEvent {
+  uint64_t ticks; // tracer_ticks
+  uint8_t kind;
+  uint8_t arg;
+  uint32_t value;
+  const void *subject;
+} trace_event_t;
+
+// A ring buffer of the latest events of one VM. Only the VM's thread writes
+// to it. Another thread may dump it at any time without locking: a record
+// is written before `head` moves past it, and the dump drops any record the
+// VM could have overwritten while it was being copied.
+typedef struct Tracer {
+  vm_t *vm;
+  trace_event_t *events;
+  size_t capacity; // A power of two
+  size_t head;     // Records written so far; only grows
+  bool dispatch;   // Record every instruction, which fills the buffer fast
+  uint64_t start_ticks; // When recording started, to convert ticks to time
+  uint64_t start_ns;
+} tracer_t;
+
+// Starts recording the last `events` events of `vm` (rounded up to a power
+// of two), and every instruction dispatched if `dispatch`. Returns NULL if
+// `vm` already has a tracer. Without SNEK_TRACE nothing calls tracer_record,
+// so the tracer stays empty.
+tracer_t *tracer_start(vm_t *vm, size_t events, bool dispatch);
+
+// Stops recording. The events can be written afterwards, even once the VM
+// is freed, as long as the programs it ran are not.
+void tracer_stop(tracer_t *tracer);
+
+// A timestamp for an event. On x86-64 it's the time stamp counter, a few
+// times cheaper than asking the clock, which only the dump then does.
+static inline uint64_t tracer_ticks(void) {
+#if defined(__x86_64__)
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline void tracer_record(tracer_t *tracer, trace_kind_t kind,
+                                 uint8_t arg, uint32_t value,
+                                 const void *subject) {
+  size_t head = tracer->head;
+  tracer->events[head & (tracer->capacity - 1)] = (trace_event_t){
+      .ticks = tracer_ticks(),
+      .kind = kind,
+      .arg = arg,
+      .value = value,
+      .subject = subject};
+  __atomic_store_n(&tracer->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Writes the buffered events as Chrome trace-event JSON, which
+// chrome://tracing and Perfetto load. Collections and their phases, and
+// calls, are spans; allocations and instructions are instants. Times are
+// relative to the oldest event kept. Returns false if `out` couldn't be
+// written.
+bool tracer_write_chrome_json(tracer_t *tracer, FILE *out);
+
+void tracer_free(tracer_t *tracer);
+
+// Trace points. Built without SNEK_TRACE they are empty and their arguments
+// are never evaluated; built with it, they cost a branch while no tracer is
+// attached.
+#ifdef SNEK_TRACE
+#define TRACE_POINT(vm, kind, arg, value, subject)                            \
+  do {                                                                         \
+    if ((vm)->tracer != NULL) {                                                \
+      tracer_record((vm)->tracer, (kind), (arg), (value), (subject));          \
+    }                                                                          \
+  } while (0)
+#define TRACE_DISPATCH_POINT(vm, op, offset, function)                         \
+  do {                                                                         \
+    if ((vm)->tracer != NULL && (vm)->tracer->dispatch) {                      \
+      tracer_record((vm)->tracer, TRACE_DISPATCH, (op), (offset), (function)); \
+    }                                                                          \
+  } while (0)
+#else
+#define TRACE_POINT(vm, kind, arg, value, subject) ((void)0)
+#define TRACE_DISPATCH_POINT(vm, op, offset, function) ((void)0)
+#endif
@@ -1,5 +1,9 @@
+#include <string.h>
+
 #include "vm.h"
 #include "../objects/snekobject.h"
+#include "heap_profiler.h"
+#include "tracer.h"
 
 vm_t *vm_new() {
   vm_t *vm = malloc(sizeof(vm_t));
@@ -7,46 +11,89 @@ vm_t *vm_new() {
     return NULL;
   }
 
-  vm->frames = stack_new(8);
+  vm->frames = malloc(VM_INITIAL_FRAMES * sizeof(frame_t));
+  vm->frame_count = 0;
+  vm->frame_capacity = VM_INITIAL_FRAMES;
   vm->objects = stack_new(8);
+  vm->stack = stack_new(64);
+  vm->gray_objects = stack_new(64);
+  vm->next_gc = VM_INITIAL_GC_THRESHOLD;
+  vm->out = stdout;
+  vm->interrupted = 0;
+  vm->jit = true;
+  vm->profiler = NULL;
+  vm->samples_pending = 0;
+  vm->gc_stats = (gc_stats_t){0};
+  vm->heap_profiler = NULL;
+  vm->tracer = NULL;
   return vm;
 }
 
 void vm_free(vm_t *vm) {
-  for (size_t i = 0; i < vm->frames->count; i++) {
-    frame_free(vm->frames->data[i]);
-  }
-  stack_free(vm->frames);
+  free(vm->frames);
 
   for (size_t i = 0; i < vm->objects->count; i++) {
     snek_object_free(vm->objects->data[i]);
   }
   stack_free(vm->objects);
+  stack_free(vm->stack);
+  stack_free(vm->gray_objects);
 
   free(vm);
 }
 
-void vm_frame_push(vm_t *vm, frame_t *frame) { stack_push(vm->frames, frame); }
-
-frame_t *vm_frame_pop(vm_t *vm) { return stack_pop(vm->frames); }
+void vm_interrupt(vm_t *vm) { vm->interrupted = 1; }
 
 frame_t *vm_new_frame(vm_t *vm) {
-  frame_t *frame = malloc(sizeof(frame_t));
-  frame->references = stack_new(8);
+  // The profiler's signal handler reads the call stack at any instruction,
+  // so the old one is freed only once the new one is in place, and a frame
+  // is filled in before it's counted
+  if (vm->frame_count == vm->frame_capacity) {
+    frame_t *frames = malloc(vm->frame_capacity * 2 * sizeof(frame_t));
+    if (frames == NULL) {
+      return NULL;
+    }
+    memcpy(frames, vm->frames, vm->frame_count * sizeof(frame_t));
+    frame_t *old = vm->frames;
+    vm->frames = frames;
+    __atomic_signal_fence(__ATOMIC_RELEASE);
+    vm->frame_capacity *= 2;
+    free(old);
+  }
 
-  vm_frame_push(vm, frame);
+  frame_t *frame = &vm->frames[vm->frame_count];
+  frame->values = vm->stack;
+  frame->base = vm->stack->count;
+  frame->function = NULL;
+  frame->ip = NULL;
+  __atomic_signal_fence(__ATOMIC_RELEASE);
+  vm->frame_count++;
+  TRACE_POINT(vm, TRACE_FRAME_PUSH, 0, vm->frame_count, NULL);
   return frame;
 }
 
-void frame_free(frame_t *frame) {
-  stack_free(frame->references);
-  free(frame);
+frame_t *vm_frame_pop(vm_t *vm) {
+  if (vm->frame_count == 0) {
+    return NULL;
+  }
+
+  frame_t *frame = &vm->frames[--vm->frame_count];
+  vm->stack->count = frame->base;
+  TRACE_POINT(vm, TRACE_FRAME_POP, 0, vm->frame_count, frame->function);
+  return frame;
 }
 
 void vm_track_object(vm_t *vm, snek_object_t *obj) {
   stack_push(vm->objects, obj);
+  size_t size = snek_object_size(obj);
+  vm->gc_stats.allocated[obj->kind]++;
+  vm->gc_stats.allocated_bytes[obj->kind] += size;
+  if (vm->heap_profiler != NULL) {
+    heap_profiler_record(vm->heap_profiler, obj, size);
+  }
+  TRACE_POINT(vm, TRACE_ALLOC, obj->kind, size, obj);
 }
 
 void frame_reference_object(frame_t *frame, snek_object_t *obj) {
-  stack_push(frame->references, obj);
+  stack_push(frame->values, obj);
 }
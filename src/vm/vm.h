@@ -1,28 +1,90 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../core/interrupt.h"
 #include "../stack/stack.h"
 
 typedef struct SnekObject snek_object_t;
+typedef struct Function function_t;
+typedef struct Profiler profiler_t;
+typedef struct HeapProfiler heap_profiler_t;
+typedef struct Tracer tracer_t;
+
+// A frame owns the value stack slots from `base` up to the next frame's base
+// (or the top of the stack for the innermost frame). Everything in that
+// range is live, so the GC scans it without any per-slot bookkeeping.
+typedef struct StackFrame {
+  stack_t *values;      // The VM's value stack
+  size_t base;          // Index of the frame's first slot
+  function_t *function; // Function being executed, NULL outside vm_run
+  uint8_t *ip;          // Next instruction of `function`
+} frame_t;
+
+// Values of snek_object_kind_t
+#define VM_OBJECT_KINDS 7
+
+// Heap telemetry since the VM was created, read with vm_gc_stats. Sizes are
+// snek_object_size: objects and the buffers they own, without malloc's
+// overhead. Times are wall clock nanoseconds.
+typedef struct GcStats {
+  size_t allocated[VM_OBJECT_KINDS];       // Objects, by snek_object_kind_t
+  size_t allocated_bytes[VM_OBJECT_KINDS]; // Their size when created
+  size_t collections;
+  size_t freed; // Objects
+  size_t freed_bytes;
+  size_t live;       // Objects on the heap
+  size_t live_bytes; // Heap size, as of the last collection or vm_gc_stats
+  size_t peak;       // Largest `live`, measured at the same points
+  size_t peak_bytes;
+  uint64_t mark_ns;  // Marking and tracing, all collections
+  uint64_t sweep_ns; // Sweeping, all collections
+  uint64_t max_pause_ns; // Longest single collection
+} gc_stats_t;
 
 typedef struct VirtualMachine {
-  stack_t *frames;  // Stack of function call frames
-  stack_t *objects; // Stack of allocated objects for GC
+  frame_t *frames;          // Call stack, frames laid out back to back
+  size_t frame_count;       // Number of active frames
+  size_t frame_capacity;    // Frames preallocated in `frames`
+  stack_t *objects;         // Stack of allocated objects for GC
+  stack_t *stack;           // Every frame's slots, the GC roots
+  stack_t *gray_objects;    // Worklist reused by every collection
+  size_t next_gc;           // Object count that triggers the next collection
+  FILE *out;                // Where `print` writes, stdout by default
+  volatile sig_atomic_t interrupted; // Set by vm_interrupt
+  bool jit;                 // Run hot functions natively, in SNEK_JIT builds
+  profiler_t *profiler;     // Sampling this VM, see profiler.h
+  // Set when the profiler has samples to fold
+  volatile sig_atomic_t samples_pending;
+  gc_stats_t gc_stats;
+  heap_profiler_t *heap_profiler; // Sampling allocations, see heap_profiler.h
+  tracer_t *tracer;               // Recording trace points, see tracer.h
 } vm_t;
 
-typedef struct StackFrame {
-  stack_t *references; // Tracks local references
-} frame_t;
+#define VM_INITIAL_FRAMES 64
+#define VM_INITIAL_GC_THRESHOLD 4096
 
 /// VM Lifecycle Management
 vm_t *vm_new();
 void vm_free(vm_t *vm);
 
+// Asks a running script to stop at its next safepoint (a loop back-edge or a
+// call). Safe to call from a signal handler.
+void vm_interrupt(vm_t *vm);
+
 /// Stack Frame Management
-void vm_frame_push(vm_t *vm, frame_t *frame);
-frame_t *vm_frame_pop(vm_t *vm);
+// Frames live inside the VM's call stack, so a frame pointer is only valid
+// until the next frame is pushed (the call stack may move when it grows).
+// Returns NULL if the call stack can't grow.
 frame_t *vm_new_frame(vm_t *vm);
-void frame_free(frame_t *frame);
+// Pops the innermost frame and releases its slots
+frame_t *vm_frame_pop(vm_t *vm);
 
 /// Object Management
+// Adds a finished object to the heap, counts it in `gc_stats` and shows it
+// to the heap profiler
 void vm_track_object(vm_t *vm, snek_object_t *obj);
+// Stores `obj` in a new slot of `frame`, which must be the innermost frame
 void frame_reference_object(frame_t *frame, snek_object_t *obj);
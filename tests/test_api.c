@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/api/sneklang.h"
+#include "../src/vm/vm.h"
+#include "test_api.h"
+
+MunitResult test_api_reuse(const MunitParameter params[], void *user_data) {
+  const char *inputs[] = {"name", "n", "scale"};
+  sneklang_program_t *program =
+      sneklang_compile("def square(x: int) -> int:\n"
+                       "    return x * x\n"
+                       "\n"
+                       "total: int = 0\n"
+                       "for i: int = 0; i < n; i = i + 1:\n"
+                       "    total = total + square(i)\n"
+                       "greeting: string = \"hello \" + name\n"
+                       "scaled: float = total * scale\n",
+                       inputs, 3);
+  munit_assert_not_null(program);
+
+  sneklang_vm_t *vm = sneklang_vm_new();
+  sneklang_bind_string(program, "name", "snek");
+  sneklang_bind_float(program, "scale", 0.5f);
+
+  size_t peak_objects = 0;
+  for (int n = 0; n < 2000; n++) {
+    munit_assert_true(sneklang_bind_int(program, "n", n % 50));
+    munit_assert_true(sneklang_run(vm, program));
+
+    int total;
+    float scaled;
+    int m = n % 50;
+    munit_assert_true(sneklang_get_int(program, "total", &total));
+    munit_assert_int(total, ==, (m - 1) * m * (2 * m - 1) / 6);
+    munit_assert_true(sneklang_get_float(program, "scaled", &scaled));
+    munit_assert_float(scaled, ==, total * 0.5f);
+    munit_assert_string_equal(sneklang_get_string(program, "greeting"),
+                              "hello snek");
+
+    if (vm->objects->count > peak_objects) {
+      peak_objects = vm->objects->count;
+    }
+  }
+
+  // Garbage from earlier runs is collected rather than piling up
+  munit_assert_size(peak_objects, <, 2 * VM_INITIAL_GC_THRESHOLD);
+  munit_assert_size(vm->stack->count, ==, 0);
+  munit_assert_size(vm->frame_count, ==, 0);
+
+  // Output goes wherever the VM points it
+  char *output = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&output, &length);
+  sneklang_program_t *printer = sneklang_compile("print(name)\n", inputs, 1);
+  sneklang_bind_string(printer, "name", "once");
+  sneklang_vm_set_output(vm, out);
+  munit_assert_true(sneklang_run(vm, printer));
+  sneklang_bind_null(printer, "name");
+  munit_assert_true(sneklang_run(vm, printer));
+  fclose(out);
+  munit_assert_string_equal(output, "once\nnull\n");
+  free(output);
+
+  sneklang_program_free(printer);
+  sneklang_program_free(program);
+  sneklang_vm_free(vm);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_api_errors(const MunitParameter params[], void *user_data) {
+  const char *inputs[] = {"x", "x"};
+
+  munit_assert_null(sneklang_compile("y: int = x\n", inputs, 2));
+  munit_assert_null(sneklang_compile("y: int = z\n", inputs, 1));
+
+  sneklang_program_t *program =
+      sneklang_compile("y: int = 10 / x\n", inputs, 1);
+  munit_assert_not_null(program);
+  munit_assert_false(sneklang_bind_int(program, "y", 1));
+  munit_assert_false(sneklang_bind_int(program, "z", 1));
+
+  sneklang_vm_t *vm = sneklang_vm_new();
+  int y;
+
+  sneklang_bind_int(program, "x", 0);
+  munit_assert_false(sneklang_run(vm, program));
+  munit_assert_false(sneklang_get_int(program, "y", &y));
+  munit_assert_size(vm->stack->count, ==, 0);
+
+  // The VM is still usable after a runtime error
+  sneklang_bind_int(program, "x", 5);
+  munit_assert_true(sneklang_run(vm, program));
+  munit_assert_true(sneklang_get_int(program, "y", &y));
+  munit_assert_int(y, ==, 2);
+  munit_assert_null(sneklang_get_string(program, "y"));
+  munit_assert_false(sneklang_get_int(program, "missing", &y));
+
+  // Rebinding drops the previous run's results
+  sneklang_bind_int(program, "x", 1);
+  munit_assert_false(sneklang_get_int(program, "y", &y));
+
+  sneklang_program_free(program);
+  sneklang_vm_free(vm);
+
+  return MUNIT_OK;
+}
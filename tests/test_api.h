@@ -0,0 +1,7 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the embedding API tests
+MunitResult test_api_reuse(const MunitParameter params[], void *user_data);
+MunitResult test_api_errors(const MunitParameter params[], void *user_data);
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/cache.h"
+#include "../src/vm/interpreter.h"
+#include "test_cache.h"
+#include "test_util.h"
+
+static const char *source = "def fib(n: int) -> int:\n"
+                            "    if n < 2:\n"
+                            "        return n\n"
+                            "    return fib(n - 1) + fib(n - 2)\n"
+                            "\n"
+                            "greeting: string = \"a string long enough to "
+                            "live outside the object\"\n"
+                            "scale: float = 0.25\n"
+                            "for i: int = 0; i < 3; i = i + 1:\n"
+                            "    print(greeting, fib(i + 10), scale * i)\n"
+                            "print(-2147483647 - 1, 1 / 0)\n";
+
+// Runs and frees `program`, returning its bytecode listing followed by its
+// output
+static char *run_program(program_t *program) {
+  char *output = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&output, &length);
+  disassemble_program(out, program);
+
+  vm_t *vm = vm_new();
+  vm->out = out;
+  munit_assert_int(vm_run(vm, program), ==, VM_RUNTIME_ERROR);
+  fclose(out);
+  vm_free(vm);
+  program_free(program);
+  return output;
+}
+
+static char *temp_path() {
+  char *path = strdup("/tmp/snek_cache_XXXXXX");
+  int fd = mkstemp(path);
+  munit_assert_int(fd, >=, 0);
+  close(fd);
+  return path;
+}
+
+static uint8_t *read_file(const char *path, size_t *length) {
+  FILE *file = fopen(path, "rb");
+  munit_assert_not_null(file);
+  fseek(file, 0, SEEK_END);
+  *length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t *data = malloc(*length);
+  munit_assert_size(fread(data, 1, *length, file), ==, *length);
+  fclose(file);
+  return data;
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t length) {
+  FILE *file = fopen(path, "wb");
+  munit_assert_not_null(file);
+  fwrite(data, 1, length, file);
+  fclose(file);
+}
+
+MunitResult test_cache_round_trip(const MunitParameter params[],
+                                  void *user_data) {
+  uint64_t hash = cache_hash_source(source, strlen(source));
+  char *path = temp_path();
+
+  program_t *program = test_compile(source, NULL);
+  munit_assert_not_null(program);
+  munit_assert_true(cache_write(path, program, hash));
+  char *expected = run_program(program);
+
+  program_t *cached = cache_load(path, hash);
+  munit_assert_not_null(cached);
+  char *actual = run_program(cached);
+  munit_assert_string_equal(actual, expected);
+
+  free(expected);
+  free(actual);
+  remove(path);
+  free(path);
+
+  // Cache files go next to the script unless a cache directory is set
+  char *beside = cache_path("dir/script.snek");
+  munit_assert_string_equal(beside, "dir/script.snekc");
+  free(beside);
+
+  setenv(SNEKC_DIR_ENV, "/tmp/snek", 1);
+  char *first = cache_path("a/script.snek");
+  char *second = cache_path("b/script.snek");
+  unsetenv(SNEKC_DIR_ENV);
+  munit_assert_int(strncmp(first, "/tmp/snek/", 10), ==, 0);
+  munit_assert_string_not_equal(first, second);
+  free(first);
+  free(second);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_cache_rejects_mismatches(const MunitParameter params[],
+                                          void *user_data) {
+  uint64_t hash = cache_hash_source(source, strlen(source));
+  char *path = temp_path();
+
+  program_t *program = test_compile(source, NULL);
+  munit_assert_not_null(program);
+  munit_assert_true(cache_write(path, program, hash));
+  program_free(program);
+
+  size_t length;
+  uint8_t *data = read_file(path, &length);
+
+  // Edited source
+  munit_assert_null(cache_load(path, hash + 1));
+
+  // Another format version
+  data[4]++;
+  write_file(path, data, length);
+  munit_assert_null(cache_load(path, hash));
+  data[4]--;
+
+  // Truncated anywhere
+  for (size_t i = 0; i < length; i++) {
+    write_file(path, data, i);
+    munit_assert_null(cache_load(path, hash));
+  }
+
+  // Damaged bytes either fail to load or load within bounds
+  for (size_t i = 24; i < length; i++) {
+    uint8_t original = data[i];
+    data[i] = 0xff;
+    write_file(path, data, length);
+    program_t *damaged = cache_load(path, hash);
+    program_free(damaged);
+    data[i] = original;
+  }
+
+  write_file(path, data, length);
+  program = cache_load(path, hash);
+  munit_assert_not_null(program);
+  program_free(program);
+
+  // A jump into the operands of a later instruction
+  program = test_compile(source, NULL);
+  munit_assert_not_null(program);
+  function_t *fib =
+      program->functions->data[program_find_function(program, "fib")];
+  chunk_t *chunk = &fib->chunk;
+  size_t jump = chunk->count;
+  size_t inside = 0;
+  for (size_t offset = 0; offset < chunk->count && inside == 0;
+       offset += instruction_size(chunk->code[offset])) {
+    if (jump == chunk->count && chunk->code[offset] == OP_JUMP_IF_FALSE) {
+      jump = offset;
+    } else if (jump < offset && instruction_size(chunk->code[offset]) > 1) {
+      inside = offset + 1;
+    }
+  }
+  munit_assert_size(inside, >, 0);
+  size_t distance = inside - (jump + instruction_size(OP_JUMP_IF_FALSE));
+  chunk->code[jump + 1] = (uint8_t)(distance >> 8);
+  chunk->code[jump + 2] = (uint8_t)distance;
+  munit_assert_true(cache_write(path, program, hash));
+  munit_assert_null(cache_load(path, hash));
+  program_free(program);
+
+  free(data);
+  remove(path);
+  free(path);
+
+  return MUNIT_OK;
+}
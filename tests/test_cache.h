@@ -0,0 +1,9 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the bytecode cache tests
+MunitResult test_cache_round_trip(const MunitParameter params[],
+                                  void *user_data);
+MunitResult test_cache_rejects_mismatches(const MunitParameter params[],
+                                          void *user_data);
@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/compiler/emit_c.h"
+#include "../src/vm/interpreter.h"
+#include "test_emit_c.h"
+#include "test_util.h"
+
+// Compiles `source` like `sneklang --emit-c` and returns the generated C
+static char *emit_source(const char *source) {
+  lexer_t *lexer = lexer_new((char *)source);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = parse_root(parser);
+  munit_assert_not_null(root);
+
+  program_t *program = compile(root);
+  munit_assert_not_null(program);
+  program_free(program);
+
+  char *code = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&code, &length);
+  munit_assert_true(emit_c(out, root));
+  fclose(out);
+
+  parser_free(parser);
+  lexer_free(lexer);
+  return code;
+}
+
+// Builds the generated C against the runtime in src/ and runs it. Returns
+// its output, or NULL if there is no C compiler to build it with.
+static char *run_native(const char *code, int *status) {
+  char path[] = "/tmp/snek_aot_XXXXXX";
+  int fd = mkstemp(path);
+  munit_assert_int(fd, >=, 0);
+  close(fd);
+
+  char source_path[64];
+  snprintf(source_path, sizeof(source_path), "%s.c", path);
+  FILE *file = fopen(source_path, "w");
+  munit_assert_not_null(file);
+  fputs(code, file);
+  fclose(file);
+
+  char command[512];
+  snprintf(command, sizeof(command),
+           "cc -O1 -pthread -I./src -o %s %s $(find src -name '*.c' ! -path "
+           "src/core/main.c) -lm 2>/dev/null",
+           path, source_path);
+  bool built = system(command) == 0;
+  remove(source_path);
+  if (!built) {
+    remove(path);
+    return NULL;
+  }
+
+  char *output = NULL;
+  size_t length = 0;
+  FILE *captured = open_memstream(&output, &length);
+  FILE *program = popen(path, "r");
+  munit_assert_not_null(program);
+
+  char buffer[256];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), program)) > 0) {
+    fwrite(buffer, 1, read, captured);
+  }
+  *status = WEXITSTATUS(pclose(program));
+  fclose(captured);
+  remove(path);
+  return output;
+}
+
+MunitResult test_emit_c_native_types(const MunitParameter params[],
+                                     void *user_data) {
+  char *code = emit_source("def sum(n: int) -> int:\n"
+                           "    total: int = 0\n"
+                           "    for i: int = 0; i < n; i = i + 1:\n"
+                           "        total = total + i\n"
+                           "    return total\n"
+                           "\n"
+                           "def maybe(x: int) -> int:\n"
+                           "    if x > 0:\n"
+                           "        return x\n"
+                           "    return null\n"
+                           "\n"
+                           "scale: float = 1.5\n"
+                           "name: string = \"snek\"\n"
+                           "count: int = 0\n"
+                           "count = null\n"
+                           "print(sum(10) * scale, maybe(1), name, count)\n");
+
+  // Typed values that only ever hold their type are plain C values
+  munit_assert_not_null(strstr(code, "static int f_sum(int v_n)"));
+  munit_assert_not_null(strstr(code, "int v_total = 0;"));
+  munit_assert_not_null(strstr(code, "static float g_scale;"));
+  munit_assert_not_null(strstr(code, "aot_add_int(v_total, v_i)"));
+
+  // Anything else stays boxed on the value stack
+  munit_assert_not_null(strstr(code, "static void f_maybe(int v_x)"));
+  munit_assert_null(strstr(code, "g_count"));
+  munit_assert_null(strstr(code, "g_name"));
+  free(code);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_emit_c_differential(const MunitParameter params[],
+                                     void *user_data) {
+  const char *source = "def greet(name: string, times: int) -> string:\n"
+                       "    out: string = \"\"\n"
+                       "    for i: int = 0; i < times; i = i + 1:\n"
+                       "        if i == 1:\n"
+                       "            continue\n"
+                       "        out = out + name\n"
+                       "    return out\n"
+                       "\n"
+                       "def fact(n: int, acc: int) -> int:\n"
+                       "    if n <= 1:\n"
+                       "        return acc\n"
+                       "    return fact(n - 1, acc * n)\n"
+                       "\n"
+                       "def halve(x: float) -> float:\n"
+                       "    return x / 2\n"
+                       "\n"
+                       "g: int = 0\n"
+                       "def bump() -> int:\n"
+                       "    g = g + 1\n"
+                       "    return g\n"
+                       "\n"
+                       "print(greet(\"ab\\n\", 3), fact(10, 1))\n"
+                       "print(halve(3), halve(5.0), 7 / 2, -3, !0, !2.5)\n"
+                       "v: int = 1\n"
+                       "v = null\n"
+                       "print(v, v == null, 1 and 2, 0 or 3, \"x\" or \"y\")\n"
+                       "print(g + bump(), bump() + g)\n"
+                       "n: float = 0.0\n"
+                       "total: int = 0\n"
+                       "while n < 100000.0:\n"
+                       "    n = n + 0.5\n"
+                       "    total = total + 2147483647\n"
+                       "    if n > 1000.0:\n"
+                       "        break\n"
+                       "print(n, total)\n"
+                       "least: int = -2147483647 - 1\n"
+                       "print(least / (g - 3), least / -1, least / 3)\n"
+                       "print(total / (g - 2))\n";
+
+  vm_result_t result;
+  char *expected = test_run_source(source, &result);
+  munit_assert_int(result, ==, VM_RUNTIME_ERROR);
+
+  char *code = emit_source(source);
+  int status = 0;
+  char *output = run_native(code, &status);
+  free(code);
+  if (output == NULL) {
+    free(expected);
+    return MUNIT_SKIP;
+  }
+
+  munit_assert_string_equal(output, expected);
+  munit_assert_int(status, ==, 1);
+  free(output);
+  free(expected);
+
+  return MUNIT_OK;
+}
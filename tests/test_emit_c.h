@@ -0,0 +1,9 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the C backend tests
+MunitResult test_emit_c_native_types(const MunitParameter params[],
+                                     void *user_data);
+MunitResult test_emit_c_differential(const MunitParameter params[],
+                                     void *user_data);
@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/objects/sneknew.h"
+#include "../src/vm/gc.h"
+#include "../src/vm/heap_profiler.h"
+#include "../src/vm/interpreter.h"
+#include "test_heap_profiler.h"
+#include "test_util.h"
+
+static char *write_json(heap_profiler_t *profiler) {
+  char *json = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&json, &length);
+  munit_assert_true(heap_profiler_write_json(profiler, out));
+  fclose(out);
+  return json;
+}
+
+MunitResult test_heap_profiler_sites(const MunitParameter params[],
+                                     void *user_data) {
+  // Enough garbage from two lines to collect several times
+  program_t *program = test_compile("total: int = 0\n"
+                                    "i: int = 0\n"
+                                    "while i < 20000:\n"
+                                    "    total = total + 1\n"
+                                    "    i = i + 1\n"
+                                    "print(total)\n",
+                                    NULL);
+  munit_assert_not_null(program);
+
+  // Every object, then the default interval
+  size_t intervals[] = {1, HEAP_PROFILE_INTERVAL};
+  char *json[2];
+  for (int run = 0; run < 2; run++) {
+    vm_t *vm = vm_new();
+    vm->out = fopen("/dev/null", "w");
+    // Native code would count against the line the interpreter entered it
+    vm->jit = false;
+    heap_profiler_t *profiler = heap_profiler_start(vm, intervals[run]);
+    munit_assert_not_null(profiler);
+    munit_assert_null(heap_profiler_start(vm, intervals[run]));
+
+    munit_assert_int(vm_run(vm, program), ==, VM_OK);
+    heap_profiler_stop(profiler);
+    munit_assert_size(heap_profiler_collections(profiler), ==,
+                      vm->gc_stats.collections);
+    munit_assert_size(heap_profiler_collections(profiler), >, 0);
+    fclose(vm->out);
+    vm_free(vm);
+
+    json[run] = write_json(profiler);
+    heap_profiler_free(profiler);
+  }
+
+  // Each line's additions land on one site, whether or not every object is
+  // sampled; the estimate is within a sample of the exact count
+  munit_assert_not_null(
+      strstr(json[0], "{\"function\": \"<script>\", \"line\": 4, "
+                      "\"op\": \"ADD\", \"allocated_objects\": 20000, "));
+  munit_assert_not_null(
+      strstr(json[0], "{\"function\": \"<script>\", \"line\": 5, "
+                      "\"op\": \"ADD\", \"allocated_objects\": 20000, "));
+  char *line = strstr(json[1], "\"line\": 4, \"op\": \"ADD\"");
+  munit_assert_not_null(line);
+  double estimate = strtod(strstr(line, "\"allocated_objects\": ") + 21, NULL);
+  double per_sample = (double)HEAP_PROFILE_INTERVAL / sizeof(snek_object_t);
+  munit_assert_double(estimate, >=, 20000 - per_sample);
+  munit_assert_double(estimate, <=, 20000 + per_sample);
+
+  free(json[0]);
+  free(json[1]);
+  program_free(program);
+  return MUNIT_OK;
+}
+
+MunitResult test_heap_profiler_survivors(const MunitParameter params[],
+                                         void *user_data) {
+  vm_t *vm = vm_new();
+  heap_profiler_t *profiler = heap_profiler_start(vm, 1);
+  frame_t *frame = vm_new_frame(vm);
+
+  // Outside a script, so every object shares one site
+  for (int i = 0; i < 10; i++) {
+    snek_object_t *obj = new_snek_integer(vm, i);
+    if (i < 4) {
+      frame_reference_object(frame, obj);
+    }
+  }
+  vm_collect_garbage(vm);
+  vm_collect_garbage(vm);
+  heap_profiler_stop(profiler);
+  vm_free(vm);
+
+  size_t size = sizeof(snek_object_t);
+  char expected[256];
+  snprintf(expected, sizeof(expected),
+           "{\"function\": null, \"line\": 0, \"op\": null, "
+           "\"allocated_objects\": 10, \"allocated_bytes\": %zu, "
+           "\"survived_objects\": 4, \"live_objects\": 4, "
+           "\"live_bytes\": %zu, \"peak_live_bytes\": %zu}",
+           10 * size, 4 * size, 4 * size);
+  char *json = write_json(profiler);
+  munit_assert_not_null(strstr(json, expected));
+  munit_assert_not_null(strstr(json, "\"collections\": 2,"));
+
+  char *report = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&report, &length);
+  munit_assert_true(heap_profiler_write_report(profiler, out));
+  fclose(out);
+  munit_assert_not_null(strstr(report, "10 samples, one per 1 bytes"));
+  munit_assert_not_null(strstr(report, "[outside a script]"));
+
+  free(report);
+  free(json);
+  heap_profiler_free(profiler);
+  return MUNIT_OK;
+}
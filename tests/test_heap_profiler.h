@@ -0,0 +1,9 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the heap profiler tests
+MunitResult test_heap_profiler_sites(const MunitParameter params[],
+                                     void *user_data);
+MunitResult test_heap_profiler_survivors(const MunitParameter params[],
+                                         void *user_data);
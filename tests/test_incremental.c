@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/parser/incremental.h"
+#include "test_incremental.h"
+
+// Statements of each kind the edits have to get right: blocks, an `if` with
+// `elif` and `else` lines in column 0, and a string spanning lines
+static char *generate(int statements) {
+  size_t capacity = (size_t)statements * 96 + 1;
+  char *source = malloc(capacity);
+  size_t length = 0;
+
+  for (int i = 0; i < statements; i++) {
+    char *at = source + length;
+    size_t left = capacity - length;
+    switch (i % 4) {
+    case 0:
+      length += snprintf(at, left, "v%d: int = %d\n\n", i, i);
+      break;
+    case 1:
+      length += snprintf(at, left,
+                         "def f%d(x: int) -> int:\n"
+                         "    return x + %d\n",
+                         i, i);
+      break;
+    case 2:
+      length += snprintf(at, left,
+                         "if v%d > 10:\n"
+                         "    v%d = 1\n"
+                         "elif v%d > 5:\n"
+                         "    v%d = 2\n"
+                         "else:\n"
+                         "    v%d = f%d(3)\n",
+                         i - 2, i - 2, i - 2, i - 2, i - 2, i - 1);
+      break;
+    default:
+      length += snprintf(at, left, "s%d: string = \"two\nlines %d\"\n", i, i);
+      break;
+    }
+  }
+  return source;
+}
+
+static bool strings_equal(const char *a, const char *b) {
+  return a == b || (a != NULL && b != NULL && strcmp(a, b) == 0);
+}
+
+static bool nodes_equal(ast_node_t *a, ast_node_t *b);
+
+static bool lists_equal(ast_node_list_t *a, ast_node_list_t *b) {
+  if (a->count != b->count) {
+    return false;
+  }
+  for (int i = 0; i < a->count; i++) {
+    if (!nodes_equal(a->nodes[i], b->nodes[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Same shape, values and line numbers
+static bool nodes_equal(ast_node_t *a, ast_node_t *b) {
+  if (a == NULL || b == NULL) {
+    return a == b;
+  }
+  if (a->type != b->type || a->line != b->line) {
+    return false;
+  }
+
+  switch (a->type) {
+  case NODE_LITERAL:
+    return a->literal.kind == b->literal.kind &&
+           a->literal.value == b->literal.value &&
+           a->literal.floating == b->literal.floating &&
+           strings_equal(a->literal.string, b->literal.string);
+  case NODE_BINARY_OP:
+    return a->binary_op.op == b->binary_op.op &&
+           nodes_equal(a->binary_op.left, b->binary_op.left) &&
+           nodes_equal(a->binary_op.right, b->binary_op.right);
+  case NODE_UNARY_OP:
+    return a->unary_op.op == b->unary_op.op &&
+           nodes_equal(a->unary_op.operand, b->unary_op.operand);
+  case NODE_VARIABLE:
+    return strings_equal(a->variable.name, b->variable.name);
+  case NODE_ASSIGNMENT:
+    return strings_equal(a->assignment.name, b->assignment.name) &&
+           nodes_equal(a->assignment.value, b->assignment.value);
+  case NODE_DECLARATION:
+    return strings_equal(a->declaration.name, b->declaration.name) &&
+           strings_equal(a->declaration.type, b->declaration.type) &&
+           nodes_equal(a->declaration.value, b->declaration.value);
+  case NODE_FUNCTION:
+    if (!strings_equal(a->function.name, b->function.name) ||
+        !strings_equal(a->function.return_type, b->function.return_type) ||
+        a->function.param_count != b->function.param_count) {
+      return false;
+    }
+    for (int i = 0; i < a->function.param_count; i++) {
+      if (!strings_equal(a->function.param_names[i],
+                         b->function.param_names[i]) ||
+          !strings_equal(a->function.param_types[i],
+                         b->function.param_types[i])) {
+        return false;
+      }
+    }
+    return lists_equal(&a->function.body, &b->function.body);
+  case NODE_CALL:
+    return strings_equal(a->call.name, b->call.name) &&
+           lists_equal(&a->call.args, &b->call.args);
+  case NODE_RETURN:
+    return nodes_equal(a->return_stmt.value, b->return_stmt.value);
+  case NODE_IF:
+    return nodes_equal(a->if_stmt.condition, b->if_stmt.condition) &&
+           lists_equal(&a->if_stmt.then_branch, &b->if_stmt.then_branch) &&
+           lists_equal(&a->if_stmt.else_branch, &b->if_stmt.else_branch);
+  case NODE_WHILE:
+    return nodes_equal(a->while_stmt.condition, b->while_stmt.condition) &&
+           lists_equal(&a->while_stmt.body, &b->while_stmt.body);
+  case NODE_FOR:
+    return nodes_equal(a->for_stmt.init, b->for_stmt.init) &&
+           nodes_equal(a->for_stmt.condition, b->for_stmt.condition) &&
+           nodes_equal(a->for_stmt.step, b->for_stmt.step) &&
+           lists_equal(&a->for_stmt.body, &b->for_stmt.body);
+  case NODE_BLOCK:
+    return lists_equal(&a->block.statements, &b->block.statements);
+  default:
+    return true;
+  }
+}
+
+// Checks the incremental result against parsing the edited text from
+// scratch. `parsed` is what the last edit returned.
+static void assert_matches_full_parse(incremental_t *parse, bool parsed) {
+  lexer_t *lexer = lexer_new(parse->source);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *expected = parse_root(parser);
+  ast_root_t *actual = incremental_root(parse);
+
+  munit_assert_int(parsed, ==, expected != NULL);
+  if (expected == NULL) {
+    munit_assert_null(actual);
+  } else {
+    munit_assert_not_null(actual);
+    munit_assert_int(actual->count, ==, expected->count);
+    for (int i = 0; i < expected->count; i++) {
+      munit_assert_true(nodes_equal(actual->nodes[i], expected->nodes[i]));
+    }
+  }
+  parser_free(parser);
+  lexer_free(lexer);
+}
+
+static size_t line_start(const char *source, size_t offset) {
+  while (offset > 0 && source[offset - 1] != '\n') {
+    offset--;
+  }
+  return offset;
+}
+
+MunitResult test_incremental_matches(const MunitParameter params[],
+                                     void *user_data) {
+  char *source = generate(200);
+  incremental_t *parse = incremental_new(source);
+  free(source);
+  munit_assert_not_null(parse->root);
+  munit_assert_true(parse->tracked);
+
+  // Every edit is checked, and single characters (which may break the
+  // script, or land inside a string) are checked again once removed
+  static const char inserts[] = "a7 \n:+(";
+  unsigned seed = 12345;
+  for (int round = 0; round < 300; round++) {
+    seed = seed * 1103515245u + 12345u;
+    size_t offset = (seed >> 8) % (parse->length + 1);
+    bool parsed;
+
+    switch (round % 4) {
+    case 0: {
+      char text[2] = {inserts[(seed >> 4) % (sizeof(inserts) - 1)], '\0'};
+      parsed = incremental_edit(parse, offset, 0, text);
+      assert_matches_full_parse(parse, parsed);
+      parsed = incremental_edit(parse, offset, 1, "");
+      break;
+    }
+    case 1:
+      // Checked along with the next edit, so the lines it moves are only
+      // caught up after both
+      incremental_edit(parse, line_start(parse->source, offset), 0,
+                       round % 8 == 1 ? "\n" : "w: int = 5\n");
+      continue;
+    case 2:
+      // Lines that start with `w` are whole statements added above
+      offset = line_start(parse->source, offset);
+      if (parse->source[offset] == 'w') {
+        parsed = incremental_edit(parse, offset, strlen("w: int = 5\n"), "");
+      } else {
+        parsed = incremental_edit(parse, offset, 0, "");
+      }
+      break;
+    default:
+      while (offset < parse->length &&
+             (parse->source[offset] < '0' || parse->source[offset] > '9')) {
+        offset++;
+      }
+      parsed = incremental_edit(parse, offset, offset < parse->length, "3");
+      break;
+    }
+    assert_matches_full_parse(parse, parsed);
+  }
+
+  incremental_free(parse);
+  return MUNIT_OK;
+}
+
+MunitResult test_incremental_reuse(const MunitParameter params[],
+                                   void *user_data) {
+  char *source = generate(400);
+  incremental_t *parse = incremental_new(source);
+  free(source);
+  munit_assert_not_null(parse->root);
+  munit_assert_int(parse->root->count, ==, 400);
+
+  ast_node_t **before = malloc(400 * sizeof(ast_node_t *));
+  memcpy(before, parse->root->nodes, 400 * sizeof(ast_node_t *));
+
+  // A digit inside `v200: int = 200` touches that statement alone
+  size_t offset = parse->starts[200].offset + strlen("v200: int = 2");
+  munit_assert_true(incremental_edit(parse, offset, 1, "9"));
+  assert_matches_full_parse(parse, true);
+  ast_root_t *root = incremental_root(parse);
+  munit_assert_int(parse->reparsed, ==, 1);
+  munit_assert_int(root->nodes[200]->declaration.value->literal.value, ==,
+                   290);
+  for (int i = 0; i < 400; i++) {
+    if (i != 200) {
+      munit_assert_ptr_equal(root->nodes[i], before[i]);
+    }
+  }
+
+  // New lines move the statements below without parsing them again, or
+  // touching their nodes until the root is asked for. Text typed at the
+  // start of a statement may continue the one before, so that one is parsed
+  // too.
+  int line = root->nodes[300]->line;
+  munit_assert_true(incremental_edit(parse, parse->starts[100].offset, 0,
+                                     "\n\nv: int = 1\n"));
+  munit_assert_int(parse->starts[301].line, ==, line + 3);
+  munit_assert_int(before[300]->line, ==, line);
+  assert_matches_full_parse(parse, true);
+  munit_assert_int(parse->reparsed, ==, 2);
+  munit_assert_int(root->count, ==, 401);
+  munit_assert_ptr_equal(root->nodes[301], before[300]);
+  munit_assert_int(root->nodes[301]->line, ==, line + 3);
+
+  // An indented line typed above the `if` joins the body of the def before
+  // it, and the `if` is kept
+  ast_node_t *kept = root->nodes[103];
+  munit_assert_true(
+      incremental_edit(parse, parse->starts[103].offset, 0, "    x = 4\n"));
+  assert_matches_full_parse(parse, true);
+  munit_assert_int(parse->reparsed, ==, 1);
+  munit_assert_ptr_equal(root->nodes[103], kept);
+  munit_assert_int(root->count, ==, 401);
+  munit_assert_int(root->nodes[102]->function.body.count, ==, 2);
+
+  // Newlines inside a string aren't lines to the lexer
+  line = root->nodes[301]->line;
+  munit_assert_true(incremental_edit(parse, parse->starts[250].offset, 0,
+                                     "t: string = \"a\nb\"\n"));
+  assert_matches_full_parse(parse, true);
+  munit_assert_int(root->nodes[302]->line, ==, line + 1);
+
+  free(before);
+  incremental_free(parse);
+  return MUNIT_OK;
+}
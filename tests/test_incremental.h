@@ -0,0 +1,9 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the incremental parser tests
+MunitResult test_incremental_matches(const MunitParameter params[],
+                                     void *user_data);
+MunitResult test_incremental_reuse(const MunitParameter params[],
+                                   void *user_data);
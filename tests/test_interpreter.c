@@ -0,0 +1,307 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "test_interpreter.h"
+#include "test_util.h"
+
+static bool function_uses(program_t *program, const char *name, opcode_t op) {
+  function_t *function =
+      program->functions->data[program_find_function(program, name)];
+  chunk_t *chunk = &function->chunk;
+
+  for (size_t offset = 0; offset < chunk->count;) {
+    if (chunk->code[offset] == op) {
+      return true;
+    }
+    offset += instruction_size(chunk->code[offset]);
+  }
+  return false;
+}
+
+MunitResult test_interpreter_calls(const MunitParameter params[],
+                                   void *user_data) {
+  vm_result_t result;
+  char *output = test_run_source("def add(a: int, b: int) -> int:\n"
+                                 "    c: int = a + b\n"
+                                 "    return c\n"
+                                 "\n"
+                                 "def twice(x: int) -> int:\n"
+                                 "    return add(x, x) * 1\n"
+                                 "\n"
+                                 "def greet():\n"
+                                 "    print(greeting)\n"
+                                 "\n"
+                                 "greeting: string = \"hello\"\n"
+                                 "total: int = twice(21)\n"
+                                 "greet()\n"
+                                 "print(total, add(1, 2) - 4, greet())\n",
+                                 &result);
+
+  munit_assert_not_null(output);
+  munit_assert_int(result, ==, VM_OK);
+  // Functions without a return value evaluate to null
+  munit_assert_string_equal(output, "hello\nhello\n42 -1 null\n");
+  free(output);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_interpreter_tail_calls(const MunitParameter params[],
+                                        void *user_data) {
+  const char *source = "def identity(x: int) -> int:\n"
+                       "    return x\n"
+                       "\n"
+                       "def forward(x: int) -> int:\n"
+                       "    return identity(x)\n"
+                       "\n"
+                       "def plus_one(x: int) -> int:\n"
+                       "    return identity(x) + 1\n"
+                       "\n"
+                       "print(forward(7), plus_one(7))\n";
+
+  program_t *program = test_compile(source, NULL);
+  munit_assert_not_null(program);
+  munit_assert_true(function_uses(program, "forward", OP_TAIL_CALL));
+  munit_assert_false(function_uses(program, "plus_one", OP_TAIL_CALL));
+  program_free(program);
+
+  vm_result_t result;
+  char *output = test_run_source(source, &result);
+  munit_assert_int(result, ==, VM_OK);
+  munit_assert_string_equal(output, "7 8\n");
+  free(output);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_interpreter_errors(const MunitParameter params[],
+                                    void *user_data) {
+  munit_assert_null(test_compile("def f(x: int) -> int:\n"
+                                 "    return x\n"
+                                 "f(1, 2)\n",
+                                 NULL));
+  munit_assert_null(test_compile("print(missing)\n", NULL));
+  munit_assert_null(test_compile("return 1\n", NULL));
+
+  vm_result_t result;
+  char *output = test_run_source("def divide(x: int) -> int:\n"
+                                 "    return x / 0\n"
+                                 "print(1)\n"
+                                 "print(divide(1))\n"
+                                 "print(2)\n",
+                                 &result);
+  // The error unwinds every frame (checked in test_run)
+  munit_assert_int(result, ==, VM_RUNTIME_ERROR);
+  munit_assert_string_equal(output, "1\n");
+  free(output);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_interpreter_control_flow(const MunitParameter params[],
+                                          void *user_data) {
+  vm_result_t result;
+  char *output =
+      test_run_source("def sign(x: int) -> string:\n"
+                      "    if x < 0:\n"
+                      "        return \"negative\"\n"
+                      "    elif x == 0:\n"
+                      "        return \"zero\"\n"
+                      "    else:\n"
+                      "        return \"positive\"\n"
+                      "\n"
+                      "def fib(n: int) -> int:\n"
+                      "    if n < 2:\n"
+                      "        return n\n"
+                      "    return fib(n - 1) + fib(n - 2)\n"
+                      "\n"
+                      "print(sign(-3), sign(0), sign(8))\n"
+                      "print(fib(15), 2 <= 2.5, \"b\" > \"a\", 1 != 1)\n"
+                      "print(0 or \"x\", 1 and 2, null or 0, 0 and f())\n"
+                      "def f() -> int:\n"
+                      "    return 1 / 0\n",
+                      &result);
+
+  munit_assert_int(result, ==, VM_OK);
+  // The right operand of `and`/`or` only runs when needed
+  munit_assert_string_equal(output, "negative zero positive\n"
+                                    "610 1 1 0\n"
+                                    "x 2 0 0\n");
+  free(output);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_interpreter_precedence(const MunitParameter params[],
+                                        void *user_data) {
+  vm_result_t result;
+  char *output =
+      test_run_source("print(10 - 4 - 3, 100 / 10 / 5, 2 + 3 * 4 - 6 / 2)\n"
+                      "print(-2 * 3 + 1, (2 + 3) * 4, !0 + 1, 3 > 2 > 1)\n"
+                      "print(1 + 2 < 4 == 1, 0 or 1 and 0, 1 or 0 and 0)\n"
+                      "print(1 == 2 or 3 - 1 * 2 == 1 and 2 >= 2)\n",
+                      &result);
+
+  munit_assert_int(result, ==, VM_OK);
+  munit_assert_string_equal(output, "3 2 11\n"
+                                    "-5 20 2 0\n"
+                                    "1 0 1\n"
+                                    "1\n");
+  free(output);
+
+  // Int arithmetic wraps around
+  output =
+      test_run_source("print(2147483647 + 1, -2147483647 - 2, 65536 * 65536)\n"
+                      "print(-(0 - 2147483647 - 1))\n"
+                      "x: int = -2147483647 - 1\n"
+                      "print(x / -1, x / 2, 7 / -1)\n",
+                      &result);
+  munit_assert_int(result, ==, VM_OK);
+  munit_assert_string_equal(output, "-2147483648 2147483647 0\n"
+                                    "-2147483648\n"
+                                    "-2147483648 -1073741824 -7\n");
+  free(output);
+
+  // A missing operand is a parse error, wherever the operator binds
+  munit_assert_false(test_parses("x: int = 1 + 2 *\n"));
+  munit_assert_false(test_parses("x: int = (1 or)\n"));
+  // ...and so is a second statement on the same line
+  munit_assert_false(test_parses("x: int = 1 2\n"));
+  munit_assert_false(test_parses("print(1) print(2)\n"));
+  munit_assert_true(test_parses("def f() -> int:\n    return 1"));
+
+  return MUNIT_OK;
+}
+
+MunitResult test_interpreter_loops(const MunitParameter params[],
+                                   void *user_data) {
+  vm_result_t result;
+  char *output = test_run_source("for i: int = 0; i < 10; i = i + 1:\n"
+                                 "    if i == 2:\n"
+                                 "        continue\n"
+                                 "    if i == 5:\n"
+                                 "        break\n"
+                                 "    print(i)\n"
+                                 "\n"
+                                 "n: int = 0\n"
+                                 "pairs: int = 0\n"
+                                 "while n < 4:\n"
+                                 "    n = n + 1\n"
+                                 "    if n == 2:\n"
+                                 "        continue\n"
+                                 "    for i: int = 0; ; i = i + 1:\n"
+                                 "        if i == n:\n"
+                                 "            break\n"
+                                 "        pairs = pairs + 1\n"
+                                 "print(n, pairs)\n",
+                                 &result);
+
+  munit_assert_int(result, ==, VM_OK);
+  // Inner `break`s only leave the inner loop; 1 + 3 + 4 pairs
+  munit_assert_string_equal(output, "0\n1\n3\n4\n4 8\n");
+  free(output);
+
+  munit_assert_null(test_compile("break\n", NULL));
+
+  return MUNIT_OK;
+}
+
+MunitResult test_interpreter_scopes(const MunitParameter params[],
+                                    void *user_data) {
+  vm_result_t result;
+  char *output =
+      test_run_source("def sum_twice(n: int) -> int:\n"
+                      "    total: int = 0\n"
+                      "    for i: int = 0; i < n; i = i + 1:\n"
+                      "        total = total + i\n"
+                      "    for i: int = 0; i < n; i = i + 1:\n"
+                      "        step: int = i\n"
+                      "        total = total + step\n"
+                      "    if total > 0:\n"
+                      "        step: string = \"positive\"\n"
+                      "        print(step)\n"
+                      "    return total\n"
+                      "\n"
+                      "print(sum_twice(4))\n"
+                      "for i: int = 0; i < 2; i = i + 1:\n"
+                      "    half: int = i\n"
+                      "    print(half)\n"
+                      "for i: string = \"a\"; i != \"aaa\"; i = i + \"a\":\n"
+                      "    print(i)\n",
+                      &result);
+
+  munit_assert_int(result, ==, VM_OK);
+  // Sibling blocks each declare their own `i` and `step`
+  munit_assert_string_equal(output, "positive\n12\n0\n1\na\naa\n");
+  free(output);
+
+  // A name can't be declared again while it's in scope
+  munit_assert_null(test_compile("x: int = 1\n"
+                                 "x: string = \"a\"\n"
+                                 "print(x)\n",
+                                 NULL));
+  munit_assert_null(test_compile("def f() -> int:\n"
+                                 "    y: int = 2\n"
+                                 "    y: int = 3\n"
+                                 "    return y\n",
+                                 NULL));
+  munit_assert_null(test_compile("def f(y: int) -> int:\n"
+                                 "    while y > 0:\n"
+                                 "        y: int = 3\n"
+                                 "    return y\n",
+                                 NULL));
+  munit_assert_null(test_compile("x: int = 1\n"
+                                 "if x > 0:\n"
+                                 "    x: int = 2\n",
+                                 NULL));
+  // ...and is gone once its block ends
+  munit_assert_null(test_compile("if 1:\n"
+                                 "    z: int = 1\n"
+                                 "print(z)\n",
+                                 NULL));
+  munit_assert_null(test_compile("def f() -> int:\n"
+                                 "    for i: int = 0; i < 3; i = i + 1:\n"
+                                 "        last: int = i\n"
+                                 "    return i\n",
+                                 NULL));
+
+  return MUNIT_OK;
+}
+
+MunitResult test_interpreter_safepoints(const MunitParameter params[],
+                                        void *user_data) {
+  program_t *program = test_compile("def count_down(n: int) -> int:\n"
+                                    "    if n == 0:\n"
+                                    "        return 0\n"
+                                    "    return count_down(n - 1)\n"
+                                    "\n"
+                                    "garbage: float = 0.0\n"
+                                    "for i: int = 0; i < 100000; i = i + 1:\n"
+                                    "    garbage = garbage + 0.5\n"
+                                    "count_down(100000)\n",
+                                    NULL);
+  munit_assert_not_null(program);
+
+  vm_t *vm = vm_new();
+  munit_assert_int(vm_run(vm, program), ==, VM_OK);
+  // Tail recursion never grew the call stack
+  munit_assert_size(vm->frame_capacity, ==, VM_INITIAL_FRAMES);
+  // Loop back-edges and calls collected the temporaries as they went
+  munit_assert_size(vm->objects->count, <, 4 * VM_INITIAL_GC_THRESHOLD);
+
+  // An interrupt stops an infinite loop at its header
+  program_t *forever = test_compile("while true:\n"
+                                    "    x: int = 1\n",
+                                    NULL);
+  vm_interrupt(vm);
+  munit_assert_int(vm_run(vm, forever), ==, VM_RUNTIME_ERROR);
+  munit_assert_size(vm->frame_count, ==, 0);
+
+  program_free(forever);
+  program_free(program);
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the compiler and interpreter tests
+MunitResult test_interpreter_calls(const MunitParameter params[],
+                                   void *user_data);
+MunitResult test_interpreter_tail_calls(const MunitParameter params[],
+                                        void *user_data);
+MunitResult test_interpreter_errors(const MunitParameter params[],
+                                    void *user_data);
+MunitResult test_interpreter_control_flow(const MunitParameter params[],
+                                          void *user_data);
+MunitResult test_interpreter_precedence(const MunitParameter params[],
+                                        void *user_data);
+MunitResult test_interpreter_loops(const MunitParameter params[],
+                                   void *user_data);
+MunitResult test_interpreter_scopes(const MunitParameter params[],
+                                    void *user_data);
+MunitResult test_interpreter_safepoints(const MunitParameter params[],
+                                        void *user_data);
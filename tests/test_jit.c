@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "../src/vm/jit.h"
+#include "test_jit.h"
+#include "test_util.h"
+
+// Runs `source` with the JIT on or off and returns everything it printed.
+// `hot` is the function whose loops should have been compiled, or NULL.
+static char *run_source(const char *source, bool jit, const char *hot,
+                        vm_result_t *result) {
+  program_t *program = test_compile(source, NULL);
+  munit_assert_not_null(program);
+  char *output = test_run(program, jit, result);
+
+  if (hot != NULL) {
+    function_t *function =
+        program->functions->data[program_find_function(program, hot)];
+    munit_assert_int(function->jit != NULL, ==, jit);
+  }
+
+  program_free(program);
+  return output;
+}
+
+// Runs `source` interpreted and compiled, which must behave the same
+static void assert_same(const char *source, const char *hot,
+                        vm_result_t expected) {
+  vm_result_t interpreted_result;
+  vm_result_t native_result;
+  char *interpreted = run_source(source, false, hot, &interpreted_result);
+  char *native = run_source(source, true, hot, &native_result);
+
+  munit_assert_int(interpreted_result, ==, expected);
+  munit_assert_int(native_result, ==, expected);
+  munit_assert_string_equal(native, interpreted);
+  free(interpreted);
+  free(native);
+}
+
+MunitResult test_jit_differential(const MunitParameter params[],
+                                  void *user_data) {
+#ifndef SNEK_JIT
+  return MUNIT_SKIP;
+#endif
+
+  // Every kind of instruction the JIT compiles inline, in a hot loop
+  assert_same("total: int = 0\n"
+              "scaled: float = 0.5\n"
+              "flag: bool = false\n"
+              "for i: int = 0; i < 3000; i = i + 1:\n"
+              "    j: int = 0\n"
+              "    while j < 3:\n"
+              "        total = total + i * j - -1\n"
+              "        j = j + 1\n"
+              "    scaled = scaled * 1.0 + 0.25 / 2.0\n"
+              "    flag = !flag and (i >= 10 or i <= 2)\n"
+              "    if i == 1500 or i != i:\n"
+              "        print(i, total, scaled, flag, null)\n"
+              "print(total, scaled, flag, total > 2999, 7 / 2)\n",
+              "<script>", VM_OK);
+
+  // Loops in functions, with calls the native code hands back
+  assert_same("def square(x: int) -> int:\n"
+              "    return x * x\n"
+              "\n"
+              "def count(n: int, acc: int) -> int:\n"
+              "    if n == 0:\n"
+              "        return acc\n"
+              "    return count(n - 1, acc + 1)\n"
+              "\n"
+              "def sum(n: int) -> int:\n"
+              "    total: int = 0\n"
+              "    for i: int = 0; i < n; i = i + 1:\n"
+              "        total = total + square(i) + count(3, 0)\n"
+              "        if total > 1000000000:\n"
+              "            break\n"
+              "    return total\n"
+              "\n"
+              "print(sum(5000), sum(10))\n",
+              "sum", VM_OK);
+
+  // Comparisons feeding a branch are inline for ints only
+  assert_same("name: string = \"a\"\n"
+              "hits: int = 0\n"
+              "for i: int = 0; i < 3000; i = i + 1:\n"
+              "    if name < \"b\" and i * 0.5 >= 1400.0:\n"
+              "        hits = hits + 1\n"
+              "    if null == null and i != -1:\n"
+              "        hits = hits + 1\n"
+              "print(hits)\n",
+              "<script>", VM_OK);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_jit_fallbacks(const MunitParameter params[],
+                               void *user_data) {
+#ifndef SNEK_JIT
+  return MUNIT_SKIP;
+#endif
+
+  // Errors in native code are raised by the interpreter, on the same line
+  assert_same("def divide(n: int) -> int:\n"
+              "    d: int = 3000\n"
+              "    total: int = 0\n"
+              "    while true:\n"
+              "        total = total + n / d\n"
+              "        d = d - 1\n"
+              "    return total\n"
+              "\n"
+              "print(\"start\")\n"
+              "print(divide(6000))\n",
+              "divide", VM_RUNTIME_ERROR);
+
+  assert_same("value: int = 0\n"
+              "for i: int = 0; i < 2000; i = i + 1:\n"
+              "    if i == 1999:\n"
+              "        value = null\n"
+              "    print(value < 1)\n"
+              "    value = value + 0\n",
+              "<script>", VM_RUNTIME_ERROR);
+
+  assert_same("value: int = 0\n"
+              "for i: int = 0; i < 2000; i = i + 1:\n"
+              "    if i == 1999:\n"
+              "        value = null\n"
+              "    if value < 1:\n"
+              "        print(i)\n",
+              "<script>", VM_RUNTIME_ERROR);
+
+  // Cold functions stay interpreted
+  assert_same("def cold(n: int) -> int:\n"
+              "    while n > 0:\n"
+              "        n = n - 1\n"
+              "    return n\n"
+              "\n"
+              "print(cold(10))\n",
+              NULL, VM_OK);
+
+  return MUNIT_OK;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the JIT tests, skipped unless built with JIT=1
+MunitResult test_jit_differential(const MunitParameter params[],
+                                  void *user_data);
+MunitResult test_jit_fallbacks(const MunitParameter params[], void *user_data);
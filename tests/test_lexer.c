@@ -229,3 +229,28 @@ MunitResult test_lexer_literals(const MunitParameter params[], void *user_data)
   lexer_free(lexer);
   return MUNIT_OK;
 }
+
+// ✅ Test: Blank lines inside a block and closing several blocks at once
+MunitResult test_lexer_dedent(const MunitParameter params[], void *user_data) {
+  lexer_t *lexer = lexer_new("a\n"
+                             "    b\n"
+                             "\n"
+                             "        c\n"
+                             "d\n");
+
+  token_type_t expected_types[] = {
+      TOKEN_IDENTIFIER, TOKEN_EOL,    TOKEN_INDENT,     TOKEN_IDENTIFIER,
+      TOKEN_EOL,        TOKEN_EOL,    TOKEN_INDENT,     TOKEN_IDENTIFIER,
+      TOKEN_EOL,        TOKEN_DEDENT, TOKEN_DEDENT,     TOKEN_IDENTIFIER,
+      TOKEN_EOL,        TOKEN_EOF};
+  int expected_count = sizeof(expected_types) / sizeof(expected_types[0]);
+
+  for (int i = 0; i < expected_count; i++) {
+    token_t *token = lexer_next_token(lexer);
+    munit_assert_int(token->type, ==, expected_types[i]);
+    token_free(token);
+  }
+
+  lexer_free(lexer);
+  return MUNIT_OK;
+}
@@ -12,4 +12,5 @@ MunitResult test_lexer_identifiers(const MunitParameter params[],
                                    void *user_data);
 MunitResult test_lexer_full_script(const MunitParameter params[],
                                    void *user_data);
-MunitResult test_lexer_literals(const MunitParameter params[], void *user_data);
\ No newline at end of file
+MunitResult test_lexer_literals(const MunitParameter params[], void *user_data);
+MunitResult test_lexer_dedent(const MunitParameter params[], void *user_data);
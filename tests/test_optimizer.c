@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "test_optimizer.h"
+#include "test_util.h"
+
+// Compiles `source` with `options` and runs it. Returns everything it
+// printed, which the caller frees.
+static char *run_with_options(const char *source, compile_options_t *options,
+                              vm_result_t *result) {
+  program_t *program = test_compile(source, options);
+  munit_assert_not_null(program);
+  char *output = test_run(program, true, result);
+  program_free(program);
+  return output;
+}
+
+// Runs `source` with and without optimizations, checks both print the same
+// thing, and returns the optimized run's report
+static opt_report_t *run_both_ways(const char *source, const char *expected) {
+  compile_options_t plain = {.optimize = false};
+  compile_options_t optimized = {.optimize = true, .report = opt_report_new()};
+  vm_result_t plain_result;
+  vm_result_t optimized_result;
+
+  char *plain_output = run_with_options(source, &plain, &plain_result);
+  char *optimized_output =
+      run_with_options(source, &optimized, &optimized_result);
+
+  munit_assert_int(optimized_result, ==, plain_result);
+  munit_assert_string_equal(plain_output, expected);
+  munit_assert_string_equal(optimized_output, expected);
+  free(plain_output);
+  free(optimized_output);
+  return optimized.report;
+}
+
+MunitResult test_optimizer_hoisting(const MunitParameter params[],
+                                    void *user_data) {
+  opt_report_t *report = run_both_ways("def scale(n: int) -> int:\n"
+                                       "    k: int = 3\n"
+                                       "    total: int = 0\n"
+                                       "    i: int = 0\n"
+                                       "    while i < n:\n"
+                                       "        total = total + k * k + 1\n"
+                                       "        i = i + 1\n"
+                                       "    return total\n"
+                                       "\n"
+                                       "x: float = 1.5\n"
+                                       "acc: float = 0.0\n"
+                                       "for j: int = 0; j < 4; j = j + 1:\n"
+                                       "    for m: int = 0; m < 2; m = m + 1:\n"
+                                       "        acc = acc + x / 2.0\n"
+                                       "print(scale(5), acc)\n",
+                                       "50 6\n");
+
+  // `k * k` and `x / 2.0`; the inner loop's temporary is itself invariant
+  // in the outer loop and moves out again
+  munit_assert_int(report->hoisted, >=, 2);
+  munit_assert_int(report->strength_reduced, ==, 0);
+  opt_report_free(report);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_optimizer_strength_reduction(const MunitParameter params[],
+                                              void *user_data) {
+  opt_report_t *report =
+      run_both_ways("def sum(n: int) -> int:\n"
+                    "    k: int = 4\n"
+                    "    total: int = 0\n"
+                    "    for i: int = 0; i < n; i = i + 1:\n"
+                    "        if i == 2:\n"
+                    "            continue\n"
+                    "        total = total + i * k\n"
+                    "    return total\n"
+                    "\n"
+                    "s: int = 0\n"
+                    "j: int = 10\n"
+                    "while j > 0:\n"
+                    "    s = s + 3 * j\n"
+                    "    j = j - 2\n"
+                    "print(sum(6), s)\n",
+                    "52 90\n");
+
+  munit_assert_int(report->strength_reduced, ==, 2);
+  opt_report_free(report);
+
+  // A float induction variable is left alone, as is a step the factor
+  // can't follow exactly
+  report = run_both_ways("f: float = 0.0\n"
+                         "t: float = 0.0\n"
+                         "while f < 2.0:\n"
+                         "    t = t + f * 3\n"
+                         "    f = f + 0.5\n"
+                         "print(t)\n",
+                         "9\n");
+  munit_assert_int(report->strength_reduced, ==, 0);
+  opt_report_free(report);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_optimizer_safety(const MunitParameter params[],
+                                  void *user_data) {
+  // Integer division by a variable could fail, and a loop that never runs
+  // mustn't fail because of it
+  opt_report_t *report = run_both_ways("a: int = 10\n"
+                                       "b: int = 0\n"
+                                       "c: int = 0\n"
+                                       "while c > 0:\n"
+                                       "    c = c - a / b\n"
+                                       "print(c)\n",
+                                       "0\n");
+  munit_assert_int(report->hoisted, ==, 0);
+  opt_report_free(report);
+
+  // Annotations aren't checked, so `x` may not be a number, and `x * 3`
+  // would fail if it ran before a loop that never does
+  report = run_both_ways("def f(x: int, n: int) -> int:\n"
+                         "    total: int = 0\n"
+                         "    while total < n:\n"
+                         "        total = total + x * 3\n"
+                         "    return total\n"
+                         "\n"
+                         "print(f(\"a\", 0), f(2, 1))\n",
+                         "0 6\n");
+  munit_assert_int(report->hoisted, ==, 0);
+  opt_report_free(report);
+
+  // `k` changes behind the loop's back, through a call
+  report = run_both_ways("def bump():\n"
+                         "    k = k + 1\n"
+                         "\n"
+                         "k: int = 1\n"
+                         "total: int = 0\n"
+                         "for i: int = 0; i < 3; i = i + 1:\n"
+                         "    total = total + k * 2\n"
+                         "    bump()\n"
+                         "print(total)\n",
+                         "12\n");
+  munit_assert_int(report->hoisted, ==, 0);
+  opt_report_free(report);
+
+  // Nothing in the loop is invariant once `x` is reassigned in it
+  report = run_both_ways("x: int = 1\n"
+                         "y: int = 0\n"
+                         "for i: int = 0; i < 3; i = i + 1:\n"
+                         "    y = y + x * 2\n"
+                         "    x = y\n"
+                         "print(y)\n",
+                         "18\n");
+  munit_assert_int(report->hoisted, ==, 0);
+  opt_report_free(report);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_optimizer_loads(const MunitParameter params[],
+                                 void *user_data) {
+  opt_report_t *report = run_both_ways("def f(n: int) -> int:\n"
+                                       "    m: int = n + 1\n"
+                                       "    m = m * 2\n"
+                                       "    return m\n"
+                                       "\n"
+                                       "x: int = f(3)\n"
+                                       "print(x)\n"
+                                       "y: bool = true and x > 5\n"
+                                       "print(y)\n",
+                                       "8\n1\n");
+
+  // The store after the short circuit is a jump target, but the load after
+  // it isn't, so all four reloads go
+  munit_assert_int(report->loads_eliminated, ==, 4);
+  opt_report_free(report);
+
+  // Loads at a loop header or a loop exit can be reached from elsewhere
+  report = run_both_ways("i: int = 0\n"
+                         "while i < 3:\n"
+                         "    i = i + 1\n"
+                         "print(i)\n",
+                         "3\n");
+  munit_assert_int(report->loads_eliminated, ==, 0);
+  opt_report_free(report);
+
+  return MUNIT_OK;
+}
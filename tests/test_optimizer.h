@@ -0,0 +1,13 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the optimizer tests
+MunitResult test_optimizer_hoisting(const MunitParameter params[],
+                                    void *user_data);
+MunitResult test_optimizer_strength_reduction(const MunitParameter params[],
+                                              void *user_data);
+MunitResult test_optimizer_safety(const MunitParameter params[],
+                                  void *user_data);
+MunitResult test_optimizer_loads(const MunitParameter params[],
+                                 void *user_data);
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/parser/parallel.h"
+#include "../src/vm/interpreter.h"
+#include "test_parallel_parse.h"
+
+// Enough statements for several chunks, including ones that must stay with
+// the statement before them and a string literal spanning lines
+static char *generate(int statements) {
+  size_t capacity = (size_t)statements * 96 + 1;
+  char *source = malloc(capacity);
+  size_t length = 0;
+
+  for (int i = 0; i < statements; i++) {
+    char *at = source + length;
+    size_t left = capacity - length;
+    switch (i % 4) {
+    case 0:
+      length += snprintf(at, left, "v%d: int = %d\n\n", i, i);
+      break;
+    case 1:
+      length += snprintf(at, left,
+                         "def f%d(x: int) -> int:\n"
+                         "    return x + %d\n",
+                         i, i);
+      break;
+    case 2:
+      length += snprintf(at, left,
+                         "if v%d > 10:\n"
+                         "    v%d = 1\n"
+                         "elif v%d > 5:\n"
+                         "    v%d = 2\n"
+                         "else:\n"
+                         "    v%d = f%d(3)\n",
+                         i - 2, i - 2, i - 2, i - 2, i - 2, i - 1);
+      break;
+    default:
+      length += snprintf(at, left, "s%d: string = \"two\nlines %d\"\n", i, i);
+      break;
+    }
+  }
+  return source;
+}
+
+// Bytecode listing (which includes line numbers) followed by the output
+static char *run(ast_root_t *root) {
+  program_t *program = compile(root);
+  munit_assert_not_null(program);
+
+  char *output = NULL;
+  size_t length = 0;
+  vm_t *vm = vm_new();
+  vm->out = open_memstream(&output, &length);
+  disassemble_program(vm->out, program);
+  munit_assert_int(vm_run(vm, program), ==, VM_OK);
+  fclose(vm->out);
+  vm_free(vm);
+  program_free(program);
+  return output;
+}
+
+MunitResult test_parallel_parse_matches(const MunitParameter params[],
+                                        void *user_data) {
+  char *source = generate(2000);
+  strcat(source, "print(v1996, s1999, f1997(1))\n");
+
+  lexer_t *lexer = lexer_new(source);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = parse_root(parser);
+  munit_assert_not_null(root);
+  munit_assert_int(root->count, ==, 2001);
+  char *expected = run(root);
+  parser_free(parser);
+  lexer_free(lexer);
+
+  for (int threads = 1; threads <= 4; threads++) {
+    root = parse_root_parallel(source, threads);
+    munit_assert_not_null(root);
+    munit_assert_int(root->count, ==, 2001);
+    char *actual = run(root);
+    munit_assert_string_equal(actual, expected);
+    free(actual);
+    ast_root_free(root);
+  }
+
+  free(expected);
+  free(source);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_parallel_parse_errors(const MunitParameter params[],
+                                       void *user_data) {
+  char *source = generate(2000);
+  // A broken statement in the last chunk fails the whole parse
+  strcat(source, "x: int = (1 + \n");
+  munit_assert_null(parse_root_parallel(source, 4));
+  free(source);
+
+  // Short scripts are parsed in one chunk
+  ast_root_t *root = parse_root_parallel("x: int = 1\nprint(x)\n", 8);
+  munit_assert_not_null(root);
+  munit_assert_int(root->count, ==, 2);
+  ast_root_free(root);
+
+  return MUNIT_OK;
+}
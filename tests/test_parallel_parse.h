@@ -0,0 +1,9 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the parallel parser tests
+MunitResult test_parallel_parse_matches(const MunitParameter params[],
+                                        void *user_data);
+MunitResult test_parallel_parse_errors(const MunitParameter params[],
+                                       void *user_data);
@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "../src/vm/profiler.h"
+#include "test_profiler.h"
+#include "test_util.h"
+
+MunitResult test_profiler_folded(const MunitParameter params[],
+                                 void *user_data) {
+  // A loop at the bottom of a recursion deeper than the frames a sample
+  // keeps, then the same loop called from the top level
+  program_t *program = test_compile("def spin(n: int) -> int:\n"
+                                    "    total: int = 0\n"
+                                    "    for i: int = 0; i < n; i = i + 1:\n"
+                                    "        total = total + 1\n"
+                                    "    return total\n"
+                                    "\n"
+                                    "def down(depth: int) -> int:\n"
+                                    "    if depth == 0:\n"
+                                    "        return spin(1000000)\n"
+                                    "    return down(depth - 1) + 1\n"
+                                    "\n"
+                                    "print(down(200))\n"
+                                    "print(spin(1000000))\n",
+                                    NULL);
+  munit_assert_not_null(program);
+
+  vm_t *vm = vm_new();
+  vm->out = fopen("/dev/null", "w");
+  profiler_t *profiler = profiler_start(vm, 1000);
+  munit_assert_not_null(profiler);
+  // The timer is per process
+  vm_t *other = vm_new();
+  munit_assert_null(profiler_start(other, 1000));
+  vm_free(other);
+
+  munit_assert_int(vm_run(vm, program), ==, VM_OK);
+  profiler_stop(profiler);
+  munit_assert_size(profiler_samples(profiler), >, 0);
+  munit_assert_size(profiler_dropped(profiler), ==, 0);
+
+  char *folded = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&folded, &length);
+  munit_assert_true(profiler_write_folded(profiler, out));
+  fclose(out);
+
+  // Every line is a stack and a count, and the counts add up
+  size_t total = 0;
+  bool truncated = false;
+  bool top_level = false;
+  for (char *line = strtok(folded, "\n"); line != NULL;
+       line = strtok(NULL, "\n")) {
+    char *count = strrchr(line, ' ');
+    munit_assert_not_null(count);
+    total += strtoul(count + 1, NULL, 10);
+    munit_assert_not_null(strstr(line, "spin:"));
+
+    if (strncmp(line, "[truncated];down:10;", 20) == 0) {
+      truncated = true;
+    } else if (strncmp(line, "<script>:13;spin:", 17) == 0) {
+      top_level = true;
+    } else {
+      munit_assert_string_equal(line, "stacks are either of the above");
+    }
+  }
+  munit_assert_size(total, ==, profiler_samples(profiler));
+  munit_assert_true(truncated);
+  munit_assert_true(top_level);
+
+  // Stopped, the profiler no longer holds the timer
+  profiler_t *next = profiler_start(vm, 1000);
+  munit_assert_not_null(next);
+  profiler_free(next);
+
+  free(folded);
+  profiler_free(profiler);
+  fclose(vm->out);
+  vm_free(vm);
+  program_free(program);
+  return MUNIT_OK;
+}
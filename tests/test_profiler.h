@@ -0,0 +1,7 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the profiler tests
+MunitResult test_profiler_folded(const MunitParameter params[],
+                                 void *user_data);
@@ -1,13 +1,43 @@
 #include "munit/munit.h"
+#include "test_api.h"
+#include "test_cache.h"
+#include "test_emit_c.h"
+#include "test_heap_profiler.h"
+#include "test_incremental.h"
+#include "test_interpreter.h"
+#include "test_jit.h"
 #include "test_lexer.h"
+#include "test_optimizer.h"
+#include "test_parallel_parse.h"
+#include "test_profiler.h"
+#include "test_scheduler.h"
+#include "test_snekobject.h"
 #include "test_stack.h"
+#include "test_tracer.h"
 #include "test_vm.h"
 
 MunitTest tests[] = {
     // VM Tests
     {"/test_vm", test_gc, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_vm/roots", test_gc_roots, NULL, NULL, MUNIT_TEST_OPTION_NONE,
+     NULL},
+    {"/test_vm/frame_growth", test_frame_growth, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_vm/gc_stats", test_gc_stats, NULL, NULL, MUNIT_TEST_OPTION_NONE,
+     NULL},
     {"/test_stack", test_stack, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 
+    // Object Tests
+    {"/objects/typed_array", test_typed_array, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/objects/array_append", test_array_append, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/objects/array_slice", test_array_slice, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/objects/string_rope", test_string_rope, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/objects/map", test_map, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
     // Lexer Tests
     {"/lexer/int", test_lexer_int, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
     {"/lexer/float", test_lexer_float, NULL, NULL, MUNIT_TEST_OPTION_NONE,
@@ -24,6 +54,89 @@ MunitTest tests[] = {
      MUNIT_TEST_OPTION_NONE, NULL},
     {"/lexer/literals", test_lexer_literals, NULL, NULL, MUNIT_TEST_OPTION_NONE,
      NULL},
+    {"/lexer/dedent", test_lexer_dedent, NULL, NULL, MUNIT_TEST_OPTION_NONE,
+     NULL},
+
+    // Compiler and Interpreter Tests
+    {"/interpreter/calls", test_interpreter_calls, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/interpreter/tail_calls", test_interpreter_tail_calls, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/interpreter/errors", test_interpreter_errors, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/interpreter/control_flow", test_interpreter_control_flow, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/interpreter/precedence", test_interpreter_precedence, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/interpreter/loops", test_interpreter_loops, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/interpreter/scopes", test_interpreter_scopes, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/interpreter/safepoints", test_interpreter_safepoints, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Parallel Parser Tests
+    {"/parser/parallel_matches", test_parallel_parse_matches, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/parser/parallel_errors", test_parallel_parse_errors, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Incremental Parser Tests
+    {"/parser/incremental_matches", test_incremental_matches, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/parser/incremental_reuse", test_incremental_reuse, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Profiler Tests
+    {"/profiler/folded", test_profiler_folded, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Heap Profiler Tests
+    {"/heap_profiler/sites", test_heap_profiler_sites, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/heap_profiler/survivors", test_heap_profiler_survivors, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Tracer Tests
+    {"/tracer/ring", test_tracer_ring, NULL, NULL, MUNIT_TEST_OPTION_NONE,
+     NULL},
+    {"/tracer/vm", test_tracer_vm, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Optimizer Tests
+    {"/optimizer/hoisting", test_optimizer_hoisting, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/optimizer/strength_reduction", test_optimizer_strength_reduction, NULL,
+     NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/optimizer/safety", test_optimizer_safety, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/optimizer/loads", test_optimizer_loads, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Isolate Scheduler Tests
+    {"/scheduler/isolates", test_scheduler_isolates, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Embedding API Tests
+    {"/api/reuse", test_api_reuse, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/api/errors", test_api_errors, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+    // Bytecode Cache Tests
+    {"/cache/round_trip", test_cache_round_trip, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/cache/rejects_mismatches", test_cache_rejects_mismatches, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // C Backend Tests
+    {"/emit_c/native_types", test_emit_c_native_types, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/emit_c/differential", test_emit_c_differential, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+
+    // JIT Tests
+    {"/jit/differential", test_jit_differential, NULL, NULL,
+     MUNIT_TEST_OPTION_NONE, NULL},
+    {"/jit/fallbacks", test_jit_fallbacks, NULL, NULL, MUNIT_TEST_OPTION_NONE,
+     NULL},
 
     {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE,
      NULL} // Null-terminated array
@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/scheduler.h"
+#include "test_scheduler.h"
+#include "test_util.h"
+
+#define ISOLATES 64
+
+MunitResult test_scheduler_isolates(const MunitParameter params[],
+                                    void *user_data) {
+  // Hot enough to be compiled in JIT builds while other isolates run it, and
+  // allocates enough for every isolate to collect garbage
+  program_t *loop = test_compile("def twice(n: int) -> int:\n"
+                                 "    return n * 2\n"
+                                 "\n"
+                                 "total: int = 0\n"
+                                 "for i: int = 0; i < 5000; i = i + 1:\n"
+                                 "    total = total + twice(i)\n"
+                                 "print(\"total\", total)\n",
+                                 NULL);
+  program_t *failing = test_compile("x: int = 1\n"
+                                    "print(x / 0)\n",
+                                    NULL);
+  munit_assert_not_null(loop);
+  munit_assert_not_null(failing);
+
+  isolate_t isolates[ISOLATES];
+  char *outputs[ISOLATES];
+  size_t lengths[ISOLATES];
+  FILE *files[ISOLATES];
+
+  scheduler_t *scheduler = scheduler_new(4);
+  munit_assert_not_null(scheduler);
+
+  // Reuse the pool for several batches
+  for (int batch = 0; batch < 3; batch++) {
+    for (int i = 0; i < ISOLATES; i++) {
+      files[i] = open_memstream(&outputs[i], &lengths[i]);
+      isolate_init(&isolates[i], i % 8 == 7 ? failing : loop, files[i]);
+      scheduler_submit(scheduler, &isolates[i]);
+    }
+    scheduler_wait(scheduler);
+
+    for (int i = 0; i < ISOLATES; i++) {
+      fclose(files[i]);
+      if (i % 8 == 7) {
+        munit_assert_int(isolates[i].result, ==, VM_RUNTIME_ERROR);
+        munit_assert_string_equal(outputs[i], "");
+      } else {
+        munit_assert_int(isolates[i].result, ==, VM_OK);
+        munit_assert_string_equal(outputs[i], "total 24995000\n");
+      }
+      free(outputs[i]);
+    }
+  }
+
+  scheduler_free(scheduler);
+  program_free(loop);
+  program_free(failing);
+
+  return MUNIT_OK;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the isolate scheduler tests
+MunitResult test_scheduler_isolates(const MunitParameter params[],
+                                    void *user_data);
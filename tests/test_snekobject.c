@@ -0,0 +1,226 @@
+#include "test_snekobject.h"
+#include "../src/objects/snekmap.h"
+#include "../src/objects/sneknew.h"
+#include "../src/objects/snekstring.h"
+#include "../src/objects/snektypedarray.h"
+#include "../src/vm/gc.h"
+#include "../src/vm/vm.h"
+#include "munit/munit.h"
+
+MunitResult test_typed_array(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  frame_t *f1 = vm_new_frame(vm);
+
+  // Odd length so the reductions exercise both the lane loop and the tail
+  snek_object_t *a = new_snek_typed_array(vm, ELEMENT_INT32, 19);
+  snek_object_t *b = new_snek_typed_array(vm, ELEMENT_INT32, 19);
+  frame_reference_object(f1, a);
+  frame_reference_object(f1, b);
+
+  for (size_t i = 0; i < 19; i++) {
+    munit_assert_true(snek_typed_array_set(a, i, (double)i - 9));
+  }
+  munit_assert_true(snek_typed_array_fill(b, 2));
+  munit_assert_false(snek_typed_array_set(a, 19, 0));
+
+  snek_object_t *sum = snek_add(vm, a, b);
+  munit_assert_not_null(sum);
+  munit_assert_int(sum->kind, ==, TYPED_ARRAY);
+  munit_assert_double(snek_typed_array_sum(sum), ==, 38);
+
+  double value;
+  munit_assert_true(snek_typed_array_min(a, &value));
+  munit_assert_double(value, ==, -9);
+  munit_assert_true(snek_typed_array_max(a, &value));
+  munit_assert_double(value, ==, 9);
+
+  // Doubles an int can't hold saturate, and ints wrap around when added
+  munit_assert_true(snek_typed_array_set(a, 0, 1e10));
+  munit_assert_true(snek_typed_array_set(a, 1, -1e10));
+  munit_assert_true(snek_typed_array_set(a, 2, 0.0 / 0.0));
+  munit_assert_true(snek_typed_array_get(a, 0, &value));
+  munit_assert_double(value, ==, 2147483647);
+  munit_assert_true(snek_typed_array_get(a, 1, &value));
+  munit_assert_double(value, ==, -2147483648.0);
+  munit_assert_true(snek_typed_array_get(a, 2, &value));
+  munit_assert_double(value, ==, 0);
+  snek_object_t *wrapped = snek_add(vm, a, b);
+  munit_assert_not_null(wrapped);
+  munit_assert_true(snek_typed_array_get(wrapped, 0, &value));
+  munit_assert_double(value, ==, -2147483647);
+
+  // Mixed kinds are converted on copy, but never added implicitly
+  snek_object_t *d = new_snek_typed_array(vm, ELEMENT_DOUBLE, 19);
+  frame_reference_object(f1, d);
+  munit_assert_true(snek_typed_array_copy(d, a));
+  munit_assert_true(snek_typed_array_get(d, 3, &value));
+  munit_assert_double(value, ==, -6);
+  munit_assert_null(snek_add(vm, a, d));
+
+  // Unreferenced result is collected, elements are never scanned
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 3);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_array_append(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  frame_t *f1 = vm_new_frame(vm);
+
+  snek_object_t *array = new_snek_array(vm, 0);
+  frame_reference_object(f1, array);
+
+  for (int i = 0; i < 100; i++) {
+    munit_assert_true(snek_array_append(array, new_snek_integer(vm, i)));
+  }
+  munit_assert_size(array->data.v_array.size, ==, 100);
+  munit_assert_size(array->data.v_array.capacity, >=, 100);
+  munit_assert_int(snek_array_get(array, 42)->data.v_int, ==, 42);
+
+  snek_object_t *last = snek_array_pop(array);
+  munit_assert_int(last->data.v_int, ==, 99);
+  munit_assert_size(array->data.v_array.size, ==, 99);
+
+  // The popped integer is garbage now, everything else is reachable
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 100);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_array_slice(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  frame_t *f1 = vm_new_frame(vm);
+
+  snek_object_t *array = new_snek_array(vm, 0);
+  for (int i = 0; i < 10; i++) {
+    snek_array_append(array, new_snek_integer(vm, i));
+  }
+
+  snek_object_t *view = new_snek_array_slice(vm, array, 2, 8);
+  snek_object_t *nested = new_snek_array_slice(vm, view, 1, 3);
+  munit_assert_null(new_snek_array_slice(vm, view, 4, 7));
+  frame_reference_object(f1, nested);
+
+  // Views share storage with their base
+  munit_assert_ptr(nested->data.v_array.base, ==, array);
+  munit_assert_int(snek_array_get(nested, 0)->data.v_int, ==, 3);
+  snek_array_set(array, 3, new_snek_integer(vm, 30));
+  munit_assert_int(snek_array_get(nested, 0)->data.v_int, ==, 30);
+
+  // Only the nested view is rooted, but it keeps the base alive
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 12);
+  munit_assert_int(snek_array_get(nested, 1)->data.v_int, ==, 4);
+
+  // Appending copies the view out of its base
+  munit_assert_true(snek_array_append(nested, new_snek_integer(vm, 5)));
+  munit_assert_null(nested->data.v_array.base);
+  snek_array_set(nested, 0, new_snek_integer(vm, 7));
+  munit_assert_int(snek_array_get(array, 3)->data.v_int, ==, 30);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_string_rope(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  frame_t *f1 = vm_new_frame(vm);
+
+  // Short concatenations are copied eagerly into inline storage
+  snek_object_t *hello = new_snek_string(vm, "hello, ");
+  snek_object_t *short_str = snek_add(vm, hello, new_snek_string(vm, "world"));
+  frame_reference_object(f1, short_str);
+  munit_assert_true(snek_string_is_inline(&short_str->data.v_string));
+  munit_assert_size(snek_string_length(short_str), ==, 12);
+  munit_assert_string_equal(snek_string_cstr(short_str), "hello, world");
+
+  // Long ones build a rope that is flattened on demand
+  snek_object_t *str = new_snek_string(vm, "");
+  for (int i = 0; i < 1000; i++) {
+    str = snek_add(vm, str, new_snek_string(vm, "0123456789"));
+  }
+  frame_reference_object(f1, str);
+  munit_assert_null(str->data.v_string.chars);
+  munit_assert_size(snek_string_length(str), ==, 10000);
+
+  // Strings too long to fit inline own a separate buffer
+  snek_object_t *flat = snek_add(vm, short_str, short_str);
+  munit_assert_false(snek_string_is_inline(&flat->data.v_string));
+  munit_assert_string_equal(flat->data.v_string.chars,
+                            "hello, worldhello, world");
+
+  // Rope nodes keep their pieces alive across a collection
+  vm_collect_garbage(vm);
+  const char *chars = snek_string_cstr(str);
+  munit_assert_size(strlen(chars), ==, 10000);
+  munit_assert_int(memcmp(chars + 9990, "0123456789", 10), ==, 0);
+
+  snek_object_t *copy = new_snek_string_len(vm, chars, 10000);
+  munit_assert_true(snek_string_equal(str, copy));
+  munit_assert_uint(snek_string_hash(str), ==, snek_string_hash(copy));
+  munit_assert_false(snek_string_equal(str, short_str));
+
+  // Once flat, the pieces are no longer reachable
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 2);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_map(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  frame_t *f1 = vm_new_frame(vm);
+
+  snek_object_t *map = new_snek_map(vm);
+  frame_reference_object(f1, map);
+
+  // Enough keys to go through several incremental resizes
+  for (int i = 0; i < 5000; i++) {
+    munit_assert_true(snek_map_set(map, new_snek_integer(vm, i),
+                                   new_snek_integer(vm, i * 2)));
+  }
+  munit_assert_size(snek_map_count(map), ==, 5000);
+
+  for (int i = 0; i < 5000; i += 7) {
+    snek_object_t *value = snek_map_get(map, new_snek_integer(vm, i));
+    munit_assert_not_null(value);
+    munit_assert_int(value->data.v_int, ==, i * 2);
+  }
+  munit_assert_null(snek_map_get(map, new_snek_integer(vm, 5000)));
+
+  // Overwrite and delete half of the keys
+  for (int i = 0; i < 5000; i += 2) {
+    munit_assert_true(snek_map_delete(map, new_snek_integer(vm, i)));
+  }
+  munit_assert_false(snek_map_delete(map, new_snek_integer(vm, 0)));
+  snek_map_set(map, new_snek_integer(vm, 1), new_snek_integer(vm, -1));
+  munit_assert_size(snek_map_count(map), ==, 2500);
+  munit_assert_int(snek_map_get(map, new_snek_integer(vm, 1))->data.v_int, ==,
+                   -1);
+  munit_assert_null(snek_map_get(map, new_snek_integer(vm, 2)));
+
+  // String keys compare by content, and never equal integer keys
+  snek_map_set(map, new_snek_string(vm, "name"), new_snek_string(vm, "snek"));
+  snek_object_t *name = snek_map_get(map, new_snek_string(vm, "name"));
+  munit_assert_string_equal(snek_string_cstr(name), "snek");
+  munit_assert_false(snek_map_set(map, new_snek_float(vm, 1.0), name));
+
+  // Live keys and values survive, everything else is collected
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 1 + 2501 * 2);
+  munit_assert_int(snek_map_get(map, new_snek_integer(vm, 4999))->data.v_int,
+                   ==, 9998);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
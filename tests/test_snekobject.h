@@ -0,0 +1,10 @@
+#pragma once
+
+#include "../src/objects/snekobject.h"
+#include "munit/munit.h" // Use the MUnit submodule
+
+MunitResult test_typed_array(const MunitParameter params[], void *user_data);
+MunitResult test_array_append(const MunitParameter params[], void *user_data);
+MunitResult test_array_slice(const MunitParameter params[], void *user_data);
+MunitResult test_string_rope(const MunitParameter params[], void *user_data);
+MunitResult test_map(const MunitParameter params[], void *user_data);
@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/objects/snekobject.h"
+#include "../src/vm/interpreter.h"
+#include "../src/vm/tracer.h"
+#include "test_tracer.h"
+#include "test_util.h"
+
+static char *write_json(tracer_t *tracer) {
+  char *json = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&json, &length);
+  munit_assert_true(tracer_write_chrome_json(tracer, out));
+  fclose(out);
+  return json;
+}
+
+static size_t count(const char *haystack, const char *needle) {
+  size_t found = 0;
+  for (const char *at = strstr(haystack, needle); at != NULL;
+       at = strstr(at + 1, needle)) {
+    found++;
+  }
+  return found;
+}
+
+MunitResult test_tracer_ring(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  tracer_t *tracer = tracer_start(vm, 5, false);
+  munit_assert_not_null(tracer);
+  munit_assert_size(tracer->capacity, ==, 8);
+  munit_assert_null(tracer_start(vm, 5, false));
+  tracer_stop(tracer);
+  munit_assert_null(vm->tracer);
+  vm_free(vm);
+
+  // Only the last eight of twenty are kept
+  for (uint32_t i = 0; i < 20; i++) {
+    tracer_record(tracer, TRACE_ALLOC, INTEGER, i, NULL);
+  }
+  char *json = write_json(tracer);
+  munit_assert_size(count(json, "\"ph\": \"i\""), ==, 8);
+  munit_assert_null(strstr(json, "\"bytes\": 11}"));
+  munit_assert_not_null(strstr(json, "\"name\": \"integer\", \"cat\": "
+                                     "\"alloc\", \"ph\": \"i\", \"s\": "
+                                     "\"t\", \"ts\": 0.000"));
+  munit_assert_not_null(strstr(json, "\"bytes\": 19}"));
+  free(json);
+
+  // A call around a collection. The pop whose push was overwritten is
+  // dropped, and the push names its span after the pop's function.
+  function_t *function = function_new("f", 0);
+  tracer_record(tracer, TRACE_FRAME_POP, 0, 0, function);
+  tracer_record(tracer, TRACE_FRAME_PUSH, 0, 1, NULL);
+  tracer_record(tracer, TRACE_GC_BEGIN, TRACE_COLLECT, 0, NULL);
+  tracer_record(tracer, TRACE_GC_BEGIN, TRACE_MARK, 0, NULL);
+  tracer_record(tracer, TRACE_GC_END, TRACE_MARK, 3, NULL);
+  tracer_record(tracer, TRACE_GC_END, TRACE_COLLECT, 3, NULL);
+  tracer_record(tracer, TRACE_FRAME_POP, 0, 0, function);
+  json = write_json(tracer);
+  munit_assert_size(count(json, "\"ph\": \"B\""), ==, 3);
+  munit_assert_size(count(json, "\"ph\": \"E\""), ==, 3);
+  munit_assert_not_null(
+      strstr(json, "{\"name\": \"f\", \"cat\": \"call\", \"ph\": \"B\""));
+  munit_assert_not_null(
+      strstr(json, "{\"name\": \"mark\", \"cat\": \"gc\", \"ph\": \"E\""));
+  munit_assert_not_null(strstr(json, "\"args\": {\"objects\": 3}"));
+
+  free(json);
+  function_free(function);
+  tracer_free(tracer);
+  return MUNIT_OK;
+}
+
+MunitResult test_tracer_vm(const MunitParameter params[], void *user_data) {
+  // Enough garbage to collect, made by calls
+  program_t *program = test_compile("def f(x: int) -> int:\n"
+                                    "    return x + 1\n"
+                                    "i: int = 0\n"
+                                    "while i < 10000:\n"
+                                    "    i = f(i)\n"
+                                    "print(i)\n",
+                                    NULL);
+  munit_assert_not_null(program);
+
+  vm_t *vm = vm_new();
+  vm->out = fopen("/dev/null", "w");
+  vm->jit = false;
+  tracer_t *tracer = tracer_start(vm, 1 << 20, true);
+  munit_assert_int(vm_run(vm, program), ==, VM_OK);
+  tracer_stop(tracer);
+  size_t collections = vm->gc_stats.collections;
+  fclose(vm->out);
+  vm_free(vm);
+
+  char *json = write_json(tracer);
+#ifdef SNEK_TRACE
+  munit_assert_size(collections, >, 0);
+  munit_assert_size(count(json, "{\"name\": \"gc\", \"cat\": \"gc\", "
+                                "\"ph\": \"B\""),
+                    ==, collections);
+  munit_assert_size(count(json, "{\"name\": \"sweep\", \"cat\": \"gc\", "
+                                "\"ph\": \"E\""),
+                    ==, collections);
+  munit_assert_size(count(json, "{\"name\": \"f\", \"cat\": \"call\", "
+                                "\"ph\": \"B\""),
+                    ==, 10000);
+  munit_assert_size(count(json, "\"ph\": \"B\""), ==,
+                    count(json, "\"ph\": \"E\""));
+  munit_assert_size(count(json, "{\"name\": \"CALL\", \"cat\": "
+                                "\"dispatch\""),
+                    ==, 10000);
+  munit_assert_not_null(strstr(json, "\"cat\": \"alloc\""));
+#else
+  // The trace points are compiled out
+  (void)collections;
+  munit_assert_size(tracer->head, ==, 0);
+  munit_assert_not_null(strstr(json, "{\"traceEvents\": [\n]"));
+#endif
+
+  free(json);
+  tracer_free(tracer);
+  program_free(program);
+  return MUNIT_OK;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Function prototypes for the tracer tests
+MunitResult test_tracer_ring(const MunitParameter params[], void *user_data);
+MunitResult test_tracer_vm(const MunitParameter params[], void *user_data);
@@ -0,0 +1,49 @@
+#include <stdlib.h>
+
+#include "test_util.h"
+
+program_t *test_compile(const char *source, compile_options_t *options) {
+  lexer_t *lexer = lexer_new((char *)source);
+  parser_t *parser = parser_new(lexer);
+  ast_root_t *root = parse_root(parser);
+  munit_assert_not_null(root);
+
+  program_t *program =
+      options != NULL ? compile_with_options(root, options) : compile(root);
+  parser_free(parser);
+  lexer_free(lexer);
+  return program;
+}
+
+bool test_parses(const char *source) {
+  lexer_t *lexer = lexer_new((char *)source);
+  parser_t *parser = parser_new(lexer);
+  bool parsed = parse_root(parser) != NULL;
+  parser_free(parser);
+  lexer_free(lexer);
+  return parsed;
+}
+
+char *test_run(program_t *program, bool jit, vm_result_t *result) {
+  char *output = NULL;
+  size_t length = 0;
+  vm_t *vm = vm_new();
+  vm->out = open_memstream(&output, &length);
+  vm->jit = jit;
+
+  *result = vm_run(vm, program);
+  munit_assert_size(vm->frame_count, ==, 0);
+  munit_assert_size(vm->stack->count, ==, 0);
+
+  fclose(vm->out);
+  vm_free(vm);
+  return output;
+}
+
+char *test_run_source(const char *source, vm_result_t *result) {
+  program_t *program = test_compile(source, NULL);
+  munit_assert_not_null(program);
+  char *output = test_run(program, true, result);
+  program_free(program);
+  return output;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/interpreter.h"
+#include "munit/munit.h" // Use the MUnit submodule
+
+// Fixtures shared by the tests that compile and run scripts
+
+// Parses and compiles `source` with `options`, or compile's defaults if NULL.
+// The script must parse. Returns NULL, after reporting the errors, if it
+// doesn't compile. The program doesn't reference the AST, so the parser is
+// freed straight away.
+program_t *test_compile(const char *source, compile_options_t *options);
+
+// Returns false, after reporting the errors, if `source` doesn't parse
+bool test_parses(const char *source);
+
+// Runs `program` on a new VM, with the JIT on (as vm_new leaves it) or off,
+// and returns everything it printed, which the caller frees. A run that
+// fails must unwind every frame too.
+char *test_run(program_t *program, bool jit, vm_result_t *result);
+
+// Compiles `source`, which must compile, runs it like test_run and frees it
+char *test_run_source(const char *source, vm_result_t *result);
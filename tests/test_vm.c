@@ -3,6 +3,8 @@
 #include "../src/vm/gc.h"
 #include "../src/vm/vm.h"
 #include "munit/munit.h"
+#include <stdlib.h>
+#include <string.h>
 
 MunitResult test_gc(const MunitParameter params[], void *user_data) {
   vm_t *vm = vm_new();
@@ -15,7 +17,7 @@ MunitResult test_gc(const MunitParameter params[], void *user_data) {
   // we haven't freed the frame
   munit_assert_int(vm->objects->count, ==, 1);
 
-  frame_free(vm_frame_pop(vm));
+  vm_frame_pop(vm);
   vm_collect_garbage(vm);
   // now the string should be collected
   munit_assert_int(vm->objects->count, ==, 0);
@@ -24,3 +26,110 @@ MunitResult test_gc(const MunitParameter params[], void *user_data) {
 
   return MUNIT_OK;
 }
+
+MunitResult test_gc_roots(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  frame_t *outer = vm_new_frame(vm);
+
+  snek_object_t *shared = new_snek_integer(vm, 1);
+  frame_reference_object(outer, shared);
+
+  frame_t *inner = vm_new_frame(vm);
+  snek_object_t *local = new_snek_integer(vm, 2);
+  // Referencing the same object twice must not root it twice
+  frame_reference_object(inner, shared);
+  frame_reference_object(inner, local);
+  munit_assert_int(vm->stack->count, ==, 3);
+
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 2);
+  munit_assert_int(vm->gray_objects->count, ==, 0);
+
+  // Popping a frame releases exactly its own slots
+  vm_frame_pop(vm);
+  munit_assert_int(vm->stack->count, ==, 1);
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 1);
+  munit_assert_ptr(vm->objects->data[0], ==, shared);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_frame_growth(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+
+  // Push past the preallocated call stack, one rooted object per frame
+  size_t depth = VM_INITIAL_FRAMES * 3;
+  for (size_t i = 0; i < depth; i++) {
+    frame_reference_object(vm_new_frame(vm), new_snek_integer(vm, (int)i));
+  }
+  munit_assert_size(vm->frame_count, ==, depth);
+  munit_assert_size(vm->frames[depth - 1].base, ==, depth - 1);
+
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, depth);
+
+  while (vm_frame_pop(vm) != NULL) {
+  }
+  vm_collect_garbage(vm);
+  munit_assert_int(vm->objects->count, ==, 0);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
+
+MunitResult test_gc_stats(const MunitParameter params[], void *user_data) {
+  vm_t *vm = vm_new();
+  frame_t *frame = vm_new_frame(vm);
+
+  snek_object_t *kept = new_snek_string(vm, "a string too long to inline");
+  frame_reference_object(frame, kept);
+  for (int i = 0; i < 10; i++) {
+    new_snek_integer(vm, i);
+  }
+  new_snek_array(vm, 4);
+
+  gc_stats_t stats = vm_gc_stats(vm);
+  munit_assert_size(stats.allocated[INTEGER], ==, 10);
+  munit_assert_size(stats.allocated[STRING], ==, 1);
+  munit_assert_size(stats.allocated[ARRAY], ==, 1);
+  munit_assert_size(stats.live, ==, 12);
+  munit_assert_size(stats.allocated_bytes[STRING], ==,
+                    snek_object_size(kept));
+  munit_assert_size(stats.allocated_bytes[STRING], >, sizeof(snek_object_t));
+
+  vm_collect_garbage(vm);
+  stats = vm_gc_stats(vm);
+  munit_assert_size(stats.collections, ==, 1);
+  munit_assert_size(stats.freed, ==, 11);
+  munit_assert_size(stats.live, ==, 1);
+  munit_assert_size(stats.live_bytes, ==, snek_object_size(kept));
+  munit_assert_size(stats.peak, ==, 12);
+
+  size_t allocated = 0;
+  size_t allocated_bytes = 0;
+  for (int kind = 0; kind < VM_OBJECT_KINDS; kind++) {
+    allocated += stats.allocated[kind];
+    allocated_bytes += stats.allocated_bytes[kind];
+  }
+  munit_assert_size(allocated, ==, stats.freed + stats.live);
+  munit_assert_size(allocated_bytes, ==, stats.freed_bytes + stats.live_bytes);
+  munit_assert_size(stats.peak_bytes, ==, allocated_bytes);
+
+  char *json = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&json, &length);
+  munit_assert_true(gc_stats_write_json(out, &stats));
+  fclose(out);
+  munit_assert_not_null(strstr(json, "\"string\": {\"objects\": 1"));
+  munit_assert_not_null(strstr(json, "\"freed_objects\": 11"));
+  munit_assert_not_null(strstr(json, "\"max_pause_ns\""));
+  free(json);
+
+  vm_free(vm);
+
+  return MUNIT_OK;
+}
@@ -5,3 +5,6 @@
 
 // Function prototype for the VM garbage collection test
 MunitResult test_gc(const MunitParameter params[], void *user_data);
+MunitResult test_gc_roots(const MunitParameter params[], void *user_data);
+MunitResult test_frame_growth(const MunitParameter params[], void *user_data);
+MunitResult test_gc_stats(const MunitParameter params[], void *user_data);